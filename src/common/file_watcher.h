@@ -0,0 +1,114 @@
+#pragma once
+
+// ============================================================================
+// File Watcher
+// Polls modification time and size of a fixed set of files. A change is
+// reported once the file has stopped changing for one poll, so editors that
+// save in several writes trigger a single reload of the finished file.
+// ============================================================================
+
+#include <chrono>
+#include <filesystem>
+#include <system_error>
+#include <vector>
+#include <cstdint>
+
+class FileWatcher
+{
+public:
+    // Replace the watched set; current states become the baseline
+    void SetFiles(std::vector<std::filesystem::path> files)
+    {
+        m_Entries.clear();
+        m_Entries.reserve(files.size());
+        for (auto& file : files)
+        {
+            Entry entry;
+            entry.stamp = Stamp(file);
+            entry.path = std::move(file);
+            m_Entries.push_back(std::move(entry));
+        }
+        m_LastPoll = std::chrono::steady_clock::now();
+    }
+
+    // Files whose change has settled since the last report. Checks the
+    // file system at most once per `interval`; cheap to call every frame.
+    std::vector<std::filesystem::path> Poll(std::chrono::milliseconds interval = std::chrono::milliseconds(500))
+    {
+        std::vector<std::filesystem::path> changed;
+        auto now = std::chrono::steady_clock::now();
+        if (now - m_LastPoll < interval)
+        {
+            return changed;
+        }
+        m_LastPoll = now;
+
+        for (Entry& entry : m_Entries)
+        {
+            FileStamp stamp = Stamp(entry.path);
+            if (entry.pending)
+            {
+                // Report once two consecutive polls agree
+                if (stamp == entry.pendingStamp)
+                {
+                    entry.stamp = stamp;
+                    entry.pending = false;
+                    changed.push_back(entry.path);
+                }
+                entry.pendingStamp = stamp;
+            }
+            else if (!(stamp == entry.stamp))
+            {
+                entry.pending = true;
+                entry.pendingStamp = stamp;
+            }
+        }
+        return changed;
+    }
+
+    size_t FileCount() const { return m_Entries.size(); }
+
+private:
+    struct FileStamp
+    {
+        int64_t writeTime = 0;
+        uint64_t size = 0;
+        bool exists = false;
+
+        bool operator==(const FileStamp& other) const
+        {
+            return writeTime == other.writeTime && size == other.size && exists == other.exists;
+        }
+    };
+
+    struct Entry
+    {
+        std::filesystem::path path;
+        FileStamp stamp;
+        FileStamp pendingStamp;
+        bool pending = false;
+    };
+
+    static FileStamp Stamp(const std::filesystem::path& path)
+    {
+        FileStamp stamp;
+        std::error_code ec;
+        auto writeTime = std::filesystem::last_write_time(path, ec);
+        if (ec)
+        {
+            return stamp;
+        }
+        uint64_t size = std::filesystem::file_size(path, ec);
+        if (ec)
+        {
+            return stamp;
+        }
+        stamp.writeTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+        stamp.size = size;
+        stamp.exists = true;
+        return stamp;
+    }
+
+    std::vector<Entry> m_Entries;
+    std::chrono::steady_clock::time_point m_LastPoll;
+};
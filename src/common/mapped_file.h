@@ -0,0 +1,212 @@
+#pragma once
+
+// ============================================================================
+// Memory-Mapped File
+// Maps a file into memory (read-only or private copy-on-write) and falls back
+// to reading it into a heap buffer when mapping is unavailable.
+// ============================================================================
+
+#include <filesystem>
+#include <vector>
+#include <cstddef>
+#include <cstdio>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class MappedFile
+{
+public:
+    enum class Access
+    {
+        ReadOnly,       // Pages are shared with the page cache, writes are not allowed
+        CopyOnWrite     // Writes go to private pages and never reach the file
+    };
+
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Close();
+            m_Data = other.m_Data;
+            m_Size = other.m_Size;
+            m_IsMapped = other.m_IsMapped;
+            m_Fallback = std::move(other.m_Fallback);
+#ifdef _WIN32
+            m_MappingHandle = other.m_MappingHandle;
+            other.m_MappingHandle = nullptr;
+#endif
+            other.m_Data = nullptr;
+            other.m_Size = 0;
+            other.m_IsMapped = false;
+        }
+        return *this;
+    }
+
+    bool Open(const std::filesystem::path& path, Access access = Access::ReadOnly)
+    {
+        Close();
+
+        if (MapFile(path, access))
+        {
+            m_IsMapped = true;
+            return true;
+        }
+
+        return ReadFile(path);
+    }
+
+    void Close()
+    {
+        if (m_IsMapped && m_Data)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(m_Data);
+            CloseHandle(m_MappingHandle);
+            m_MappingHandle = nullptr;
+#else
+            munmap(m_Data, m_Size);
+#endif
+        }
+        m_Data = nullptr;
+        m_Size = 0;
+        m_IsMapped = false;
+        m_Fallback.clear();
+        m_Fallback.shrink_to_fit();
+    }
+
+    char* Data() { return m_Data; }
+    const char* Data() const { return m_Data; }
+    size_t Size() const { return m_Size; }
+    bool IsValid() const { return m_Data != nullptr; }
+    bool IsMapped() const { return m_IsMapped; }
+
+private:
+    char* m_Data = nullptr;
+    size_t m_Size = 0;
+    bool m_IsMapped = false;
+    std::vector<char> m_Fallback;   // Used when the file could not be mapped
+#ifdef _WIN32
+    HANDLE m_MappingHandle = nullptr;
+#endif
+
+    bool MapFile(const std::filesystem::path& path, Access access)
+    {
+#ifdef _WIN32
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        DWORD protect = (access == Access::CopyOnWrite) ? PAGE_WRITECOPY : PAGE_READONLY;
+        HANDLE mapping = CreateFileMappingW(file, nullptr, protect, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping)
+        {
+            return false;
+        }
+
+        DWORD viewAccess = (access == Access::CopyOnWrite) ? FILE_MAP_COPY : FILE_MAP_READ;
+        void* view = MapViewOfFile(mapping, viewAccess, 0, 0, 0);
+        if (!view)
+        {
+            CloseHandle(mapping);
+            return false;
+        }
+
+        m_MappingHandle = mapping;
+        m_Data = static_cast<char*>(view);
+        m_Size = static_cast<size_t>(fileSize.QuadPart);
+        return true;
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            close(fd);
+            return false;
+        }
+
+        int protect = (access == Access::CopyOnWrite) ? (PROT_READ | PROT_WRITE) : PROT_READ;
+        void* view = mmap(nullptr, static_cast<size_t>(st.st_size), protect, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (view == MAP_FAILED)
+        {
+            return false;
+        }
+
+        madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+        m_Data = static_cast<char*>(view);
+        m_Size = static_cast<size_t>(st.st_size);
+        return true;
+#endif
+    }
+
+    bool ReadFile(const std::filesystem::path& path)
+    {
+        FILE* file = nullptr;
+#ifdef _WIN32
+        _wfopen_s(&file, path.c_str(), L"rb");
+#else
+        file = fopen(path.c_str(), "rb");
+#endif
+        if (!file)
+        {
+            return false;
+        }
+
+        fseek(file, 0, SEEK_END);
+        long fileSize = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        if (fileSize <= 0)
+        {
+            fclose(file);
+            return false;
+        }
+
+        m_Fallback.resize(static_cast<size_t>(fileSize));
+        size_t bytesRead = fread(m_Fallback.data(), 1, m_Fallback.size(), file);
+        fclose(file);
+
+        m_Fallback.resize(bytesRead);
+        m_Data = m_Fallback.data();
+        m_Size = m_Fallback.size();
+        return bytesRead > 0;
+    }
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+// ============================================================================
+// Parallel Helpers
+// A minimal fork-join ForEach over an index range plus a byte budget that
+// bounds how much memory concurrent jobs may hold at once.
+// ============================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+namespace parallel
+{
+
+inline unsigned DefaultThreadCount()
+{
+    unsigned count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 4;
+}
+
+// Run fn(i) for every i in [0, count) on up to `threadCount` threads
+// (0 = DefaultThreadCount()). The calling thread takes part; indices are
+// handed out dynamically so uneven jobs balance. Returns when all are done.
+template <typename Fn>
+void ForEach(size_t count, unsigned threadCount, Fn&& fn)
+{
+    if (threadCount == 0)
+    {
+        threadCount = DefaultThreadCount();
+    }
+    threadCount = static_cast<unsigned>(std::min<size_t>(threadCount, count));
+
+    if (threadCount <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            fn(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{ 0 };
+    auto worker = [&]()
+    {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+        {
+            fn(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned t = 1; t < threadCount; t++)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+// Blocks Acquire() while the bytes held by other jobs plus the request would
+// exceed the limit. A single request larger than the limit is admitted once
+// nothing else is in flight, so oversized jobs run alone instead of deadlocking.
+class MemoryBudget
+{
+public:
+    explicit MemoryBudget(size_t limitBytes) : m_Limit(limitBytes) {}
+
+    void Acquire(size_t bytes)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Available.wait(lock, [&]() { return m_InFlight == 0 || m_InFlight + bytes <= m_Limit; });
+        m_InFlight += bytes;
+        m_Peak = std::max(m_Peak, m_InFlight);
+    }
+
+    void Release(size_t bytes)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_InFlight -= bytes;
+        }
+        m_Available.notify_all();
+    }
+
+    size_t Peak() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Peak;
+    }
+
+private:
+    size_t m_Limit;
+    size_t m_InFlight = 0;
+    size_t m_Peak = 0;
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Available;
+};
+
+} // namespace parallel
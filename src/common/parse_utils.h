@@ -0,0 +1,88 @@
+#pragma once
+
+// ============================================================================
+// Scene Parsing Utilities
+// Locale-independent, allocation-free number parsing for Mitsuba XML
+// property values (float, integer, boolean, rgb, matrix, point/vector).
+// Built on std::from_chars so "1.5" parses identically under any C locale.
+// ============================================================================
+
+#include <charconv>
+#include <string_view>
+#include <cstddef>
+
+namespace parse_utils
+{
+
+// Mitsuba separates list entries with whitespace and/or commas
+inline bool IsSeparator(char c)
+{
+    return c == ' ' || c == ',' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Parse the next number from text and advance past it.
+// Returns false (leaving value untouched) when no number could be read.
+template <typename T>
+inline bool NextNumber(std::string_view& text, T& value)
+{
+    size_t pos = 0;
+    while (pos < text.size() && IsSeparator(text[pos]))
+    {
+        pos++;
+    }
+    // std::from_chars does not accept an explicit leading '+'
+    if (pos < text.size() && text[pos] == '+')
+    {
+        pos++;
+    }
+
+    const char* first = text.data() + pos;
+    const char* last = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(first, last, value);
+    if (ec != std::errc())
+    {
+        return false;
+    }
+
+    text.remove_prefix(static_cast<size_t>(ptr - text.data()));
+    return true;
+}
+
+// Parse up to `count` numbers into `out`. Returns the number actually parsed.
+template <typename T>
+inline size_t ParseList(std::string_view text, T* out, size_t count)
+{
+    size_t parsed = 0;
+    while (parsed < count && NextNumber(text, out[parsed]))
+    {
+        parsed++;
+    }
+    return parsed;
+}
+
+inline float ParseFloat(std::string_view text, float defaultValue = 0.0f)
+{
+    float value = defaultValue;
+    return NextNumber(text, value) ? value : defaultValue;
+}
+
+inline int ParseInt(std::string_view text, int defaultValue = 0)
+{
+    int value = defaultValue;
+    return NextNumber(text, value) ? value : defaultValue;
+}
+
+inline bool ParseBool(std::string_view text, bool defaultValue = false)
+{
+    if (text == "true" || text == "1")
+    {
+        return true;
+    }
+    if (text == "false" || text == "0")
+    {
+        return false;
+    }
+    return defaultValue;
+}
+
+} // namespace parse_utils
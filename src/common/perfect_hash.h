@@ -0,0 +1,118 @@
+#pragma once
+
+// ============================================================================
+// Compile-Time Perfect Hash Map
+// Fixed string_view -> value tables built entirely at compile time. The seed
+// search guarantees every key lands in its own slot, so a lookup is one hash,
+// one mask and one string compare - no probing, no allocation.
+// ============================================================================
+
+#include <array>
+#include <string_view>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+namespace perfect_hash
+{
+
+// Seeded FNV-1a
+constexpr uint32_t HashName(std::string_view text, uint32_t seed)
+{
+    uint32_t hash = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (char c : text)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash ^ (hash >> 15);
+}
+
+constexpr size_t NextPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+template <typename T, size_t N>
+class Map
+{
+public:
+    using Entry = std::pair<std::string_view, T>;
+
+    // Two empty slots per key keeps the seed search short
+    static constexpr size_t TableSize = NextPowerOfTwo(N * 2);
+
+    constexpr explicit Map(const Entry (&entries)[N])
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            for (size_t j = i + 1; j < N; j++)
+            {
+                if (entries[i].first == entries[j].first)
+                {
+                    throw "perfect_hash::Map: duplicate key";
+                }
+            }
+        }
+
+        for (uint32_t seed = 0; seed < 65536; seed++)
+        {
+            if (TryBuild(entries, seed))
+            {
+                return;
+            }
+        }
+        throw "perfect_hash::Map: no collision-free seed found";
+    }
+
+    constexpr const T* Find(std::string_view key) const
+    {
+        const Slot& slot = m_Slots[HashName(key, m_Seed) & (TableSize - 1)];
+        return (slot.used && slot.key == key) ? &slot.value : nullptr;
+    }
+
+    static constexpr size_t Size() { return N; }
+
+private:
+    struct Slot
+    {
+        std::string_view key;
+        T value{};
+        bool used = false;
+    };
+
+    std::array<Slot, TableSize> m_Slots{};
+    uint32_t m_Seed = 0;
+
+    constexpr bool TryBuild(const Entry (&entries)[N], uint32_t seed)
+    {
+        m_Slots = {};
+        m_Seed = seed;
+        for (const Entry& entry : entries)
+        {
+            Slot& slot = m_Slots[HashName(entry.first, seed) & (TableSize - 1)];
+            if (slot.used)
+            {
+                return false;
+            }
+            slot.key = entry.first;
+            slot.value = entry.second;
+            slot.used = true;
+        }
+        return true;
+    }
+};
+
+// Deduces N from the initializer: MakeMap<float>({ {"a", 1.0f}, {"b", 2.0f} })
+template <typename T, size_t N>
+constexpr Map<T, N> MakeMap(const std::pair<std::string_view, T> (&entries)[N])
+{
+    return Map<T, N>(entries);
+}
+
+} // namespace perfect_hash
@@ -7,10 +7,12 @@
 // ============================================================================
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <filesystem>
 #include <cstdint>
 #include <cstring>
+#include <cstdio>
 #include <algorithm>
 
 #include <donut/core/log.h>
@@ -49,6 +51,133 @@ struct EnvironmentMap
     bool IsValid() const { return texture.IsValid(); }
 };
 
+// Image header information, available without decoding any pixels
+struct TextureInfo
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;           // Channels stored in the file
+    bool isHDR = false;
+    
+    bool IsValid() const { return width > 0 && height > 0; }
+    
+    // Peak bytes held while decoding: the RGBA32F result plus the decoder's
+    // own RGBA buffer (8-bit for LDR, float for HDR/EXR)
+    size_t DecodeFootprint() const
+    {
+        size_t pixels = static_cast<size_t>(width) * height;
+        return pixels * 4 * sizeof(float) + pixels * 4 * (isHDR ? sizeof(float) : 1);
+    }
+};
+
+// Read width/height/channels from an OpenEXR header (dataWindow/channels attributes)
+inline TextureInfo ProbeEXRHeader(const std::filesystem::path& filePath)
+{
+    TextureInfo info;
+    info.isHDR = true;
+    
+    FILE* file = nullptr;
+#ifdef _WIN32
+    fopen_s(&file, filePath.string().c_str(), "rb");
+#else
+    file = fopen(filePath.string().c_str(), "rb");
+#endif
+    if (!file)
+    {
+        return info;
+    }
+    
+    // Headers are small; attributes past this window are not needed
+    std::vector<unsigned char> header(64 * 1024);
+    header.resize(fread(header.data(), 1, header.size(), file));
+    fclose(file);
+    
+    const unsigned char magic[4] = { 0x76, 0x2f, 0x31, 0x01 };
+    if (header.size() < 8 || std::memcmp(header.data(), magic, 4) != 0)
+    {
+        return info;
+    }
+    
+    auto readInt = [&](size_t pos) -> int32_t
+    {
+        return static_cast<int32_t>(uint32_t(header[pos]) | (uint32_t(header[pos + 1]) << 8) |
+            (uint32_t(header[pos + 2]) << 16) | (uint32_t(header[pos + 3]) << 24));
+    };
+    auto readString = [&](size_t& pos) -> std::string_view
+    {
+        size_t start = pos;
+        while (pos < header.size() && header[pos] != 0)
+        {
+            pos++;
+        }
+        std::string_view text(reinterpret_cast<const char*>(header.data()) + start, pos - start);
+        pos++;  // Skip terminator
+        return text;
+    };
+    
+    // Attribute list: name\0 type\0 int32 size, value; an empty name ends it
+    size_t pos = 8;
+    while (pos < header.size())
+    {
+        std::string_view name = readString(pos);
+        if (name.empty())
+        {
+            break;
+        }
+        readString(pos);  // Attribute type
+        if (pos + 4 > header.size())
+        {
+            break;
+        }
+        int32_t size = readInt(pos);
+        pos += 4;
+        if (size < 0 || pos + size > header.size())
+        {
+            break;
+        }
+        
+        if (name == "dataWindow" && size == 16)
+        {
+            info.width = readInt(pos + 8) - readInt(pos) + 1;
+            info.height = readInt(pos + 12) - readInt(pos + 4) + 1;
+        }
+        else if (name == "channels")
+        {
+            // Channel list: name\0 + 16 bytes of per-channel data, terminated by \0
+            size_t channelPos = pos;
+            size_t end = pos + size;
+            while (channelPos < end && header[channelPos] != 0)
+            {
+                readString(channelPos);
+                channelPos += 16;
+                info.channels++;
+            }
+        }
+        pos += size;
+    }
+    
+    return info;
+}
+
+// Read image dimensions without decoding pixels (auto-detects format)
+inline TextureInfo ProbeTexture(const std::filesystem::path& filePath)
+{
+    std::string ext = filePath.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    
+    if (ext == ".exr")
+    {
+        return ProbeEXRHeader(filePath);
+    }
+    
+    TextureInfo info;
+    if (stbi_info(filePath.string().c_str(), &info.width, &info.height, &info.channels))
+    {
+        info.isHDR = (ext == ".hdr");
+    }
+    return info;
+}
+
 // Load texture from file (auto-detects format)
 inline TextureData LoadTexture(const std::filesystem::path& filePath)
 {
@@ -5,32 +5,29 @@
 #include <donut/core/vfs/VFS.h>
 #include <nvrhi/utils.h>
 
-#include <pugixml.hpp>
-
-#define HANDMADE_MATH_USE_RADIANS
-#include "HandmadeMath.h"
-
-#define TINYOBJ_LOADER_C_IMPLEMENTATION
-#include <tinyobj_loader_c.h>
-
-// Texture loading utilities
-#include "../common/texture_utils.h"
+// Scene loading (parser, OBJ reader callback)
+#include "../scene_core/mitsuba_parser.h"
+#include "../scene_core/obj_reader.h"
+#include "../scene_core/vertex_dedup.h"
+#include "../scene_core/ply_reader.h"
+#include "../scene_core/vertex_cache.h"
+#include "../scene_core/mesh_simplify.h"
+#include "../common/parallel.h"
 
 #include <filesystem>
 #include <unordered_map>
-#include <unordered_set>
-#include <sstream>
 #include <cmath>
 #include <algorithm>
 
 using namespace donut;
 
 static const char* g_WindowTitle = "Mitsuba Scene Rasterizer";
+static constexpr float g_NearPlane = 0.1f;
 
 // ============================================================================
 // GPU Structures (must match HLSL) - using plain floats for GPU compatibility
 // ============================================================================
-struct GPUVertex
+struct RasterVertex
 {
     float position[3];
     float normal[3];
@@ -62,415 +59,37 @@ struct LightConstants
 };
 
 // ============================================================================
-// Mitsuba Scene Parser - using HandmadeMath (column-vector convention)
+// Mesh Data for Rendering
 // ============================================================================
-class MitsubaSceneParser
+// CPU side of a mesh, between reading its file and uploading it
+struct RasterMeshData
 {
-public:
-    struct Camera
-    {
-        HMM_Mat4 transform = HMM_M4D(1.0f);  // Identity matrix
-        float fov = 45.0f;
-        int width = 1280;
-        int height = 720;
-    };
-
-    // Texture reference structure
-    struct TextureRef
-    {
-        std::string filename;
-        bool isValid = false;
-        int textureIndex = -1;
-    };
-
-    struct Material
-    {
-        std::string id;
-        HMM_Vec3 baseColor = HMM_V3(0.5f, 0.5f, 0.5f);
-        float roughness = 0.5f;
-        TextureRef baseColorTexture;
-    };
-
-    struct Shape
-    {
-        std::string type;
-        std::string filename;
-        std::string materialRef;
-        HMM_Mat4 transform = HMM_M4D(1.0f);  // Identity matrix
-        bool isEmitter = false;
-        HMM_Vec3 emission = HMM_V3(0.0f, 0.0f, 0.0f);
-        
-        Material inlineMaterial;
-        bool hasInlineMaterial = false;
-    };
-
-    Camera camera;
-    std::unordered_map<std::string, Material> materials;
-    std::vector<Shape> shapes;
-    std::filesystem::path sceneDirectory;
-    
-    // Loaded textures
-    std::unordered_map<std::string, int> textureIndexMap;
-    std::vector<texture_utils::TextureData> loadedTextures;
-
-    bool Parse(const std::filesystem::path& xmlPath)
-    {
-        sceneDirectory = xmlPath.parent_path();
-
-        pugi::xml_document doc;
-        pugi::xml_parse_result result = doc.load_file(xmlPath.c_str());
-
-        if (!result)
-        {
-            log::error("Failed to parse XML file: %s", result.description());
-            return false;
-        }
-
-        pugi::xml_node sceneNode = doc.child("scene");
-        if (!sceneNode)
-        {
-            log::error("No <scene> node found in XML");
-            return false;
-        }
-
-        for (pugi::xml_node node : sceneNode.children())
-        {
-            std::string nodeName = node.name();
-
-            if (nodeName == "sensor")
-            {
-                ParseSensor(node);
-            }
-            else if (nodeName == "bsdf")
-            {
-                Material mat = ParseBSDF(node);
-                if (!mat.id.empty())
-                {
-                    materials[mat.id] = mat;
-                }
-            }
-            else if (nodeName == "shape")
-            {
-                ParseShape(node);
-            }
-        }
-
-        // Load all referenced textures
-        LoadReferencedTextures();
-
-        log::info("Parsed %zu materials, %zu shapes, %zu textures", 
-            materials.size(), shapes.size(), loadedTextures.size());
-        return true;
-    }
-
-private:
-    // Parse Mitsuba matrix for HMM row-vector convention
-    // Mitsuba uses column-vector: p' = M * p, where p'.x = m00*p.x + m01*p.y + m02*p.z + m03
-    // HMM uses row-vector: p' = p * M, where p'.x = p.x*col0.x + p.y*col1.x + p.z*col2.x + p.w*col3.x
-    // For equivalence: col0.x=m00, col1.x=m01, col2.x=m02, col3.x=m03
-    //                  col0.y=m10, col1.y=m11, col2.y=m12, col3.y=m13, etc.
-    // Mitsuba XML text order: m00 m01 m02 m03  m10 m11 m12 m13  m20 m21 m22 m23  m30 m31 m32 m33
-    HMM_Mat4 ParseMatrix(const std::string& matrixStr)
-    {
-        std::istringstream iss(matrixStr);
-        float values[16];
-        for (int i = 0; i < 16; i++)
-        {
-            iss >> values[i];
-        }
-        
-        // Map Mitsuba matrix to HMM columns:
-        // Column j gets all elements m[i][j] for i=0..3
-        HMM_Mat4 result;
-        result.Columns[0] = HMM_V4(values[0], values[4], values[8],  values[12]); // m00,m10,m20,m30
-        result.Columns[1] = HMM_V4(values[1], values[5], values[9],  values[13]); // m01,m11,m21,m31
-        result.Columns[2] = HMM_V4(values[2], values[6], values[10], values[14]); // m02,m12,m22,m32
-        result.Columns[3] = HMM_V4(values[3], values[7], values[11], values[15]); // m03,m13,m23,m33
-        return result;
-    }
-
-    HMM_Vec3 ParseRGB(const std::string& rgbStr)
-    {
-        HMM_Vec3 color = HMM_V3(0.0f, 0.0f, 0.0f);
-        std::string cleaned = rgbStr;
-        for (char& c : cleaned)
-        {
-            if (c == ',') c = ' ';
-        }
-        std::istringstream iss(cleaned);
-        iss >> color.X >> color.Y >> color.Z;
-        return color;
-    }
-
-    void ParseSensor(pugi::xml_node sensorNode)
-    {
-        for (pugi::xml_node child : sensorNode.children("float"))
-        {
-            std::string name = child.attribute("name").value();
-            if (name == "fov")
-            {
-                camera.fov = child.attribute("value").as_float(45.0f);
-            }
-        }
-
-        pugi::xml_node transformNode = sensorNode.child("transform");
-        if (transformNode)
-        {
-            pugi::xml_node matrixNode = transformNode.child("matrix");
-            if (matrixNode)
-            {
-                camera.transform = ParseMatrix(matrixNode.attribute("value").value());
-            }
-        }
-
-        pugi::xml_node filmNode = sensorNode.child("film");
-        if (filmNode)
-        {
-            for (pugi::xml_node child : filmNode.children("integer"))
-            {
-                std::string name = child.attribute("name").value();
-                if (name == "width")
-                {
-                    camera.width = child.attribute("value").as_int(1280);
-                }
-                else if (name == "height")
-                {
-                    camera.height = child.attribute("value").as_int(720);
-                }
-            }
-        }
-    }
-
-    Material ParseBSDF(pugi::xml_node bsdfNode, bool nested = false)
-    {
-        Material mat;
-        
-        if (!nested)
-        {
-            mat.id = bsdfNode.attribute("id").value();
-        }
-
-        std::string type = bsdfNode.attribute("type").value();
-
-        if (type == "twosided")
-        {
-            pugi::xml_node innerBsdf = bsdfNode.child("bsdf");
-            if (innerBsdf)
-            {
-                Material innerMat = ParseBSDF(innerBsdf, true);
-                innerMat.id = mat.id;
-                return innerMat;
-            }
-        }
-
-        for (pugi::xml_node child : bsdfNode.children())
-        {
-            std::string childName = child.name();
-            std::string propName = child.attribute("name").value();
-
-            if (childName == "rgb")
-            {
-                HMM_Vec3 color = ParseRGB(child.attribute("value").value());
-                if (propName == "reflectance" || propName == "diffuse_reflectance" || propName == "specular_reflectance")
-                {
-                    mat.baseColor = color;
-                }
-            }
-            else if (childName == "float")
-            {
-                float value = child.attribute("value").as_float();
-                if (propName == "alpha")
-                {
-                    mat.roughness = value;
-                }
-            }
-            else if (childName == "texture")
-            {
-                // Parse texture reference
-                std::string texType = child.attribute("type").value();
-                if (texType == "bitmap")
-                {
-                    for (pugi::xml_node texChild : child.children("string"))
-                    {
-                        std::string texPropName = texChild.attribute("name").value();
-                        if (texPropName == "filename")
-                        {
-                            std::string filename = texChild.attribute("value").value();
-                            if (propName == "reflectance" || propName == "diffuse_reflectance")
-                            {
-                                mat.baseColorTexture.filename = filename;
-                                mat.baseColorTexture.isValid = true;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-
-        return mat;
-    }
-
-    void ParseShape(pugi::xml_node shapeNode)
-    {
-        Shape shape;
-        shape.type = shapeNode.attribute("type").value();
-
-        pugi::xml_node transformNode = shapeNode.child("transform");
-        if (transformNode)
-        {
-            pugi::xml_node matrixNode = transformNode.child("matrix");
-            if (matrixNode)
-            {
-                shape.transform = ParseMatrix(matrixNode.attribute("value").value());
-            }
-        }
-
-        for (pugi::xml_node child : shapeNode.children("string"))
-        {
-            std::string name = child.attribute("name").value();
-            if (name == "filename")
-            {
-                shape.filename = child.attribute("value").value();
-            }
-        }
-
-        pugi::xml_node refNode = shapeNode.child("ref");
-        if (refNode)
-        {
-            shape.materialRef = refNode.attribute("id").value();
-        }
-
-        pugi::xml_node inlineBsdf = shapeNode.child("bsdf");
-        if (inlineBsdf)
-        {
-            shape.inlineMaterial = ParseBSDF(inlineBsdf, true);
-            shape.hasInlineMaterial = true;
-        }
-
-        pugi::xml_node emitterNode = shapeNode.child("emitter");
-        if (emitterNode)
-        {
-            shape.isEmitter = true;
-            for (pugi::xml_node child : emitterNode.children("rgb"))
-            {
-                std::string name = child.attribute("name").value();
-                if (name == "radiance")
-                {
-                    shape.emission = ParseRGB(child.attribute("value").value());
-                }
-            }
-        }
-
-        shapes.push_back(shape);
-    }
-    
-    // Load all referenced textures
-    void LoadReferencedTextures()
-    {
-        std::unordered_set<std::string> textureFiles;
-        
-        // Collect texture filenames from materials
-        for (auto& [id, mat] : materials)
-        {
-            if (mat.baseColorTexture.isValid && !mat.baseColorTexture.filename.empty())
-            {
-                textureFiles.insert(mat.baseColorTexture.filename);
-            }
-        }
-        
-        // Also check inline materials in shapes
-        for (auto& shape : shapes)
-        {
-            if (shape.hasInlineMaterial && shape.inlineMaterial.baseColorTexture.isValid)
-            {
-                textureFiles.insert(shape.inlineMaterial.baseColorTexture.filename);
-            }
-        }
-        
-        // Load each unique texture
-        for (const auto& filename : textureFiles)
-        {
-            std::filesystem::path texturePath = sceneDirectory / filename;
-            texture_utils::TextureData texData = texture_utils::LoadTexture(texturePath);
-            
-            if (texData.IsValid())
-            {
-                int index = static_cast<int>(loadedTextures.size());
-                textureIndexMap[filename] = index;
-                loadedTextures.push_back(std::move(texData));
-            }
-        }
-        
-        // Update material texture indices
-        for (auto& [id, mat] : materials)
-        {
-            if (mat.baseColorTexture.isValid && !mat.baseColorTexture.filename.empty())
-            {
-                auto it = textureIndexMap.find(mat.baseColorTexture.filename);
-                if (it != textureIndexMap.end())
-                {
-                    mat.baseColorTexture.textureIndex = it->second;
-                }
-            }
-        }
-        
-        // Update inline material texture indices
-        for (auto& shape : shapes)
-        {
-            if (shape.hasInlineMaterial && shape.inlineMaterial.baseColorTexture.isValid)
-            {
-                auto it = textureIndexMap.find(shape.inlineMaterial.baseColorTexture.filename);
-                if (it != textureIndexMap.end())
-                {
-                    shape.inlineMaterial.baseColorTexture.textureIndex = it->second;
-                }
-            }
-        }
-    }
+    std::vector<RasterVertex> vertices;
+    std::vector<uint32_t> indices;  // Every LOD level, finest first
+    std::vector<MeshLOD> lods;
 };
 
-// ============================================================================
-// OBJ Loader Callback
-// ============================================================================
-static void FileReaderCallback(void* ctx, const char* filename, int is_mtl, 
-                               const char* obj_filename, char** buf, size_t* len)
+// GPU buffers of one mesh, shared by every shape that uses it. All LOD
+// levels index the same vertex buffer.
+struct MeshGeometry
 {
-    std::filesystem::path* basePath = static_cast<std::filesystem::path*>(ctx);
-    std::filesystem::path fullPath = *basePath / filename;
-
-    FILE* file = nullptr;
-#ifdef _WIN32
-    fopen_s(&file, fullPath.string().c_str(), "rb");
-#else
-    file = fopen(fullPath.string().c_str(), "rb");
-#endif
-
-    if (!file)
-    {
-        *buf = nullptr;
-        *len = 0;
-        return;
-    }
-
-    fseek(file, 0, SEEK_END);
-    long fileSize = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    *buf = static_cast<char*>(malloc(fileSize + 1));
-    *len = fread(*buf, 1, fileSize, file);
-    (*buf)[*len] = '\0';
+    nvrhi::BufferHandle vertexBuffer;
+    nvrhi::BufferHandle indexBuffer;
+    std::vector<MeshLOD> lods;      // Empty if the mesh failed to load
+    HMM_Vec3 boundsCenter;          // Local-space bounding sphere
+    float boundsRadius = 0.0f;
+};
 
-    fclose(file);
-}
+// Where a geometry comes from: an OBJ/PLY file, or the unit rectangle
+struct GeometrySource
+{
+    std::filesystem::path path;
+    std::string_view type;
+};
 
-// ============================================================================
-// Mesh Data for Rendering
-// ============================================================================
 struct RenderMesh
 {
-    nvrhi::BufferHandle vertexBuffer;
-    nvrhi::BufferHandle indexBuffer;
-    uint32_t indexCount;
+    uint32_t geometry;        // Index into m_Geometries
     HMM_Mat4 worldTransform;  // Model matrix (local to world)
     HMM_Vec3 baseColor;
     float roughness;
@@ -504,6 +123,17 @@ private:
     nvrhi::SamplerHandle m_LinearSampler;
 
     std::vector<RenderMesh> m_Meshes;
+    std::vector<MeshGeometry> m_Geometries;
+    std::vector<GeometrySource> m_GeometrySources;  // Parallel to m_Geometries until they are built
+    std::unordered_map<std::string_view, uint32_t> m_FileMeshCache;  // Geometry index, keyed by OBJ/PLY filename
+    uint32_t m_RectangleGeometry = UINT32_MAX;
+
+    // Each mesh draws the coarsest LOD level whose error projects to at
+    // most this many pixels
+    float m_LODErrorPixels = 1.0f;
+    size_t m_DrawnTriangles = 0;        // Last frame, after LOD selection
+    size_t m_FullTriangles = 0;         // Last frame, all at level 0
+    bool m_LODReported = false;
     
     MitsubaSceneParser m_SceneParser;
     std::filesystem::path m_ScenePath;
@@ -561,18 +191,18 @@ public:
             nvrhi::VertexAttributeDesc()
                 .setName("POSITION")
                 .setFormat(nvrhi::Format::RGB32_FLOAT)
-                .setOffset(offsetof(GPUVertex, position))
-                .setElementStride(sizeof(GPUVertex)),
+                .setOffset(offsetof(RasterVertex, position))
+                .setElementStride(sizeof(RasterVertex)),
             nvrhi::VertexAttributeDesc()
                 .setName("NORMAL")
                 .setFormat(nvrhi::Format::RGB32_FLOAT)
-                .setOffset(offsetof(GPUVertex, normal))
-                .setElementStride(sizeof(GPUVertex)),
+                .setOffset(offsetof(RasterVertex, normal))
+                .setElementStride(sizeof(RasterVertex)),
             nvrhi::VertexAttributeDesc()
                 .setName("TEXCOORD")
                 .setFormat(nvrhi::Format::RG32_FLOAT)
-                .setOffset(offsetof(GPUVertex, texcoord))
-                .setElementStride(sizeof(GPUVertex))
+                .setOffset(offsetof(RasterVertex, texcoord))
+                .setElementStride(sizeof(RasterVertex))
         };
         m_InputLayout = GetDevice()->createInputLayout(attributes, 3, m_VertexShader);
 
@@ -614,12 +244,12 @@ public:
 
         m_CommandList = GetDevice()->createCommandList();
         
-        // Create textures (needs command list)
-        CreateMaterialTextures();
-
         // Load meshes from scene
         LoadSceneMeshes();
 
+        // Create textures used by the draw list (needs command list)
+        CreateMaterialTextures();
+
         // Initialize camera from scene
         InitializeCamera();
 
@@ -654,9 +284,28 @@ public:
         
         log::info("Created default white texture");
         
-        // Create textures from loaded texture data
-        for (const auto& texData : m_SceneParser.loadedTextures)
+        // Decode only the textures the draw list samples
+        std::vector<int> usedTextures;
+        for (const RenderMesh& mesh : m_Meshes)
+        {
+            if (mesh.baseColorTexIdx >= 0)
+            {
+                usedTextures.push_back(mesh.baseColorTexIdx);
+            }
+        }
+        m_SceneParser.DecodeTextures(usedTextures);
+        
+        // Create textures from decoded texture data; slots that were never
+        // decoded (or failed) get the default texture so indices stay aligned
+        for (const auto& sceneTexture : m_SceneParser.textures)
         {
+            const texture_utils::TextureData& texData = sceneTexture.data;
+            if (!texData.IsValid())
+            {
+                m_MaterialTextures.push_back(m_DefaultTexture);
+                continue;
+            }
+            
             nvrhi::TextureDesc texDesc;
             texDesc.width = texData.width;
             texDesc.height = texData.height;
@@ -683,168 +332,341 @@ public:
 
     void LoadSceneMeshes()
     {
-        m_CommandList->open();
+        // Shape group members are loaded once; every instance of the group
+        // reuses their geometry with its own world transform
+        std::unordered_map<std::string_view, std::vector<RenderMesh>> groupMeshes;
 
         for (auto& shape : m_SceneParser.shapes)
         {
-            if (shape.type == "obj")
+            if (shape.type == "obj" || shape.type == "ply")
             {
-                LoadOBJMesh(shape);
+                LoadFileMesh(shape);
             }
             else if (shape.type == "rectangle")
             {
                 CreateRectangleMesh(shape);
             }
+            else if (shape.type == "instance")
+            {
+                auto groupIt = m_SceneParser.shapeGroups.find(shape.groupRef);
+                if (groupIt == m_SceneParser.shapeGroups.end())
+                {
+                    log::warning("Instance references unknown shape group '%.*s'",
+                        static_cast<int>(shape.groupRef.size()), shape.groupRef.data());
+                    continue;
+                }
+
+                auto [meshesIt, isNew] = groupMeshes.try_emplace(shape.groupRef);
+                if (isNew)
+                {
+                    // Load members into m_Meshes, then move them out as prototypes
+                    size_t firstMesh = m_Meshes.size();
+                    for (auto& member : groupIt->second.shapes)
+                    {
+                        if (member.type == "obj" || member.type == "ply")
+                        {
+                            LoadFileMesh(member);
+                        }
+                        else if (member.type == "rectangle")
+                        {
+                            CreateRectangleMesh(member);
+                        }
+                    }
+                    meshesIt->second.assign(m_Meshes.begin() + firstMesh, m_Meshes.end());
+                    m_Meshes.resize(firstMesh);
+                }
+
+                for (const RenderMesh& prototype : meshesIt->second)
+                {
+                    RenderMesh mesh = prototype;
+                    mesh.worldTransform = HMM_MulM4(shape.transform, prototype.worldTransform);
+                    m_Meshes.push_back(mesh);
+                }
+            }
         }
 
+        BuildGeometries();
+
+        log::info("Loaded %zu meshes (%zu unique mesh files)", m_Meshes.size(), m_FileMeshCache.size());
+    }
+
+    uint32_t AddGeometry(GeometrySource source)
+    {
+        m_Geometries.emplace_back();
+        m_GeometrySources.push_back(std::move(source));
+        return static_cast<uint32_t>(m_Geometries.size() - 1);
+    }
+
+    // Read, reorder and simplify every queued geometry in parallel, then
+    // upload them in order. Meshes whose file failed to load are dropped.
+    void BuildGeometries()
+    {
+        std::vector<RasterMeshData> meshes(m_Geometries.size());
+        parallel::ForEach(meshes.size(), 0, [&](size_t i)
+        {
+            const GeometrySource& source = m_GeometrySources[i];
+            bool ok = source.type == "rectangle" ? BuildRectangleMesh(meshes[i])
+                    : source.type == "ply"       ? ReadPLYMesh(source.path, meshes[i])
+                                                 : ReadOBJMesh(source.path, meshes[i]);
+            if (ok && !meshes[i].vertices.empty() && !meshes[i].indices.empty())
+            {
+                OptimizeMesh(meshes[i]);
+            }
+            else
+            {
+                meshes[i] = {};
+            }
+        });
+
+        m_CommandList->open();
+        size_t fullTriangles = 0;
+        size_t coarsestTriangles = 0;
+        size_t levels = 0;
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            if (meshes[i].lods.empty())
+            {
+                continue;
+            }
+            UploadGeometry(meshes[i], m_Geometries[i]);
+            fullTriangles += meshes[i].lods.front().indexCount / 3;
+            coarsestTriangles += meshes[i].lods.back().indexCount / 3;
+            levels += meshes[i].lods.size();
+        }
         m_CommandList->close();
         GetDevice()->executeCommandList(m_CommandList);
+        m_GeometrySources.clear();
+
+        std::erase_if(m_Meshes, [&](const RenderMesh& mesh) { return m_Geometries[mesh.geometry].lods.empty(); });
 
-        log::info("Loaded %zu meshes", m_Meshes.size());
+        if (!meshes.empty())
+        {
+            log::info("Built %zu LOD levels for %zu geometries: %zu triangles at full detail, %zu at the coarsest",
+                levels, meshes.size(), fullTriangles, coarsestTriangles);
+        }
     }
 
-    void LoadOBJMesh(MitsubaSceneParser::Shape& shape)
+    void LoadFileMesh(const MitsubaSceneParser::Shape& shape)
     {
-        std::filesystem::path objPath = m_SceneParser.sceneDirectory / shape.filename;
+        RenderMesh mesh;
 
+        // Shapes that reference the same file share its geometry
+        auto [cached, isNew] = m_FileMeshCache.try_emplace(shape.filename, 0);
+        if (isNew)
+        {
+            cached->second = AddGeometry({ m_SceneParser.sceneDirectory / shape.filename, shape.type });
+        }
+        mesh.geometry = cached->second;
+
+        mesh.worldTransform = shape.transform;  // Store model matrix
+
+        // Get material
+        if (!shape.materialRef.empty() && m_SceneParser.materials.count(shape.materialRef))
+        {
+            auto& mat = m_SceneParser.materials[shape.materialRef];
+            mesh.baseColor = mat.baseColor;
+            mesh.roughness = mat.roughness;
+            mesh.baseColorTexIdx = mat.baseColorTexture.textureIndex;
+        }
+        else if (shape.hasInlineMaterial)
+        {
+            mesh.baseColor = shape.inlineMaterial.baseColor;
+            mesh.roughness = shape.inlineMaterial.roughness;
+            mesh.baseColorTexIdx = shape.inlineMaterial.baseColorTexture.textureIndex;
+        }
+        else
+        {
+            mesh.baseColor = HMM_V3(0.5f, 0.5f, 0.5f);
+            mesh.roughness = 0.5f;
+            mesh.baseColorTexIdx = -1;
+        }
+
+        mesh.isEmitter = shape.isEmitter;
+        mesh.emission = shape.emission;
+
+        m_Meshes.push_back(mesh);
+    }
+
+    // Parse an OBJ file into local-space vertices and indices
+    static bool ReadOBJMesh(const std::filesystem::path& objPath, RasterMeshData& mesh)
+    {
         tinyobj_attrib_t attrib;
         tinyobj_shape_t* shapes = nullptr;
         size_t numShapes = 0;
         tinyobj_material_t* materials = nullptr;
         size_t numMaterials = 0;
 
-        std::filesystem::path basePath = objPath.parent_path();
-
+        // Keeps the mapped OBJ alive until parsing is done
+        OBJReaderContext reader;
         int ret = tinyobj_parse_obj(&attrib, &shapes, &numShapes, &materials, &numMaterials,
-            objPath.string().c_str(), FileReaderCallback, &basePath, TINYOBJ_FLAG_TRIANGULATE);
+            objPath.string().c_str(), FileReaderCallback, &reader, TINYOBJ_FLAG_TRIANGULATE);
 
         if (ret != TINYOBJ_SUCCESS)
         {
             log::warning("Failed to load OBJ: %s", objPath.string().c_str());
-            return;
+            return false;
         }
 
-        std::vector<GPUVertex> vertices;
-        std::vector<uint32_t> indices;
-        std::unordered_map<uint64_t, uint32_t> vertexMap;
+        VertexDedup dedup;
+        dedup.Build({ attrib.faces, attrib.num_faces },
+                    std::max({ attrib.num_vertices, attrib.num_normals, attrib.num_texcoords }));
 
-        for (unsigned int f = 0; f < attrib.num_faces; f++)
+        mesh.vertices.resize(dedup.VertexCount());
+        mesh.indices = std::move(dedup.cornerVertex);
+        for (size_t i = 0; i < mesh.vertices.size(); i++)
         {
-            tinyobj_vertex_index_t idx = attrib.faces[f];
-            uint64_t key = (uint64_t(idx.v_idx) << 40) | (uint64_t(idx.vn_idx) << 20) | uint64_t(idx.vt_idx);
+            const tinyobj_vertex_index_t& idx = attrib.faces[dedup.firstCorner[i]];
+            RasterVertex& vertex = mesh.vertices[i];
+
+            // Keep vertices in local/model space (don't pre-transform)
+            vertex.position[0] = attrib.vertices[3 * idx.v_idx + 0];
+            vertex.position[1] = attrib.vertices[3 * idx.v_idx + 1];
+            vertex.position[2] = attrib.vertices[3 * idx.v_idx + 2];
 
-            auto it = vertexMap.find(key);
-            if (it != vertexMap.end())
+            if (idx.vn_idx >= 0 && attrib.normals)
             {
-                indices.push_back(it->second);
+                HMM_Vec3 n = HMM_NormV3(HMM_V3(
+                    attrib.normals[3 * idx.vn_idx + 0],
+                    attrib.normals[3 * idx.vn_idx + 1],
+                    attrib.normals[3 * idx.vn_idx + 2]
+                ));
+                vertex.normal[0] = n.X;
+                vertex.normal[1] = n.Y;
+                vertex.normal[2] = n.Z;
             }
             else
             {
-                GPUVertex vertex;
+                vertex.normal[0] = 0.0f;
+                vertex.normal[1] = 1.0f;
+                vertex.normal[2] = 0.0f;
+            }
 
-                // Keep vertices in local/model space (don't pre-transform)
-                vertex.position[0] = attrib.vertices[3 * idx.v_idx + 0];
-                vertex.position[1] = attrib.vertices[3 * idx.v_idx + 1];
-                vertex.position[2] = attrib.vertices[3 * idx.v_idx + 2];
+            if (idx.vt_idx >= 0 && attrib.texcoords)
+            {
+                vertex.texcoord[0] = attrib.texcoords[2 * idx.vt_idx + 0];
+                vertex.texcoord[1] = attrib.texcoords[2 * idx.vt_idx + 1];
+            }
+            else
+            {
+                vertex.texcoord[0] = 0.0f;
+                vertex.texcoord[1] = 0.0f;
+            }
+        }
 
-                if (idx.vn_idx >= 0 && attrib.normals)
-                {
-                    HMM_Vec3 n = HMM_NormV3(HMM_V3(
-                        attrib.normals[3 * idx.vn_idx + 0],
-                        attrib.normals[3 * idx.vn_idx + 1],
-                        attrib.normals[3 * idx.vn_idx + 2]
-                    ));
-                    vertex.normal[0] = n.X;
-                    vertex.normal[1] = n.Y;
-                    vertex.normal[2] = n.Z;
-                }
-                else
-                {
-                    vertex.normal[0] = 0.0f;
-                    vertex.normal[1] = 1.0f;
-                    vertex.normal[2] = 0.0f;
-                }
+        tinyobj_attrib_free(&attrib);
+        tinyobj_shapes_free(shapes, numShapes);
+        tinyobj_materials_free(materials, numMaterials);
+        return true;
+    }
 
-                if (idx.vt_idx >= 0 && attrib.texcoords)
-                {
-                    vertex.texcoord[0] = attrib.texcoords[2 * idx.vt_idx + 0];
-                    vertex.texcoord[1] = attrib.texcoords[2 * idx.vt_idx + 1];
-                }
-                else
-                {
-                    vertex.texcoord[0] = 0.0f;
-                    vertex.texcoord[1] = 0.0f;
-                }
+    // Read a PLY file into local-space vertices and indices
+    static bool ReadPLYMesh(const std::filesystem::path& plyPath, RasterMeshData& mesh)
+    {
+        PLYFile ply;
+        if (!ply.Open(plyPath))
+        {
+            log::warning("Failed to load PLY: %s", plyPath.string().c_str());
+            return false;
+        }
+
+        mesh.vertices.resize(ply.VertexCount());
+        for (size_t i = 0; i < mesh.vertices.size(); i++)
+        {
+            RasterVertex& vertex = mesh.vertices[i];
+            ply.Positions().Read(i, vertex.position, 3);
 
-                uint32_t newIndex = static_cast<uint32_t>(vertices.size());
-                vertexMap[key] = newIndex;
-                vertices.push_back(vertex);
-                indices.push_back(newIndex);
+            if (ply.Normals())
+            {
+                float normal[3];
+                ply.Normals().Read(i, normal, 3);
+                HMM_Vec3 n = HMM_NormV3(HMM_V3(normal[0], normal[1], normal[2]));
+                vertex.normal[0] = n.X;
+                vertex.normal[1] = n.Y;
+                vertex.normal[2] = n.Z;
+            }
+            else
+            {
+                vertex.normal[0] = 0.0f;
+                vertex.normal[1] = 1.0f;
+                vertex.normal[2] = 0.0f;
+            }
+
+            if (ply.Texcoords())
+            {
+                ply.Texcoords().Read(i, vertex.texcoord, 2);
+            }
+            else
+            {
+                vertex.texcoord[0] = 0.0f;
+                vertex.texcoord[1] = 0.0f;
             }
         }
+        mesh.indices = std::move(ply.Indices());
+        return true;
+    }
 
-        if (vertices.empty() || indices.empty())
+    // Reorder for the vertex cache and fetch locality, then build the LOD
+    // chain. Coarser levels index the same vertices, each level in its own
+    // cache order.
+    static void OptimizeMesh(RasterMeshData& mesh)
+    {
+        const size_t vertexCount = mesh.vertices.size();
+        OptimizeVertexCache(mesh.indices, vertexCount);
+        RemapVertices(mesh.vertices, OptimizeVertexFetch(mesh.indices, vertexCount));
+
+        const RasterVertex& first = mesh.vertices.front();
+        const SimplifyVertices simplify = { first.position, first.normal, first.texcoord, sizeof(RasterVertex), vertexCount };
+        mesh.lods = BuildLODChain(simplify, mesh.indices);
+        for (size_t level = 1; level < mesh.lods.size(); level++)
         {
-            tinyobj_attrib_free(&attrib);
-            tinyobj_shapes_free(shapes, numShapes);
-            tinyobj_materials_free(materials, numMaterials);
-            return;
+            const MeshLOD& lod = mesh.lods[level];
+            OptimizeVertexCache(std::span(mesh.indices).subspan(lod.indexOffset, lod.indexCount), vertexCount);
         }
+    }
 
-        // Create GPU buffers
-        RenderMesh mesh;
-
+    void UploadGeometry(const RasterMeshData& mesh, MeshGeometry& geometry)
+    {
         nvrhi::BufferDesc vbDesc;
-        vbDesc.byteSize = sizeof(GPUVertex) * vertices.size();
+        vbDesc.byteSize = sizeof(RasterVertex) * mesh.vertices.size();
         vbDesc.isVertexBuffer = true;
         vbDesc.initialState = nvrhi::ResourceStates::VertexBuffer;
         vbDesc.keepInitialState = true;
-        mesh.vertexBuffer = GetDevice()->createBuffer(vbDesc);
-        m_CommandList->writeBuffer(mesh.vertexBuffer, vertices.data(), vbDesc.byteSize);
+        geometry.vertexBuffer = GetDevice()->createBuffer(vbDesc);
+        m_CommandList->writeBuffer(geometry.vertexBuffer, mesh.vertices.data(), vbDesc.byteSize);
 
         nvrhi::BufferDesc ibDesc;
-        ibDesc.byteSize = sizeof(uint32_t) * indices.size();
+        ibDesc.byteSize = sizeof(uint32_t) * mesh.indices.size();
         ibDesc.isIndexBuffer = true;
         ibDesc.initialState = nvrhi::ResourceStates::IndexBuffer;
         ibDesc.keepInitialState = true;
-        mesh.indexBuffer = GetDevice()->createBuffer(ibDesc);
-        m_CommandList->writeBuffer(mesh.indexBuffer, indices.data(), ibDesc.byteSize);
+        geometry.indexBuffer = GetDevice()->createBuffer(ibDesc);
+        m_CommandList->writeBuffer(geometry.indexBuffer, mesh.indices.data(), ibDesc.byteSize);
 
-        mesh.indexCount = static_cast<uint32_t>(indices.size());
-        mesh.worldTransform = shape.transform;  // Store model matrix
+        geometry.lods = mesh.lods;
 
-        // Get material
-        if (!shape.materialRef.empty() && m_SceneParser.materials.count(shape.materialRef))
+        // Sphere around the bounding box centre
+        HMM_Vec3 lower = HMM_V3(INFINITY, INFINITY, INFINITY);
+        HMM_Vec3 upper = HMM_V3(-INFINITY, -INFINITY, -INFINITY);
+        for (const RasterVertex& vertex : mesh.vertices)
         {
-            auto& mat = m_SceneParser.materials[shape.materialRef];
-            mesh.baseColor = mat.baseColor;
-            mesh.roughness = mat.roughness;
-            mesh.baseColorTexIdx = mat.baseColorTexture.textureIndex;
-        }
-        else if (shape.hasInlineMaterial)
-        {
-            mesh.baseColor = shape.inlineMaterial.baseColor;
-            mesh.roughness = shape.inlineMaterial.roughness;
-            mesh.baseColorTexIdx = shape.inlineMaterial.baseColorTexture.textureIndex;
+            for (int k = 0; k < 3; k++)
+            {
+                lower.Elements[k] = std::min(lower.Elements[k], vertex.position[k]);
+                upper.Elements[k] = std::max(upper.Elements[k], vertex.position[k]);
+            }
         }
-        else
+        geometry.boundsCenter = HMM_MulV3F(HMM_AddV3(lower, upper), 0.5f);
+        float radiusSquared = 0.0f;
+        for (const RasterVertex& vertex : mesh.vertices)
         {
-            mesh.baseColor = HMM_V3(0.5f, 0.5f, 0.5f);
-            mesh.roughness = 0.5f;
-            mesh.baseColorTexIdx = -1;
+            HMM_Vec3 offset = HMM_SubV3(HMM_V3(vertex.position[0], vertex.position[1], vertex.position[2]), geometry.boundsCenter);
+            radiusSquared = std::max(radiusSquared, HMM_LenSqrV3(offset));
         }
-
-        mesh.isEmitter = shape.isEmitter;
-        mesh.emission = shape.emission;
-
-        m_Meshes.push_back(mesh);
-
-        tinyobj_attrib_free(&attrib);
-        tinyobj_shapes_free(shapes, numShapes);
-        tinyobj_materials_free(materials, numMaterials);
+        geometry.boundsRadius = sqrtf(radiusSquared);
     }
 
-    void CreateRectangleMesh(MitsubaSceneParser::Shape& shape)
+    // Unit rectangle in the XY plane, facing +Z
+    static bool BuildRectangleMesh(RasterMeshData& mesh)
     {
         HMM_Vec3 positions[4] = {
             HMM_V3(-1.0f, -1.0f, 0.0f),
@@ -862,7 +684,8 @@ public:
         };
 
         // Keep vertices in local space (don't pre-transform)
-        std::vector<GPUVertex> vertices(4);
+        std::vector<RasterVertex>& vertices = mesh.vertices;
+        vertices.resize(4);
         for (int i = 0; i < 4; i++)
         {
             vertices[i].position[0] = positions[i].X;
@@ -875,27 +698,20 @@ public:
             vertices[i].texcoord[1] = texcoords[i].Y;
         }
 
-        std::vector<uint32_t> indices = { 0, 1, 2, 0, 2, 3 };
-
-        RenderMesh mesh;
-
-        nvrhi::BufferDesc vbDesc;
-        vbDesc.byteSize = sizeof(GPUVertex) * vertices.size();
-        vbDesc.isVertexBuffer = true;
-        vbDesc.initialState = nvrhi::ResourceStates::VertexBuffer;
-        vbDesc.keepInitialState = true;
-        mesh.vertexBuffer = GetDevice()->createBuffer(vbDesc);
-        m_CommandList->writeBuffer(mesh.vertexBuffer, vertices.data(), vbDesc.byteSize);
+        mesh.indices = { 0, 1, 2, 0, 2, 3 };
+        return true;
+    }
 
-        nvrhi::BufferDesc ibDesc;
-        ibDesc.byteSize = sizeof(uint32_t) * indices.size();
-        ibDesc.isIndexBuffer = true;
-        ibDesc.initialState = nvrhi::ResourceStates::IndexBuffer;
-        ibDesc.keepInitialState = true;
-        mesh.indexBuffer = GetDevice()->createBuffer(ibDesc);
-        m_CommandList->writeBuffer(mesh.indexBuffer, indices.data(), ibDesc.byteSize);
+    void CreateRectangleMesh(const MitsubaSceneParser::Shape& shape)
+    {
+        // Every rectangle shares one geometry
+        if (m_RectangleGeometry == UINT32_MAX)
+        {
+            m_RectangleGeometry = AddGeometry({ {}, "rectangle" });
+        }
 
-        mesh.indexCount = 6;
+        RenderMesh mesh;
+        mesh.geometry = m_RectangleGeometry;
         mesh.worldTransform = shape.transform;  // Store model matrix
 
         if (shape.hasInlineMaterial)
@@ -1026,7 +842,10 @@ public:
         
         m_CameraTarget = HMM_AddV3(m_CameraPosition, forward);
         
-        GetDeviceManager()->SetInformativeWindowTitle(g_WindowTitle);
+        char lodInfo[128];
+        snprintf(lodInfo, sizeof(lodInfo), "LOD %.1f px: %.2fM of %.2fM triangles", m_LODErrorPixels,
+            double(m_DrawnTriangles) * 1e-6, double(m_FullTriangles) * 1e-6);
+        GetDeviceManager()->SetInformativeWindowTitle(g_WindowTitle, true, lodInfo);
     }
 
     void BackBufferResizing() override
@@ -1090,13 +909,16 @@ public:
         // Use HMM right-handed perspective with [0,1] depth range for D3D/Vulkan
         // RH: camera looks down -Z, which matches Mitsuba convention
         HMM_Mat4 view = HMM_LookAt_RH(m_CameraPosition, m_CameraTarget, HMM_V3(0.0f, 1.0f, 0.0f));
-        HMM_Mat4 proj = HMM_Perspective_RH_ZO(verticalFovRadians, aspect, 0.1f, 10000.0f);
+        HMM_Mat4 proj = HMM_Perspective_RH_ZO(verticalFovRadians, aspect, g_NearPlane, 10000.0f);
         
         // For column-vector convention: VP = Proj * View
         // HMM uses column-vector math: v' = M * v
         // So MVP = Proj * View * Model, applied as v_clip = MVP * v_local
         HMM_Mat4 viewProj = HMM_MulM4(proj, view);  // P * V
 
+        // Pixels covered by one world unit, one unit in front of the camera
+        float pixelsPerUnit = float(fbinfo.height) / (2.0f * tanf(verticalFovRadians * 0.5f));
+
         m_CommandList->open();
 
         // Clear framebuffer
@@ -1163,8 +985,15 @@ public:
         }
 
         // Render each mesh
+        m_DrawnTriangles = 0;
+        m_FullTriangles = 0;
         for (auto& mesh : m_Meshes)
         {
+            const MeshGeometry& geometry = m_Geometries[mesh.geometry];
+            const MeshLOD& lod = SelectLOD(geometry, mesh.worldTransform, pixelsPerUnit);
+            m_DrawnTriangles += lod.indexCount / 3;
+            m_FullTriangles += geometry.lods.front().indexCount / 3;
+
             // Calculate MVP = Proj * View * Model (column-vector convention)
             // v_clip = MVP * v_local = P * V * M * v
             HMM_Mat4 mvp = HMM_MulM4(viewProj, mesh.worldTransform);  // (P * V) * M = P * V * M
@@ -1222,19 +1051,49 @@ public:
             state.pipeline = m_Pipeline;
             state.framebuffer = renderFramebuffer;
             state.bindings = { bindingSet };
-            state.vertexBuffers = { { mesh.vertexBuffer, 0, 0 } };
-            state.indexBuffer = { mesh.indexBuffer, nvrhi::Format::R32_UINT, 0 };
+            state.vertexBuffers = { { geometry.vertexBuffer, 0, 0 } };
+            state.indexBuffer = { geometry.indexBuffer, nvrhi::Format::R32_UINT, 0 };
             state.viewport.addViewportAndScissorRect(renderFramebuffer->getFramebufferInfo().getViewport());
 
             m_CommandList->setGraphicsState(state);
 
             nvrhi::DrawArguments args;
-            args.vertexCount = mesh.indexCount;
+            args.vertexCount = lod.indexCount;
+            args.startIndexLocation = lod.indexOffset;
             m_CommandList->drawIndexed(args);
         }
 
         m_CommandList->close();
         GetDevice()->executeCommandList(m_CommandList);
+
+        if (!m_LODReported && m_FullTriangles > 0)
+        {
+            log::info("LOD at %.1f px error: drawing %zu of %zu triangles (%.1f%%)", m_LODErrorPixels,
+                m_DrawnTriangles, m_FullTriangles, 100.0 * double(m_DrawnTriangles) / double(m_FullTriangles));
+            m_LODReported = true;
+        }
+    }
+
+    // Coarsest level whose error, seen from the camera at the near side of
+    // the mesh's bounding sphere, covers at most m_LODErrorPixels. The
+    // largest axis scale of the transform bounds how far it stretches the
+    // error; inside the sphere the distance clamps to the near plane.
+    const MeshLOD& SelectLOD(const MeshGeometry& geometry, const HMM_Mat4& worldTransform, float pixelsPerUnit) const
+    {
+        float scale = sqrtf(std::max({ HMM_LenSqrV3(worldTransform.Columns[0].XYZ),
+                                       HMM_LenSqrV3(worldTransform.Columns[1].XYZ),
+                                       HMM_LenSqrV3(worldTransform.Columns[2].XYZ) }));
+        HMM_Vec3 center = HMM_MulM4V4(worldTransform, HMM_V4V(geometry.boundsCenter, 1.0f)).XYZ;
+        float distance = HMM_LenV3(HMM_SubV3(center, m_CameraPosition)) - geometry.boundsRadius * scale;
+        float pixelsPerObjectUnit = scale * pixelsPerUnit / std::max(distance, g_NearPlane);
+
+        size_t level = 0;
+        while (level + 1 < geometry.lods.size()
+               && geometry.lods[level + 1].error * pixelsPerObjectUnit <= m_LODErrorPixels)
+        {
+            level++;
+        }
+        return geometry.lods[level];
     }
 };
 
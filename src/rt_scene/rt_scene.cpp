@@ -18,939 +18,38 @@
 namespace dm = donut::math;
 #endif
 
-#include <pugixml.hpp>
+// Scene loading (parser, OBJ ingest, GPU packing)
+#include "../scene_core/mitsuba_parser.h"
+#include "../scene_core/scene_geometry.h"
+#include "../scene_core/scene_cache.h"
+#include "../common/file_watcher.h"
 
-#define HANDMADE_MATH_USE_RADIANS
-#include "HandmadeMath.h"
-
-#define TINYOBJ_LOADER_C_IMPLEMENTATION
-#include <tinyobj_loader_c.h>
-
-// Texture loading utilities
-#include "../common/texture_utils.h"
-
-#include <filesystem>
-#include <unordered_map>
-#include <unordered_set>
-#include <sstream>
-#include <cmath>
-
-using namespace donut;
-
-static const char* g_WindowTitle = "Donut Example: Mitsuba Scene Ray Tracer";
-
-// ============================================================================
-// Material Types (matching Mitsuba BSDF types)
-// ============================================================================
-enum class MaterialType : uint32_t
-{
-    Diffuse = 0,
-    Conductor = 1,
-    RoughConductor = 2,
-    Dielectric = 3,
-    RoughDielectric = 4,
-    Plastic = 5,
-    RoughPlastic = 6,
-    ThinDielectric = 7,
-    Principled = 8,
-    Blend = 9,
-    Mask = 10,
-    Null = 11
-};
-
-// ============================================================================
-// GPU Structures (must match HLSL) - using plain floats for GPU compatibility
-// ============================================================================
-struct GPUMaterial
-{
-    float baseColor[3];
-    float roughness;
-    
-    float eta[3];          // For conductors: complex IOR real part
-    float metallic;
-    
-    float k[3];            // For conductors: complex IOR imaginary part
-    uint32_t type;
-    
-    float intIOR;          // Interior index of refraction
-    float extIOR;          // Exterior index of refraction
-    int32_t baseColorTexIdx;   // -1 if no texture
-    int32_t roughnessTexIdx;   // -1 if no texture
-    
-    int32_t normalTexIdx;      // -1 if no texture
-    
-    // Principled BSDF parameters
-    float specular;        // Specular intensity
-    float specTint;        // Tint specular towards base color
-    float sheen;           // Sheen intensity
-    
-    float sheenTint;       // Tint sheen towards base color
-    float clearcoat;       // Clearcoat intensity
-    float clearcoatGloss;  // Clearcoat glossiness
-    float specTrans;       // Specular transmission
-    
-    // Mask/Blend parameters
-    float opacity;         // Opacity for mask material
-    float blendWeight;     // Blend weight for blendbsdf
-    float nonlinear;       // Nonlinear mode for plastic (0 or 1)
-    float padding;
-};
-
-struct GPUVertex
-{
-    float position[3];
-    float pad0;
-    float normal[3];
-    float pad1;
-    float texcoord[2];
-    float pad2[2];
-};
-
-struct GPUInstance
-{
-    uint32_t vertexOffset;
-    uint32_t indexOffset;
-    uint32_t materialIndex;
-    uint32_t isEmitter;
-    float emission[3];
-    float pad;
-};
-
-struct CameraConstants
-{
-    float viewInverse[16];   // column-major 4x4 matrix
-    float projInverse[16];   // column-major 4x4 matrix
-    float cameraPosition[3];
-    uint32_t frameIndex;
-    uint32_t samplesPerPixel;
-    uint32_t maxBounces;
-    float envMapIntensity;
-    uint32_t hasEnvMap;
-    float exposure;          // Exposure control for tone mapping
-    float padding[3];        // Padding to align to 16 bytes
-};
-
-// ============================================================================
-// Mitsuba Scene Parser - using HandmadeMath
-// ============================================================================
-class MitsubaSceneParser
-{
-public:
-    struct Camera
-    {
-        HMM_Mat4 transform = HMM_M4D(1.0f);  // Identity matrix
-        float fov = 45.0f;
-        int width = 1280;
-        int height = 720;
-    };
-
-    // Texture reference structure
-    struct TextureRef
-    {
-        std::string filename;
-        bool isValid = false;
-        int textureIndex = -1;  // Index into loaded textures array
-    };
-
-    struct Material
-    {
-        std::string id;
-        MaterialType type = MaterialType::Diffuse;
-        HMM_Vec3 baseColor = HMM_V3(0.5f, 0.5f, 0.5f);  // Mitsuba default: 0.5
-        float roughness = 0.1f;   // Mitsuba default alpha: 0.1 (NOT 0.5!)
-        HMM_Vec3 eta = HMM_V3(1.0f, 1.0f, 1.0f);
-        HMM_Vec3 k = HMM_V3(0.0f, 0.0f, 0.0f);
-        float intIOR = 1.5046f;   // Mitsuba default: bk7 (1.5046)
-        float extIOR = 1.000277f; // Mitsuba default: air (1.000277)
-        float metallic = 0.0f;
-        
-        // Principled BSDF parameters
-        float specular = 0.5f;
-        float specTint = 0.0f;
-        float sheen = 0.0f;
-        float sheenTint = 0.0f;
-        float clearcoat = 0.0f;
-        float clearcoatGloss = 0.0f;
-        float specTrans = 0.0f;
-        
-        // Mask/Blend parameters
-        float opacity = 1.0f;
-        float blendWeight = 0.5f;
-        
-        // Plastic-specific parameters
-        bool nonlinear = false;  // Mitsuba default: false (preserve texture colors)
-        
-        // Texture references
-        TextureRef baseColorTexture;
-        TextureRef roughnessTexture;
-        TextureRef normalTexture;
-    };
-    
-    // Environment map structure
-    struct EnvironmentMapInfo
-    {
-        std::string filename;
-        float intensity = 1.0f;
-        bool isValid = false;
-    };
-
-    struct Shape
-    {
-        std::string type;           // "obj" or "rectangle"
-        std::string filename;       // OBJ filename
-        std::string materialRef;    // Reference to material ID
-        HMM_Mat4 transform = HMM_M4D(1.0f);  // Identity matrix
-        bool isEmitter = false;
-        HMM_Vec3 emission = HMM_V3(0.0f, 0.0f, 0.0f);
-        
-        // For inline materials
-        Material inlineMaterial;
-        bool hasInlineMaterial = false;
-    };
-
-    Camera camera;
-    std::unordered_map<std::string, Material> materials;
-    std::vector<Shape> shapes;
-    std::filesystem::path sceneDirectory;
-    
-    // Environment map
-    EnvironmentMapInfo environmentMap;
-    
-    // Loaded textures (indexed by material texture references)
-    std::unordered_map<std::string, int> textureIndexMap;
-    std::vector<texture_utils::TextureData> loadedTextures;
-
-    bool Parse(const std::filesystem::path& xmlPath)
-    {
-        sceneDirectory = xmlPath.parent_path();
-
-        pugi::xml_document doc;
-        pugi::xml_parse_result result = doc.load_file(xmlPath.c_str());
-
-        if (!result)
-        {
-            log::error("Failed to parse XML file: %s", result.description());
-            return false;
-        }
-
-        pugi::xml_node sceneNode = doc.child("scene");
-        if (!sceneNode)
-        {
-            log::error("No <scene> node found in XML");
-            return false;
-        }
-
-        // Parse all children
-        for (pugi::xml_node node : sceneNode.children())
-        {
-            std::string nodeName = node.name();
-
-            if (nodeName == "sensor")
-            {
-                ParseSensor(node);
-            }
-            else if (nodeName == "bsdf")
-            {
-                Material mat = ParseBSDF(node);
-                if (!mat.id.empty())
-                {
-                    materials[mat.id] = mat;
-                }
-            }
-            else if (nodeName == "shape")
-            {
-                ParseShape(node);
-            }
-            else if (nodeName == "emitter")
-            {
-                ParseEmitter(node);
-            }
-            else if (nodeName == "texture")
-            {
-                ParseTextureDefinition(node);
-            }
-        }
-
-        // Load all referenced textures
-        LoadReferencedTextures();
-
-        log::info("Parsed %zu materials, %zu shapes, %zu textures", 
-            materials.size(), shapes.size(), loadedTextures.size());
-        
-        // Debug: print material types
-        for (auto& [id, mat] : materials)
-        {
-            const char* typeNames[] = {
-                "Diffuse", "Conductor", "RoughConductor", "Dielectric", "RoughDielectric", 
-                "Plastic", "RoughPlastic", "ThinDielectric", "Principled", "Blend", "Mask", "Null"
-            };
-            uint32_t typeIdx = static_cast<uint32_t>(mat.type);
-            const char* typeName = (typeIdx < 12) ? typeNames[typeIdx] : "Unknown";
-            log::info("  Material '%s': type=%s, roughness=%.3f, baseColor=(%.2f,%.2f,%.2f), intIOR=%.2f, extIOR=%.2f, texIdx=%d, nonlinear=%s",
-                id.c_str(), typeName, mat.roughness, 
-                mat.baseColor.X, mat.baseColor.Y, mat.baseColor.Z,
-                mat.intIOR, mat.extIOR,
-                mat.baseColorTexture.textureIndex,
-                mat.nonlinear ? "true" : "false");
-        }
-        if (environmentMap.isValid)
-        {
-            log::info("Environment map: %s (intensity: %.2f)", 
-                environmentMap.filename.c_str(), environmentMap.intensity);
-        }
-        return true;
-    }
-
-private:
-    // Parse a 4x4 matrix from Mitsuba format to HMM column-major storage
-    // Mitsuba XML text order: m00 m01 m02 m03  m10 m11 m12 m13  m20 m21 m22 m23  m30 m31 m32 m33
-    // HMM stores column-major: Columns[j] contains (m0j, m1j, m2j, m3j)
-    HMM_Mat4 ParseMatrix(const std::string& matrixStr)
-    {
-        std::istringstream iss(matrixStr);
-        float values[16];
-        for (int i = 0; i < 16; i++)
-        {
-            iss >> values[i];
-        }
-        
-        // Map Mitsuba matrix to HMM columns:
-        // Column j gets all elements m[i][j] for i=0..3
-        HMM_Mat4 result;
-        result.Columns[0] = HMM_V4(values[0], values[4], values[8],  values[12]); // m00,m10,m20,m30
-        result.Columns[1] = HMM_V4(values[1], values[5], values[9],  values[13]); // m01,m11,m21,m31
-        result.Columns[2] = HMM_V4(values[2], values[6], values[10], values[14]); // m02,m12,m22,m32
-        result.Columns[3] = HMM_V4(values[3], values[7], values[11], values[15]); // m03,m13,m23,m33
-        return result;
-    }
-
-    // Parse RGB color from "r, g, b" format
-    HMM_Vec3 ParseRGB(const std::string& rgbStr)
-    {
-        HMM_Vec3 color = HMM_V3(0.0f, 0.0f, 0.0f);
-        std::string cleaned = rgbStr;
-        // Remove commas
-        for (char& c : cleaned)
-        {
-            if (c == ',') c = ' ';
-        }
-        std::istringstream iss(cleaned);
-        iss >> color.X >> color.Y >> color.Z;
-        return color;
-    }
-
-    void ParseSensor(pugi::xml_node sensorNode)
-    {
-        // Parse FOV
-        for (pugi::xml_node child : sensorNode.children("float"))
-        {
-            std::string name = child.attribute("name").value();
-            if (name == "fov")
-            {
-                camera.fov = child.attribute("value").as_float(45.0f);
-            }
-        }
-
-        // Parse transform
-        pugi::xml_node transformNode = sensorNode.child("transform");
-        if (transformNode)
-        {
-            pugi::xml_node matrixNode = transformNode.child("matrix");
-            if (matrixNode)
-            {
-                camera.transform = ParseMatrix(matrixNode.attribute("value").value());
-            }
-        }
-
-        // Parse film (resolution)
-        pugi::xml_node filmNode = sensorNode.child("film");
-        if (filmNode)
-        {
-            for (pugi::xml_node child : filmNode.children("integer"))
-            {
-                std::string name = child.attribute("name").value();
-                if (name == "width")
-                {
-                    camera.width = child.attribute("value").as_int(1280);
-                }
-                else if (name == "height")
-                {
-                    camera.height = child.attribute("value").as_int(720);
-                }
-            }
-        }
-    }
-
-    Material ParseBSDF(pugi::xml_node bsdfNode, bool nested = false)
-    {
-        Material mat;
-        
-        if (!nested)
-        {
-            mat.id = bsdfNode.attribute("id").value();
-        }
-
-        std::string type = bsdfNode.attribute("type").value();
-
-        // Handle twosided wrapper
-        if (type == "twosided")
-        {
-            pugi::xml_node innerBsdf = bsdfNode.child("bsdf");
-            if (innerBsdf)
-            {
-                Material innerMat = ParseBSDF(innerBsdf, true);
-                innerMat.id = mat.id;
-                return innerMat;
-            }
-        }
-
-        // Set material type
-        if (type == "diffuse")
-        {
-            mat.type = MaterialType::Diffuse;
-            mat.roughness = 1.0f;  // Lambertian diffuse - roughness doesn't apply
-            mat.baseColor = HMM_V3(0.5f, 0.5f, 0.5f);  // Mitsuba default reflectance
-        }
-        else if (type == "conductor")
-        {
-            mat.type = MaterialType::Conductor;
-            mat.roughness = 0.0f;
-            mat.baseColor = HMM_V3(1.0f, 1.0f, 1.0f);
-        }
-        else if (type == "roughconductor")
-        {
-            mat.type = MaterialType::RoughConductor;
-            mat.roughness = 0.1f;  // Mitsuba default alpha
-            mat.baseColor = HMM_V3(1.0f, 1.0f, 1.0f);  // Default specular reflectance
-        }
-        else if (type == "dielectric")
-        {
-            mat.type = MaterialType::Dielectric;
-            mat.roughness = 0.0f;
-        }
-        else if (type == "roughdielectric")
-        {
-            mat.type = MaterialType::RoughDielectric;
-            mat.roughness = 0.1f;  // Mitsuba default alpha
-        }
-        else if (type == "plastic")
-        {
-            mat.type = MaterialType::Plastic;
-            mat.roughness = 0.0f;  // Smooth plastic
-            mat.intIOR = 1.49f;    // Mitsuba default: polypropylene
-        }
-        else if (type == "roughplastic")
-        {
-            mat.type = MaterialType::RoughPlastic;
-            mat.roughness = 0.1f;  // Mitsuba default alpha
-            mat.intIOR = 1.49f;    // Mitsuba default: polypropylene
-        }
-        else if (type == "thindielectric")
-        {
-            mat.type = MaterialType::ThinDielectric;
-            mat.roughness = 0.0f;
-        }
-        else if (type == "principled")
-        {
-            mat.type = MaterialType::Principled;
-            mat.specular = 0.5f;  // Default specular
-        }
-        else if (type == "blendbsdf")
-        {
-            mat.type = MaterialType::Blend;
-            mat.blendWeight = 0.5f;
-        }
-        else if (type == "mask")
-        {
-            mat.type = MaterialType::Mask;
-            mat.opacity = 0.5f;
-        }
-        else if (type == "null")
-        {
-            mat.type = MaterialType::Null;
-        }
-
-        // Parse material properties
-        for (pugi::xml_node child : bsdfNode.children())
-        {
-            std::string childName = child.name();
-            std::string propName = child.attribute("name").value();
-
-            if (childName == "rgb" || childName == "spectrum")
-            {
-                HMM_Vec3 color = ParseRGB(child.attribute("value").value());
-                if (propName == "reflectance" || propName == "diffuse_reflectance" || 
-                    propName == "specular_reflectance" || propName == "base_color")
-                {
-                    mat.baseColor = color;
-                }
-                else if (propName == "eta")
-                {
-                    mat.eta = color;
-                }
-                else if (propName == "k")
-                {
-                    mat.k = color;
-                }
-            }
-            else if (childName == "float")
-            {
-                float value = child.attribute("value").as_float();
-                if (propName == "alpha")
-                {
-                    // Mitsuba's alpha is the GGX roughness directly
-                    // Our shader squares roughness to get alpha, so we take sqrt here
-                    // to get the correct final alpha value
-                    mat.roughness = sqrtf(value);
-                }
-                else if (propName == "roughness")
-                {
-                    mat.roughness = value;
-                }
-                else if (propName == "int_ior")
-                {
-                    mat.intIOR = value;
-                }
-                else if (propName == "ext_ior")
-                {
-                    mat.extIOR = value;
-                }
-                else if (propName == "eta")
-                {
-                    // Scalar eta for dielectrics
-                    mat.intIOR = value;
-                }
-                // Principled BSDF parameters
-                else if (propName == "metallic")
-                {
-                    mat.metallic = value;
-                }
-                else if (propName == "specular")
-                {
-                    mat.specular = value;
-                }
-                else if (propName == "spec_tint")
-                {
-                    mat.specTint = value;
-                }
-                else if (propName == "sheen")
-                {
-                    mat.sheen = value;
-                }
-                else if (propName == "sheen_tint")
-                {
-                    mat.sheenTint = value;
-                }
-                else if (propName == "clearcoat")
-                {
-                    mat.clearcoat = value;
-                }
-                else if (propName == "clearcoat_gloss")
-                {
-                    mat.clearcoatGloss = value;
-                }
-                else if (propName == "spec_trans")
-                {
-                    mat.specTrans = value;
-                }
-                // Mask/Blend parameters
-                else if (propName == "opacity")
-                {
-                    mat.opacity = value;
-                }
-                else if (propName == "weight")
-                {
-                    mat.blendWeight = value;
-                }
-            }
-            else if (childName == "string")
-            {
-                std::string value = child.attribute("value").value();
-                if (propName == "material")
-                {
-                    // Mitsuba conductor material presets
-                    // Reference: https://mitsuba.readthedocs.io/en/stable/src/generated/plugins_bsdfs.html
-                    if (value == "none")
-                    {
-                        // Perfect mirror - 100% reflective
-                        mat.eta = HMM_V3(0.0f, 0.0f, 0.0f);
-                        mat.k = HMM_V3(0.0f, 0.0f, 0.0f);
-                    }
-                    else if (value == "Ag" || value == "silver")
-                    {
-                        mat.eta = HMM_V3(0.155f, 0.117f, 0.138f);
-                        mat.k = HMM_V3(4.827f, 3.122f, 2.147f);
-                    }
-                    else if (value == "Au" || value == "gold")
-                    {
-                        mat.eta = HMM_V3(0.143f, 0.374f, 1.442f);
-                        mat.k = HMM_V3(3.983f, 2.387f, 1.603f);
-                    }
-                    else if (value == "Cu" || value == "copper")
-                    {
-                        mat.eta = HMM_V3(0.200f, 0.924f, 1.102f);
-                        mat.k = HMM_V3(3.912f, 2.452f, 2.142f);
-                    }
-                    else if (value == "Al" || value == "aluminium" || value == "aluminum")
-                    {
-                        mat.eta = HMM_V3(1.657f, 0.880f, 0.521f);
-                        mat.k = HMM_V3(9.224f, 6.269f, 4.837f);
-                    }
-                    else if (value == "Cr" || value == "chromium")
-                    {
-                        mat.eta = HMM_V3(3.180f, 3.180f, 2.010f);
-                        mat.k = HMM_V3(3.300f, 3.330f, 3.040f);
-                    }
-                    else if (value == "Ni" || value == "nickel")
-                    {
-                        mat.eta = HMM_V3(1.970f, 1.860f, 1.670f);
-                        mat.k = HMM_V3(3.740f, 3.060f, 2.580f);
-                    }
-                    else if (value == "Ti" || value == "titanium")
-                    {
-                        mat.eta = HMM_V3(2.160f, 1.970f, 1.810f);
-                        mat.k = HMM_V3(2.930f, 2.620f, 2.350f);
-                    }
-                    else if (value == "W" || value == "tungsten")
-                    {
-                        mat.eta = HMM_V3(4.350f, 3.400f, 2.850f);
-                        mat.k = HMM_V3(3.400f, 2.700f, 2.150f);
-                    }
-                    else if (value == "Fe" || value == "iron")
-                    {
-                        mat.eta = HMM_V3(2.950f, 2.930f, 2.650f);
-                        mat.k = HMM_V3(3.000f, 2.950f, 2.800f);
-                    }
-                    // Add more presets as needed
-                }
-                // Mitsuba dielectric IOR presets (for int_ior / ext_ior)
-                else if (propName == "int_ior" || propName == "ext_ior")
-                {
-                    float ior = 1.0f;
-                    // Mitsuba IOR preset table
-                    if (value == "vacuum")              ior = 1.0f;
-                    else if (value == "helium")         ior = 1.00004f;
-                    else if (value == "hydrogen")       ior = 1.00013f;
-                    else if (value == "air")            ior = 1.000277f;
-                    else if (value == "carbon dioxide") ior = 1.00045f;
-                    else if (value == "water")          ior = 1.333f;
-                    else if (value == "acetone")        ior = 1.36f;
-                    else if (value == "ethanol")        ior = 1.361f;
-                    else if (value == "carbon tetrachloride") ior = 1.461f;
-                    else if (value == "glycerol")       ior = 1.4729f;
-                    else if (value == "benzene")        ior = 1.501f;
-                    else if (value == "silicone oil")   ior = 1.52045f;
-                    else if (value == "bromine")        ior = 1.661f;
-                    else if (value == "water ice")      ior = 1.31f;
-                    else if (value == "fused quartz")   ior = 1.458f;
-                    else if (value == "pyrex")          ior = 1.470f;
-                    else if (value == "acrylic glass")  ior = 1.49f;
-                    else if (value == "polypropylene")  ior = 1.49f;
-                    else if (value == "bk7")            ior = 1.5046f;
-                    else if (value == "sodium chloride") ior = 1.544f;
-                    else if (value == "amber")          ior = 1.55f;
-                    else if (value == "pet")            ior = 1.575f;
-                    else if (value == "diamond")        ior = 2.419f;
-                    
-                    if (propName == "int_ior") mat.intIOR = ior;
-                    else mat.extIOR = ior;
-                }
-            }
-            else if (childName == "texture")
-            {
-                // Parse texture reference
-                TextureRef texRef = ParseTextureRef(child);
-                if (texRef.isValid)
-                {
-                    if (propName == "reflectance" || propName == "diffuse_reflectance")
-                    {
-                        mat.baseColorTexture = texRef;
-                    }
-                    else if (propName == "alpha" || propName == "roughness")
-                    {
-                        mat.roughnessTexture = texRef;
-                    }
-                }
-            }
-            else if (childName == "boolean")
-            {
-                std::string value = child.attribute("value").value();
-                bool boolValue = (value == "true" || value == "1");
-                if (propName == "nonlinear")
-                {
-                    mat.nonlinear = boolValue;
-                }
-            }
-        }
-
-        return mat;
-    }
-
-    void ParseShape(pugi::xml_node shapeNode)
-    {
-        Shape shape;
-        shape.type = shapeNode.attribute("type").value();
-
-        // Parse transform
-        pugi::xml_node transformNode = shapeNode.child("transform");
-        if (transformNode)
-        {
-            pugi::xml_node matrixNode = transformNode.child("matrix");
-            if (matrixNode)
-            {
-                shape.transform = ParseMatrix(matrixNode.attribute("value").value());
-            }
-        }
-
-        // Parse OBJ filename
-        for (pugi::xml_node child : shapeNode.children("string"))
-        {
-            std::string name = child.attribute("name").value();
-            if (name == "filename")
-            {
-                shape.filename = child.attribute("value").value();
-            }
-        }
-
-        // Parse material reference
-        pugi::xml_node refNode = shapeNode.child("ref");
-        if (refNode)
-        {
-            shape.materialRef = refNode.attribute("id").value();
-        }
-
-        // Parse inline BSDF
-        pugi::xml_node inlineBsdf = shapeNode.child("bsdf");
-        if (inlineBsdf)
-        {
-            shape.inlineMaterial = ParseBSDF(inlineBsdf, true);
-            shape.hasInlineMaterial = true;
-        }
-
-        // Parse emitter
-        pugi::xml_node emitterNode = shapeNode.child("emitter");
-        if (emitterNode)
-        {
-            shape.isEmitter = true;
-            for (pugi::xml_node child : emitterNode.children("rgb"))
-            {
-                std::string name = child.attribute("name").value();
-                if (name == "radiance")
-                {
-                    shape.emission = ParseRGB(child.attribute("value").value());
-                }
-            }
-        }
-
-        shapes.push_back(shape);
-    }
-
-    // Parse global emitter (environment map)
-    void ParseEmitter(pugi::xml_node emitterNode)
-    {
-        std::string type = emitterNode.attribute("type").value();
-        
-        // Environment map emitter
-        if (type == "envmap")
-        {
-            for (pugi::xml_node child : emitterNode.children("string"))
-            {
-                std::string name = child.attribute("name").value();
-                if (name == "filename")
-                {
-                    environmentMap.filename = child.attribute("value").value();
-                    environmentMap.isValid = true;
-                }
-            }
-            
-            for (pugi::xml_node child : emitterNode.children("float"))
-            {
-                std::string name = child.attribute("name").value();
-                if (name == "scale")
-                {
-                    environmentMap.intensity = child.attribute("value").as_float(1.0f);
-                }
-            }
-            
-            // Also check for intensity in rgb format
-            for (pugi::xml_node child : emitterNode.children("rgb"))
-            {
-                std::string name = child.attribute("name").value();
-                if (name == "scale")
-                {
-                    HMM_Vec3 scale = ParseRGB(child.attribute("value").value());
-                    environmentMap.intensity = (scale.X + scale.Y + scale.Z) / 3.0f;
-                }
-            }
-            
-            log::info("Found environment map: %s", environmentMap.filename.c_str());
-        }
-        // Constant environment
-        else if (type == "constant")
-        {
-            // Could be extended to support constant environment color
-        }
-    }
-    
-    // Parse standalone texture definition
-    void ParseTextureDefinition(pugi::xml_node textureNode)
-    {
-        std::string id = textureNode.attribute("id").value();
-        std::string type = textureNode.attribute("type").value();
-        
-        if (type == "bitmap")
-        {
-            for (pugi::xml_node child : textureNode.children("string"))
-            {
-                std::string name = child.attribute("name").value();
-                if (name == "filename")
-                {
-                    std::string filename = child.attribute("value").value();
-                    // Store for later loading
-                    textureIndexMap[id] = -1;  // Will be updated when loaded
-                    log::info("Found texture definition: %s -> %s", id.c_str(), filename.c_str());
-                }
-            }
-        }
-    }
-    
-    // Parse texture reference in BSDF
-    TextureRef ParseTextureRef(pugi::xml_node textureNode)
-    {
-        TextureRef ref;
-        std::string type = textureNode.attribute("type").value();
-        
-        if (type == "bitmap")
-        {
-            for (pugi::xml_node child : textureNode.children("string"))
-            {
-                std::string name = child.attribute("name").value();
-                if (name == "filename")
-                {
-                    ref.filename = child.attribute("value").value();
-                    ref.isValid = true;
-                }
-            }
-        }
-        else if (type == "ref")
-        {
-            // Reference to a standalone texture definition
-            std::string refId = textureNode.attribute("id").value();
-            if (textureIndexMap.find(refId) != textureIndexMap.end())
-            {
-                ref.isValid = true;
-                // Filename will be resolved later
-            }
-        }
-        
-        return ref;
-    }
-    
-    // Load all referenced textures
-    void LoadReferencedTextures()
-    {
-        std::unordered_set<std::string> textureFiles;
-        
-        // Collect texture filenames from materials
-        for (auto& [id, mat] : materials)
-        {
-            if (mat.baseColorTexture.isValid && !mat.baseColorTexture.filename.empty())
-            {
-                textureFiles.insert(mat.baseColorTexture.filename);
-            }
-            if (mat.roughnessTexture.isValid && !mat.roughnessTexture.filename.empty())
-            {
-                textureFiles.insert(mat.roughnessTexture.filename);
-            }
-            if (mat.normalTexture.isValid && !mat.normalTexture.filename.empty())
-            {
-                textureFiles.insert(mat.normalTexture.filename);
-            }
-        }
-        
-        // Load each unique texture
-        for (const auto& filename : textureFiles)
-        {
-            std::filesystem::path texturePath = sceneDirectory / filename;
-            texture_utils::TextureData texData = texture_utils::LoadTexture(texturePath);
-            
-            if (texData.IsValid())
-            {
-                int index = static_cast<int>(loadedTextures.size());
-                textureIndexMap[filename] = index;
-                loadedTextures.push_back(std::move(texData));
-                log::info("Loaded texture [%d]: %s (%dx%d)", index, filename.c_str(), texData.width, texData.height);
-            }
-            else
-            {
-                log::error("Failed to load texture: %s", texturePath.string().c_str());
-            }
-        }
-        
-        // Update material texture indices
-        for (auto& [id, mat] : materials)
-        {
-            if (mat.baseColorTexture.isValid && !mat.baseColorTexture.filename.empty())
-            {
-                auto it = textureIndexMap.find(mat.baseColorTexture.filename);
-                if (it != textureIndexMap.end())
-                {
-                    mat.baseColorTexture.textureIndex = it->second;
-                }
-            }
-            if (mat.roughnessTexture.isValid && !mat.roughnessTexture.filename.empty())
-            {
-                auto it = textureIndexMap.find(mat.roughnessTexture.filename);
-                if (it != textureIndexMap.end())
-                {
-                    mat.roughnessTexture.textureIndex = it->second;
-                }
-            }
-            if (mat.normalTexture.isValid && !mat.normalTexture.filename.empty())
-            {
-                auto it = textureIndexMap.find(mat.normalTexture.filename);
-                if (it != textureIndexMap.end())
-                {
-                    mat.normalTexture.textureIndex = it->second;
-                }
-            }
-        }
-    }
-};
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace donut;
+
+static const char* g_WindowTitle = "Donut Example: Mitsuba Scene Ray Tracer";
 
 // ============================================================================
-// OBJ Loader Callback for tinyobjloader-c
+// GPU Structures (must match HLSL)
+// GPUMaterial/GPUVertex/GPUInstance live in scene_core/scene_geometry.h
 // ============================================================================
-static void FileReaderCallback(void* ctx, const char* filename, int is_mtl, 
-                               const char* obj_filename, char** buf, size_t* len)
+struct CameraConstants
 {
-    std::filesystem::path* basePath = static_cast<std::filesystem::path*>(ctx);
-    std::filesystem::path fullPath = *basePath / filename;
-
-    FILE* file = nullptr;
-#ifdef _WIN32
-    fopen_s(&file, fullPath.string().c_str(), "rb");
-#else
-    file = fopen(fullPath.string().c_str(), "rb");
-#endif
-
-    if (!file)
-    {
-        *buf = nullptr;
-        *len = 0;
-        return;
-    }
-
-    fseek(file, 0, SEEK_END);
-    long fileSize = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    *buf = static_cast<char*>(malloc(fileSize + 1));
-    *len = fread(*buf, 1, fileSize, file);
-    (*buf)[*len] = '\0';
-
-    fclose(file);
-}
+    float viewInverse[16];   // column-major 4x4 matrix
+    float projInverse[16];   // column-major 4x4 matrix
+    float cameraPosition[3];
+    uint32_t frameIndex;
+    uint32_t samplesPerPixel;
+    uint32_t maxBounces;
+    float envMapIntensity;
+    uint32_t hasEnvMap;
+    float exposure;          // Exposure control for tone mapping
+    float padding[3];        // Padding to align to 16 bytes
+};
 
 // ============================================================================
 // Ray Traced Scene Application
@@ -971,7 +70,8 @@ private:
     nvrhi::rt::AccelStructHandle m_TopLevelAS;
 
     // Buffers
-    nvrhi::BufferHandle m_VertexBuffer;
+    nvrhi::BufferHandle m_PositionBuffer;   // BLAS input only
+    nvrhi::BufferHandle m_VertexBuffer;     // Shading attributes
     nvrhi::BufferHandle m_IndexBuffer;
     nvrhi::BufferHandle m_MaterialBuffer;
     nvrhi::BufferHandle m_InstanceBuffer;
@@ -1009,11 +109,21 @@ private:
     std::unique_ptr<engine::BindingCache> m_BindingCache;
 
     // Scene data
-    MitsubaSceneParser m_SceneParser;
-    std::vector<GPUVertex> m_Vertices;
-    std::vector<uint32_t> m_Indices;
-    std::vector<GPUMaterial> m_Materials;
-    std::vector<GPUInstance> m_Instances;
+    std::unique_ptr<MitsubaSceneParser> m_SceneParser = std::make_unique<MitsubaSceneParser>();
+    SceneGeometry m_Geometry;
+    SceneCache m_SceneCache;
+    PackedScene m_Scene;    // What gets uploaded: views into m_Geometry or m_SceneCache
+
+    // Hot reload (--watch): buffers get headroom so edits can be patched in
+    bool m_WatchScene = false;
+    FileWatcher m_Watcher;
+    size_t m_PositionCapacity = 0;
+    size_t m_VertexCapacity = 0;
+    size_t m_IndexCapacity = 0;
+    size_t m_MaterialCapacity = 0;
+    size_t m_InstanceCapacity = 0;
+    size_t m_TopLevelCapacity = 0;
+    std::vector<std::string> m_MaterialTextureFiles;    // Source of each m_MaterialTextures slot
 
     // Camera (using HMM)
     CameraConstants m_CameraConstants;
@@ -1055,8 +165,9 @@ private:
     std::filesystem::path m_ScenePath;
 
 public:
-    RayTracedScene(app::DeviceManager* deviceManager, const std::filesystem::path& scenePath)
+    RayTracedScene(app::DeviceManager* deviceManager, const std::filesystem::path& scenePath, bool watchScene)
         : IRenderPass(deviceManager)
+        , m_WatchScene(watchScene)
         , m_ScenePath(scenePath)
     {
     }
@@ -1064,17 +175,48 @@ public:
     bool Init()
     {
         // Parse the Mitsuba scene
-        if (!m_SceneParser.Parse(m_ScenePath))
+        if (!m_SceneParser->Parse(m_ScenePath))
         {
             log::error("Failed to parse scene file: %s", m_ScenePath.string().c_str());
             return false;
         }
 
-        // Load geometry from scene
-        if (!LoadSceneGeometry())
+        // Reuse the packed scene from the last run if no source file changed,
+        // otherwise load and pack it now and cache the result. Watched scenes
+        // use a different (all local space) layout and bypass the cache.
+        m_Geometry.keepShapesLocal = m_WatchScene;
+        std::filesystem::path cachePath = SceneCache::PathFor(m_ScenePath);
+        uint64_t cacheKey = m_WatchScene ? 0 : SceneCache::ComputeKey(*m_SceneParser, m_ScenePath, m_Geometry);
+        if (!m_WatchScene && m_SceneCache.Open(cachePath, cacheKey))
         {
-            log::error("Failed to load scene geometry");
-            return false;
+            m_Scene = m_SceneCache.Scene();
+            log::info("Loaded scene from cache: %s", cachePath.string().c_str());
+        }
+        else
+        {
+            if (!m_Geometry.Load(*m_SceneParser))
+            {
+                log::error("Failed to load scene geometry");
+                return false;
+            }
+
+            // Decode only the textures that placed instances actually use
+            m_SceneParser->DecodeTextures(m_Geometry.UsedTextureIndices());
+
+            m_Scene = PackedScene::FromGeometry(m_Geometry, *m_SceneParser);
+            if (!m_Scene.Verify())
+            {
+                log::error("Scene geometry has out-of-range indices, not uploading it");
+                return false;
+            }
+            if (m_WatchScene)
+            {
+                WatchSceneFiles();
+            }
+            else
+            {
+                SceneCache::Write(cachePath, cacheKey, m_Scene);
+            }
         }
 
         // Initialize shader factory
@@ -1225,396 +367,55 @@ public:
         return true;
     }
 
-    bool LoadSceneGeometry()
-    {
-        uint32_t currentVertexOffset = 0;
-        uint32_t currentIndexOffset = 0;
-        uint32_t currentMaterialIndex = 0;
-
-        // Create materials from parsed scene
-        for (auto& [id, mat] : m_SceneParser.materials)
-        {
-            GPUMaterial gpuMat = {};  // Zero-initialize
-            gpuMat.baseColor[0] = mat.baseColor.X;
-            gpuMat.baseColor[1] = mat.baseColor.Y;
-            gpuMat.baseColor[2] = mat.baseColor.Z;
-            gpuMat.roughness = mat.roughness;
-            gpuMat.eta[0] = mat.eta.X;
-            gpuMat.eta[1] = mat.eta.Y;
-            gpuMat.eta[2] = mat.eta.Z;
-            gpuMat.k[0] = mat.k.X;
-            gpuMat.k[1] = mat.k.Y;
-            gpuMat.k[2] = mat.k.Z;
-            gpuMat.type = static_cast<uint32_t>(mat.type);
-            gpuMat.intIOR = mat.intIOR;
-            gpuMat.extIOR = mat.extIOR;
-            gpuMat.metallic = mat.metallic;
-            if (mat.type == MaterialType::Conductor || mat.type == MaterialType::RoughConductor)
-            {
-                gpuMat.metallic = 1.0f;
-            }
-            gpuMat.baseColorTexIdx = mat.baseColorTexture.textureIndex;
-            gpuMat.roughnessTexIdx = mat.roughnessTexture.textureIndex;
-            gpuMat.normalTexIdx = mat.normalTexture.textureIndex;
-            
-            // Principled BSDF parameters
-            gpuMat.specular = mat.specular;
-            gpuMat.specTint = mat.specTint;
-            gpuMat.sheen = mat.sheen;
-            gpuMat.sheenTint = mat.sheenTint;
-            gpuMat.clearcoat = mat.clearcoat;
-            gpuMat.clearcoatGloss = mat.clearcoatGloss;
-            gpuMat.specTrans = mat.specTrans;
-            
-            // Mask/Blend parameters
-            gpuMat.opacity = mat.opacity;
-            gpuMat.blendWeight = mat.blendWeight;
-            gpuMat.nonlinear = mat.nonlinear ? 1.0f : 0.0f;
-            gpuMat.padding = 0.0f;
-            
-            m_Materials.push_back(gpuMat);
-        }
-
-        // Process each shape
-        for (auto& shape : m_SceneParser.shapes)
-        {
-            if (shape.type == "obj")
-            {
-                LoadOBJShape(shape, currentVertexOffset, currentIndexOffset, currentMaterialIndex);
-            }
-            else if (shape.type == "rectangle")
-            {
-                CreateRectangleShape(shape, currentVertexOffset, currentIndexOffset, currentMaterialIndex);
-            }
-        }
-
-        log::info("Loaded %zu vertices, %zu indices, %zu materials, %zu instances",
-            m_Vertices.size(), m_Indices.size(), m_Materials.size(), m_Instances.size());
-
-        return !m_Vertices.empty();
-    }
-
-    void LoadOBJShape(MitsubaSceneParser::Shape& shape, uint32_t& vertexOffset, 
-                      uint32_t& indexOffset, uint32_t& materialIndex)
+    // Room to grow for watched scenes, so most edits patch buffers in place
+    size_t BufferCapacity(size_t count) const
     {
-        std::filesystem::path objPath = m_SceneParser.sceneDirectory / shape.filename;
-
-        tinyobj_attrib_t attrib;
-        tinyobj_shape_t* shapes = nullptr;
-        size_t numShapes = 0;
-        tinyobj_material_t* materials = nullptr;
-        size_t numMaterials = 0;
-
-        std::filesystem::path basePath = objPath.parent_path();
-
-        int ret = tinyobj_parse_obj(&attrib, &shapes, &numShapes, &materials, &numMaterials,
-            objPath.string().c_str(), FileReaderCallback, &basePath, TINYOBJ_FLAG_TRIANGULATE);
-
-        if (ret != TINYOBJ_SUCCESS)
-        {
-            log::warning("Failed to load OBJ: %s", objPath.string().c_str());
-            return;
-        }
-
-        uint32_t startVertexIndex = static_cast<uint32_t>(m_Vertices.size());
-        uint32_t startIndexOffset = static_cast<uint32_t>(m_Indices.size());
-
-        // Convert vertices with transform
-        std::unordered_map<uint64_t, uint32_t> vertexMap;
-
-        for (unsigned int f = 0; f < attrib.num_faces; f++)
-        {
-            tinyobj_vertex_index_t idx = attrib.faces[f];
-
-            // Create unique key for vertex
-            uint64_t key = (uint64_t(idx.v_idx) << 40) | (uint64_t(idx.vn_idx) << 20) | uint64_t(idx.vt_idx);
-
-            auto it = vertexMap.find(key);
-            if (it != vertexMap.end())
-            {
-                m_Indices.push_back(it->second);
-            }
-            else
-            {
-                GPUVertex vertex;
-
-                // Position - transform using HMM (column-vector: M * v)
-                HMM_Vec4 pos = HMM_V4(
-                    attrib.vertices[3 * idx.v_idx + 0],
-                    attrib.vertices[3 * idx.v_idx + 1],
-                    attrib.vertices[3 * idx.v_idx + 2],
-                    1.0f
-                );
-                HMM_Vec4 worldPos = HMM_MulM4V4(shape.transform, pos);
-                vertex.position[0] = worldPos.X;
-                vertex.position[1] = worldPos.Y;
-                vertex.position[2] = worldPos.Z;
-
-                // Normal - transform using upper 3x3 of world matrix
-                if (idx.vn_idx >= 0 && attrib.normals)
-                {
-                    HMM_Vec4 normal = HMM_V4(
-                        attrib.normals[3 * idx.vn_idx + 0],
-                        attrib.normals[3 * idx.vn_idx + 1],
-                        attrib.normals[3 * idx.vn_idx + 2],
-                        0.0f
-                    );
-                    HMM_Vec4 worldNormal = HMM_MulM4V4(shape.transform, normal);
-                    HMM_Vec3 n = HMM_NormV3(HMM_V3(worldNormal.X, worldNormal.Y, worldNormal.Z));
-                    vertex.normal[0] = n.X;
-                    vertex.normal[1] = n.Y;
-                    vertex.normal[2] = n.Z;
-                }
-                else
-                {
-                    vertex.normal[0] = 0.0f;
-                    vertex.normal[1] = 1.0f;
-                    vertex.normal[2] = 0.0f;
-                }
-
-                // Texcoord
-                if (idx.vt_idx >= 0 && attrib.texcoords)
-                {
-                    vertex.texcoord[0] = attrib.texcoords[2 * idx.vt_idx + 0];
-                    vertex.texcoord[1] = attrib.texcoords[2 * idx.vt_idx + 1];
-                }
-                else
-                {
-                    vertex.texcoord[0] = 0.0f;
-                    vertex.texcoord[1] = 0.0f;
-                }
-
-                uint32_t newIndex = static_cast<uint32_t>(m_Vertices.size());
-                vertexMap[key] = newIndex;
-                m_Vertices.push_back(vertex);
-                m_Indices.push_back(newIndex);
-            }
-        }
-
-        // Find material index
-        uint32_t matIndex = 0;
-        if (!shape.materialRef.empty())
-        {
-            uint32_t idx = 0;
-            for (auto& [id, mat] : m_SceneParser.materials)
-            {
-                if (id == shape.materialRef)
-                {
-                    matIndex = idx;
-                    break;
-                }
-                idx++;
-            }
-        }
-        else if (shape.hasInlineMaterial)
-        {
-            // Add inline material
-            GPUMaterial gpuMat = {};
-            const auto& mat = shape.inlineMaterial;
-            gpuMat.baseColor[0] = mat.baseColor.X;
-            gpuMat.baseColor[1] = mat.baseColor.Y;
-            gpuMat.baseColor[2] = mat.baseColor.Z;
-            gpuMat.roughness = mat.roughness;
-            gpuMat.eta[0] = mat.eta.X;
-            gpuMat.eta[1] = mat.eta.Y;
-            gpuMat.eta[2] = mat.eta.Z;
-            gpuMat.k[0] = mat.k.X;
-            gpuMat.k[1] = mat.k.Y;
-            gpuMat.k[2] = mat.k.Z;
-            gpuMat.type = static_cast<uint32_t>(mat.type);
-            gpuMat.intIOR = mat.intIOR;
-            gpuMat.extIOR = mat.extIOR;
-            gpuMat.metallic = mat.metallic;
-            if (mat.type == MaterialType::Conductor || mat.type == MaterialType::RoughConductor)
-                gpuMat.metallic = 1.0f;
-            gpuMat.baseColorTexIdx = mat.baseColorTexture.textureIndex;
-            gpuMat.roughnessTexIdx = mat.roughnessTexture.textureIndex;
-            gpuMat.normalTexIdx = mat.normalTexture.textureIndex;
-            gpuMat.specular = mat.specular;
-            gpuMat.specTint = mat.specTint;
-            gpuMat.sheen = mat.sheen;
-            gpuMat.sheenTint = mat.sheenTint;
-            gpuMat.clearcoat = mat.clearcoat;
-            gpuMat.clearcoatGloss = mat.clearcoatGloss;
-            gpuMat.specTrans = mat.specTrans;
-            gpuMat.opacity = mat.opacity;
-            gpuMat.blendWeight = mat.blendWeight;
-            gpuMat.nonlinear = mat.nonlinear ? 1.0f : 0.0f;
-            gpuMat.padding = 0.0f;
-            matIndex = static_cast<uint32_t>(m_Materials.size());
-            m_Materials.push_back(gpuMat);
-        }
-
-        // Create instance
-        GPUInstance instance;
-        instance.vertexOffset = startVertexIndex;
-        instance.indexOffset = startIndexOffset;
-        instance.materialIndex = matIndex;
-        instance.isEmitter = shape.isEmitter ? 1 : 0;
-        instance.emission[0] = shape.emission.X;
-        instance.emission[1] = shape.emission.Y;
-        instance.emission[2] = shape.emission.Z;
-        m_Instances.push_back(instance);
-
-        // Cleanup
-        tinyobj_attrib_free(&attrib);
-        tinyobj_shapes_free(shapes, numShapes);
-        tinyobj_materials_free(materials, numMaterials);
+        return m_WatchScene ? count + count / 4 + 1024 : count;
     }
 
-    void CreateRectangleShape(MitsubaSceneParser::Shape& shape, uint32_t& vertexOffset,
-                              uint32_t& indexOffset, uint32_t& materialIndex)
+    nvrhi::BufferHandle CreateSceneBuffer(size_t stride, size_t capacity, bool isAccelStructBuildInput, const char* name)
     {
-        uint32_t startVertexIndex = static_cast<uint32_t>(m_Vertices.size());
-        uint32_t startIndexOffset = static_cast<uint32_t>(m_Indices.size());
-
-        // Create a unit rectangle in XY plane, centered at origin
-        HMM_Vec4 positions[4] = {
-            HMM_V4(-1.0f, -1.0f, 0.0f, 1.0f),
-            HMM_V4( 1.0f, -1.0f, 0.0f, 1.0f),
-            HMM_V4( 1.0f,  1.0f, 0.0f, 1.0f),
-            HMM_V4(-1.0f,  1.0f, 0.0f, 1.0f)
-        };
-
-        HMM_Vec4 normal = HMM_V4(0.0f, 0.0f, 1.0f, 0.0f);
-        float texcoords[4][2] = {
-            {0.0f, 0.0f},
-            {1.0f, 0.0f},
-            {1.0f, 1.0f},
-            {0.0f, 1.0f}
-        };
-
-        // Transform and add vertices
-        for (int i = 0; i < 4; i++)
-        {
-            GPUVertex vertex;
-            HMM_Vec4 worldPos = HMM_MulM4V4(shape.transform, positions[i]);
-            vertex.position[0] = worldPos.X;
-            vertex.position[1] = worldPos.Y;
-            vertex.position[2] = worldPos.Z;
-
-            HMM_Vec4 worldNormal = HMM_MulM4V4(shape.transform, normal);
-            HMM_Vec3 n = HMM_NormV3(HMM_V3(worldNormal.X, worldNormal.Y, worldNormal.Z));
-            vertex.normal[0] = n.X;
-            vertex.normal[1] = n.Y;
-            vertex.normal[2] = n.Z;
-
-            vertex.texcoord[0] = texcoords[i][0];
-            vertex.texcoord[1] = texcoords[i][1];
-            m_Vertices.push_back(vertex);
-        }
-
-        // Add indices (two triangles)
-        uint32_t base = startVertexIndex;
-        m_Indices.push_back(base + 0);
-        m_Indices.push_back(base + 1);
-        m_Indices.push_back(base + 2);
-        m_Indices.push_back(base + 0);
-        m_Indices.push_back(base + 2);
-        m_Indices.push_back(base + 3);
-
-        // Handle material
-        uint32_t matIndex = 0;
-        if (shape.hasInlineMaterial)
-        {
-            GPUMaterial gpuMat = {};
-            const auto& mat = shape.inlineMaterial;
-            gpuMat.baseColor[0] = mat.baseColor.X;
-            gpuMat.baseColor[1] = mat.baseColor.Y;
-            gpuMat.baseColor[2] = mat.baseColor.Z;
-            gpuMat.roughness = mat.roughness;
-            gpuMat.eta[0] = mat.eta.X;
-            gpuMat.eta[1] = mat.eta.Y;
-            gpuMat.eta[2] = mat.eta.Z;
-            gpuMat.k[0] = mat.k.X;
-            gpuMat.k[1] = mat.k.Y;
-            gpuMat.k[2] = mat.k.Z;
-            gpuMat.type = static_cast<uint32_t>(mat.type);
-            gpuMat.intIOR = mat.intIOR;
-            gpuMat.extIOR = mat.extIOR;
-            gpuMat.metallic = mat.metallic;
-            if (mat.type == MaterialType::Conductor || mat.type == MaterialType::RoughConductor)
-                gpuMat.metallic = 1.0f;
-            gpuMat.baseColorTexIdx = mat.baseColorTexture.textureIndex;
-            gpuMat.roughnessTexIdx = mat.roughnessTexture.textureIndex;
-            gpuMat.normalTexIdx = mat.normalTexture.textureIndex;
-            gpuMat.specular = mat.specular;
-            gpuMat.specTint = mat.specTint;
-            gpuMat.sheen = mat.sheen;
-            gpuMat.sheenTint = mat.sheenTint;
-            gpuMat.clearcoat = mat.clearcoat;
-            gpuMat.clearcoatGloss = mat.clearcoatGloss;
-            gpuMat.specTrans = mat.specTrans;
-            gpuMat.opacity = mat.opacity;
-            gpuMat.blendWeight = mat.blendWeight;
-            gpuMat.nonlinear = mat.nonlinear ? 1.0f : 0.0f;
-            gpuMat.padding = 0.0f;
-            matIndex = static_cast<uint32_t>(m_Materials.size());
-            m_Materials.push_back(gpuMat);
-        }
-
-        // Create instance
-        GPUInstance instance;
-        instance.vertexOffset = startVertexIndex;
-        instance.indexOffset = startIndexOffset;
-        instance.materialIndex = matIndex;
-        instance.isEmitter = shape.isEmitter ? 1 : 0;
-        instance.emission[0] = shape.emission.X;
-        instance.emission[1] = shape.emission.Y;
-        instance.emission[2] = shape.emission.Z;
-        m_Instances.push_back(instance);
+        nvrhi::BufferDesc bufferDesc;
+        bufferDesc.byteSize = stride * capacity;
+        bufferDesc.structStride = static_cast<uint32_t>(stride);
+        bufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+        bufferDesc.keepInitialState = true;
+        bufferDesc.isAccelStructBuildInput = isAccelStructBuildInput;
+        bufferDesc.debugName = name;
+        return GetDevice()->createBuffer(bufferDesc);
     }
 
     void CreateGPUResources()
     {
         m_CommandList->open();
 
-        // Create vertex buffer
-        nvrhi::BufferDesc vertexBufferDesc;
-        vertexBufferDesc.byteSize = sizeof(GPUVertex) * m_Vertices.size();
-        vertexBufferDesc.structStride = sizeof(GPUVertex);
-        vertexBufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
-        vertexBufferDesc.keepInitialState = true;
-        vertexBufferDesc.isAccelStructBuildInput = true;
-        vertexBufferDesc.debugName = "VertexBuffer";
-        m_VertexBuffer = GetDevice()->createBuffer(vertexBufferDesc);
-        m_CommandList->writeBuffer(m_VertexBuffer, m_Vertices.data(), vertexBufferDesc.byteSize);
+        // Create position and vertex attribute buffers
+        m_PositionCapacity = BufferCapacity(m_Scene.positions.size());
+        m_PositionBuffer = CreateSceneBuffer(sizeof(GPUPosition), m_PositionCapacity, true, "PositionBuffer");
+        m_CommandList->writeBuffer(m_PositionBuffer, m_Scene.positions.data(), m_Scene.positions.size_bytes());
+        m_VertexCapacity = BufferCapacity(m_Scene.vertices.size());
+        m_VertexBuffer = CreateSceneBuffer(sizeof(GPUVertex), m_VertexCapacity, false, "VertexBuffer");
+        m_CommandList->writeBuffer(m_VertexBuffer, m_Scene.vertices.data(), m_Scene.vertices.size_bytes());
 
         // Create index buffer
-        nvrhi::BufferDesc indexBufferDesc;
-        indexBufferDesc.byteSize = sizeof(uint32_t) * m_Indices.size();
-        indexBufferDesc.structStride = sizeof(uint32_t);
-        indexBufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
-        indexBufferDesc.keepInitialState = true;
-        indexBufferDesc.isAccelStructBuildInput = true;
-        indexBufferDesc.debugName = "IndexBuffer";
-        m_IndexBuffer = GetDevice()->createBuffer(indexBufferDesc);
-        m_CommandList->writeBuffer(m_IndexBuffer, m_Indices.data(), indexBufferDesc.byteSize);
+        m_IndexCapacity = BufferCapacity(m_Scene.indices.size());
+        m_IndexBuffer = CreateSceneBuffer(sizeof(uint32_t), m_IndexCapacity, true, "IndexBuffer");
+        m_CommandList->writeBuffer(m_IndexBuffer, m_Scene.indices.data(), m_Scene.indices.size_bytes());
 
         // Create material buffer
-        if (!m_Materials.empty())
+        if (!m_Scene.materials.empty())
         {
-            nvrhi::BufferDesc materialBufferDesc;
-            materialBufferDesc.byteSize = sizeof(GPUMaterial) * m_Materials.size();
-            materialBufferDesc.structStride = sizeof(GPUMaterial);
-            materialBufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
-            materialBufferDesc.keepInitialState = true;
-            materialBufferDesc.debugName = "MaterialBuffer";
-            m_MaterialBuffer = GetDevice()->createBuffer(materialBufferDesc);
-            m_CommandList->writeBuffer(m_MaterialBuffer, m_Materials.data(), materialBufferDesc.byteSize);
+            m_MaterialCapacity = BufferCapacity(m_Scene.materials.size());
+            m_MaterialBuffer = CreateSceneBuffer(sizeof(GPUMaterial), m_MaterialCapacity, false, "MaterialBuffer");
+            m_CommandList->writeBuffer(m_MaterialBuffer, m_Scene.materials.data(), m_Scene.materials.size_bytes());
         }
 
         // Create instance buffer
-        if (!m_Instances.empty())
+        if (!m_Scene.instances.empty())
         {
-            nvrhi::BufferDesc instanceBufferDesc;
-            instanceBufferDesc.byteSize = sizeof(GPUInstance) * m_Instances.size();
-            instanceBufferDesc.structStride = sizeof(GPUInstance);
-            instanceBufferDesc.initialState = nvrhi::ResourceStates::ShaderResource;
-            instanceBufferDesc.keepInitialState = true;
-            instanceBufferDesc.debugName = "InstanceBuffer";
-            m_InstanceBuffer = GetDevice()->createBuffer(instanceBufferDesc);
-            m_CommandList->writeBuffer(m_InstanceBuffer, m_Instances.data(), instanceBufferDesc.byteSize);
+            m_InstanceCapacity = BufferCapacity(m_Scene.instances.size());
+            m_InstanceBuffer = CreateSceneBuffer(sizeof(GPUInstance), m_InstanceCapacity, false, "InstanceBuffer");
+            m_CommandList->writeBuffer(m_InstanceBuffer, m_Scene.instances.data(), m_Scene.instances.size_bytes());
         }
 
         // Create camera constant buffer
@@ -1636,9 +437,9 @@ public:
     void CreateEnvironmentMapTexture()
     {
         // Load environment map if specified
-        if (m_SceneParser.environmentMap.isValid)
+        if (m_SceneParser->environmentMap.isValid)
         {
-            std::filesystem::path envMapPath = m_SceneParser.sceneDirectory / m_SceneParser.environmentMap.filename;
+            std::filesystem::path envMapPath = m_SceneParser->sceneDirectory / m_SceneParser->environmentMap.filename;
             texture_utils::TextureData envMapData = texture_utils::LoadTexture(envMapPath);
             
             if (envMapData.IsValid())
@@ -1705,26 +506,12 @@ public:
             GetDevice()->executeCommandList(m_CommandList);
         }
         
-        // Create textures from loaded texture data
-        for (const auto& texData : m_SceneParser.loadedTextures)
+        // Create textures from decoded texture data; slots that were never
+        // decoded (or failed) get the default texture so indices stay aligned
+        for (size_t i = 0; i < m_Scene.textures.size(); i++)
         {
-            nvrhi::TextureDesc textureDesc;
-            textureDesc.width = texData.width;
-            textureDesc.height = texData.height;
-            textureDesc.format = nvrhi::Format::RGBA32_FLOAT;
-            textureDesc.initialState = nvrhi::ResourceStates::ShaderResource;
-            textureDesc.keepInitialState = true;
-            textureDesc.debugName = texData.path.c_str();
-            
-            nvrhi::TextureHandle texture = GetDevice()->createTexture(textureDesc);
-            
-            m_CommandList->open();
-            m_CommandList->writeTexture(texture, 0, 0, 
-                texData.data.data(), texData.width * 4 * sizeof(float));
-            m_CommandList->close();
-            GetDevice()->executeCommandList(m_CommandList);
-            
-            m_MaterialTextures.push_back(texture);
+            m_MaterialTextures.push_back(CreateMaterialTexture(i));
+            m_MaterialTextureFiles.push_back(MaterialTextureFile(i));
         }
         
         if (!m_MaterialTextures.empty())
@@ -1733,91 +520,327 @@ public:
         }
     }
 
+    std::string MaterialTextureFile(size_t index) const
+    {
+        return index < m_SceneParser->textures.size() ? std::string(m_SceneParser->textures[index].filename) : std::string();
+    }
+
+    nvrhi::TextureHandle CreateMaterialTexture(size_t index)
+    {
+        const PackedScene::Texture& texData = m_Scene.textures[index];
+        if (texData.width == 0)
+        {
+            return m_DefaultMaterialTexture;
+        }
+        
+        nvrhi::TextureDesc textureDesc;
+        textureDesc.width = texData.width;
+        textureDesc.height = texData.height;
+        textureDesc.format = nvrhi::Format::RGBA32_FLOAT;
+        textureDesc.initialState = nvrhi::ResourceStates::ShaderResource;
+        textureDesc.keepInitialState = true;
+        std::string debugName = MaterialTextureFile(index);
+        textureDesc.debugName = debugName.empty() ? std::string("MaterialTexture") : debugName;
+        
+        nvrhi::TextureHandle texture = GetDevice()->createTexture(textureDesc);
+        
+        m_CommandList->open();
+        m_CommandList->writeTexture(texture, 0, 0, 
+            texData.rgba.data(), texData.width * 4 * sizeof(float));
+        m_CommandList->close();
+        GetDevice()->executeCommandList(m_CommandList);
+        return texture;
+    }
+
     void BuildAccelerationStructures()
+    {
+        // Build one BLAS per unique mesh; instances of a shape group share them
+        for (const MeshRange& mesh : m_Scene.meshes)
+        {
+            m_BottomLevelAS.push_back(BuildMeshBLAS(mesh));
+        }
+
+        BuildTopLevelAS(false);
+    }
+
+    nvrhi::rt::AccelStructHandle BuildMeshBLAS(const MeshRange& mesh)
+    {
+        // Indices are local to the mesh, so the build sees only the mesh's
+        // own slice of the position stream
+        nvrhi::rt::AccelStructDesc blasDesc;
+        blasDesc.isTopLevel = false;
+
+        nvrhi::rt::GeometryDesc geometryDesc;
+        auto& triangles = geometryDesc.geometryData.triangles;
+        triangles.indexBuffer = m_IndexBuffer;
+        triangles.indexOffset = mesh.indexOffset * sizeof(uint32_t);
+        triangles.indexFormat = nvrhi::Format::R32_UINT;
+        triangles.indexCount = mesh.indexCount;
+        triangles.vertexBuffer = m_PositionBuffer;
+        triangles.vertexOffset = uint64_t(mesh.vertexOffset) * sizeof(GPUPosition);
+        triangles.vertexFormat = nvrhi::Format::RGB32_FLOAT;
+        triangles.vertexStride = sizeof(GPUPosition);
+        triangles.vertexCount = mesh.vertexCount;
+        geometryDesc.geometryType = nvrhi::rt::GeometryType::Triangles;
+        geometryDesc.flags = nvrhi::rt::GeometryFlags::Opaque;
+        blasDesc.bottomLevelGeometries.push_back(geometryDesc);
+
+        nvrhi::rt::AccelStructHandle blas = GetDevice()->createAccelStruct(blasDesc);
+        nvrhi::utils::BuildBottomLevelAccelStruct(m_CommandList, blas, blasDesc);
+        return blas;
+    }
+
+    // Build the TLAS from the current placements. `refit` updates the
+    // existing one in place and is only valid for transform-only changes.
+    void BuildTopLevelAS(bool refit)
     {
         std::vector<nvrhi::rt::InstanceDesc> tlasInstances;
 
-        // Build BLAS for each instance
-        for (size_t i = 0; i < m_Instances.size(); i++)
+        // Create one TLAS instance per placement; InstanceID() indexes m_Scene.instances
+        for (size_t i = 0; i < m_Scene.placements.size(); i++)
+        {
+            const InstancePlacement& placement = m_Scene.placements[i];
+
+            nvrhi::rt::InstanceDesc instanceDesc;
+            instanceDesc.bottomLevelAS = m_BottomLevelAS[placement.meshIndex];
+            instanceDesc.instanceMask = 1;
+            instanceDesc.instanceID = static_cast<uint32_t>(i);
+            instanceDesc.flags = nvrhi::rt::InstanceFlags::TriangleFrontCounterclockwise;
+            // Row-major 3x4 object-to-world matrix (HMM is column-major)
+            for (int row = 0; row < 3; row++)
+            {
+                for (int col = 0; col < 4; col++)
+                {
+                    instanceDesc.transform[row * 4 + col] = placement.transform.Columns[col].Elements[row];
+                }
+            }
+            tlasInstances.push_back(instanceDesc);
+        }
+
+        // Watched scenes keep an updatable TLAS with spare instance slots
+        nvrhi::rt::AccelStructBuildFlags buildFlags = m_WatchScene
+            ? nvrhi::rt::AccelStructBuildFlags::AllowUpdate : nvrhi::rt::AccelStructBuildFlags::None;
+
+        if (!m_TopLevelAS || tlasInstances.size() > m_TopLevelCapacity)
+        {
+            m_TopLevelCapacity = BufferCapacity(tlasInstances.size());
+
+            nvrhi::rt::AccelStructDesc tlasDesc;
+            tlasDesc.isTopLevel = true;
+            tlasDesc.topLevelMaxInstances = static_cast<uint32_t>(m_TopLevelCapacity);
+            tlasDesc.buildFlags = buildFlags;
+
+            m_TopLevelAS = GetDevice()->createAccelStruct(tlasDesc);
+            m_BindingSet = nullptr;
+            refit = false;
+        }
+
+        if (refit)
+        {
+            buildFlags = buildFlags | nvrhi::rt::AccelStructBuildFlags::PerformUpdate;
+        }
+        m_CommandList->buildTopLevelAccelStruct(m_TopLevelAS, tlasInstances.data(), tlasInstances.size(), buildFlags);
+    }
+
+    // ========================================================================
+    // Hot Reload
+    // ========================================================================
+    void WatchSceneFiles()
+    {
+        std::vector<std::filesystem::path> files = m_SceneParser->ReferencedFiles();
+        files.push_back(m_ScenePath);
+        m_Watcher.SetFiles(std::move(files));
+        log::info("Watching %zu scene files for changes", m_Watcher.FileCount());
+    }
+
+    // Write `range` of `data` into `buffer`, or recreate the buffer when the
+    // data no longer fits. Returns true if the buffer was recreated.
+    template <typename T>
+    bool PatchSceneBuffer(nvrhi::BufferHandle& buffer, size_t& capacity, std::span<const T> data,
+                          const std::vector<SceneDelta::Range>& ranges, bool writeAll, bool isAccelStructBuildInput,
+                          const char* name)
+    {
+        if (!buffer || data.size() > capacity)
         {
-            const GPUInstance& instance = m_Instances[i];
-            uint32_t indexCount = 0;
+            capacity = BufferCapacity(data.size());
+            buffer = CreateSceneBuffer(sizeof(T), capacity, isAccelStructBuildInput, name);
+            m_CommandList->writeBuffer(buffer, data.data(), data.size_bytes());
+            return true;
+        }
 
-            // Calculate index count for this instance
-            if (i < m_Instances.size() - 1)
+        if (writeAll)
+        {
+            m_CommandList->writeBuffer(buffer, data.data(), data.size_bytes());
+            return false;
+        }
+        for (const SceneDelta::Range& range : ranges)
+        {
+            if (range.IsEmpty())
             {
-                indexCount = m_Instances[i + 1].indexOffset - instance.indexOffset;
+                continue;
             }
-            else
+            m_CommandList->writeBuffer(buffer, data.data() + range.offset, range.count * sizeof(T), range.offset * sizeof(T));
+        }
+        return false;
+    }
+
+    // Poll the watched files and apply whatever changed: patch buffer ranges,
+    // rebuild the BLAS of changed meshes, refit or rebuild the TLAS, replace
+    // changed textures. Nothing else is re-uploaded.
+    void ReloadChangedFiles()
+    {
+        std::vector<std::filesystem::path> changed = m_Watcher.Poll();
+        if (changed.empty())
+        {
+            return;
+        }
+        auto reloadStart = std::chrono::steady_clock::now();
+
+        // An edited XML or included fragment is parsed into a new parser; the
+        // current one stays alive until the geometry has been rebuilt from it
+        std::unique_ptr<MitsubaSceneParser> reparsed;
+        const std::vector<std::filesystem::path>& fragments = m_SceneParser->includedFiles;
+        bool xmlChanged = std::any_of(changed.begin(), changed.end(), [&](const std::filesystem::path& file)
+        {
+            return file == m_ScenePath || std::find(fragments.begin(), fragments.end(), file) != fragments.end();
+        });
+        if (xmlChanged)
+        {
+            reparsed = std::make_unique<MitsubaSceneParser>();
+            if (!reparsed->Parse(m_ScenePath))
             {
-                indexCount = static_cast<uint32_t>(m_Indices.size()) - instance.indexOffset;
+                log::warning("Scene reload failed, keeping the current scene");
+                return;
             }
+            reparsed->AdoptDecodedTextures(*m_SceneParser, changed);
+        }
+        else
+        {
+            m_SceneParser->InvalidateTextures(changed);
+        }
+        MitsubaSceneParser& scene = reparsed ? *reparsed : *m_SceneParser;
+
+        SceneDelta delta;
+        if (!m_Geometry.Reload(scene, changed, delta))
+        {
+            return;
+        }
+        scene.DecodeTextures(m_Geometry.UsedTextureIndices());
+
+        std::string oldEnvMap(m_SceneParser->environmentMap.isValid ? m_SceneParser->environmentMap.filename : "");
+        if (reparsed)
+        {
+            m_SceneParser = std::move(reparsed);
+        }
+        std::string newEnvMap(m_SceneParser->environmentMap.isValid ? m_SceneParser->environmentMap.filename : "");
+        m_Scene = PackedScene::FromGeometry(m_Geometry, *m_SceneParser);
 
-            uint32_t vertexCount = 0;
-            if (i < m_Instances.size() - 1)
+        // Environment map: swapped in the XML or edited on disk
+        if (oldEnvMap != newEnvMap || (!newEnvMap.empty() &&
+            std::find(changed.begin(), changed.end(), m_SceneParser->sceneDirectory / newEnvMap) != changed.end()))
+        {
+            m_EnvironmentMap = nullptr;
+            CreateEnvironmentMapTexture();
+            m_BindingSet = nullptr;
+        }
+
+        // Material textures: keep slots whose file is unchanged and whose
+        // decoded state did not change, recreate the rest
+        size_t replacedTextures = 0;
+        std::vector<nvrhi::TextureHandle> textures;
+        std::vector<std::string> textureFiles;
+        for (size_t i = 0; i < m_Scene.textures.size(); i++)
+        {
+            std::string file = MaterialTextureFile(i);
+            bool fileChanged = std::find(changed.begin(), changed.end(), m_SceneParser->sceneDirectory / file) != changed.end();
+            bool reusable = i < m_MaterialTextures.size() && m_MaterialTextureFiles[i] == file && !fileChanged &&
+                            ((m_MaterialTextures[i] == m_DefaultMaterialTexture) == (m_Scene.textures[i].width == 0));
+            if (reusable)
             {
-                vertexCount = m_Instances[i + 1].vertexOffset - instance.vertexOffset;
+                textures.push_back(m_MaterialTextures[i]);
             }
             else
             {
-                vertexCount = static_cast<uint32_t>(m_Vertices.size()) - instance.vertexOffset;
+                textures.push_back(CreateMaterialTexture(i));
+                replacedTextures++;
             }
+            textureFiles.push_back(std::move(file));
+        }
+        if (replacedTextures > 0 || textures.size() != m_MaterialTextures.size())
+        {
+            m_BindingSet = nullptr;
+        }
+        m_MaterialTextures = std::move(textures);
+        m_MaterialTextureFiles = std::move(textureFiles);
 
-            // Create BLAS
-            // Note: Indices are stored as global indices, so we use the entire vertex buffer
-            // with no vertex offset. The indices directly reference the correct vertices.
-            nvrhi::rt::AccelStructDesc blasDesc;
-            blasDesc.isTopLevel = false;
-
-            nvrhi::rt::GeometryDesc geometryDesc;
-            auto& triangles = geometryDesc.geometryData.triangles;
-            triangles.indexBuffer = m_IndexBuffer;
-            triangles.indexOffset = instance.indexOffset * sizeof(uint32_t);
-            triangles.indexFormat = nvrhi::Format::R32_UINT;
-            triangles.indexCount = indexCount;
-            triangles.vertexBuffer = m_VertexBuffer;
-            triangles.vertexOffset = 0;  // Use global indices - no vertex offset
-            triangles.vertexFormat = nvrhi::Format::RGB32_FLOAT;
-            triangles.vertexStride = sizeof(GPUVertex);
-            triangles.vertexCount = static_cast<uint32_t>(m_Vertices.size());  // Total vertex count
-            geometryDesc.geometryType = nvrhi::rt::GeometryType::Triangles;
-            geometryDesc.flags = nvrhi::rt::GeometryFlags::Opaque;
-            blasDesc.bottomLevelGeometries.push_back(geometryDesc);
-
-            nvrhi::rt::AccelStructHandle blas = GetDevice()->createAccelStruct(blasDesc);
-            nvrhi::utils::BuildBottomLevelAccelStruct(m_CommandList, blas, blasDesc);
-            m_BottomLevelAS.push_back(blas);
-
-            // Create TLAS instance
-            nvrhi::rt::InstanceDesc instanceDesc;
-            instanceDesc.bottomLevelAS = blas;
-            instanceDesc.instanceMask = 1;
-            instanceDesc.instanceID = static_cast<uint32_t>(i);
-            instanceDesc.flags = nvrhi::rt::InstanceFlags::TriangleFrontCounterclockwise;
-            // Identity transform for TLAS instance (row-major 3x4 matrix)
-            float transform[12] = {
-                1.0f, 0.0f, 0.0f, 0.0f,  // row 0
-                0.0f, 1.0f, 0.0f, 0.0f,  // row 1
-                0.0f, 0.0f, 1.0f, 0.0f   // row 2
-            };
-            memcpy(instanceDesc.transform, transform, sizeof(transform));
-            tlasInstances.push_back(instanceDesc);
+        m_CommandList->open();
+
+        bool resized = false;
+        resized |= PatchSceneBuffer(m_PositionBuffer, m_PositionCapacity, m_Scene.positions,
+            delta.vertexRanges, false, true, "PositionBuffer");
+        resized |= PatchSceneBuffer(m_VertexBuffer, m_VertexCapacity, m_Scene.vertices,
+            delta.vertexRanges, false, false, "VertexBuffer");
+        resized |= PatchSceneBuffer(m_IndexBuffer, m_IndexCapacity, m_Scene.indices,
+            delta.indexRanges, false, true, "IndexBuffer");
+        if (!m_Scene.materials.empty())
+        {
+            resized |= PatchSceneBuffer(m_MaterialBuffer, m_MaterialCapacity, m_Scene.materials,
+                { delta.materialRange }, delta.materialsResized, false, "MaterialBuffer");
+        }
+        if (!m_Scene.instances.empty())
+        {
+            resized |= PatchSceneBuffer(m_InstanceBuffer, m_InstanceCapacity, m_Scene.instances,
+                { delta.instanceRange }, delta.instancesResized, false, "InstanceBuffer");
+        }
+        if (resized)
+        {
+            m_BindingSet = nullptr;
+        }
+
+        // BLAS copy their input, so meshes that did not change keep theirs
+        // even if the position buffer was just recreated
+        for (uint32_t meshIndex : delta.rebuiltMeshes)
+        {
+            m_BottomLevelAS[meshIndex] = BuildMeshBLAS(m_Scene.meshes[meshIndex]);
+        }
+        for (size_t meshIndex = delta.firstNewMesh; meshIndex < m_Scene.meshes.size(); meshIndex++)
+        {
+            m_BottomLevelAS.push_back(BuildMeshBLAS(m_Scene.meshes[meshIndex]));
+        }
+
+        bool blasChanged = !delta.rebuiltMeshes.empty() || m_Scene.meshes.size() > delta.firstNewMesh;
+        if (delta.placementsChanged || blasChanged)
+        {
+            // Moved shapes only need a refit; new BLAS or instance counts a full build
+            BuildTopLevelAS(!blasChanged && !delta.instancesResized);
         }
 
-        // Build TLAS
-        nvrhi::rt::AccelStructDesc tlasDesc;
-        tlasDesc.isTopLevel = true;
-        tlasDesc.topLevelMaxInstances = static_cast<uint32_t>(tlasInstances.size());
+        m_CommandList->close();
+        GetDevice()->executeCommandList(m_CommandList);
+
+        if (xmlChanged)
+        {
+            WatchSceneFiles();
+        }
+        m_FrameIndex = 0;
 
-        m_TopLevelAS = GetDevice()->createAccelStruct(tlasDesc);
-        m_CommandList->buildTopLevelAccelStruct(m_TopLevelAS, tlasInstances.data(), tlasInstances.size());
+        double reloadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - reloadStart).count();
+        log::info("Hot reload of %zu file(s) in %.2f ms: %zu meshes rebuilt, %zu added, %u materials%s, "
+            "%u instances%s, TLAS %s, %zu textures replaced",
+            changed.size(), reloadMs, delta.rebuiltMeshes.size(), m_Scene.meshes.size() - delta.firstNewMesh,
+            delta.materialsResized ? uint32_t(m_Scene.materials.size()) : delta.materialRange.count,
+            delta.materialsResized ? " (resized)" : "",
+            delta.instancesResized ? uint32_t(m_Scene.instances.size()) : delta.instanceRange.count,
+            delta.instancesResized ? " (resized)" : "",
+            (delta.placementsChanged || blasChanged) ? (blasChanged || delta.instancesResized ? "rebuilt" : "refit") : "unchanged",
+            replacedTextures);
     }
 
     void SetupCameraFromScene()
     {
         // Extract camera position from transform matrix
         // HMM column-major: Columns[3] = translation = (m03, m13, m23, m33)
-        HMM_Mat4& camTransform = m_SceneParser.camera.transform;
+        HMM_Mat4& camTransform = m_SceneParser->camera.transform;
         
         m_CameraPosition = HMM_V3(
             camTransform.Columns[3].X,
@@ -1905,6 +928,11 @@ public:
 
     void Animate(float fElapsedTimeSeconds) override
     {
+        if (m_WatchScene)
+        {
+            ReloadChangedFiles();
+        }
+
         // Calculate forward and right vectors from yaw/pitch
         HMM_Vec3 forward = HMM_V3(
             sinf(m_CameraYaw) * cosf(m_CameraPitch),
@@ -2092,7 +1120,14 @@ public:
             }
 #endif
 
-            // Create binding set
+            // Render targets changed, so the binding set must be recreated
+            m_BindingSet = nullptr;
+        }
+
+        // Create binding set (again after a resize or a hot reload that
+        // replaced bound resources)
+        if (!m_BindingSet)
+        {
             nvrhi::BindingSetDesc bindingSetDesc;
             bindingSetDesc.bindings = {
                 nvrhi::BindingSetItem::RayTracingAccelStruct(0, m_TopLevelAS),
@@ -2132,7 +1167,7 @@ public:
         float aspect = float(fbinfo.width) / float(fbinfo.height);
         
         // Mitsuba uses horizontal FOV by default, convert to vertical FOV
-        float horizontalFovRadians = m_SceneParser.camera.fov * (HMM_PI32 / 180.0f);
+        float horizontalFovRadians = m_SceneParser->camera.fov * (HMM_PI32 / 180.0f);
         float verticalFovRadians = 2.0f * atanf(tanf(horizontalFovRadians * 0.5f) / aspect);
 
         // Use RH perspective with [0,1] depth (matches Mitsuba's RH convention)
@@ -2151,8 +1186,8 @@ public:
         m_CameraConstants.cameraPosition[1] = m_CameraPosition.Y;
         m_CameraConstants.cameraPosition[2] = m_CameraPosition.Z;
         m_CameraConstants.frameIndex = m_FrameIndex;
-        m_CameraConstants.envMapIntensity = m_SceneParser.environmentMap.intensity;
-        m_CameraConstants.hasEnvMap = m_SceneParser.environmentMap.isValid ? 1 : 0;
+        m_CameraConstants.envMapIntensity = m_SceneParser->environmentMap.intensity;
+        m_CameraConstants.hasEnvMap = m_SceneParser->environmentMap.isValid ? 1 : 0;
         m_CameraConstants.exposure = m_Exposure;
 
         // Debug: print first frame info
@@ -2375,6 +1410,7 @@ int main(int __argc, const char** __argv)
 
     // Get scene path from command line or use default
     std::filesystem::path scenePath;
+    bool watchScene = false;    // --watch: hot-reload edits to the scene files
     
 #ifdef WIN32
     int argc;
@@ -2383,10 +1419,13 @@ int main(int __argc, const char** __argv)
     for (int i = 1; i < argc; i++)
     {
         std::wstring arg = argv[i];
-        if (arg.find(L".xml") != std::wstring::npos)
+        if (arg == L"--watch")
+        {
+            watchScene = true;
+        }
+        else if (scenePath.empty() && arg.find(L".xml") != std::wstring::npos)
         {
             scenePath = arg;
-            break;
         }
     }
     LocalFree(argv);
@@ -2394,17 +1433,20 @@ int main(int __argc, const char** __argv)
     for (int i = 1; i < __argc; i++)
     {
         std::string arg = __argv[i];
-        if (arg.find(".xml") != std::string::npos)
+        if (arg == "--watch")
+        {
+            watchScene = true;
+        }
+        else if (scenePath.empty() && arg.find(".xml") != std::string::npos)
         {
             scenePath = arg;
-            break;
         }
     }
 #endif
 
     if (scenePath.empty())
     {
-        log::info("Usage: rt_scene <scene.xml>");
+        log::info("Usage: rt_scene <scene.xml> [--watch]");
         log::info("No scene file specified. Please provide a Mitsuba scene XML file.");
         
         // Try to use a default path for testing
@@ -2435,7 +1477,7 @@ int main(int __argc, const char** __argv)
         std::shared_ptr<engine::ShaderFactory> shaderFactory = std::make_shared<engine::ShaderFactory>(
             deviceManager->GetDevice(), rootFs, "/");
         
-        RayTracedScene example(deviceManager, scenePath);
+        RayTracedScene example(deviceManager, scenePath, watchScene);
         if (example.Init())
         {
             UIRenderer ui(deviceManager, &example);
@@ -6,14 +6,12 @@
 // ============================================================================
 // Structures
 // ============================================================================
+// Shading attributes, packed by PackVertex() in scene_core/vertex_format.cpp.
+// Positions live in a separate buffer that only the BLAS builds read.
 struct GPUVertex
 {
-    float3 position;
-    float pad0;
-    float3 normal;
-    float pad1;
-    float2 texcoord;
-    float2 pad2;
+    uint normal;        // Octahedral, two snorm16 (x in the low half)
+    uint texcoord;      // Two half floats (u in the low half)
 };
 
 struct GPUMaterial
@@ -236,19 +234,38 @@ float3 SampleBRDFWithWeight(GPUMaterial mat, float3 wo, float3 normal, float2 u,
 // ============================================================================
 // Intersection Helpers
 // ============================================================================
+float3 UnpackNormal(uint packed)
+{
+    // Sign-extend the two snorm16 halves
+    int2 q = asint(uint2(packed << 16, packed)) >> 16;
+    float2 e = max(float2(q) / 32767.0f, -1.0f);
+
+    // Unfold the lower hemisphere of the octahedron
+    float3 n = float3(e, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.x -= (n.x >= 0.0f ? 1.0f : -1.0f) * t;
+    n.y -= (n.y >= 0.0f ? 1.0f : -1.0f) * t;
+    return normalize(n);
+}
+
+float2 UnpackTexcoord(uint packed)
+{
+    return float2(f16tof32(packed), f16tof32(packed >> 16));
+}
+
 float3 GetInterpolatedNormal(uint instanceID, uint primitiveIndex, float2 barycentrics)
 {
     GPUInstance instance = Instances[instanceID];
     
-    // Get triangle vertex indices (global indices into vertex buffer)
-    uint i0 = Indices[instance.indexOffset + primitiveIndex * 3 + 0];
-    uint i1 = Indices[instance.indexOffset + primitiveIndex * 3 + 1];
-    uint i2 = Indices[instance.indexOffset + primitiveIndex * 3 + 2];
+    // Get triangle vertex indices (local to the instance's mesh)
+    uint i0 = instance.vertexOffset + Indices[instance.indexOffset + primitiveIndex * 3 + 0];
+    uint i1 = instance.vertexOffset + Indices[instance.indexOffset + primitiveIndex * 3 + 1];
+    uint i2 = instance.vertexOffset + Indices[instance.indexOffset + primitiveIndex * 3 + 2];
     
     // Fetch vertex normals
-    float3 n0 = Vertices[i0].normal;
-    float3 n1 = Vertices[i1].normal;
-    float3 n2 = Vertices[i2].normal;
+    float3 n0 = UnpackNormal(Vertices[i0].normal);
+    float3 n1 = UnpackNormal(Vertices[i1].normal);
+    float3 n2 = UnpackNormal(Vertices[i2].normal);
     
     // Barycentric interpolation
     float3 normal = n0 * (1.0f - barycentrics.x - barycentrics.y) +
@@ -262,15 +279,15 @@ float2 GetInterpolatedTexcoord(uint instanceID, uint primitiveIndex, float2 bary
 {
     GPUInstance instance = Instances[instanceID];
     
-    // Get triangle vertex indices (global indices into vertex buffer)
-    uint i0 = Indices[instance.indexOffset + primitiveIndex * 3 + 0];
-    uint i1 = Indices[instance.indexOffset + primitiveIndex * 3 + 1];
-    uint i2 = Indices[instance.indexOffset + primitiveIndex * 3 + 2];
+    // Get triangle vertex indices (local to the instance's mesh)
+    uint i0 = instance.vertexOffset + Indices[instance.indexOffset + primitiveIndex * 3 + 0];
+    uint i1 = instance.vertexOffset + Indices[instance.indexOffset + primitiveIndex * 3 + 1];
+    uint i2 = instance.vertexOffset + Indices[instance.indexOffset + primitiveIndex * 3 + 2];
     
     // Fetch vertex texcoords
-    float2 t0 = Vertices[i0].texcoord;
-    float2 t1 = Vertices[i1].texcoord;
-    float2 t2 = Vertices[i2].texcoord;
+    float2 t0 = UnpackTexcoord(Vertices[i0].texcoord);
+    float2 t1 = UnpackTexcoord(Vertices[i1].texcoord);
+    float2 t2 = UnpackTexcoord(Vertices[i2].texcoord);
     
     // Barycentric interpolation
     float2 texcoord = t0 * (1.0f - barycentrics.x - barycentrics.y) +
@@ -657,7 +674,10 @@ void ClosestHit(inout HitInfo payload, in Attributes attrib)
     uint primitiveIndex = PrimitiveIndex();
     
     // Get interpolated normal and texcoord
+    // Shape group meshes are stored in object space: bring the normal to world
+    // space with the inverse transpose (identity for pre-transformed meshes)
     float3 normal = GetInterpolatedNormal(instanceID, primitiveIndex, attrib.barycentrics);
+    normal = normalize(mul(normal, (float3x3)WorldToObject3x4()));
     float2 texcoord = GetInterpolatedTexcoord(instanceID, primitiveIndex, attrib.barycentrics);
     
     GPUInstance instance = Instances[instanceID];
@@ -0,0 +1,659 @@
+#include "mesh_simplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <tuple>
+
+// ============================================================================
+// Quadrics
+// The summed squared distance to a set of planes, each weighted by the area
+// of the triangle it came from, as the symmetric 4x4 matrix of the plane
+// equations. Dividing by the summed area gives a mean squared distance.
+// ============================================================================
+namespace
+{
+
+constexpr float kBorderWeight = 10.0f;  // Border planes, per squared edge length
+constexpr uint32_t kNone = UINT32_MAX;
+
+struct Quadric
+{
+    float a2 = 0, b2 = 0, c2 = 0, d2 = 0;
+    float ab = 0, ac = 0, ad = 0, bc = 0, bd = 0, cd = 0;
+    float area = 0;
+
+    void AddPlane(const float n[3], float d, float weight)
+    {
+        a2 += weight * n[0] * n[0];
+        b2 += weight * n[1] * n[1];
+        c2 += weight * n[2] * n[2];
+        d2 += weight * d * d;
+        ab += weight * n[0] * n[1];
+        ac += weight * n[0] * n[2];
+        ad += weight * n[0] * d;
+        bc += weight * n[1] * n[2];
+        bd += weight * n[1] * d;
+        cd += weight * n[2] * d;
+    }
+
+    void Add(const Quadric& other)
+    {
+        a2 += other.a2; b2 += other.b2; c2 += other.c2; d2 += other.d2;
+        ab += other.ab; ac += other.ac; ad += other.ad;
+        bc += other.bc; bd += other.bd; cd += other.cd;
+        area += other.area;
+    }
+
+    float Error(const float p[3]) const
+    {
+        const float x = p[0], y = p[1], z = p[2];
+        const float error = a2 * x * x + b2 * y * y + c2 * z * z
+                          + 2.0f * (ab * x * y + ac * x * z + bc * y * z)
+                          + 2.0f * (ad * x + bd * y + cd * z) + d2;
+        return std::max(error, 0.0f);
+    }
+};
+
+inline void Subtract(const float* a, const float* b, float out[3])
+{
+    out[0] = a[0] - b[0];
+    out[1] = a[1] - b[1];
+    out[2] = a[2] - b[2];
+}
+
+inline void Cross(const float a[3], const float b[3], float out[3])
+{
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+inline float Dot(const float a[3], const float b[3])
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// ============================================================================
+// Vertex Kinds
+// Manifold vertices are surrounded by triangles and may collapse onto any
+// neighbour. Border vertices sit on one open border and seam vertices are
+// one of exactly two copies of a position on a closed surface (split by
+// normal or texcoord); both only collapse along their border or seam, seam
+// vertices together with their copy. Anything else is locked.
+// ============================================================================
+enum class VertexKind : uint8_t
+{
+    Manifold,
+    Border,
+    Seam,
+    Locked,
+};
+
+class Simplifier
+{
+public:
+    Simplifier(const SimplifyVertices& vertices, std::span<const uint32_t> indices, const LODSettings& settings);
+
+    // Collapse edges until at most `targetIndexCount` indices are left or
+    // nothing more can collapse
+    void Run(size_t targetIndexCount);
+
+    const std::vector<uint32_t>& Indices() const { return m_Indices; }
+    float Error() const { return m_Error * m_Scale; }
+
+private:
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        float cost;     // Position, border and attribute error, orders the collapses
+        float error;    // Distance to the triangle planes only, in mesh sizes
+    };
+
+    size_t Pass(size_t targetIndexCount);
+    void BuildAdjacency();
+    void ClassifyVertices();
+    void BuildQuadrics();
+
+    std::span<const uint32_t> TrianglesOf(uint32_t v) const
+    {
+        return { m_VertexTriangles.data() + m_FirstTriangle[v], m_FirstTriangle[v + 1] - m_FirstTriangle[v] };
+    }
+    const float* Position(uint32_t v) const { return &m_Positions[v * 3]; }
+
+    bool HasEdge(uint32_t a, uint32_t b) const;
+    bool HasPositionEdge(uint32_t a, uint32_t b) const;
+    uint32_t SeamPartner(uint32_t from, uint32_t to) const;
+    bool CanCollapse(uint32_t from, uint32_t to) const;
+    bool Flips(uint32_t from, uint32_t to) const;
+    float AttributeCost(uint32_t from, uint32_t to) const;
+    Collapse Evaluate(uint32_t from, uint32_t to) const;
+
+    LODSettings m_Settings;
+    size_t m_VertexCount = 0;
+    std::vector<float> m_Positions;     // Moved and scaled into the unit cube
+    std::vector<float> m_Normals;
+    std::vector<float> m_Texcoords;
+    float m_Scale = 1.0f;               // Object units per mesh size
+
+    std::vector<uint32_t> m_Wedge;      // Next vertex with the same position, in a loop
+    std::vector<uint32_t> m_PositionId; // Lowest vertex with the same position
+    std::vector<VertexKind> m_Kind;
+    std::vector<Quadric> m_Quadrics;        // Triangle planes
+    std::vector<Quadric> m_BorderQuadrics;  // Open edge planes, only steer the order
+
+    std::vector<uint32_t> m_Indices;
+    std::vector<uint32_t> m_FirstTriangle;
+    std::vector<uint32_t> m_VertexTriangles;
+    float m_Error = 0.0f;
+};
+
+Simplifier::Simplifier(const SimplifyVertices& vertices, std::span<const uint32_t> indices,
+                       const LODSettings& settings)
+    : m_Settings(settings)
+    , m_VertexCount(vertices.count)
+    , m_Indices(indices.begin(), indices.end())
+{
+    const size_t n = m_VertexCount;
+    auto stream = [&](const float* base, size_t v) {
+        return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(base) + v * vertices.stride);
+    };
+
+    float lower[3] = { INFINITY, INFINITY, INFINITY };
+    float upper[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (size_t v = 0; v < n; v++)
+    {
+        const float* p = stream(vertices.positions, v);
+        for (int k = 0; k < 3; k++)
+        {
+            lower[k] = std::min(lower[k], p[k]);
+            upper[k] = std::max(upper[k], p[k]);
+        }
+    }
+    const float extent = n > 0 ? std::max({ upper[0] - lower[0], upper[1] - lower[1], upper[2] - lower[2] }) : 0.0f;
+    m_Scale = extent > 0.0f ? extent : 1.0f;
+
+    m_Positions.resize(n * 3);
+    m_Normals.assign(n * 3, 0.0f);
+    m_Texcoords.assign(n * 2, 0.0f);
+    for (size_t v = 0; v < n; v++)
+    {
+        const float* p = stream(vertices.positions, v);
+        for (int k = 0; k < 3; k++)
+        {
+            m_Positions[v * 3 + k] = (p[k] - lower[k]) / m_Scale;
+        }
+        if (vertices.normals)
+        {
+            memcpy(&m_Normals[v * 3], stream(vertices.normals, v), sizeof(float) * 3);
+        }
+        if (vertices.texcoords)
+        {
+            memcpy(&m_Texcoords[v * 2], stream(vertices.texcoords, v), sizeof(float) * 2);
+        }
+    }
+
+    // Copies of a position are found by sorting on the original bits
+    std::vector<uint32_t> order(n);
+    for (size_t v = 0; v < n; v++)
+    {
+        order[v] = static_cast<uint32_t>(v);
+    }
+    auto bits = [&](uint32_t v) {
+        const float* p = stream(vertices.positions, v);
+        uint32_t key[3];
+        memcpy(key, p, sizeof(key));
+        return std::make_tuple(key[0], key[1], key[2]);
+    };
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        const auto ka = bits(a);
+        const auto kb = bits(b);
+        return ka != kb ? ka < kb : a < b;
+    });
+    m_Wedge.resize(n);
+    m_PositionId.resize(n);
+    for (size_t begin = 0; begin < n;)
+    {
+        size_t end = begin + 1;
+        while (end < n && bits(order[end]) == bits(order[begin]))
+        {
+            end++;
+        }
+        for (size_t i = begin; i < end; i++)
+        {
+            m_Wedge[order[i]] = order[i + 1 < end ? i + 1 : begin];
+            m_PositionId[order[i]] = order[begin];
+        }
+        begin = end;
+    }
+
+    BuildAdjacency();
+    ClassifyVertices();
+    BuildQuadrics();
+}
+
+// ============================================================================
+// Topology
+// Rebuilt from the current triangles on every pass, so edges that collapses
+// created are seen as well.
+// ============================================================================
+void Simplifier::BuildAdjacency()
+{
+    const size_t n = m_VertexCount;
+    m_FirstTriangle.assign(n + 1, 0);
+    for (uint32_t index : m_Indices)
+    {
+        m_FirstTriangle[index + 1]++;
+    }
+    for (size_t v = 0; v < n; v++)
+    {
+        m_FirstTriangle[v + 1] += m_FirstTriangle[v];
+    }
+    m_VertexTriangles.resize(m_Indices.size());
+    std::vector<uint32_t> fill(m_FirstTriangle.begin(), m_FirstTriangle.end() - 1);
+    for (size_t i = 0; i < m_Indices.size(); i++)
+    {
+        m_VertexTriangles[fill[m_Indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+}
+
+// Directed edge a -> b in some triangle's winding
+bool Simplifier::HasEdge(uint32_t a, uint32_t b) const
+{
+    for (uint32_t t : TrianglesOf(a))
+    {
+        const uint32_t* c = &m_Indices[t * 3];
+        for (int k = 0; k < 3; k++)
+        {
+            if (c[k] == a && c[(k + 1) % 3] == b)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Directed edge between any copies of the two positions
+bool Simplifier::HasPositionEdge(uint32_t a, uint32_t b) const
+{
+    const uint32_t target = m_PositionId[b];
+    uint32_t w = a;
+    do
+    {
+        for (uint32_t t : TrianglesOf(w))
+        {
+            const uint32_t* c = &m_Indices[t * 3];
+            for (int k = 0; k < 3; k++)
+            {
+                if (c[k] == w && m_PositionId[c[(k + 1) % 3]] == target)
+                {
+                    return true;
+                }
+            }
+        }
+        w = m_Wedge[w];
+    } while (w != a);
+    return false;
+}
+
+void Simplifier::ClassifyVertices()
+{
+    const size_t n = m_VertexCount;
+
+    // Open edges have no triangle on the other side; counted per vertex and,
+    // over all copies, per position
+    std::vector<uint32_t> openOut(n, 0), openIn(n, 0);
+    std::vector<uint32_t> positionOpenOut(n, 0), positionOpenIn(n, 0);
+    for (size_t i = 0; i < m_Indices.size(); i++)
+    {
+        const uint32_t a = m_Indices[i];
+        const uint32_t b = m_Indices[i - i % 3 + (i % 3 + 1) % 3];
+        if (!HasEdge(b, a))
+        {
+            openOut[a]++;
+            openIn[b]++;
+        }
+        if (!HasPositionEdge(b, a))
+        {
+            positionOpenOut[m_PositionId[a]]++;
+            positionOpenIn[m_PositionId[b]]++;
+        }
+    }
+
+    m_Kind.assign(n, VertexKind::Locked);
+    for (size_t v = 0; v < n; v++)
+    {
+        const uint32_t p = m_PositionId[v];
+        const uint32_t wedge = m_Wedge[v];
+        if (wedge == v)
+        {
+            if (openOut[v] == 0 && openIn[v] == 0)
+            {
+                m_Kind[v] = VertexKind::Manifold;
+            }
+            else if (openOut[v] == 1 && openIn[v] == 1 && positionOpenOut[p] == 1 && positionOpenIn[p] == 1)
+            {
+                m_Kind[v] = VertexKind::Border;
+            }
+        }
+        else if (m_Wedge[wedge] == v && positionOpenOut[p] == 0 && positionOpenIn[p] == 0
+                 && openOut[v] == 1 && openIn[v] == 1 && openOut[wedge] == 1 && openIn[wedge] == 1)
+        {
+            m_Kind[v] = VertexKind::Seam;
+        }
+    }
+}
+
+// Each vertex gets the planes of its triangles, plus planes through its open
+// edges at right angles to the triangle, which hold borders and seams in
+// place
+void Simplifier::BuildQuadrics()
+{
+    m_Quadrics.assign(m_VertexCount, Quadric{});
+    m_BorderQuadrics.assign(m_VertexCount, Quadric{});
+    for (size_t t = 0; t < m_Indices.size() / 3; t++)
+    {
+        const uint32_t* c = &m_Indices[t * 3];
+        float e1[3], e2[3], normal[3];
+        Subtract(Position(c[1]), Position(c[0]), e1);
+        Subtract(Position(c[2]), Position(c[0]), e2);
+        Cross(e1, e2, normal);
+        const float length = std::sqrt(Dot(normal, normal));
+        if (!(length > 0.0f))
+        {
+            continue;
+        }
+        for (float& x : normal)
+        {
+            x /= length;
+        }
+        const float area = length * 0.5f;
+        const float d = -Dot(normal, Position(c[0]));
+        for (int k = 0; k < 3; k++)
+        {
+            m_Quadrics[c[k]].AddPlane(normal, d, area);
+            m_Quadrics[c[k]].area += area;
+        }
+
+        for (int k = 0; k < 3; k++)
+        {
+            const uint32_t a = c[k];
+            const uint32_t b = c[(k + 1) % 3];
+            if (HasEdge(b, a))
+            {
+                continue;
+            }
+            float edge[3], side[3];
+            Subtract(Position(b), Position(a), edge);
+            Cross(edge, normal, side);
+            const float sideLength = std::sqrt(Dot(side, side));
+            if (!(sideLength > 0.0f))
+            {
+                continue;
+            }
+            for (float& x : side)
+            {
+                x /= sideLength;
+            }
+            const float sideD = -Dot(side, Position(a));
+            const float weight = kBorderWeight * Dot(edge, edge);
+            m_BorderQuadrics[a].AddPlane(side, sideD, weight);
+            m_BorderQuadrics[b].AddPlane(side, sideD, weight);
+        }
+    }
+}
+
+// ============================================================================
+// Collapses
+// ============================================================================
+// The copy of `to` that the other copy of seam vertex `from` collapses onto:
+// the one across the seam, or `to` itself where the seam ends there
+uint32_t Simplifier::SeamPartner(uint32_t from, uint32_t to) const
+{
+    const uint32_t other = m_Wedge[from];
+    for (uint32_t w = m_Wedge[to]; w != to; w = m_Wedge[w])
+    {
+        if (HasEdge(other, w) || HasEdge(w, other))
+        {
+            return w;
+        }
+    }
+    return HasEdge(other, to) || HasEdge(to, other) ? to : kNone;
+}
+
+bool Simplifier::CanCollapse(uint32_t from, uint32_t to) const
+{
+    if (m_PositionId[from] == m_PositionId[to])
+    {
+        return false;
+    }
+    switch (m_Kind[from])
+    {
+    case VertexKind::Manifold:
+        return true;
+    case VertexKind::Border:
+        return (HasPositionEdge(from, to) && !HasPositionEdge(to, from))
+            || (HasPositionEdge(to, from) && !HasPositionEdge(from, to));
+    case VertexKind::Seam:
+        return ((HasEdge(from, to) && !HasEdge(to, from)) || (HasEdge(to, from) && !HasEdge(from, to)))
+            && SeamPartner(from, to) != kNone;
+    default:
+        return false;
+    }
+}
+
+// Whether moving `from` onto `to` turns one of its remaining triangles over
+// or on edge
+bool Simplifier::Flips(uint32_t from, uint32_t to) const
+{
+    for (uint32_t t : TrianglesOf(from))
+    {
+        const uint32_t* c = &m_Indices[t * 3];
+        if (c[0] == to || c[1] == to || c[2] == to)
+        {
+            continue;
+        }
+        const int k = c[0] == from ? 0 : c[1] == from ? 1 : 2;
+        const float* a = Position(c[(k + 1) % 3]);
+        const float* b = Position(c[(k + 2) % 3]);
+        float ab[3], before[3], after[3], nBefore[3], nAfter[3];
+        Subtract(b, a, ab);
+        Subtract(Position(from), a, before);
+        Subtract(Position(to), a, after);
+        Cross(ab, before, nBefore);
+        Cross(ab, after, nAfter);
+        // Also rejects turns close to a flip, which the next collapses
+        // would finish
+        if (Dot(nBefore, nAfter) <= 0.25f * std::sqrt(Dot(nBefore, nBefore) * Dot(nAfter, nAfter)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Area-weighted change of the interpolated attributes over `from`'s triangles
+float Simplifier::AttributeCost(uint32_t from, uint32_t to) const
+{
+    float normal = 0.0f;
+    for (int k = 0; k < 3; k++)
+    {
+        const float d = m_Normals[from * 3 + k] - m_Normals[to * 3 + k];
+        normal += d * d;
+    }
+    float texcoord = 0.0f;
+    for (int k = 0; k < 2; k++)
+    {
+        const float d = m_Texcoords[from * 2 + k] - m_Texcoords[to * 2 + k];
+        texcoord += d * d;
+    }
+    return m_Quadrics[from].area * (m_Settings.normalWeight * normal + m_Settings.texcoordWeight * texcoord);
+}
+
+Simplifier::Collapse Simplifier::Evaluate(uint32_t from, uint32_t to) const
+{
+    float position = m_Quadrics[from].Error(Position(to));
+    float area = m_Quadrics[from].area;
+    float constraints = m_BorderQuadrics[from].Error(Position(to)) + AttributeCost(from, to);
+    if (m_Kind[from] == VertexKind::Seam)
+    {
+        const uint32_t other = m_Wedge[from];
+        const uint32_t otherTo = SeamPartner(from, to);
+        position += m_Quadrics[other].Error(Position(otherTo));
+        area += m_Quadrics[other].area;
+        constraints += m_BorderQuadrics[other].Error(Position(otherTo)) + AttributeCost(other, otherTo);
+    }
+    const float error = area > 0.0f ? std::sqrt(position / area) : 0.0f;
+    return { from, to, position + constraints, error };
+}
+
+// One round of the cheapest collapses that do not touch each other's
+// triangles, so each can be checked for flips on its own. Returns the
+// number of collapses.
+size_t Simplifier::Pass(size_t targetIndexCount)
+{
+    const size_t n = m_VertexCount;
+    BuildAdjacency();
+
+    std::vector<Collapse> candidates;
+    for (uint32_t from = 0; from < n; from++)
+    {
+        if (m_Kind[from] == VertexKind::Locked || TrianglesOf(from).empty())
+        {
+            continue;
+        }
+        Collapse best = { kNone, kNone, INFINITY, 0.0f };
+        for (uint32_t t : TrianglesOf(from))
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                const uint32_t to = m_Indices[t * 3 + k];
+                if (to == from || !CanCollapse(from, to))
+                {
+                    continue;
+                }
+                const Collapse collapse = Evaluate(from, to);
+                if (collapse.cost < best.cost || (collapse.cost == best.cost && to < best.to))
+                {
+                    best = collapse;
+                }
+            }
+        }
+        if (best.to != kNone)
+        {
+            candidates.push_back(best);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b) {
+        return a.cost != b.cost ? a.cost < b.cost : a.from < b.from;
+    });
+
+    const size_t triangleGoal = (m_Indices.size() - targetIndexCount + 2) / 3;
+    std::vector<uint32_t> remap(n);
+    for (size_t v = 0; v < n; v++)
+    {
+        remap[v] = static_cast<uint32_t>(v);
+    }
+    std::vector<uint8_t> touched(n, 0);
+    size_t removed = 0;
+    size_t collapses = 0;
+    for (const Collapse& collapse : candidates)
+    {
+        if (removed >= triangleGoal)
+        {
+            break;
+        }
+        const bool seam = m_Kind[collapse.from] == VertexKind::Seam;
+        const uint32_t from[2] = { collapse.from, seam ? m_Wedge[collapse.from] : kNone };
+        const uint32_t to[2] = { collapse.to, seam ? SeamPartner(collapse.from, collapse.to) : kNone };
+        const int count = seam ? 2 : 1;
+
+        bool blocked = false;
+        for (int i = 0; i < count; i++)
+        {
+            blocked = blocked || touched[from[i]] || touched[to[i]] || Flips(from[i], to[i]);
+        }
+        if (blocked)
+        {
+            continue;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            remap[from[i]] = to[i];
+            m_Quadrics[to[i]].Add(m_Quadrics[from[i]]);
+            m_BorderQuadrics[to[i]].Add(m_BorderQuadrics[from[i]]);
+            for (uint32_t t : TrianglesOf(from[i]))
+            {
+                const uint32_t* c = &m_Indices[t * 3];
+                removed += (c[0] == to[i] || c[1] == to[i] || c[2] == to[i]) ? 1 : 0;
+                touched[c[0]] = touched[c[1]] = touched[c[2]] = 1;
+            }
+        }
+        m_Error = std::max(m_Error, collapse.error);
+        collapses++;
+    }
+
+    // Triangles that lost a corner are dropped
+    size_t write = 0;
+    for (size_t i = 0; i < m_Indices.size(); i += 3)
+    {
+        const uint32_t a = remap[m_Indices[i + 0]];
+        const uint32_t b = remap[m_Indices[i + 1]];
+        const uint32_t c = remap[m_Indices[i + 2]];
+        if (a != b && b != c && c != a)
+        {
+            m_Indices[write++] = a;
+            m_Indices[write++] = b;
+            m_Indices[write++] = c;
+        }
+    }
+    m_Indices.resize(write);
+    return collapses;
+}
+
+void Simplifier::Run(size_t targetIndexCount)
+{
+    while (m_Indices.size() > targetIndexCount && Pass(targetIndexCount) > 0)
+    {
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// LOD Chain
+// One simplifier runs down through all the levels, so the quadrics and the
+// error of each level are measured against the full-resolution mesh.
+// ============================================================================
+std::vector<MeshLOD> BuildLODChain(const SimplifyVertices& vertices, std::vector<uint32_t>& indices,
+                                   const LODSettings& settings)
+{
+    std::vector<MeshLOD> lods;
+    lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+
+    const size_t minIndices = size_t(settings.minTriangles) * 3;
+    if (settings.maxLevels < 2 || indices.size() <= minIndices)
+    {
+        return lods;
+    }
+
+    Simplifier simplifier(vertices, indices, settings);
+    size_t previous = indices.size();
+    while (lods.size() < settings.maxLevels && previous > minIndices)
+    {
+        const size_t target = std::max(size_t(float(previous / 3) * settings.reduction) * 3, minIndices);
+        simplifier.Run(target);
+        const size_t count = simplifier.Indices().size();
+        if (count > previous - previous / 8)
+        {
+            break;
+        }
+        lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(count), simplifier.Error() });
+        indices.insert(indices.end(), simplifier.Indices().begin(), simplifier.Indices().end());
+        previous = count;
+    }
+    return lods;
+}
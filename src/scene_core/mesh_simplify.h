@@ -0,0 +1,53 @@
+#pragma once
+
+// ============================================================================
+// Mesh Simplify
+// Level-of-detail chains by edge collapse, cheapest first by quadric error
+// (Garland and Heckbert, "Surface Simplification Using Quadric Error
+// Metrics", 1997). A collapse moves a vertex onto one of its neighbours, so
+// every level indexes a subset of the original vertices and all levels can
+// share one vertex buffer. Normal and texcoord changes add to the cost of a
+// collapse. Open borders and attribute seams only collapse along themselves,
+// and vertices where they meet or branch are kept.
+// ============================================================================
+
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Where the simplifier reads the vertices; every stream uses `stride`
+struct SimplifyVertices
+{
+    const float* positions = nullptr;   // xyz
+    const float* normals = nullptr;     // xyz, optional
+    const float* texcoords = nullptr;   // uv, optional
+    size_t stride = 0;                  // Bytes from one vertex to the next
+    size_t count = 0;
+};
+
+struct LODSettings
+{
+    uint32_t maxLevels = 5;             // Including the full-resolution level
+    float reduction = 0.5f;             // Share of triangles each level keeps of the previous one
+    uint32_t minTriangles = 64;         // No level is built below this
+    // Cost of a unit change of normal / texcoord, relative to the squared
+    // position error measured in mesh sizes
+    float normalWeight = 0.5f;
+    float texcoordWeight = 0.5f;
+};
+
+// One level: a range of the shared index buffer
+struct MeshLOD
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    float error;        // How far the surface may have moved from level 0, in object units
+};
+
+// Append coarser levels of `indices` (level 0, error 0) to the same vector
+// until maxLevels or minTriangles is reached. Stops early when a level
+// would remove less than 1/8 of the previous one's triangles, which happens
+// once only borders, seams and corners are left.
+std::vector<MeshLOD> BuildLODChain(const SimplifyVertices& vertices, std::vector<uint32_t>& indices,
+                                   const LODSettings& settings = {});
@@ -0,0 +1,1278 @@
+#include "mitsuba_parser.h"
+#include "../common/parse_utils.h"
+#include "../common/perfect_hash.h"
+#include "../common/parallel.h"
+
+#include <donut/core/log.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+
+using namespace donut;
+
+// ============================================================================
+// BSDF Lookup Tables
+// Keyed by compile-time perfect hashes (see common/perfect_hash.h)
+// ============================================================================
+namespace
+{
+
+// XML element that carries a property value
+enum class ValueKind : uint8_t
+{
+    Color,
+    Float,
+    String,
+    Texture,
+    Boolean
+};
+
+enum class BSDFProperty : uint8_t
+{
+    Reflectance,            // reflectance, diffuse_reflectance
+    SpecularReflectance,
+    BaseColor,
+    Eta,
+    K,
+    Alpha,
+    Roughness,
+    IntIOR,
+    ExtIOR,
+    Metallic,
+    Specular,
+    SpecTint,
+    Sheen,
+    SheenTint,
+    Clearcoat,
+    ClearcoatGloss,
+    SpecTrans,
+    Opacity,
+    Weight,
+    ConductorMaterial,      // <string name="material">
+    Nonlinear
+};
+
+// Wrapper BSDFs whose only effect we support is their nested <bsdf>
+enum class BSDFKind : uint8_t
+{
+    Material,
+    Wrapper
+};
+
+struct BSDFTypeInfo
+{
+    BSDFKind kind;
+    MaterialType type;
+};
+
+// Complex IOR fitted to RGB
+struct ConductorPreset
+{
+    float eta[3];
+    float k[3];
+};
+
+constexpr auto kValueKinds = perfect_hash::MakeMap<ValueKind>({
+    { "rgb",      ValueKind::Color },
+    { "spectrum", ValueKind::Color },
+    { "float",    ValueKind::Float },
+    { "string",   ValueKind::String },
+    { "texture",  ValueKind::Texture },
+    { "boolean",  ValueKind::Boolean },
+});
+
+constexpr auto kBSDFTypes = perfect_hash::MakeMap<BSDFTypeInfo>({
+    { "diffuse",         { BSDFKind::Material, MaterialType::Diffuse } },
+    { "conductor",       { BSDFKind::Material, MaterialType::Conductor } },
+    { "roughconductor",  { BSDFKind::Material, MaterialType::RoughConductor } },
+    { "dielectric",      { BSDFKind::Material, MaterialType::Dielectric } },
+    { "roughdielectric", { BSDFKind::Material, MaterialType::RoughDielectric } },
+    { "plastic",         { BSDFKind::Material, MaterialType::Plastic } },
+    { "roughplastic",    { BSDFKind::Material, MaterialType::RoughPlastic } },
+    { "pplastic",        { BSDFKind::Material, MaterialType::RoughPlastic } },  // Polarized plastic, shaded as rough plastic
+    { "thindielectric",  { BSDFKind::Material, MaterialType::ThinDielectric } },
+    { "principled",      { BSDFKind::Material, MaterialType::Principled } },
+    { "principledthin",  { BSDFKind::Material, MaterialType::Principled } },
+    { "blendbsdf",       { BSDFKind::Material, MaterialType::Blend } },
+    { "mask",            { BSDFKind::Material, MaterialType::Mask } },
+    { "null",            { BSDFKind::Material, MaterialType::Null } },
+    { "twosided",        { BSDFKind::Wrapper,  MaterialType::Diffuse } },
+    { "bumpmap",         { BSDFKind::Wrapper,  MaterialType::Diffuse } },
+    { "normalmap",       { BSDFKind::Wrapper,  MaterialType::Diffuse } },
+});
+
+constexpr auto kBSDFProperties = perfect_hash::MakeMap<BSDFProperty>({
+    { "reflectance",          BSDFProperty::Reflectance },
+    { "diffuse_reflectance",  BSDFProperty::Reflectance },
+    { "specular_reflectance", BSDFProperty::SpecularReflectance },
+    { "base_color",           BSDFProperty::BaseColor },
+    { "eta",                  BSDFProperty::Eta },
+    { "k",                    BSDFProperty::K },
+    { "alpha",                BSDFProperty::Alpha },
+    { "roughness",            BSDFProperty::Roughness },
+    { "int_ior",              BSDFProperty::IntIOR },
+    { "ext_ior",              BSDFProperty::ExtIOR },
+    { "metallic",             BSDFProperty::Metallic },
+    { "specular",             BSDFProperty::Specular },
+    { "spec_tint",            BSDFProperty::SpecTint },
+    { "sheen",                BSDFProperty::Sheen },
+    { "sheen_tint",           BSDFProperty::SheenTint },
+    { "clearcoat",            BSDFProperty::Clearcoat },
+    { "clearcoat_gloss",      BSDFProperty::ClearcoatGloss },
+    { "spec_trans",           BSDFProperty::SpecTrans },
+    { "opacity",              BSDFProperty::Opacity },
+    { "weight",               BSDFProperty::Weight },
+    { "material",             BSDFProperty::ConductorMaterial },
+    { "nonlinear",            BSDFProperty::Nonlinear },
+});
+
+// Mitsuba conductor material presets
+// Reference: https://mitsuba.readthedocs.io/en/stable/src/generated/plugins_bsdfs.html
+// "_palik" names are Mitsuba's alternative measurements of the same metal;
+// they share the RGB fit of the base entry.
+constexpr ConductorPreset kPresetNone     = { { 0.000f, 0.000f, 0.000f }, { 0.000f, 0.000f, 0.000f } };  // Perfect mirror
+constexpr ConductorPreset kPresetSilver   = { { 0.155f, 0.117f, 0.138f }, { 4.827f, 3.122f, 2.147f } };
+constexpr ConductorPreset kPresetGold     = { { 0.143f, 0.374f, 1.442f }, { 3.983f, 2.387f, 1.603f } };
+constexpr ConductorPreset kPresetCopper   = { { 0.200f, 0.924f, 1.102f }, { 3.912f, 2.452f, 2.142f } };
+constexpr ConductorPreset kPresetAluminum = { { 1.657f, 0.880f, 0.521f }, { 9.224f, 6.269f, 4.837f } };
+constexpr ConductorPreset kPresetChromium = { { 3.180f, 3.180f, 2.010f }, { 3.300f, 3.330f, 3.040f } };
+constexpr ConductorPreset kPresetNickel   = { { 1.970f, 1.860f, 1.670f }, { 3.740f, 3.060f, 2.580f } };
+constexpr ConductorPreset kPresetTitanium = { { 2.160f, 1.970f, 1.810f }, { 2.930f, 2.620f, 2.350f } };
+constexpr ConductorPreset kPresetTungsten = { { 4.350f, 3.400f, 2.850f }, { 3.400f, 2.700f, 2.150f } };
+constexpr ConductorPreset kPresetIron     = { { 2.950f, 2.930f, 2.650f }, { 3.000f, 2.950f, 2.800f } };
+
+constexpr auto kConductorPresets = perfect_hash::MakeMap<ConductorPreset>({
+    { "none",      kPresetNone },
+    { "Ag",        kPresetSilver },
+    { "silver",    kPresetSilver },
+    { "Au",        kPresetGold },
+    { "gold",      kPresetGold },
+    { "Cu",        kPresetCopper },
+    { "Cu_palik",  kPresetCopper },
+    { "copper",    kPresetCopper },
+    { "Al",        kPresetAluminum },
+    { "aluminium", kPresetAluminum },
+    { "aluminum",  kPresetAluminum },
+    { "Cr",        kPresetChromium },
+    { "chromium",  kPresetChromium },
+    { "Ni",        kPresetNickel },
+    { "Ni_palik",  kPresetNickel },
+    { "nickel",    kPresetNickel },
+    { "Ti",        kPresetTitanium },
+    { "titanium",  kPresetTitanium },
+    { "W",         kPresetTungsten },
+    { "tungsten",  kPresetTungsten },
+    { "Fe",        kPresetIron },
+    { "iron",      kPresetIron },
+});
+
+// Mitsuba dielectric IOR presets (for int_ior / ext_ior)
+constexpr auto kIORPresets = perfect_hash::MakeMap<float>({
+    { "vacuum",               1.0f },
+    { "helium",               1.00004f },
+    { "hydrogen",             1.00013f },
+    { "air",                  1.000277f },
+    { "carbon dioxide",       1.00045f },
+    { "water",                1.333f },
+    { "acetone",              1.36f },
+    { "ethanol",              1.361f },
+    { "carbon tetrachloride", 1.461f },
+    { "glycerol",             1.4729f },
+    { "benzene",              1.501f },
+    { "silicone oil",         1.52045f },
+    { "bromine",              1.661f },
+    { "water ice",            1.31f },
+    { "fused quartz",         1.458f },
+    { "pyrex",                1.470f },
+    { "acrylic glass",        1.49f },
+    { "polypropylene",        1.49f },
+    { "bk7",                  1.5046f },
+    { "sodium chloride",      1.544f },
+    { "amber",                1.55f },
+    { "pet",                  1.575f },
+    { "diamond",              2.419f },
+});
+
+} // namespace
+
+bool MitsubaSceneParser::Parse(const std::filesystem::path& xmlPath)
+{
+    sceneDirectory = xmlPath.parent_path();
+    stats = {};
+    auto parseStart = std::chrono::steady_clock::now();
+
+    // Map the file copy-on-write and let pugixml parse it in place:
+    // node names and values are null-terminated inside the mapping
+    // instead of being copied into a separate heap buffer.
+    if (!m_SceneFile.Open(xmlPath, MappedFile::Access::CopyOnWrite))
+    {
+        log::error("Failed to open XML file: %s", xmlPath.string().c_str());
+        return false;
+    }
+
+    // Parameter substitution rewrites attributes, skip it for the common
+    // scene without any $references
+    bool hasReferences = memchr(m_SceneFile.Data(), '$', m_SceneFile.Size()) != nullptr;
+
+    pugi::xml_parse_result result = m_Document.load_buffer_inplace(m_SceneFile.Data(), m_SceneFile.Size());
+
+    if (!result)
+    {
+        log::error("Failed to parse XML file: %s", result.description());
+        return false;
+    }
+
+    pugi::xml_node sceneNode = m_Document.child("scene");
+    if (!sceneNode)
+    {
+        log::error("No <scene> node found in XML");
+        return false;
+    }
+
+    m_IncludeStack = { xmlPath.lexically_normal() };
+    ParseSceneElements(sceneNode, sceneDirectory, hasReferences, nullptr);
+
+    auto parseEnd = std::chrono::steady_clock::now();
+    double parseNs = std::chrono::duration<double, std::nano>(parseEnd - parseStart).count();
+    log::info("Parsed scene XML in %.2f ms (%zu nodes, %.0f ns/node, %zu includes of %zu fragments)",
+        parseNs * 1e-6, stats.nodeCount, stats.nodeCount > 0 ? parseNs / stats.nodeCount : 0.0,
+        stats.includeCount, stats.fragmentCount);
+
+    // Resolve referenced textures (header only, pixels are decoded on demand)
+    if (probeTextures)
+    {
+        ProbeReferencedTextures();
+    }
+
+    stats.xmlParseMs = parseNs * 1e-6;
+    stats.textureProbeMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - parseEnd).count();
+
+    log::info("Parsed %zu materials, %zu shapes, %zu shape groups, %zu textures", 
+        materials.size(), shapes.size(), shapeGroups.size(), textures.size());
+    
+    // Debug: print material types
+    for (auto& [id, mat] : materials)
+    {
+        const char* typeNames[] = {
+            "Diffuse", "Conductor", "RoughConductor", "Dielectric", "RoughDielectric", 
+            "Plastic", "RoughPlastic", "ThinDielectric", "Principled", "Blend", "Mask", "Null"
+        };
+        uint32_t typeIdx = static_cast<uint32_t>(mat.type);
+        const char* typeName = (typeIdx < 12) ? typeNames[typeIdx] : "Unknown";
+        log::info("  Material '%.*s': type=%s, roughness=%.3f, baseColor=(%.2f,%.2f,%.2f), intIOR=%.2f, extIOR=%.2f, texIdx=%d, nonlinear=%s",
+            static_cast<int>(id.size()), id.data(), typeName, mat.roughness, 
+            mat.baseColor.X, mat.baseColor.Y, mat.baseColor.Z,
+            mat.intIOR, mat.extIOR,
+            mat.baseColorTexture.textureIndex,
+            mat.nonlinear ? "true" : "false");
+    }
+    if (environmentMap.isValid)
+    {
+        log::info("Environment map: %.*s (intensity: %.2f)", 
+            static_cast<int>(environmentMap.filename.size()), environmentMap.filename.data(),
+            environmentMap.intensity);
+    }
+    return true;
+}
+
+// ============================================================================
+// Scene Elements, Includes and Parameters
+// ============================================================================
+
+// Walk the children of a <scene> root in document order. `definitionsOnly`
+// (when given) is cleared if anything other than ids and defaults was added.
+void MitsubaSceneParser::ParseSceneElements(pugi::xml_node sceneNode, const std::filesystem::path& fileDirectory,
+                                            bool substitute, bool* definitionsOnly)
+{
+    for (pugi::xml_node node : sceneNode.children())
+    {
+        std::string_view nodeName = node.name();
+        stats.nodeCount++;
+
+        // Mitsuba resolves $references per element, so a <default> only
+        // affects the elements after it
+        if (substitute)
+        {
+            SubstituteParameters(node);
+        }
+
+        if (nodeName == "sensor")
+        {
+            ParseSensor(node);
+        }
+        else if (nodeName == "bsdf")
+        {
+            auto bsdfStart = std::chrono::steady_clock::now();
+            Material mat = ParseBSDF(node);
+            stats.bsdfCount++;
+            stats.bsdfParseMs += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - bsdfStart).count();
+            if (!mat.id.empty())
+            {
+                auto [it, isNew] = materials.insert_or_assign(mat.id, mat);
+                if (isNew)
+                {
+                    materialOrder.push_back(mat.id);
+                }
+            }
+        }
+        else if (nodeName == "shape")
+        {
+            shapes.push_back(ParseShape(node));
+        }
+        else if (nodeName == "shapegroup")
+        {
+            ParseShapeGroup(node);
+        }
+        else if (nodeName == "emitter")
+        {
+            ParseEmitter(node);
+        }
+        else if (nodeName == "texture")
+        {
+            ParseTextureDefinition(node);
+        }
+        else if (nodeName == "default")
+        {
+            std::string_view name = node.attribute("name").value();
+            if (name.empty())
+            {
+                log::warning("Ignoring <default> without a name");
+                continue;
+            }
+            // Values given by the caller or an earlier <default> win
+            if (parameters.try_emplace(std::string(name), node.attribute("value").value()).second)
+            {
+                m_DefaultOrigins[std::string(name)] = m_IncludeStack.back().generic_string();
+            }
+        }
+        else if (nodeName == "include")
+        {
+            if (!ParseInclude(node, fileDirectory) && definitionsOnly)
+            {
+                *definitionsOnly = false;
+            }
+            continue;
+        }
+
+        if (definitionsOnly && (nodeName == "sensor" || nodeName == "shape" || nodeName == "emitter"))
+        {
+            *definitionsOnly = false;
+        }
+    }
+}
+
+// Returns whether the fragment only holds definitions (ids and defaults)
+bool MitsubaSceneParser::ParseInclude(pugi::xml_node includeNode, const std::filesystem::path& fileDirectory)
+{
+    std::string_view filename = includeNode.attribute("filename").value();
+    if (filename.empty())
+    {
+        log::warning("Ignoring <include> without a filename");
+        return true;
+    }
+    stats.includeCount++;
+
+    // Relative to the including file first, then to the scene
+    std::error_code ec;
+    std::filesystem::path path = (fileDirectory / filename).lexically_normal();
+    if (!std::filesystem::exists(path, ec))
+    {
+        path = (sceneDirectory / filename).lexically_normal();
+    }
+
+    if (std::find(m_IncludeStack.begin(), m_IncludeStack.end(), path) != m_IncludeStack.end())
+    {
+        log::error("Recursive <include> of %s", path.string().c_str());
+        return true;
+    }
+
+    Fragment* fragment = LoadFragment(path);
+    if (!fragment)
+    {
+        return true;
+    }
+
+    // Re-applying pure definitions with the same parameters changes nothing
+    if (fragment->applied && fragment->definitionsOnly)
+    {
+        return true;
+    }
+
+    bool fragmentDefinitionsOnly = true;
+    m_IncludeStack.push_back(path);
+    ParseSceneElements(fragment->document.child("scene"), path.parent_path(),
+        fragment->substitute, &fragmentDefinitionsOnly);
+    m_IncludeStack.pop_back();
+
+    fragment->applied = true;
+    fragment->definitionsOnly = fragmentDefinitionsOnly;
+    return fragmentDefinitionsOnly;
+}
+
+// Parsed fragment for `path` under the current parameter values. The file is
+// read once per load; its document is parsed once per distinct set of values
+// of the parameters it references. A value the fragment's own <default> set
+// counts as unset, so including it again does not parse it again.
+MitsubaSceneParser::Fragment* MitsubaSceneParser::LoadFragment(const std::filesystem::path& path)
+{
+    std::string pathKey = path.generic_string();
+    auto sourceIt = m_FragmentSources.find(pathKey);
+    if (sourceIt == m_FragmentSources.end())
+    {
+        FragmentSource source;
+        if (!source.file.Open(path))
+        {
+            log::error("Failed to open included file: %s", path.string().c_str());
+            return nullptr;
+        }
+
+        // Names of all $references, sorted and unique
+        std::string_view text(source.file.Data(), source.file.Size());
+        for (size_t pos = text.find('$'); pos != std::string_view::npos; pos = text.find('$', pos + 1))
+        {
+            std::string_view name = ParameterName(text.substr(pos + 1));
+            if (!name.empty())
+            {
+                source.parameterNames.emplace_back(name);
+            }
+        }
+        std::sort(source.parameterNames.begin(), source.parameterNames.end());
+        source.parameterNames.erase(std::unique(source.parameterNames.begin(), source.parameterNames.end()),
+            source.parameterNames.end());
+
+        sourceIt = m_FragmentSources.emplace(pathKey, std::move(source)).first;
+        includedFiles.push_back(path);
+    }
+    const FragmentSource& source = sourceIt->second;
+
+    std::string key = pathKey;
+    for (const std::string& name : source.parameterNames)
+    {
+        auto value = parameters.find(name);
+        auto origin = m_DefaultOrigins.find(name);
+        bool ownDefault = origin != m_DefaultOrigins.end() && origin->second == pathKey;
+        key += '\0';
+        key += name;
+        key += value != parameters.end() && !ownDefault ? "=" + value->second : std::string("\x01");
+    }
+
+    std::unique_ptr<Fragment>& fragment = m_Fragments[key];
+    if (fragment)
+    {
+        return fragment.get();
+    }
+
+    // Each parameter set gets its own copy to substitute into
+    auto parsed = std::make_unique<Fragment>();
+    pugi::xml_parse_result result = parsed->document.load_buffer(source.file.Data(), source.file.Size());
+    if (!result || !parsed->document.child("scene"))
+    {
+        log::error("Failed to parse included file %s: %s", path.string().c_str(),
+            result ? "no <scene> node" : result.description());
+        m_Fragments.erase(key);
+        return nullptr;
+    }
+    parsed->substitute = !source.parameterNames.empty();
+    stats.fragmentCount++;
+
+    fragment = std::move(parsed);
+    return fragment.get();
+}
+
+// Leading identifier of `text` ([A-Za-z0-9_]*)
+std::string_view MitsubaSceneParser::ParameterName(std::string_view text)
+{
+    size_t length = 0;
+    while (length < text.size() &&
+           (isalnum(static_cast<unsigned char>(text[length])) || text[length] == '_'))
+    {
+        length++;
+    }
+    return text.substr(0, length);
+}
+
+// Replace $name in the attributes of `node` and its descendants. Unknown
+// names are left in place.
+void MitsubaSceneParser::SubstituteParameters(pugi::xml_node node)
+{
+    for (pugi::xml_attribute attribute : node.attributes())
+    {
+        std::string_view value = attribute.value();
+        size_t pos = value.find('$');
+        if (pos == std::string_view::npos)
+        {
+            continue;
+        }
+
+        std::string resolved(value.substr(0, pos));
+        while (pos != std::string_view::npos)
+        {
+            std::string_view name = ParameterName(value.substr(pos + 1));
+            auto it = name.empty() ? parameters.end() : parameters.find(std::string(name));
+            if (it != parameters.end())
+            {
+                resolved += it->second;
+            }
+            else
+            {
+                if (!name.empty())
+                {
+                    log::warning("Undefined scene parameter $%.*s", static_cast<int>(name.size()), name.data());
+                }
+                resolved += '$';
+                resolved += name;
+            }
+
+            size_t next = value.find('$', pos + 1 + name.size());
+            resolved += value.substr(pos + 1 + name.size(), next == std::string_view::npos ? next : next - pos - 1 - name.size());
+            pos = next;
+        }
+
+        // pugixml keeps the new value alive with the document
+        attribute.set_value(resolved.c_str());
+    }
+
+    for (pugi::xml_node child : node.children())
+    {
+        SubstituteParameters(child);
+    }
+}
+
+// Parse a 4x4 matrix from Mitsuba format to HMM column-major storage
+// Mitsuba XML text order: m00 m01 m02 m03  m10 m11 m12 m13  m20 m21 m22 m23  m30 m31 m32 m33
+// HMM stores column-major: Columns[j] contains (m0j, m1j, m2j, m3j)
+HMM_Mat4 MitsubaSceneParser::ParseMatrix(std::string_view matrixStr)
+{
+    float values[16];
+    size_t count = parse_utils::ParseList(matrixStr, values, 16);
+    if (count != 16)
+    {
+        log::warning("Malformed matrix value (%zu entries), using identity", count);
+        return HMM_M4D(1.0f);
+    }
+    
+    // Map Mitsuba matrix to HMM columns:
+    // Column j gets all elements m[i][j] for i=0..3
+    HMM_Mat4 result;
+    result.Columns[0] = HMM_V4(values[0], values[4], values[8],  values[12]); // m00,m10,m20,m30
+    result.Columns[1] = HMM_V4(values[1], values[5], values[9],  values[13]); // m01,m11,m21,m31
+    result.Columns[2] = HMM_V4(values[2], values[6], values[10], values[14]); // m02,m12,m22,m32
+    result.Columns[3] = HMM_V4(values[3], values[7], values[11], values[15]); // m03,m13,m23,m33
+    return result;
+}
+
+// Parse RGB color from "r, g, b" format
+HMM_Vec3 MitsubaSceneParser::ParseRGB(std::string_view rgbStr)
+{
+    float values[3] = { 0.0f, 0.0f, 0.0f };
+    size_t count = parse_utils::ParseList(rgbStr, values, 3);
+    if (count == 1)
+    {
+        // A single value is a uniform (gray) spectrum
+        values[1] = values[2] = values[0];
+    }
+    return HMM_V3(values[0], values[1], values[2]);
+}
+
+// Parse a <point> given as x/y/z attributes or as value="x, y, z"
+HMM_Vec3 MitsubaSceneParser::ParsePoint(pugi::xml_node pointNode)
+{
+    pugi::xml_attribute value = pointNode.attribute("value");
+    if (value)
+    {
+        return ParseRGB(value.value());
+    }
+    return HMM_V3(parse_utils::ParseFloat(pointNode.attribute("x").value()),
+                  parse_utils::ParseFloat(pointNode.attribute("y").value()),
+                  parse_utils::ParseFloat(pointNode.attribute("z").value()));
+}
+
+void MitsubaSceneParser::ParseSensor(pugi::xml_node sensorNode)
+{
+    // Parse FOV
+    for (pugi::xml_node child : sensorNode.children("float"))
+    {
+        std::string_view name = child.attribute("name").value();
+        if (name == "fov")
+        {
+            camera.fov = parse_utils::ParseFloat(child.attribute("value").value(), 45.0f);
+        }
+    }
+
+    // Parse transform
+    pugi::xml_node transformNode = sensorNode.child("transform");
+    if (transformNode)
+    {
+        pugi::xml_node matrixNode = transformNode.child("matrix");
+        if (matrixNode)
+        {
+            camera.transform = ParseMatrix(matrixNode.attribute("value").value());
+        }
+    }
+
+    // Parse film (resolution)
+    pugi::xml_node filmNode = sensorNode.child("film");
+    if (filmNode)
+    {
+        for (pugi::xml_node child : filmNode.children("integer"))
+        {
+            std::string_view name = child.attribute("name").value();
+            if (name == "width")
+            {
+                camera.width = parse_utils::ParseInt(child.attribute("value").value(), 1280);
+            }
+            else if (name == "height")
+            {
+                camera.height = parse_utils::ParseInt(child.attribute("value").value(), 720);
+            }
+        }
+    }
+}
+
+MitsubaSceneParser::Material MitsubaSceneParser::ParseBSDF(pugi::xml_node bsdfNode, bool nested)
+{
+    Material mat;
+    
+    if (!nested)
+    {
+        mat.id = bsdfNode.attribute("id").value();
+    }
+
+    const BSDFTypeInfo* typeInfo = kBSDFTypes.Find(bsdfNode.attribute("type").value());
+
+    // Handle twosided/bumpmap/normalmap wrappers
+    if (typeInfo && typeInfo->kind == BSDFKind::Wrapper)
+    {
+        pugi::xml_node innerBsdf = bsdfNode.child("bsdf");
+        if (innerBsdf)
+        {
+            Material innerMat = ParseBSDF(innerBsdf, true);
+            innerMat.id = mat.id;
+            return innerMat;
+        }
+    }
+
+    // Set material type and its defaults
+    if (typeInfo && typeInfo->kind == BSDFKind::Material)
+    {
+        mat.type = typeInfo->type;
+        switch (mat.type)
+        {
+        case MaterialType::Diffuse:
+            mat.roughness = 1.0f;  // Lambertian diffuse - roughness doesn't apply
+            mat.baseColor = HMM_V3(0.5f, 0.5f, 0.5f);  // Mitsuba default reflectance
+            break;
+        case MaterialType::Conductor:
+            mat.roughness = 0.0f;
+            mat.baseColor = HMM_V3(1.0f, 1.0f, 1.0f);
+            break;
+        case MaterialType::RoughConductor:
+            mat.roughness = 0.1f;  // Mitsuba default alpha
+            mat.baseColor = HMM_V3(1.0f, 1.0f, 1.0f);  // Default specular reflectance
+            break;
+        case MaterialType::Dielectric:
+        case MaterialType::ThinDielectric:
+            mat.roughness = 0.0f;
+            break;
+        case MaterialType::RoughDielectric:
+            mat.roughness = 0.1f;  // Mitsuba default alpha
+            break;
+        case MaterialType::Plastic:
+            mat.roughness = 0.0f;  // Smooth plastic
+            mat.intIOR = 1.49f;    // Mitsuba default: polypropylene
+            break;
+        case MaterialType::RoughPlastic:
+            mat.roughness = 0.1f;  // Mitsuba default alpha
+            mat.intIOR = 1.49f;    // Mitsuba default: polypropylene
+            break;
+        case MaterialType::Principled:
+            mat.specular = 0.5f;  // Default specular
+            break;
+        case MaterialType::Blend:
+            mat.blendWeight = 0.5f;
+            break;
+        case MaterialType::Mask:
+            mat.opacity = 0.5f;
+            break;
+        case MaterialType::Null:
+            break;
+        }
+    }
+
+    // Parse material properties
+    for (pugi::xml_node child : bsdfNode.children())
+    {
+        const ValueKind* kind = kValueKinds.Find(child.name());
+        const BSDFProperty* prop = kBSDFProperties.Find(child.attribute("name").value());
+        if (!kind || !prop)
+        {
+            continue;
+        }
+
+        switch (*kind)
+        {
+        case ValueKind::Color:
+        {
+            HMM_Vec3 color = ParseRGB(child.attribute("value").value());
+            switch (*prop)
+            {
+            case BSDFProperty::Reflectance:
+            case BSDFProperty::SpecularReflectance:
+            case BSDFProperty::BaseColor: mat.baseColor = color; break;
+            case BSDFProperty::Eta:       mat.eta = color; break;
+            case BSDFProperty::K:         mat.k = color; break;
+            default: break;
+            }
+            break;
+        }
+        case ValueKind::Float:
+        {
+            float value = parse_utils::ParseFloat(child.attribute("value").value());
+            switch (*prop)
+            {
+            case BSDFProperty::Alpha:
+                // Mitsuba's alpha is the GGX roughness directly
+                // Our shader squares roughness to get alpha, so we take sqrt here
+                // to get the correct final alpha value
+                mat.roughness = sqrtf(value);
+                break;
+            case BSDFProperty::Roughness:      mat.roughness = value; break;
+            case BSDFProperty::IntIOR:         mat.intIOR = value; break;
+            case BSDFProperty::ExtIOR:         mat.extIOR = value; break;
+            case BSDFProperty::Eta:            mat.intIOR = value; break;  // Scalar eta for dielectrics
+            // Principled BSDF parameters
+            case BSDFProperty::Metallic:       mat.metallic = value; break;
+            case BSDFProperty::Specular:       mat.specular = value; break;
+            case BSDFProperty::SpecTint:       mat.specTint = value; break;
+            case BSDFProperty::Sheen:          mat.sheen = value; break;
+            case BSDFProperty::SheenTint:      mat.sheenTint = value; break;
+            case BSDFProperty::Clearcoat:      mat.clearcoat = value; break;
+            case BSDFProperty::ClearcoatGloss: mat.clearcoatGloss = value; break;
+            case BSDFProperty::SpecTrans:      mat.specTrans = value; break;
+            // Mask/Blend parameters
+            case BSDFProperty::Opacity:        mat.opacity = value; break;
+            case BSDFProperty::Weight:         mat.blendWeight = value; break;
+            default: break;
+            }
+            break;
+        }
+        case ValueKind::String:
+        {
+            std::string_view value = child.attribute("value").value();
+            if (*prop == BSDFProperty::ConductorMaterial)
+            {
+                if (const ConductorPreset* preset = kConductorPresets.Find(value))
+                {
+                    mat.eta = HMM_V3(preset->eta[0], preset->eta[1], preset->eta[2]);
+                    mat.k = HMM_V3(preset->k[0], preset->k[1], preset->k[2]);
+                }
+                else
+                {
+                    log::warning("Unknown conductor material preset '%.*s'",
+                        static_cast<int>(value.size()), value.data());
+                }
+            }
+            else if (*prop == BSDFProperty::IntIOR || *prop == BSDFProperty::ExtIOR)
+            {
+                const float* preset = kIORPresets.Find(value);
+                float ior = preset ? *preset : 1.0f;
+                if (!preset)
+                {
+                    log::warning("Unknown IOR preset '%.*s'", static_cast<int>(value.size()), value.data());
+                }
+                
+                if (*prop == BSDFProperty::IntIOR) mat.intIOR = ior;
+                else mat.extIOR = ior;
+            }
+            break;
+        }
+        case ValueKind::Texture:
+        {
+            // Parse texture reference
+            TextureRef texRef = ParseTextureRef(child);
+            if (texRef.isValid)
+            {
+                if (*prop == BSDFProperty::Reflectance)
+                {
+                    mat.baseColorTexture = texRef;
+                }
+                else if (*prop == BSDFProperty::Alpha || *prop == BSDFProperty::Roughness)
+                {
+                    mat.roughnessTexture = texRef;
+                }
+            }
+            break;
+        }
+        case ValueKind::Boolean:
+            if (*prop == BSDFProperty::Nonlinear)
+            {
+                mat.nonlinear = parse_utils::ParseBool(child.attribute("value").value());
+            }
+            break;
+        }
+    }
+
+    return mat;
+}
+
+MitsubaSceneParser::Shape MitsubaSceneParser::ParseShape(pugi::xml_node shapeNode)
+{
+    Shape shape;
+    shape.type = shapeNode.attribute("type").value();
+
+    // Parse transform
+    pugi::xml_node transformNode = shapeNode.child("transform");
+    if (transformNode)
+    {
+        pugi::xml_node matrixNode = transformNode.child("matrix");
+        if (matrixNode)
+        {
+            shape.transform = ParseMatrix(matrixNode.attribute("value").value());
+        }
+    }
+
+    // Parse mesh filename
+    for (pugi::xml_node child : shapeNode.children("string"))
+    {
+        std::string_view name = child.attribute("name").value();
+        if (name == "filename")
+        {
+            shape.filename = child.attribute("value").value();
+        }
+    }
+    for (pugi::xml_node child : shapeNode.children("integer"))
+    {
+        std::string_view name = child.attribute("name").value();
+        if (name == "shape_index")
+        {
+            shape.shapeIndex = static_cast<uint32_t>(std::max(0, parse_utils::ParseInt(child.attribute("value").value())));
+        }
+    }
+
+    // Parse analytic shape parameters
+    for (pugi::xml_node child : shapeNode.children("float"))
+    {
+        std::string_view name = child.attribute("name").value();
+        if (name == "radius")
+        {
+            shape.radius = parse_utils::ParseFloat(child.attribute("value").value(), 1.0f);
+        }
+    }
+    for (pugi::xml_node child : shapeNode.children("point"))
+    {
+        std::string_view name = child.attribute("name").value();
+        if (name == "center")
+        {
+            shape.center = ParsePoint(child);
+        }
+        else if (name == "p0")
+        {
+            shape.p0 = ParsePoint(child);
+        }
+        else if (name == "p1")
+        {
+            shape.p1 = ParsePoint(child);
+        }
+    }
+
+    // Parse material reference (or the referenced shape group for instances)
+    pugi::xml_node refNode = shapeNode.child("ref");
+    if (refNode)
+    {
+        if (shape.type == "instance")
+        {
+            shape.groupRef = refNode.attribute("id").value();
+        }
+        else
+        {
+            shape.materialRef = refNode.attribute("id").value();
+        }
+    }
+
+    // Parse inline BSDF
+    pugi::xml_node inlineBsdf = shapeNode.child("bsdf");
+    if (inlineBsdf)
+    {
+        auto bsdfStart = std::chrono::steady_clock::now();
+        shape.inlineMaterial = ParseBSDF(inlineBsdf, true);
+        stats.bsdfCount++;
+        stats.bsdfParseMs += std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - bsdfStart).count();
+        shape.hasInlineMaterial = true;
+    }
+
+    // Parse emitter
+    pugi::xml_node emitterNode = shapeNode.child("emitter");
+    if (emitterNode)
+    {
+        shape.isEmitter = true;
+        for (pugi::xml_node child : emitterNode.children("rgb"))
+        {
+            std::string_view name = child.attribute("name").value();
+            if (name == "radiance")
+            {
+                shape.emission = ParseRGB(child.attribute("value").value());
+            }
+        }
+    }
+
+    return shape;
+}
+
+void MitsubaSceneParser::ParseShapeGroup(pugi::xml_node groupNode)
+{
+    ShapeGroup group;
+    group.id = groupNode.attribute("id").value();
+    if (group.id.empty())
+    {
+        log::warning("Ignoring <shapegroup> without an id");
+        return;
+    }
+
+    for (pugi::xml_node child : groupNode.children("shape"))
+    {
+        Shape shape = ParseShape(child);
+        if (shape.type == "instance")
+        {
+            // Mitsuba does not allow nesting instances inside a shape group
+            log::warning("Ignoring nested instance in shape group '%.*s'",
+                static_cast<int>(group.id.size()), group.id.data());
+            continue;
+        }
+        group.shapes.push_back(shape);
+    }
+
+    shapeGroups[group.id] = std::move(group);
+}
+
+// Parse global emitter (environment map)
+void MitsubaSceneParser::ParseEmitter(pugi::xml_node emitterNode)
+{
+    std::string_view type = emitterNode.attribute("type").value();
+    
+    // Environment map emitter
+    if (type == "envmap")
+    {
+        for (pugi::xml_node child : emitterNode.children("string"))
+        {
+            std::string_view name = child.attribute("name").value();
+            if (name == "filename")
+            {
+                environmentMap.filename = child.attribute("value").value();
+                environmentMap.isValid = true;
+            }
+        }
+        
+        for (pugi::xml_node child : emitterNode.children("float"))
+        {
+            std::string_view name = child.attribute("name").value();
+            if (name == "scale")
+            {
+                environmentMap.intensity = parse_utils::ParseFloat(child.attribute("value").value(), 1.0f);
+            }
+        }
+        
+        // Also check for intensity in rgb format
+        for (pugi::xml_node child : emitterNode.children("rgb"))
+        {
+            std::string_view name = child.attribute("name").value();
+            if (name == "scale")
+            {
+                HMM_Vec3 scale = ParseRGB(child.attribute("value").value());
+                environmentMap.intensity = (scale.X + scale.Y + scale.Z) / 3.0f;
+            }
+        }
+        
+        log::info("Found environment map: %.*s",
+            static_cast<int>(environmentMap.filename.size()), environmentMap.filename.data());
+    }
+    // Constant environment
+    else if (type == "constant")
+    {
+        // Could be extended to support constant environment color
+    }
+}
+
+// Parse standalone texture definition
+void MitsubaSceneParser::ParseTextureDefinition(pugi::xml_node textureNode)
+{
+    std::string_view id = textureNode.attribute("id").value();
+    std::string_view type = textureNode.attribute("type").value();
+    
+    if (type == "bitmap")
+    {
+        for (pugi::xml_node child : textureNode.children("string"))
+        {
+            std::string_view name = child.attribute("name").value();
+            if (name == "filename")
+            {
+                std::string_view filename = child.attribute("value").value();
+                // Store for later loading
+                textureIndexMap[id] = -1;  // Will be updated when loaded
+                log::info("Found texture definition: %.*s -> %.*s",
+                    static_cast<int>(id.size()), id.data(),
+                    static_cast<int>(filename.size()), filename.data());
+            }
+        }
+    }
+}
+
+// Parse texture reference in BSDF
+MitsubaSceneParser::TextureRef MitsubaSceneParser::ParseTextureRef(pugi::xml_node textureNode)
+{
+    TextureRef ref;
+    std::string_view type = textureNode.attribute("type").value();
+    
+    if (type == "bitmap")
+    {
+        for (pugi::xml_node child : textureNode.children("string"))
+        {
+            std::string_view name = child.attribute("name").value();
+            if (name == "filename")
+            {
+                ref.filename = child.attribute("value").value();
+                ref.isValid = true;
+            }
+        }
+    }
+    else if (type == "ref")
+    {
+        // Reference to a standalone texture definition
+        std::string_view refId = textureNode.attribute("id").value();
+        if (textureIndexMap.find(refId) != textureIndexMap.end())
+        {
+            ref.isValid = true;
+            // Filename will be resolved later
+        }
+    }
+    
+    return ref;
+}
+
+// Probe all referenced textures and assign their indices
+void MitsubaSceneParser::ProbeReferencedTextures()
+{
+    // Textures can be referenced from named BSDFs and from inline shape BSDFs
+    std::vector<TextureRef*> textureRefs;
+    auto collectRefs = [&textureRefs](Material& mat)
+    {
+        for (TextureRef* ref : { &mat.baseColorTexture, &mat.roughnessTexture, &mat.normalTexture })
+        {
+            if (ref->isValid && !ref->filename.empty())
+            {
+                textureRefs.push_back(ref);
+            }
+        }
+    };
+    for (auto& [id, mat] : materials)
+    {
+        collectRefs(mat);
+    }
+    for (auto& shape : shapes)
+    {
+        if (shape.hasInlineMaterial)
+        {
+            collectRefs(shape.inlineMaterial);
+        }
+    }
+    for (auto& [id, group] : shapeGroups)
+    {
+        for (auto& shape : group.shapes)
+        {
+            if (shape.hasInlineMaterial)
+            {
+                collectRefs(shape.inlineMaterial);
+            }
+        }
+    }
+
+    // Sorted unique filenames give the same texture indices on every run
+    std::vector<std::string_view> textureFiles;
+    textureFiles.reserve(textureRefs.size());
+    for (const TextureRef* ref : textureRefs)
+    {
+        textureFiles.push_back(ref->filename);
+    }
+    std::sort(textureFiles.begin(), textureFiles.end());
+    textureFiles.erase(std::unique(textureFiles.begin(), textureFiles.end()), textureFiles.end());
+    
+    // Read only the image headers (dimensions, channels) for budgeting
+    std::vector<texture_utils::TextureInfo> infos(textureFiles.size());
+    parallel::ForEach(textureFiles.size(), textureThreads, [&](size_t i)
+    {
+        infos[i] = texture_utils::ProbeTexture(sceneDirectory / textureFiles[i]);
+    });
+    
+    // Assign indices in filename order; unreadable textures are skipped
+    for (size_t i = 0; i < textureFiles.size(); i++)
+    {
+        std::string_view filename = textureFiles[i];
+        
+        if (infos[i].IsValid())
+        {
+            int index = static_cast<int>(textures.size());
+            textureIndexMap[filename] = index;
+            log::info("Found texture [%d]: %.*s (%dx%d, %d channels)", index,
+                static_cast<int>(filename.size()), filename.data(),
+                infos[i].width, infos[i].height, infos[i].channels);
+            
+            Texture texture;
+            texture.filename = filename;
+            texture.info = infos[i];
+            textures.push_back(std::move(texture));
+        }
+        else
+        {
+            log::error("Failed to read texture header: %s", (sceneDirectory / filename).string().c_str());
+        }
+    }
+    
+    // Update material texture indices
+    for (TextureRef* ref : textureRefs)
+    {
+        auto it = textureIndexMap.find(ref->filename);
+        if (it != textureIndexMap.end())
+        {
+            ref->textureIndex = it->second;
+        }
+    }
+}
+
+void MitsubaSceneParser::DecodeTextures(const std::vector<int>& indices)
+{
+    // Unique, not yet attempted, valid indices
+    std::vector<int> pending;
+    for (int index : indices)
+    {
+        if (index >= 0 && index < static_cast<int>(textures.size()) && !textures[index].decodeAttempted)
+        {
+            textures[index].decodeAttempted = true;
+            pending.push_back(index);
+        }
+    }
+    if (pending.empty())
+    {
+        return;
+    }
+
+    auto decodeStart = std::chrono::steady_clock::now();
+
+    // Each job reserves its decode footprint first, so at most
+    // textureDecodeBudget bytes are being decoded at any time
+    // (a single larger texture runs alone)
+    parallel::MemoryBudget budget(textureDecodeBudget);
+    parallel::ForEach(pending.size(), textureThreads, [&](size_t i)
+    {
+        Texture& texture = textures[pending[i]];
+        size_t footprint = texture.info.DecodeFootprint();
+        
+        budget.Acquire(footprint);
+        texture.data = texture_utils::LoadTexture(sceneDirectory / texture.filename);
+        budget.Release(footprint);
+    });
+
+    for (int index : pending)
+    {
+        if (!textures[index].data.IsValid())
+        {
+            log::error("Failed to decode texture: %s", (sceneDirectory / textures[index].filename).string().c_str());
+        }
+    }
+
+    stats.decodedTextures += pending.size();
+    stats.peakDecodeBytes = std::max(stats.peakDecodeBytes, budget.Peak());
+    stats.textureDecodeMs += std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - decodeStart).count();
+}
+
+const texture_utils::TextureData& MitsubaSceneParser::GetTexture(int index)
+{
+    static const texture_utils::TextureData s_Invalid;
+    if (index < 0 || index >= static_cast<int>(textures.size()))
+    {
+        return s_Invalid;
+    }
+    DecodeTextures({ index });
+    return textures[index].data;
+}
+
+std::vector<std::filesystem::path> MitsubaSceneParser::ReferencedFiles() const
+{
+    std::vector<std::filesystem::path> files;
+    auto addShapes = [&](const std::vector<Shape>& shapeList)
+    {
+        for (const Shape& shape : shapeList)
+        {
+            if (!shape.filename.empty())
+            {
+                files.push_back(sceneDirectory / shape.filename);
+            }
+        }
+    };
+    addShapes(shapes);
+    for (const auto& [id, group] : shapeGroups)
+    {
+        addShapes(group.shapes);
+    }
+    for (const Texture& texture : textures)
+    {
+        files.push_back(sceneDirectory / texture.filename);
+    }
+    if (environmentMap.isValid)
+    {
+        files.push_back(sceneDirectory / environmentMap.filename);
+    }
+    files.insert(files.end(), includedFiles.begin(), includedFiles.end());
+
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    return files;
+}
+
+void MitsubaSceneParser::AdoptDecodedTextures(MitsubaSceneParser& previous,
+                                              const std::vector<std::filesystem::path>& changedFiles)
+{
+    for (Texture& texture : textures)
+    {
+        auto it = previous.textureIndexMap.find(texture.filename);
+        if (it == previous.textureIndexMap.end())
+        {
+            continue;
+        }
+        Texture& old = previous.textures[it->second];
+        bool changed = std::find(changedFiles.begin(), changedFiles.end(),
+            sceneDirectory / texture.filename) != changedFiles.end();
+        if (!changed && old.decodeAttempted)
+        {
+            texture.data = std::move(old.data);
+            texture.decodeAttempted = true;
+        }
+    }
+}
+
+std::vector<int> MitsubaSceneParser::InvalidateTextures(const std::vector<std::filesystem::path>& changedFiles)
+{
+    std::vector<int> invalidated;
+    for (size_t i = 0; i < textures.size(); i++)
+    {
+        Texture& texture = textures[i];
+        std::filesystem::path path = sceneDirectory / texture.filename;
+        if (std::find(changedFiles.begin(), changedFiles.end(), path) == changedFiles.end())
+        {
+            continue;
+        }
+
+        // Indices stay fixed until the XML itself is reloaded, so an
+        // unreadable header leaves the slot empty rather than removing it
+        texture.info = texture_utils::ProbeTexture(path);
+        texture.data = {};
+        texture.decodeAttempted = false;
+        invalidated.push_back(static_cast<int>(i));
+    }
+    return invalidated;
+}
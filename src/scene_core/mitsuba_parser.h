@@ -0,0 +1,265 @@
+#pragma once
+
+// ============================================================================
+// Mitsuba Scene Parser
+// CPU-only parsing of Mitsuba XML scenes (sensor, BSDFs, shapes, emitters,
+// textures). Shared by the ray tracer, the rasterizer and scene_stats.
+// Supports <include> fragments, <default> parameters and $name references;
+// file names inside fragments resolve against the main scene directory, as
+// in Mitsuba.
+// ============================================================================
+
+#include <pugixml.hpp>
+
+#define HANDMADE_MATH_USE_RADIANS
+#include "HandmadeMath.h"
+
+#include "../common/texture_utils.h"
+#include "../common/mapped_file.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+// ============================================================================
+// Material Types (matching Mitsuba BSDF types)
+// ============================================================================
+enum class MaterialType : uint32_t
+{
+    Diffuse = 0,
+    Conductor = 1,
+    RoughConductor = 2,
+    Dielectric = 3,
+    RoughDielectric = 4,
+    Plastic = 5,
+    RoughPlastic = 6,
+    ThinDielectric = 7,
+    Principled = 8,
+    Blend = 9,
+    Mask = 10,
+    Null = 11
+};
+
+// ============================================================================
+// Mitsuba Scene Parser - using HandmadeMath
+// ============================================================================
+class MitsubaSceneParser
+{
+public:
+    struct Camera
+    {
+        HMM_Mat4 transform = HMM_M4D(1.0f);  // Identity matrix
+        float fov = 45.0f;
+        int width = 1280;
+        int height = 720;
+    };
+
+    // String views below point into the in-situ parsed XML buffer and
+    // stay valid for the lifetime of the parser.
+
+    // Texture reference structure
+    struct TextureRef
+    {
+        std::string_view filename;
+        bool isValid = false;
+        int textureIndex = -1;  // Index into loaded textures array
+    };
+
+    struct Material
+    {
+        std::string_view id;
+        MaterialType type = MaterialType::Diffuse;
+        HMM_Vec3 baseColor = HMM_V3(0.5f, 0.5f, 0.5f);  // Mitsuba default: 0.5
+        float roughness = 0.1f;   // Mitsuba default alpha: 0.1 (NOT 0.5!)
+        HMM_Vec3 eta = HMM_V3(1.0f, 1.0f, 1.0f);
+        HMM_Vec3 k = HMM_V3(0.0f, 0.0f, 0.0f);
+        float intIOR = 1.5046f;   // Mitsuba default: bk7 (1.5046)
+        float extIOR = 1.000277f; // Mitsuba default: air (1.000277)
+        float metallic = 0.0f;
+        
+        // Principled BSDF parameters
+        float specular = 0.5f;
+        float specTint = 0.0f;
+        float sheen = 0.0f;
+        float sheenTint = 0.0f;
+        float clearcoat = 0.0f;
+        float clearcoatGloss = 0.0f;
+        float specTrans = 0.0f;
+        
+        // Mask/Blend parameters
+        float opacity = 1.0f;
+        float blendWeight = 0.5f;
+        
+        // Plastic-specific parameters
+        bool nonlinear = false;  // Mitsuba default: false (preserve texture colors)
+        
+        // Texture references
+        TextureRef baseColorTexture;
+        TextureRef roughnessTexture;
+        TextureRef normalTexture;
+    };
+    
+    // Environment map structure
+    struct EnvironmentMapInfo
+    {
+        std::string_view filename;
+        float intensity = 1.0f;
+        bool isValid = false;
+    };
+
+    struct Shape
+    {
+        std::string_view type;          // "obj", "ply", "serialized", "rectangle", "sphere",
+                                        // "disk", "cylinder", "cube" or "instance"
+        std::string_view filename;      // Mesh filename
+        uint32_t shapeIndex = 0;        // Mesh within a .serialized file
+        std::string_view materialRef;   // Reference to material ID
+        std::string_view groupRef;      // Reference to shape group ID (type="instance")
+        HMM_Mat4 transform = HMM_M4D(1.0f);  // Identity matrix
+
+        // Sphere and cylinder parameters, applied before `transform`
+        HMM_Vec3 center = HMM_V3(0.0f, 0.0f, 0.0f);
+        float radius = 1.0f;
+        HMM_Vec3 p0 = HMM_V3(0.0f, 0.0f, 0.0f);   // Cylinder axis start
+        HMM_Vec3 p1 = HMM_V3(0.0f, 0.0f, 1.0f);   // Cylinder axis end
+
+        bool isEmitter = false;
+        HMM_Vec3 emission = HMM_V3(0.0f, 0.0f, 0.0f);
+        
+        // For inline materials
+        Material inlineMaterial;
+        bool hasInlineMaterial = false;
+    };
+
+    // <shapegroup>: shapes kept in group-local space, placed by instances
+    struct ShapeGroup
+    {
+        std::string_view id;
+        std::vector<Shape> shapes;
+    };
+
+    Camera camera;
+    std::unordered_map<std::string_view, Material> materials;
+    std::vector<std::string_view> materialOrder;    // Material IDs in document order
+    std::vector<Shape> shapes;
+    std::unordered_map<std::string_view, ShapeGroup> shapeGroups;
+    std::filesystem::path sceneDirectory;
+    
+    // Environment map
+    EnvironmentMapInfo environmentMap;
+    
+    // A texture referenced by the scene. Parse() only reads its header;
+    // pixels are decoded the first time a consumer asks for them.
+    struct Texture
+    {
+        std::string_view filename;
+        texture_utils::TextureInfo info;    // From the header probe
+        texture_utils::TextureData data;    // Empty until decoded
+        bool decodeAttempted = false;
+    };
+
+    // Referenced textures (indexed by material texture references)
+    std::unordered_map<std::string_view, int> textureIndexMap;
+    std::vector<Texture> textures;
+
+    // Timings of the last Parse() call
+    struct ParseStats
+    {
+        size_t nodeCount = 0;       // Scene elements, including those of fragments
+        size_t includeCount = 0;    // <include> elements
+        size_t fragmentCount = 0;   // Fragment documents parsed (cache misses)
+        double xmlParseMs = 0.0;
+        double textureProbeMs = 0.0;
+        size_t bsdfCount = 0;       // Named and inline <bsdf> elements
+        double bsdfParseMs = 0.0;   // Part of xmlParseMs spent in ParseBSDF
+        double textureDecodeMs = 0.0;   // Accumulated over DecodeTextures()/GetTexture()
+        size_t decodedTextures = 0;
+        size_t peakDecodeBytes = 0; // Largest concurrent texture decode footprint
+    };
+    ParseStats stats;
+
+    // Values for $name references, like Mitsuba's -Dname=value. Set before
+    // Parse(); <default> elements only add names that are not set yet.
+    std::unordered_map<std::string, std::string> parameters;
+    // Fragments pulled in through <include>, in first-load order
+    std::vector<std::filesystem::path> includedFiles;
+
+    // Set to false to skip probing texture headers (parse-only benchmarks)
+    bool probeTextures = true;
+    // Texture decode worker threads (0 = hardware concurrency)
+    unsigned textureThreads = 0;
+    // Cap on the bytes of all texture decodes in flight at once
+    size_t textureDecodeBudget = size_t(2) << 30;
+
+    bool Parse(const std::filesystem::path& xmlPath);
+
+    // Decode the given texture indices that are not decoded yet, concurrently
+    // on textureThreads workers within textureDecodeBudget. Not thread-safe
+    // with respect to other calls on this parser.
+    void DecodeTextures(const std::vector<int>& indices);
+    // Pixels of one texture, decoded on first use. The result is invalid
+    // (IsValid() == false) for unknown indices or failed decodes.
+    const texture_utils::TextureData& GetTexture(int index);
+
+    // Every external file the scene references (meshes, textures, environment
+    // map, included fragments), joined with sceneDirectory, sorted and unique
+    std::vector<std::filesystem::path> ReferencedFiles() const;
+
+    // Hot reload: take over pixels `previous` already decoded for textures
+    // this parse references too, except those listed in `changedFiles`
+    void AdoptDecodedTextures(MitsubaSceneParser& previous, const std::vector<std::filesystem::path>& changedFiles);
+    // Hot reload: forget the pixels of the listed files and re-read their
+    // headers, so the next decode picks up the new contents. Returns the
+    // affected texture indices.
+    std::vector<int> InvalidateTextures(const std::vector<std::filesystem::path>& changedFiles);
+
+private:
+    // An included fragment parsed under one set of parameter values; its
+    // attributes have those values substituted in
+    struct Fragment
+    {
+        pugi::xml_document document;
+        bool substitute = false;        // References any $name
+        bool applied = false;
+        bool definitionsOnly = true;    // Only ids and defaults: applying again is a no-op
+    };
+
+    struct FragmentSource
+    {
+        MappedFile file;
+        std::vector<std::string> parameterNames;    // Every $name it references
+    };
+
+    // Backing storage for the string views handed out above
+    MappedFile m_SceneFile;
+    pugi::xml_document m_Document;
+    // Keyed by path, and by path plus referenced parameter values
+    std::unordered_map<std::string, FragmentSource> m_FragmentSources;
+    std::unordered_map<std::string, std::unique_ptr<Fragment>> m_Fragments;
+    std::vector<std::filesystem::path> m_IncludeStack;
+    // Parameter name -> path of the file whose <default> set it
+    std::unordered_map<std::string, std::string> m_DefaultOrigins;
+
+    void ParseSceneElements(pugi::xml_node sceneNode, const std::filesystem::path& fileDirectory,
+                            bool substitute, bool* definitionsOnly);
+    bool ParseInclude(pugi::xml_node includeNode, const std::filesystem::path& fileDirectory);
+    Fragment* LoadFragment(const std::filesystem::path& path);
+    static std::string_view ParameterName(std::string_view text);
+    void SubstituteParameters(pugi::xml_node node);
+
+    HMM_Mat4 ParseMatrix(std::string_view matrixStr);
+    HMM_Vec3 ParseRGB(std::string_view rgbStr);
+    HMM_Vec3 ParsePoint(pugi::xml_node pointNode);
+    void ParseSensor(pugi::xml_node sensorNode);
+    Material ParseBSDF(pugi::xml_node bsdfNode, bool nested = false);
+    Shape ParseShape(pugi::xml_node shapeNode);
+    void ParseShapeGroup(pugi::xml_node groupNode);
+    void ParseEmitter(pugi::xml_node emitterNode);
+    void ParseTextureDefinition(pugi::xml_node textureNode);
+    TextureRef ParseTextureRef(pugi::xml_node textureNode);
+    void ProbeReferencedTextures();
+};
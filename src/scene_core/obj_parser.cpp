@@ -0,0 +1,370 @@
+#include "obj_parser.h"
+#include "../common/mapped_file.h"
+#include "../common/parallel.h"
+
+#include <donut/core/log.h>
+
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+
+using namespace donut;
+
+// ============================================================================
+// Chunk Parsing
+// Each chunk counts its own attributes from zero. Absolute indices are
+// already file-global; relative ones are resolved against the chunk-local
+// count and remembered so the stitch pass can add the chunk's base.
+// ============================================================================
+namespace
+{
+
+// Chunks are small enough to balance across threads and large enough that
+// per-chunk overhead disappears
+constexpr size_t kChunkBytes = size_t(8) << 20;
+
+enum Component : uint32_t
+{
+    Position,
+    Texcoord,
+    Normal
+};
+
+struct Chunk
+{
+    const char* begin = nullptr;
+    const char* end = nullptr;
+
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> texcoords;
+    std::vector<tinyobj_vertex_index_t> corners;
+    std::vector<uint32_t> relative;     // (corner << 2) | Component
+
+    const char* error = nullptr;        // First malformed record, if any
+};
+
+// Raw OBJ indices of one face corner; 0 = not given (OBJ indices start at 1)
+struct RawCorner
+{
+    int v = 0;
+    int vt = 0;
+    int vn = 0;
+};
+
+inline bool IsBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline void SkipBlanks(const char*& p, const char* end)
+{
+    while (p < end && IsBlank(*p))
+    {
+        p++;
+    }
+}
+
+// Missing or unreadable components stay 0, as with tinyobj
+template <size_t N>
+void ParseFloats(const char* p, const char* end, std::vector<float>& out)
+{
+    float values[N] = {};
+    for (size_t i = 0; i < N; i++)
+    {
+        SkipBlanks(p, end);
+        // std::from_chars does not accept an explicit leading '+'
+        if (p < end && *p == '+')
+        {
+            p++;
+        }
+        auto [ptr, ec] = std::from_chars(p, end, values[i]);
+        if (ec != std::errc())
+        {
+            break;
+        }
+        p = ptr;
+    }
+    out.insert(out.end(), values, values + N);
+}
+
+// v, v/vt, v//vn or v/vt/vn
+bool ParseCorner(const char*& p, const char* end, RawCorner& corner)
+{
+    auto [afterV, ec] = std::from_chars(p, end, corner.v);
+    if (ec != std::errc() || corner.v == 0)
+    {
+        return false;
+    }
+    p = afterV;
+    if (p == end || *p != '/')
+    {
+        return true;
+    }
+
+    p++;
+    if (p < end && *p != '/')
+    {
+        auto [afterVt, ecVt] = std::from_chars(p, end, corner.vt);
+        if (ecVt != std::errc() || corner.vt == 0)
+        {
+            return false;
+        }
+        p = afterVt;
+    }
+    if (p == end || *p != '/')
+    {
+        return true;
+    }
+
+    p++;
+    auto [afterVn, ecVn] = std::from_chars(p, end, corner.vn);
+    if (ecVn != std::errc() || corner.vn == 0)
+    {
+        return false;
+    }
+    p = afterVn;
+    return true;
+}
+
+int ResolveIndex(Chunk& chunk, int raw, size_t localCount, Component component)
+{
+    if (raw > 0)
+    {
+        return raw - 1;
+    }
+    if (raw == 0)
+    {
+        return -1;
+    }
+    // May be negative here when it points into an earlier chunk
+    chunk.relative.push_back(static_cast<uint32_t>(chunk.corners.size() << 2) | component);
+    return static_cast<int>(localCount) + raw;
+}
+
+void PushCorner(Chunk& chunk, const RawCorner& raw)
+{
+    tinyobj_vertex_index_t corner;
+    corner.v_idx = ResolveIndex(chunk, raw.v, chunk.positions.size() / 3, Position);
+    corner.vt_idx = ResolveIndex(chunk, raw.vt, chunk.texcoords.size() / 2, Texcoord);
+    corner.vn_idx = ResolveIndex(chunk, raw.vn, chunk.normals.size() / 3, Normal);
+    chunk.corners.push_back(corner);
+}
+
+// Fan-triangulate like tinyobj: (0, 1, 2), (0, 2, 3), ...
+bool ParseFace(const char* p, const char* end, Chunk& chunk)
+{
+    RawCorner first;
+    RawCorner previous;
+    size_t count = 0;
+    for (SkipBlanks(p, end); p < end; SkipBlanks(p, end))
+    {
+        RawCorner corner;
+        if (!ParseCorner(p, end, corner) || (p < end && !IsBlank(*p)))
+        {
+            return false;
+        }
+        if (count == 0)
+        {
+            first = corner;
+        }
+        else if (count >= 2)
+        {
+            PushCorner(chunk, first);
+            PushCorner(chunk, previous);
+            PushCorner(chunk, corner);
+        }
+        previous = corner;
+        count++;
+    }
+    return true;
+}
+
+void ParseChunk(Chunk& chunk)
+{
+    for (const char* line = chunk.begin; line < chunk.end;)
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(line, '\n', size_t(chunk.end - line)));
+        if (!lineEnd)
+        {
+            lineEnd = chunk.end;
+        }
+
+        const char* p = line;
+        SkipBlanks(p, lineEnd);
+        if (lineEnd - p >= 2 && p[0] == 'v')
+        {
+            if (IsBlank(p[1]))
+            {
+                ParseFloats<3>(p + 2, lineEnd, chunk.positions);
+            }
+            else if (p[1] == 'n' && lineEnd - p >= 3 && IsBlank(p[2]))
+            {
+                ParseFloats<3>(p + 3, lineEnd, chunk.normals);
+            }
+            else if (p[1] == 't' && lineEnd - p >= 3 && IsBlank(p[2]))
+            {
+                ParseFloats<2>(p + 3, lineEnd, chunk.texcoords);
+            }
+        }
+        else if (lineEnd - p >= 2 && p[0] == 'f' && IsBlank(p[1]))
+        {
+            if (!ParseFace(p + 2, lineEnd, chunk))
+            {
+                chunk.error = line;
+                return;
+            }
+        }
+
+        line = lineEnd + 1;
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// OBJMeshView
+// ============================================================================
+OBJMeshView OBJMeshView::FromAttributes(const OBJAttributes& attributes)
+{
+    return { attributes.positions, attributes.normals, attributes.texcoords, attributes.corners };
+}
+
+OBJMeshView OBJMeshView::FromTinyObj(const tinyobj_attrib_t& attrib)
+{
+    OBJMeshView view;
+    view.positions = { attrib.vertices, size_t(attrib.num_vertices) * 3 };
+    view.normals = { attrib.normals, size_t(attrib.num_normals) * 3 };
+    view.texcoords = { attrib.texcoords, size_t(attrib.num_texcoords) * 2 };
+    view.corners = { attrib.faces, size_t(attrib.num_faces) };
+    return view;
+}
+
+// ============================================================================
+// ParseOBJChunked
+// ============================================================================
+bool ParseOBJChunked(const std::filesystem::path& objPath, unsigned threadCount, OBJAttributes& attributes)
+{
+    attributes = {};
+
+    MappedFile file;
+    if (!file.Open(objPath))
+    {
+        log::warning("Cannot read OBJ: %s", objPath.string().c_str());
+        return false;
+    }
+    const char* data = file.Data();
+    const size_t size = file.Size();
+
+    // Split at the first line break after each nominal boundary; a chunk
+    // whose range holds no line break ends up empty
+    const size_t chunkCount = std::max<size_t>(1, (size + kChunkBytes - 1) / kChunkBytes);
+    std::vector<Chunk> chunks(chunkCount);
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        const char* begin = data;
+        if (i > 0)
+        {
+            const char* nominal = data + i * (size / chunkCount) - 1;
+            const char* lineBreak = static_cast<const char*>(memchr(nominal, '\n', size_t(data + size - nominal)));
+            begin = std::max(lineBreak ? lineBreak + 1 : data + size, chunks[i - 1].begin);
+        }
+        chunks[i].begin = begin;
+        if (i > 0)
+        {
+            chunks[i - 1].end = begin;
+        }
+    }
+    chunks.back().end = data + size;
+
+    parallel::ForEach(chunkCount, threadCount, [&](size_t i) { ParseChunk(chunks[i]); });
+
+    for (const Chunk& chunk : chunks)
+    {
+        if (chunk.error)
+        {
+            log::warning("Malformed OBJ face at byte %zu: %s", size_t(chunk.error - data), objPath.string().c_str());
+            return false;
+        }
+    }
+
+    // Prefix sums give every chunk its place in the output and the base of
+    // its relative indices
+    struct ChunkBase
+    {
+        size_t positions = 0;
+        size_t normals = 0;
+        size_t texcoords = 0;
+        size_t corners = 0;
+    };
+    std::vector<ChunkBase> bases(chunkCount + 1);
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        bases[i + 1].positions = bases[i].positions + chunks[i].positions.size();
+        bases[i + 1].normals = bases[i].normals + chunks[i].normals.size();
+        bases[i + 1].texcoords = bases[i].texcoords + chunks[i].texcoords.size();
+        bases[i + 1].corners = bases[i].corners + chunks[i].corners.size();
+    }
+    const ChunkBase& total = bases[chunkCount];
+
+    if (total.positions / 3 > size_t(INT_MAX) || total.corners > size_t(UINT32_MAX))
+    {
+        log::warning("OBJ is too large for 32-bit indices: %s", objPath.string().c_str());
+        return false;
+    }
+    const int positionCount = static_cast<int>(total.positions / 3);
+    const int normalCount = static_cast<int>(total.normals / 3);
+    const int texcoordCount = static_cast<int>(total.texcoords / 2);
+
+    attributes.positions.resize(total.positions);
+    attributes.normals.resize(total.normals);
+    attributes.texcoords.resize(total.texcoords);
+    attributes.corners.resize(total.corners);
+
+    // Copy, rebase and range-check each chunk, releasing it as soon as it
+    // has been copied
+    std::vector<uint8_t> inRange(chunkCount, 1);
+    parallel::ForEach(chunkCount, threadCount, [&](size_t i)
+    {
+        Chunk& chunk = chunks[i];
+        const ChunkBase& base = bases[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), attributes.positions.begin() + base.positions);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), attributes.normals.begin() + base.normals);
+        std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), attributes.texcoords.begin() + base.texcoords);
+
+        for (uint32_t slot : chunk.relative)
+        {
+            tinyobj_vertex_index_t& corner = chunk.corners[slot >> 2];
+            switch (slot & 3)
+            {
+            case Position: corner.v_idx += static_cast<int>(base.positions / 3); break;
+            case Texcoord: corner.vt_idx += static_cast<int>(base.texcoords / 2); break;
+            case Normal: corner.vn_idx += static_cast<int>(base.normals / 3); break;
+            }
+        }
+
+        for (const tinyobj_vertex_index_t& corner : chunk.corners)
+        {
+            if (corner.v_idx < 0 || corner.v_idx >= positionCount ||
+                corner.vt_idx < -1 || corner.vt_idx >= texcoordCount ||
+                corner.vn_idx < -1 || corner.vn_idx >= normalCount)
+            {
+                inRange[i] = 0;
+                break;
+            }
+        }
+        std::copy(chunk.corners.begin(), chunk.corners.end(), attributes.corners.begin() + base.corners);
+
+        chunk = {};
+    });
+
+    if (std::find(inRange.begin(), inRange.end(), 0) != inRange.end())
+    {
+        log::warning("OBJ face index out of range: %s", objPath.string().c_str());
+        attributes = {};
+        return false;
+    }
+    return true;
+}
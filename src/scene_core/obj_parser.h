@@ -0,0 +1,48 @@
+#pragma once
+
+// ============================================================================
+// OBJ Parser
+// Multi-threaded parser for single large OBJ files, where tinyobj spends
+// minutes on one core. The file is split into line-aligned chunks that are
+// parsed concurrently; the per-chunk attribute arrays are then concatenated
+// and face indices rebased. Only geometry is read (v, vt, vn, f) - groups,
+// materials and all other records are skipped, as BuildOBJMesh ignores them.
+// ============================================================================
+
+#include <tinyobj_loader_c.h>
+
+#include <filesystem>
+#include <span>
+#include <vector>
+#include <cstddef>
+
+// Attribute arrays of one OBJ file. Polygons are fan-triangulated like
+// tinyobj does, three corners per triangle. Corner indices are zero-based
+// and -1 marks an attribute the corner does not reference.
+struct OBJAttributes
+{
+    std::vector<float> positions;   // xyz
+    std::vector<float> normals;     // xyz
+    std::vector<float> texcoords;   // uv
+    std::vector<tinyobj_vertex_index_t> corners;
+};
+
+// Non-owning view of parsed OBJ geometry, filled from either parser so both
+// go through the same dedup and transform code
+struct OBJMeshView
+{
+    std::span<const float> positions;
+    std::span<const float> normals;
+    std::span<const float> texcoords;
+    std::span<const tinyobj_vertex_index_t> corners;
+
+    static OBJMeshView FromAttributes(const OBJAttributes& attributes);
+    // Expects TINYOBJ_FLAG_TRIANGULATE
+    static OBJMeshView FromTinyObj(const tinyobj_attrib_t& attrib);
+};
+
+// Parse `objPath` on up to `threadCount` threads (0 = all cores). Indices
+// may be absolute or relative (negative) and are resolved against the whole
+// file, not the chunk they appear in. Logs and returns false if the file
+// cannot be read, a face record is malformed or an index is out of range.
+bool ParseOBJChunked(const std::filesystem::path& objPath, unsigned threadCount, OBJAttributes& attributes);
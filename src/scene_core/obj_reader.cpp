@@ -0,0 +1,32 @@
+#define TINYOBJ_LOADER_C_IMPLEMENTATION
+#include "obj_reader.h"
+
+size_t OBJReaderContext::BytesRead() const
+{
+    size_t bytes = 0;
+    for (const MappedFile& file : m_Files)
+    {
+        bytes += file.Size();
+    }
+    return bytes;
+}
+
+void FileReaderCallback(void* ctx, const char* filename, int /*is_mtl*/,
+                        const char* /*obj_filename*/, char** buf, size_t* len)
+{
+    OBJReaderContext* reader = static_cast<OBJReaderContext*>(ctx);
+
+    // tinyobj only reads the buffer (lines are copied before parsing) and
+    // never frees it, so the read-only mapping can be handed over directly
+    MappedFile file;
+    if (!file.Open(filename))
+    {
+        *buf = nullptr;
+        *len = 0;
+        return;
+    }
+
+    *buf = file.Data();
+    *len = file.Size();
+    reader->m_Files.push_back(std::move(file));
+}
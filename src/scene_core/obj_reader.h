@@ -0,0 +1,37 @@
+#pragma once
+
+// ============================================================================
+// OBJ Reader
+// File reader callback for tinyobjloader-c. The tinyobj implementation is
+// compiled into scene_core, so applications only include the header.
+// ============================================================================
+
+#include <tinyobj_loader_c.h>
+
+#include "../common/mapped_file.h"
+
+#include <vector>
+#include <cstddef>
+
+// Owns the files handed to tinyobj. They are memory-mapped read-only (heap
+// fallback if mapping fails) and stay valid until the context is destroyed,
+// so keep it alive across tinyobj_parse_obj:
+//
+//     OBJReaderContext reader;
+//     tinyobj_parse_obj(..., path, FileReaderCallback, &reader, flags);
+class OBJReaderContext
+{
+public:
+    // Bytes of all files read through this context
+    size_t BytesRead() const;
+
+private:
+    friend void FileReaderCallback(void*, const char*, int, const char*, char**, size_t*);
+    std::vector<MappedFile> m_Files;    // OBJ and its MTL
+};
+
+// ctx must point to an OBJReaderContext. tinyobj passes the OBJ path as
+// given to tinyobj_parse_obj and MTL paths relative to it, so both are
+// opened as is.
+void FileReaderCallback(void* ctx, const char* filename, int is_mtl,
+                        const char* obj_filename, char** buf, size_t* len);
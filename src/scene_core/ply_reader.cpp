@@ -0,0 +1,559 @@
+#include "ply_reader.h"
+
+#include <donut/core/log.h>
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <string_view>
+
+using namespace donut;
+
+// ============================================================================
+// Header
+// ============================================================================
+namespace
+{
+
+enum class Format
+{
+    Ascii,
+    BinaryLittleEndian,
+    BinaryBigEndian
+};
+
+enum class Type : uint8_t
+{
+    Invalid,
+    Int8,
+    UInt8,
+    Int16,
+    UInt16,
+    Int32,
+    UInt32,
+    Float32,
+    Float64
+};
+
+size_t TypeSize(Type type)
+{
+    switch (type)
+    {
+    case Type::Int8: case Type::UInt8: return 1;
+    case Type::Int16: case Type::UInt16: return 2;
+    case Type::Int32: case Type::UInt32: case Type::Float32: return 4;
+    case Type::Float64: return 8;
+    default: return 0;
+    }
+}
+
+Type ParseType(std::string_view name)
+{
+    if (name == "char" || name == "int8") return Type::Int8;
+    if (name == "uchar" || name == "uint8") return Type::UInt8;
+    if (name == "short" || name == "int16") return Type::Int16;
+    if (name == "ushort" || name == "uint16") return Type::UInt16;
+    if (name == "int" || name == "int32") return Type::Int32;
+    if (name == "uint" || name == "uint32") return Type::UInt32;
+    if (name == "float" || name == "float32") return Type::Float32;
+    if (name == "double" || name == "float64") return Type::Float64;
+    return Type::Invalid;
+}
+
+struct Property
+{
+    std::string_view name;
+    Type type = Type::Invalid;          // Item type for lists
+    Type countType = Type::Invalid;     // Invalid = not a list
+    size_t offset = 0;                  // Within a fixed-size element
+
+    bool IsList() const { return countType != Type::Invalid; }
+};
+
+struct Element
+{
+    std::string_view name;
+    size_t count = 0;
+    std::vector<Property> properties;
+
+    bool IsFixedSize() const
+    {
+        return std::none_of(properties.begin(), properties.end(), [](const Property& p) { return p.IsList(); });
+    }
+    size_t Size() const
+    {
+        size_t size = 0;
+        for (const Property& property : properties)
+        {
+            size += TypeSize(property.type);
+        }
+        return size;
+    }
+    // Smallest binary instance: every list empty
+    size_t MinSize() const
+    {
+        size_t size = 0;
+        for (const Property& property : properties)
+        {
+            size += TypeSize(property.IsList() ? property.countType : property.type);
+        }
+        return size;
+    }
+    const Property* Find(std::string_view name) const
+    {
+        for (const Property& property : properties)
+        {
+            if (property.name == name)
+            {
+                return &property;
+            }
+        }
+        return nullptr;
+    }
+};
+
+// Split off the next whitespace-separated word of a header line
+std::string_view NextWord(std::string_view& line)
+{
+    size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos)
+    {
+        line = {};
+        return {};
+    }
+    size_t end = line.find_first_of(" \t\r", start);
+    std::string_view word = line.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+    line.remove_prefix(end == std::string_view::npos ? line.size() : end);
+    return word;
+}
+
+// Returns the position right after "end_header\n", or nullptr
+const char* ParseHeader(const char* data, size_t size, Format& format, std::vector<Element>& elements)
+{
+    std::string_view text(data, size);
+    if (text.substr(0, 3) != "ply")
+    {
+        return nullptr;
+    }
+
+    bool hasFormat = false;
+    size_t lineStart = 0;
+    while (lineStart < text.size())
+    {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos)
+        {
+            return nullptr;
+        }
+        std::string_view line = text.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        std::string_view keyword = NextWord(line);
+        if (keyword == "format")
+        {
+            std::string_view name = NextWord(line);
+            hasFormat = true;
+            if (name == "ascii") format = Format::Ascii;
+            else if (name == "binary_little_endian") format = Format::BinaryLittleEndian;
+            else if (name == "binary_big_endian") format = Format::BinaryBigEndian;
+            else return nullptr;
+        }
+        else if (keyword == "element")
+        {
+            Element element;
+            element.name = NextWord(line);
+            std::string_view count = NextWord(line);
+            if (std::from_chars(count.data(), count.data() + count.size(), element.count).ec != std::errc())
+            {
+                return nullptr;
+            }
+            elements.push_back(element);
+        }
+        else if (keyword == "property")
+        {
+            if (elements.empty())
+            {
+                return nullptr;
+            }
+            Property property;
+            std::string_view type = NextWord(line);
+            if (type == "list")
+            {
+                property.countType = ParseType(NextWord(line));
+                type = NextWord(line);
+                if (property.countType == Type::Invalid || property.countType == Type::Float32 ||
+                    property.countType == Type::Float64)
+                {
+                    return nullptr;
+                }
+            }
+            property.type = ParseType(type);
+            property.name = NextWord(line);
+            if (property.type == Type::Invalid)
+            {
+                return nullptr;
+            }
+
+            Element& element = elements.back();
+            property.offset = element.properties.empty() || element.properties.back().IsList() ? 0 :
+                element.properties.back().offset + TypeSize(element.properties.back().type);
+            element.properties.push_back(property);
+        }
+        else if (keyword == "end_header")
+        {
+            return hasFormat ? data + lineStart : nullptr;
+        }
+        // comment, obj_info and blank lines are ignored
+    }
+    return nullptr;
+}
+
+// ============================================================================
+// Body Decoding
+// General path for ASCII, big-endian and layouts the in-place path does not
+// cover. Every value goes through double, which is exact for all PLY types.
+// ============================================================================
+class ValueReader
+{
+public:
+    ValueReader(const char* begin, const char* end, Format format) : m_Position(begin), m_End(end), m_Format(format) {}
+
+    bool Read(Type type, double& value)
+    {
+        if (m_Format == Format::Ascii)
+        {
+            while (m_Position < m_End && (*m_Position == ' ' || *m_Position == '\t' || *m_Position == '\r' || *m_Position == '\n'))
+            {
+                m_Position++;
+            }
+            auto [ptr, ec] = std::from_chars(m_Position, m_End, value);
+            m_Position = ptr;
+            return ec == std::errc();
+        }
+
+        size_t size = TypeSize(type);
+        if (size_t(m_End - m_Position) < size)
+        {
+            return false;
+        }
+        unsigned char bytes[8];
+        memcpy(bytes, m_Position, size);
+        m_Position += size;
+        if ((m_Format == Format::BinaryBigEndian) != (std::endian::native == std::endian::big))
+        {
+            std::reverse(bytes, bytes + size);
+        }
+
+        switch (type)
+        {
+        case Type::Int8: { int8_t v; memcpy(&v, bytes, 1); value = v; break; }
+        case Type::UInt8: { uint8_t v; memcpy(&v, bytes, 1); value = v; break; }
+        case Type::Int16: { int16_t v; memcpy(&v, bytes, 2); value = v; break; }
+        case Type::UInt16: { uint16_t v; memcpy(&v, bytes, 2); value = v; break; }
+        case Type::Int32: { int32_t v; memcpy(&v, bytes, 4); value = v; break; }
+        case Type::UInt32: { uint32_t v; memcpy(&v, bytes, 4); value = v; break; }
+        case Type::Float32: { float v; memcpy(&v, bytes, 4); value = v; break; }
+        case Type::Float64: { double v; memcpy(&v, bytes, 8); value = v; break; }
+        default: return false;
+        }
+        return true;
+    }
+
+    const char* Position() const { return m_Position; }
+    size_t Remaining() const { return size_t(m_End - m_Position); }
+    void Advance(size_t bytes) { m_Position += bytes; }
+    bool IsBinary() const { return m_Format != Format::Ascii; }
+
+private:
+    const char* m_Position;
+    const char* m_End;
+    Format m_Format;
+};
+
+// Read one element instance, handing every value to onValue(property, item, value)
+template <typename OnValue>
+bool ReadInstance(ValueReader& reader, const Element& element, OnValue&& onValue)
+{
+    for (const Property& property : element.properties)
+    {
+        double value = 0.0;
+        if (!property.IsList())
+        {
+            if (!reader.Read(property.type, value))
+            {
+                return false;
+            }
+            onValue(property, 0, value);
+            continue;
+        }
+
+        // Every item takes at least a byte, which also keeps size_t(count)
+        // defined for huge ASCII counts
+        double count = 0.0;
+        if (!reader.Read(property.countType, count) || !(count >= 0.0 && count <= double(reader.Remaining())))
+        {
+            return false;
+        }
+        for (size_t item = 0; item < size_t(count); item++)
+        {
+            if (!reader.Read(property.type, value))
+            {
+                return false;
+            }
+            onValue(property, item, value);
+        }
+    }
+    return true;
+}
+
+const char* const kTexcoordNames[][2] = {
+    { "u", "v" }, { "s", "t" }, { "texture_u", "texture_v" }, { "texture_s", "texture_t" },
+};
+
+} // namespace
+
+// ============================================================================
+// PLYFile
+// ============================================================================
+bool PLYFile::Open(const std::filesystem::path& path)
+{
+    *this = {};
+    if (!m_File.Open(path))
+    {
+        log::warning("Cannot read PLY: %s", path.string().c_str());
+        return false;
+    }
+
+    Format format = Format::Ascii;
+    std::vector<Element> elements;
+    const char* body = ParseHeader(m_File.Data(), m_File.Size(), format, elements);
+    if (!body)
+    {
+        log::warning("Malformed PLY header: %s", path.string().c_str());
+        return false;
+    }
+
+    const bool inPlace = format == Format::BinaryLittleEndian && std::endian::native == std::endian::little;
+    ValueReader reader(body, m_File.Data() + m_File.Size(), format);
+    bool ok = true;
+    bool hasVertices = false;
+
+    for (const Element& element : elements)
+    {
+        // Header counts size the allocations below, so one the rest of the
+        // file cannot hold fails here instead of in the allocator: a binary
+        // instance takes at least MinSize() bytes, an ASCII one at least a
+        // character per property
+        const size_t minSize = std::max<size_t>(reader.IsBinary() ? element.MinSize() : element.properties.size(), 1);
+        if (element.count > reader.Remaining() / minSize)
+        {
+            ok = false;
+            break;
+        }
+
+        if (element.name == "vertex" && !hasVertices)
+        {
+            hasVertices = true;
+            m_VertexCount = element.count;
+
+            const Property* position[3] = { element.Find("x"), element.Find("y"), element.Find("z") };
+            const Property* normal[3] = { element.Find("nx"), element.Find("ny"), element.Find("nz") };
+            const Property* texcoord[2] = {};
+            for (const auto& names : kTexcoordNames)
+            {
+                if (element.Find(names[0]) && element.Find(names[1]))
+                {
+                    texcoord[0] = element.Find(names[0]);
+                    texcoord[1] = element.Find(names[1]);
+                    break;
+                }
+            }
+            if (!position[0] || !position[1] || !position[2])
+            {
+                log::warning("PLY vertices have no positions: %s", path.string().c_str());
+                return false;
+            }
+            const bool hasNormal = normal[0] && normal[1] && normal[2];
+            const bool hasTexcoord = texcoord[0] != nullptr;
+
+            // In place when every attribute used is a float laid out as
+            // consecutive components (x y z, nx ny nz, u v)
+            auto isFloatRun = [](const Property* const* components, size_t count)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    if (components[i]->type != Type::Float32 || components[i]->IsList() ||
+                        components[i]->offset != components[0]->offset + i * sizeof(float))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            };
+            if (inPlace && element.IsFixedSize() && isFloatRun(position, 3) &&
+                (!hasNormal || isFloatRun(normal, 3)) && (!hasTexcoord || isFloatRun(texcoord, 2)))
+            {
+                const size_t stride = element.Size();
+                if (element.count > reader.Remaining() / std::max<size_t>(stride, 1))
+                {
+                    ok = false;
+                    break;
+                }
+                m_Positions = { reader.Position() + position[0]->offset, stride };
+                if (hasNormal)
+                {
+                    m_Normals = { reader.Position() + normal[0]->offset, stride };
+                }
+                if (hasTexcoord)
+                {
+                    m_Texcoords = { reader.Position() + texcoord[0]->offset, stride };
+                }
+                reader.Advance(element.count * stride);
+                continue;
+            }
+
+            // Decode into 8 floats per vertex: position, normal, texcoord
+            const Property* slots[8] = { position[0], position[1], position[2],
+                                         normal[0], normal[1], normal[2], texcoord[0], texcoord[1] };
+            m_Decoded.assign(element.count * 8, 0.0f);
+            for (size_t v = 0; ok && v < element.count; v++)
+            {
+                float* out = &m_Decoded[v * 8];
+                ok = ReadInstance(reader, element, [&](const Property& property, size_t, double value)
+                {
+                    for (size_t s = 0; s < 8; s++)
+                    {
+                        if (slots[s] == &property)
+                        {
+                            out[s] = static_cast<float>(value);
+                        }
+                    }
+                });
+            }
+            const char* decoded = reinterpret_cast<const char*>(m_Decoded.data());
+            m_Positions = { decoded, 8 * sizeof(float) };
+            if (hasNormal)
+            {
+                m_Normals = { decoded + 3 * sizeof(float), 8 * sizeof(float) };
+            }
+            if (hasTexcoord)
+            {
+                m_Texcoords = { decoded + 6 * sizeof(float), 8 * sizeof(float) };
+            }
+        }
+        else if (element.name == "face")
+        {
+            const Property* indexList = element.Find("vertex_indices");
+            if (!indexList)
+            {
+                indexList = element.Find("vertex_index");
+            }
+            if (reader.IsBinary())
+            {
+                m_Indices.reserve(m_Indices.size() + element.count * 3);
+            }
+
+            // Fan-triangulate the indices collected for one face
+            std::vector<uint32_t> polygon;
+            auto emitPolygon = [&]()
+            {
+                for (size_t k = 2; k < polygon.size(); k++)
+                {
+                    m_Indices.insert(m_Indices.end(), { polygon[0], polygon[k - 1], polygon[k] });
+                }
+                polygon.clear();
+            };
+
+            // The common exporter layout: "list uchar int|uint vertex_indices"
+            // only, which is mostly triangles
+            if (inPlace && indexList && element.properties.size() == 1 && indexList->countType == Type::UInt8 &&
+                (indexList->type == Type::Int32 || indexList->type == Type::UInt32))
+            {
+                const char* p = reader.Position();
+                const char* end = p + reader.Remaining();
+                for (size_t f = 0; ok && f < element.count; f++)
+                {
+                    if (p >= end || size_t(end - p) < 1 + static_cast<uint8_t>(*p) * sizeof(uint32_t))
+                    {
+                        ok = false;
+                        break;
+                    }
+                    const size_t count = static_cast<uint8_t>(*p);
+                    if (count == 3)
+                    {
+                        size_t first = m_Indices.size();
+                        m_Indices.resize(first + 3);
+                        memcpy(&m_Indices[first], p + 1, 3 * sizeof(uint32_t));
+                    }
+                    else
+                    {
+                        polygon.resize(count);
+                        memcpy(polygon.data(), p + 1, count * sizeof(uint32_t));
+                        emitPolygon();
+                    }
+                    p += 1 + count * sizeof(uint32_t);
+                }
+                reader.Advance(size_t(p - reader.Position()));
+                continue;
+            }
+
+            for (size_t f = 0; ok && f < element.count; f++)
+            {
+                bool inRange = true;
+                ok = ReadInstance(reader, element, [&](const Property& property, size_t, double value)
+                {
+                    if (&property == indexList)
+                    {
+                        // Converting a negative or too large value is undefined
+                        inRange = inRange && value >= 0.0 && value <= double(UINT32_MAX);
+                        polygon.push_back(inRange ? static_cast<uint32_t>(value) : 0);
+                    }
+                }) && inRange;
+                emitPolygon();
+            }
+        }
+        else if (reader.IsBinary() && element.IsFixedSize())
+        {
+            // Skip unused elements (edges, materials, ...) without decoding
+            const size_t size = element.Size();
+            if (element.count > reader.Remaining() / std::max<size_t>(size, 1))
+            {
+                ok = false;
+                break;
+            }
+            reader.Advance(element.count * size);
+        }
+        else
+        {
+            for (size_t i = 0; ok && i < element.count; i++)
+            {
+                ok = ReadInstance(reader, element, [](const Property&, size_t, double) {});
+            }
+        }
+
+        if (!ok)
+        {
+            break;
+        }
+    }
+
+    if (!ok)
+    {
+        log::warning("PLY data is truncated or malformed: %s", path.string().c_str());
+        return false;
+    }
+    if (!hasVertices)
+    {
+        log::warning("PLY has no vertex element: %s", path.string().c_str());
+        return false;
+    }
+    for (uint32_t index : m_Indices)
+    {
+        if (index >= m_VertexCount)
+        {
+            log::warning("PLY face index out of range: %s", path.string().c_str());
+            return false;
+        }
+    }
+    return true;
+}
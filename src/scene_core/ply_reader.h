@@ -0,0 +1,63 @@
+#pragma once
+
+// ============================================================================
+// PLY Reader
+// Memory-mapped reader for Stanford PLY meshes (ASCII, binary little and big
+// endian), the format Mitsuba's and Blender's exporters write for
+// <shape type="ply">. Little-endian files whose vertex attributes are floats
+// are used in place: attributes are strided views into the mapping, and
+// triangle indices are copied out without per-element parsing. Any other
+// layout is decoded into a compact copy with the same interface.
+// ============================================================================
+
+#include "../common/mapped_file.h"
+
+#include <filesystem>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// `count` floats per element, element i starting at data + i * stride
+struct PLYAttribute
+{
+    const char* data = nullptr;     // nullptr = not present in the file
+    size_t stride = 0;
+
+    explicit operator bool() const { return data != nullptr; }
+
+    // Unaligned-safe: binary PLY records are packed
+    void Read(size_t index, float* out, size_t count) const
+    {
+        memcpy(out, data + index * stride, count * sizeof(float));
+    }
+};
+
+class PLYFile
+{
+public:
+    // Map `path`, parse its header and locate or decode the vertex and face
+    // elements. Logs and returns false for malformed or truncated files and
+    // out-of-range face indices.
+    bool Open(const std::filesystem::path& path);
+
+    size_t VertexCount() const { return m_VertexCount; }
+    const PLYAttribute& Positions() const { return m_Positions; }   // xyz
+    const PLYAttribute& Normals() const { return m_Normals; }       // xyz
+    const PLYAttribute& Texcoords() const { return m_Texcoords; }   // uv
+
+    // Three per triangle, polygons fan-triangulated. May be moved out.
+    std::vector<uint32_t>& Indices() { return m_Indices; }
+
+    // Vertex attributes are read straight from the mapping
+    bool IsZeroCopy() const { return m_Decoded.empty() && m_VertexCount > 0; }
+
+private:
+    MappedFile m_File;
+    size_t m_VertexCount = 0;
+    PLYAttribute m_Positions;
+    PLYAttribute m_Normals;
+    PLYAttribute m_Texcoords;
+    std::vector<float> m_Decoded;       // 8 floats per vertex when not in place
+    std::vector<uint32_t> m_Indices;
+};
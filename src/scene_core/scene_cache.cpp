@@ -0,0 +1,461 @@
+#include "scene_cache.h"
+
+#include <donut/core/log.h>
+
+#include <algorithm>
+#include <bit>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <cstdio>
+#include <cstring>
+
+using namespace donut;
+
+// ============================================================================
+// File Layout
+// [CacheHeader][CacheTextureEntry x textureCount][sections...][texels...]
+// Every section starts on a kSectionAlignment boundary so the mapped arrays
+// can be used in place (HMM_Mat4 needs 16-byte alignment).
+// ============================================================================
+namespace
+{
+
+// Bump whenever a GPU struct, the packing or the texture decode changes
+constexpr uint32_t kCacheVersion = 6;
+constexpr char kCacheMagic[8] = { 'R', 'T', 'S', 'C', 'A', 'C', 'H', 'E' };
+constexpr uint64_t kSectionAlignment = 64;
+
+enum Section : uint32_t
+{
+    Positions,
+    Vertices,
+    Indices,
+    Materials,
+    Instances,
+    Meshes,
+    Placements,
+    AnalyticShapes,
+    SectionCount
+};
+
+constexpr uint32_t kElementSizes[SectionCount] = {
+    sizeof(GPUPosition),
+    sizeof(GPUVertex),
+    sizeof(uint32_t),
+    sizeof(GPUMaterial),
+    sizeof(GPUInstance),
+    sizeof(MeshRange),
+    sizeof(InstancePlacement),
+    sizeof(AnalyticShape),
+};
+
+struct CacheSection
+{
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct CacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t textureCount;
+    uint64_t key;
+    uint32_t elementSizes[SectionCount];
+    CacheSection sections[SectionCount];
+};
+
+struct CacheTextureEntry
+{
+    int32_t width;      // 0 = not available
+    int32_t height;
+    uint64_t offset;    // width * height * 4 floats
+};
+
+uint64_t AlignUp(uint64_t value)
+{
+    return (value + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+}
+
+// FNV-1a 64
+void HashBytes(uint64_t& hash, const void* data, size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+// Length first, so consecutive strings cannot run into each other
+void HashString(uint64_t& hash, const std::string& text)
+{
+    uint64_t size = text.size();
+    HashBytes(hash, &size, sizeof(size));
+    HashBytes(hash, text.data(), text.size());
+}
+
+void HashFile(uint64_t& hash, const std::filesystem::path& path)
+{
+    std::string name = path.generic_string();
+    HashBytes(hash, name.data(), name.size());
+
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(path, ec);
+    if (ec)
+    {
+        size = UINT64_MAX;
+    }
+    auto writeTime = std::filesystem::last_write_time(path, ec);
+    int64_t ticks = ec ? 0 : static_cast<int64_t>(writeTime.time_since_epoch().count());
+
+    HashBytes(hash, &size, sizeof(size));
+    HashBytes(hash, &ticks, sizeof(ticks));
+}
+
+template <typename T>
+std::span<const T> SectionView(const char* base, const CacheSection& section)
+{
+    return { reinterpret_cast<const T*>(base + section.offset), static_cast<size_t>(section.count) };
+}
+
+} // namespace
+
+// ============================================================================
+// PackedScene
+// ============================================================================
+PackedScene PackedScene::FromGeometry(const SceneGeometry& geometry, const MitsubaSceneParser& scene)
+{
+    PackedScene packed;
+    packed.positions = geometry.positions;
+    packed.vertices = geometry.vertices;
+    packed.indices = geometry.indices;
+    packed.materials = geometry.materials;
+    packed.instances = geometry.instances;
+    packed.meshes = geometry.meshes;
+    packed.placements = geometry.placements;
+    packed.analyticShapes = geometry.analyticShapes;
+
+    packed.textures.resize(scene.textures.size());
+    for (size_t i = 0; i < scene.textures.size(); i++)
+    {
+        const texture_utils::TextureData& data = scene.textures[i].data;
+        if (data.IsValid())
+        {
+            packed.textures[i] = { data.width, data.height, data.data };
+        }
+    }
+    return packed;
+}
+
+bool PackedScene::Verify() const
+{
+    if (positions.size() != vertices.size() || placements.size() != instances.size())
+    {
+        log::warning("Scene arrays disagree: %zu positions, %zu vertices, %zu placements, %zu instances",
+            positions.size(), vertices.size(), placements.size(), instances.size());
+        return false;
+    }
+
+    for (size_t m = 0; m < meshes.size(); m++)
+    {
+        const MeshRange& mesh = meshes[m];
+        if (uint64_t(mesh.vertexOffset) + mesh.vertexCount > vertices.size() ||
+            uint64_t(mesh.indexOffset) + mesh.indexCount > indices.size() || mesh.indexCount % 3 != 0)
+        {
+            log::warning("Mesh %zu has vertices %u..%u and indices %u..%u, outside the %zu vertices and %zu indices",
+                m, mesh.vertexOffset, mesh.vertexOffset + mesh.vertexCount,
+                mesh.indexOffset, mesh.indexOffset + mesh.indexCount, vertices.size(), indices.size());
+            return false;
+        }
+
+        // A plain max reduction vectorizes; the offending index is only
+        // searched for when there is one
+        std::span<const uint32_t> meshIndices = indices.subspan(mesh.indexOffset, mesh.indexCount);
+        uint32_t maxIndex = 0;
+        for (uint32_t index : meshIndices)
+        {
+            maxIndex = std::max(maxIndex, index);
+        }
+        if (!meshIndices.empty() && maxIndex >= mesh.vertexCount)
+        {
+            auto bad = std::find_if(meshIndices.begin(), meshIndices.end(),
+                [&](uint32_t index) { return index >= mesh.vertexCount; });
+            log::warning("Mesh %zu: index %zu is %u, but the mesh has %u vertices",
+                m, size_t(bad - meshIndices.begin()), *bad, mesh.vertexCount);
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < placements.size(); i++)
+    {
+        const uint32_t meshIndex = placements[i].meshIndex;
+        if (meshIndex >= meshes.size())
+        {
+            log::warning("Instance %zu uses mesh %u of %zu", i, meshIndex, meshes.size());
+            return false;
+        }
+        const MeshRange& mesh = meshes[meshIndex];
+        if (instances[i].vertexOffset != mesh.vertexOffset || instances[i].indexOffset != mesh.indexOffset)
+        {
+            log::warning("Instance %zu reads vertices from %u and indices from %u, but mesh %u starts at %u and %u",
+                i, instances[i].vertexOffset, instances[i].indexOffset, meshIndex, mesh.vertexOffset, mesh.indexOffset);
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < analyticShapes.size(); i++)
+    {
+        const AnalyticShape& shape = analyticShapes[i];
+        if (uint32_t(shape.type) > uint32_t(AnalyticType::Cube) || shape.materialIndex >= materials.size())
+        {
+            log::warning("Analytic shape %zu has type %u and material %u of %zu",
+                i, uint32_t(shape.type), shape.materialIndex, materials.size());
+            return false;
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// SceneCache
+// ============================================================================
+uint64_t SceneCache::ComputeKey(const MitsubaSceneParser& scene, const std::filesystem::path& xmlPath,
+                                const SceneGeometry& loader)
+{
+    uint64_t hash = 14695981039346656037ull;
+    HashFile(hash, xmlPath);
+    for (const auto& source : scene.ReferencedFiles())
+    {
+        HashFile(hash, source);
+    }
+
+    // Parameters can come from the command line; sorted, as the map is not
+    std::vector<std::pair<std::string, std::string>> parameters(scene.parameters.begin(), scene.parameters.end());
+    std::sort(parameters.begin(), parameters.end());
+    for (const auto& [name, value] : parameters)
+    {
+        HashString(hash, name);
+        HashString(hash, value);
+    }
+
+    // Thread counts and the parser choice leave the arrays unchanged
+    const uint32_t settings[] = {
+        loader.keepShapesLocal ? 1u : 0u,
+        loader.optimizeVertexCache ? 1u : 0u,
+        std::bit_cast<uint32_t>(loader.analyticEdgePixels),
+        loader.maxAnalyticSegments,
+        loader.analyticPrimitives,
+    };
+    HashBytes(hash, settings, sizeof(settings));
+    return hash;
+}
+
+std::filesystem::path SceneCache::PathFor(const std::filesystem::path& xmlPath)
+{
+    std::filesystem::path cachePath = xmlPath;
+    cachePath += ".rtcache";
+    return cachePath;
+}
+
+bool SceneCache::Write(const std::filesystem::path& cachePath, uint64_t key, const PackedScene& packed)
+{
+    CacheHeader header = {};
+    memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+    header.version = kCacheVersion;
+    header.textureCount = static_cast<uint32_t>(packed.textures.size());
+    header.key = key;
+    memcpy(header.elementSizes, kElementSizes, sizeof(kElementSizes));
+
+    const void* sectionData[SectionCount] = {
+        packed.positions.data(), packed.vertices.data(), packed.indices.data(), packed.materials.data(),
+        packed.instances.data(), packed.meshes.data(), packed.placements.data(), packed.analyticShapes.data(),
+    };
+    const size_t sectionCounts[SectionCount] = {
+        packed.positions.size(), packed.vertices.size(), packed.indices.size(), packed.materials.size(),
+        packed.instances.size(), packed.meshes.size(), packed.placements.size(), packed.analyticShapes.size(),
+    };
+
+    // Lay out all sections and texel blocks up front
+    uint64_t offset = AlignUp(sizeof(CacheHeader) + sizeof(CacheTextureEntry) * packed.textures.size());
+    for (uint32_t s = 0; s < SectionCount; s++)
+    {
+        header.sections[s] = { offset, sectionCounts[s] };
+        offset = AlignUp(offset + sectionCounts[s] * kElementSizes[s]);
+    }
+    std::vector<CacheTextureEntry> textureEntries(packed.textures.size());
+    for (size_t i = 0; i < packed.textures.size(); i++)
+    {
+        const PackedScene::Texture& texture = packed.textures[i];
+        textureEntries[i] = { texture.width, texture.height, offset };
+        offset = AlignUp(offset + texture.rgba.size_bytes());
+    }
+
+    std::filesystem::path tempPath = cachePath;
+    tempPath += ".tmp";
+
+    FILE* file = nullptr;
+#ifdef _WIN32
+    _wfopen_s(&file, tempPath.c_str(), L"wb");
+#else
+    file = fopen(tempPath.c_str(), "wb");
+#endif
+    if (!file)
+    {
+        log::warning("Cannot write scene cache: %s", tempPath.string().c_str());
+        return false;
+    }
+
+    uint64_t written = 0;
+    bool ok = true;
+    auto writeAt = [&](uint64_t position, const void* data, size_t size)
+    {
+        static const char zeros[kSectionAlignment] = {};
+        while (ok && written < position)
+        {
+            size_t pad = static_cast<size_t>(std::min<uint64_t>(position - written, kSectionAlignment));
+            ok = fwrite(zeros, 1, pad, file) == pad;
+            written += pad;
+        }
+        if (ok && size > 0)
+        {
+            ok = fwrite(data, 1, size, file) == size;
+            written += size;
+        }
+    };
+
+    writeAt(0, &header, sizeof(header));
+    writeAt(written, textureEntries.data(), textureEntries.size() * sizeof(CacheTextureEntry));
+    for (uint32_t s = 0; s < SectionCount; s++)
+    {
+        writeAt(header.sections[s].offset, sectionData[s], sectionCounts[s] * kElementSizes[s]);
+    }
+    for (size_t i = 0; i < packed.textures.size(); i++)
+    {
+        writeAt(textureEntries[i].offset, packed.textures[i].rgba.data(), packed.textures[i].rgba.size_bytes());
+    }
+    ok = (fclose(file) == 0) && ok;
+
+    std::error_code ec;
+    if (ok)
+    {
+        std::filesystem::rename(tempPath, cachePath, ec);
+        ok = !ec;
+    }
+    if (!ok)
+    {
+        std::filesystem::remove(tempPath, ec);
+        log::warning("Failed to write scene cache: %s", cachePath.string().c_str());
+        return false;
+    }
+
+    log::info("Wrote scene cache %s (%.1f MB)", cachePath.string().c_str(), double(written) / (1024.0 * 1024.0));
+    return true;
+}
+
+bool SceneCache::Open(const std::filesystem::path& cachePath, uint64_t key)
+{
+    Close();
+
+    std::error_code ec;
+    if (!std::filesystem::exists(cachePath, ec) || !m_File.Open(cachePath))
+    {
+        return false;
+    }
+
+    const char* base = m_File.Data();
+    const uint64_t fileSize = m_File.Size();
+
+    CacheHeader header;
+    if (fileSize < sizeof(header))
+    {
+        log::warning("Scene cache is truncated, ignoring: %s", cachePath.string().c_str());
+        Close();
+        return false;
+    }
+    memcpy(&header, base, sizeof(header));
+
+    if (memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+        header.version != kCacheVersion ||
+        memcmp(header.elementSizes, kElementSizes, sizeof(kElementSizes)) != 0)
+    {
+        log::info("Scene cache has an old format, rebuilding: %s", cachePath.string().c_str());
+        Close();
+        return false;
+    }
+    if (header.key != key)
+    {
+        log::info("Scene sources changed, rebuilding cache: %s", cachePath.string().c_str());
+        Close();
+        return false;
+    }
+
+    // Bounds-check everything before handing out views
+    auto fits = [&](uint64_t offset, uint64_t count, uint64_t elementSize)
+    {
+        return offset % kSectionAlignment == 0 && offset <= fileSize &&
+               count <= (fileSize - offset) / elementSize;
+    };
+
+    uint64_t tableEnd = sizeof(CacheHeader) + uint64_t(header.textureCount) * sizeof(CacheTextureEntry);
+    bool valid = tableEnd <= fileSize;
+    for (uint32_t s = 0; valid && s < SectionCount; s++)
+    {
+        valid = fits(header.sections[s].offset, header.sections[s].count, kElementSizes[s]);
+    }
+
+    std::vector<CacheTextureEntry> textureEntries(valid ? header.textureCount : 0);
+    if (valid && !textureEntries.empty())
+    {
+        memcpy(textureEntries.data(), base + sizeof(CacheHeader), textureEntries.size() * sizeof(CacheTextureEntry));
+    }
+    for (const CacheTextureEntry& entry : textureEntries)
+    {
+        valid = valid && entry.width >= 0 && entry.height >= 0 &&
+                fits(entry.offset, uint64_t(entry.width) * uint64_t(entry.height) * 4, sizeof(float));
+    }
+
+    if (!valid)
+    {
+        log::warning("Scene cache is corrupt, ignoring: %s", cachePath.string().c_str());
+        Close();
+        return false;
+    }
+
+    m_Scene.positions = SectionView<GPUPosition>(base, header.sections[Positions]);
+    m_Scene.vertices = SectionView<GPUVertex>(base, header.sections[Vertices]);
+    m_Scene.indices = SectionView<uint32_t>(base, header.sections[Indices]);
+    m_Scene.materials = SectionView<GPUMaterial>(base, header.sections[Materials]);
+    m_Scene.instances = SectionView<GPUInstance>(base, header.sections[Instances]);
+    m_Scene.meshes = SectionView<MeshRange>(base, header.sections[Meshes]);
+    m_Scene.placements = SectionView<InstancePlacement>(base, header.sections[Placements]);
+    m_Scene.analyticShapes = SectionView<AnalyticShape>(base, header.sections[AnalyticShapes]);
+
+    // Placements index meshes directly when building TLAS instances, and
+    // BLAS builds and shaders trust the mesh ranges
+    if (!m_Scene.Verify())
+    {
+        log::warning("Scene cache is corrupt, ignoring: %s", cachePath.string().c_str());
+        Close();
+        return false;
+    }
+
+    m_Scene.textures.resize(textureEntries.size());
+    for (size_t i = 0; i < textureEntries.size(); i++)
+    {
+        const CacheTextureEntry& entry = textureEntries[i];
+        size_t floatCount = size_t(entry.width) * size_t(entry.height) * 4;
+        m_Scene.textures[i] = { entry.width, entry.height,
+                                { reinterpret_cast<const float*>(base + entry.offset), floatCount } };
+    }
+
+    return true;
+}
+
+void SceneCache::Close()
+{
+    m_File.Close();
+    m_Scene = {};
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+// ============================================================================
+// Scene Cache
+// Versioned binary snapshot of a loaded scene: the packed GPU arrays, mesh
+// ranges, placements, analytic shapes and decoded material textures.
+// Written next to the scene after a cold load and memory-mapped on the next
+// launch, where the arrays are used in place - no OBJ parsing, vertex dedup
+// or image decode.
+// ============================================================================
+
+#include "scene_geometry.h"
+#include "../common/mapped_file.h"
+
+#include <filesystem>
+#include <span>
+#include <vector>
+#include <cstdint>
+
+// Read-only view of everything the renderer uploads. Backed either by a
+// live SceneGeometry + parser or by a mapped cache file; the spans stay
+// valid as long as that owner does.
+struct PackedScene
+{
+    struct Texture
+    {
+        int width = 0;                  // 0 = not available, bind a default
+        int height = 0;
+        std::span<const float> rgba;    // width * height * 4 floats
+    };
+
+    std::span<const GPUPosition> positions;
+    std::span<const GPUVertex> vertices;        // Attributes, parallel to positions
+    std::span<const uint32_t> indices;
+    std::span<const GPUMaterial> materials;
+    std::span<const GPUInstance> instances;
+    std::span<const MeshRange> meshes;
+    std::span<const InstancePlacement> placements;
+    std::span<const AnalyticShape> analyticShapes;
+    std::vector<Texture> textures;      // Indexed like MitsubaSceneParser::textures
+
+    // View over freshly loaded data; textures that were not decoded stay empty
+    static PackedScene FromGeometry(const SceneGeometry& geometry, const MitsubaSceneParser& scene);
+
+    // Check that every mesh range lies inside the arrays, every index is
+    // below its mesh's vertex count and every instance points at the ranges
+    // of its mesh, so no BLAS build or shader read leaves its instance's
+    // vertices; analytic shapes need a known type and material. Logs the
+    // first problem found.
+    bool Verify() const;
+};
+
+class SceneCache
+{
+public:
+    // Hash of the scene XML, every file it references (path, size and
+    // modification time), the $name parameters and the settings of `loader`
+    // that change what Load() produces. Any edit invalidates the cache.
+    static uint64_t ComputeKey(const MitsubaSceneParser& scene, const std::filesystem::path& xmlPath,
+                               const SceneGeometry& loader);
+
+    static std::filesystem::path PathFor(const std::filesystem::path& xmlPath);
+
+    // Write `packed` under `key`. Goes through a temporary file and a rename
+    // so an interrupted write never leaves a truncated cache behind.
+    static bool Write(const std::filesystem::path& cachePath, uint64_t key, const PackedScene& packed);
+
+    // Map a cache file and validate its header against `key` and the
+    // current struct layouts. Returns false (quietly for a plain miss)
+    // if it cannot be used.
+    bool Open(const std::filesystem::path& cachePath, uint64_t key);
+    void Close();
+
+    bool IsOpen() const { return m_File.IsValid(); }
+    const PackedScene& Scene() const { return m_Scene; }
+    size_t FileSize() const { return m_File.Size(); }
+
+private:
+    MappedFile m_File;
+    PackedScene m_Scene;
+};
@@ -0,0 +1,1188 @@
+#include "scene_geometry.h"
+#include "obj_reader.h"
+#include "obj_parser.h"
+#include "vertex_dedup.h"
+#include "ply_reader.h"
+#include "serialized_reader.h"
+#include "vertex_transform.h"
+#include "vertex_format.h"
+#include "vertex_cache.h"
+#include "../common/parallel.h"
+#include "../common/parse_utils.h"
+
+#include <donut/core/log.h>
+
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+using namespace donut;
+
+GPUMaterial PackMaterial(const MitsubaSceneParser::Material& mat)
+{
+    GPUMaterial gpuMat = {};  // Zero-initialize
+    gpuMat.baseColor[0] = mat.baseColor.X;
+    gpuMat.baseColor[1] = mat.baseColor.Y;
+    gpuMat.baseColor[2] = mat.baseColor.Z;
+    gpuMat.roughness = mat.roughness;
+    gpuMat.eta[0] = mat.eta.X;
+    gpuMat.eta[1] = mat.eta.Y;
+    gpuMat.eta[2] = mat.eta.Z;
+    gpuMat.k[0] = mat.k.X;
+    gpuMat.k[1] = mat.k.Y;
+    gpuMat.k[2] = mat.k.Z;
+    gpuMat.type = static_cast<uint32_t>(mat.type);
+    gpuMat.intIOR = mat.intIOR;
+    gpuMat.extIOR = mat.extIOR;
+    gpuMat.metallic = mat.metallic;
+    if (mat.type == MaterialType::Conductor || mat.type == MaterialType::RoughConductor)
+    {
+        gpuMat.metallic = 1.0f;
+    }
+    gpuMat.baseColorTexIdx = mat.baseColorTexture.textureIndex;
+    gpuMat.roughnessTexIdx = mat.roughnessTexture.textureIndex;
+    gpuMat.normalTexIdx = mat.normalTexture.textureIndex;
+    
+    // Principled BSDF parameters
+    gpuMat.specular = mat.specular;
+    gpuMat.specTint = mat.specTint;
+    gpuMat.sheen = mat.sheen;
+    gpuMat.sheenTint = mat.sheenTint;
+    gpuMat.clearcoat = mat.clearcoat;
+    gpuMat.clearcoatGloss = mat.clearcoatGloss;
+    gpuMat.specTrans = mat.specTrans;
+    
+    // Mask/Blend parameters
+    gpuMat.opacity = mat.opacity;
+    gpuMat.blendWeight = mat.blendWeight;
+    gpuMat.nonlinear = mat.nonlinear ? 1.0f : 0.0f;
+    gpuMat.padding = 0.0f;
+    return gpuMat;
+}
+
+// ============================================================================
+// Material Table
+// ============================================================================
+size_t MaterialTable::RecordHash::operator()(const GPUMaterial& material) const
+{
+    // FNV-1a over the raw record; GPUMaterial has no implicit padding
+    static_assert(sizeof(GPUMaterial) % sizeof(uint32_t) == 0, "GPUMaterial must be tightly packed");
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&material);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < sizeof(GPUMaterial); i++)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+bool MaterialTable::RecordEqual::operator()(const GPUMaterial& a, const GPUMaterial& b) const
+{
+    return memcmp(&a, &b, sizeof(GPUMaterial)) == 0;
+}
+
+void MaterialTable::Clear()
+{
+    m_Materials.clear();
+    m_RecordIndices.clear();
+    m_NamedIndices.clear();
+    m_InternRequests = 0;
+}
+
+uint32_t MaterialTable::Intern(const GPUMaterial& material)
+{
+    m_InternRequests++;
+    auto [it, isNew] = m_RecordIndices.try_emplace(material, static_cast<uint32_t>(m_Materials.size()));
+    if (isNew)
+    {
+        m_Materials.push_back(material);
+    }
+    return it->second;
+}
+
+uint32_t MaterialTable::AddNamed(std::string_view id, const GPUMaterial& material)
+{
+    uint32_t index = Intern(material);
+    m_NamedIndices[id] = index;
+    return index;
+}
+
+int32_t MaterialTable::Find(std::string_view id) const
+{
+    auto it = m_NamedIndices.find(id);
+    return it != m_NamedIndices.end() ? static_cast<int32_t>(it->second) : -1;
+}
+
+// ============================================================================
+// Scene Geometry
+// ============================================================================
+bool SceneGeometry::Load(const MitsubaSceneParser& scene)
+{
+    positions.clear();
+    vertices.clear();
+    indices.clear();
+    meshes.clear();
+    m_LocalMeshes.clear();
+    m_LoadedLocal = keepShapesLocal;
+
+    PlaceShapes(scene);
+
+    log::info("Loaded %zu vertices, %zu indices, %zu materials, %zu meshes, %zu instances",
+        vertices.size(), indices.size(), materials.size(), meshes.size(), instances.size());
+    if (m_MaterialTable.InternRequests() > materials.size())
+    {
+        log::info("Material table: %zu unique records for %zu materials",
+            materials.size(), m_MaterialTable.InternRequests());
+    }
+    if (m_LoadedLocal)
+    {
+        log::info("Kept %zu meshes in local space for reloading", m_LocalMeshes.size());
+    }
+    else if (!m_LocalMeshes.empty())
+    {
+        log::info("Instanced %zu mesh files referenced by multiple shapes", m_LocalMeshes.size());
+    }
+    if (!analyticShapes.empty())
+    {
+        log::info("Kept %zu analytic shapes for exact intersection", analyticShapes.size());
+    }
+
+    size_t storedBytes = GeometryByteSize();
+    size_t flattenedBytes = FlattenedGeometryByteSize();
+    if (flattenedBytes > storedBytes)
+    {
+        log::info("Instancing: %.2f MB of geometry instead of %.2f MB flattened (saved %.2f MB)",
+            storedBytes / (1024.0 * 1024.0), flattenedBytes / (1024.0 * 1024.0),
+            (flattenedBytes - storedBytes) / (1024.0 * 1024.0));
+    }
+
+    return !vertices.empty() || !analyticShapes.empty();
+}
+
+void SceneGeometry::PlaceShapes(const MitsubaSceneParser& scene)
+{
+    materials.clear();
+    instances.clear();
+    placements.clear();
+    analyticShapes.clear();
+    m_MaterialTable.Clear();
+
+    // Create materials from parsed scene, in document order so indices are stable
+    for (std::string_view id : scene.materialOrder)
+    {
+        m_MaterialTable.AddNamed(id, PackMaterial(scene.materials.at(id)));
+    }
+
+    // Shape group members are loaded once, on first use, in group space
+    struct GroupMember
+    {
+        uint32_t meshIndex;
+        uint32_t materialIndex;
+        const MitsubaSceneParser::Shape* shape;
+    };
+    std::unordered_map<std::string_view, std::vector<GroupMember>> loadedGroups;
+
+    // Mesh files referenced by more than one standalone shape are loaded
+    // once in local space and placed with each shape's transform
+    std::unordered_map<std::string, uint32_t> fileUseCount;
+    for (auto& shape : scene.shapes)
+    {
+        if (IsFileShape(shape))
+        {
+            fileUseCount[LocalMeshKey(shape)]++;
+        }
+    }
+
+    const HMM_Mat4 identity = HMM_M4D(1.0f);
+
+    // Process each shape
+    for (auto& shape : scene.shapes)
+    {
+        if (shape.type == "instance")
+        {
+            auto groupIt = scene.shapeGroups.find(shape.groupRef);
+            if (groupIt == scene.shapeGroups.end())
+            {
+                log::warning("Instance references unknown shape group '%.*s'",
+                    static_cast<int>(shape.groupRef.size()), shape.groupRef.data());
+                continue;
+            }
+
+            if (m_LoadedLocal)
+            {
+                // Members share the per-file local meshes; the group transform
+                // is folded into each placement
+                for (auto& member : groupIt->second.shapes)
+                {
+                    HMM_Mat4 toWorld = HMM_MulM4(shape.transform, ShapeTransform(member));
+                    if (KeepAnalytic(member, toWorld))
+                    {
+                        continue;
+                    }
+                    int32_t meshIndex = LocalShapeMesh(scene, member, toWorld);
+                    if (meshIndex >= 0)
+                    {
+                        AddInstance(uint32_t(meshIndex), ResolveMaterial(member), member, toWorld);
+                    }
+                }
+                continue;
+            }
+
+            // Analytic members the renderer intersects itself are placed per
+            // instance; the others are tessellated once, for the first instance
+            auto [loadedIt, isNew] = loadedGroups.try_emplace(shape.groupRef);
+            for (auto& member : groupIt->second.shapes)
+            {
+                HMM_Mat4 toWorld = HMM_MulM4(shape.transform, ShapeTransform(member));
+                if (KeepAnalytic(member, toWorld) || !isNew)
+                {
+                    continue;
+                }
+                int32_t meshIndex = RequestShapeMesh(scene, member, ShapeTransform(member), toWorld);
+                if (meshIndex >= 0)
+                {
+                    loadedIt->second.push_back({ uint32_t(meshIndex), ResolveMaterial(member), &member });
+                }
+            }
+
+            for (const GroupMember& member : loadedIt->second)
+            {
+                AddInstance(member.meshIndex, member.materialIndex, *member.shape, shape.transform);
+            }
+        }
+        else if (KeepAnalytic(shape, ShapeTransform(shape)))
+        {
+            continue;
+        }
+        else if (m_LoadedLocal || (IsFileShape(shape) && fileUseCount[LocalMeshKey(shape)] > 1))
+        {
+            HMM_Mat4 toWorld = ShapeTransform(shape);
+            int32_t meshIndex = LocalShapeMesh(scene, shape, toWorld);
+            if (meshIndex >= 0)
+            {
+                AddInstance(uint32_t(meshIndex), ResolveMaterial(shape), shape, toWorld);
+            }
+        }
+        else
+        {
+            // Standalone shapes are baked into world space
+            HMM_Mat4 toWorld = ShapeTransform(shape);
+            int32_t meshIndex = RequestShapeMesh(scene, shape, toWorld, toWorld);
+            if (meshIndex >= 0)
+            {
+                AddInstance(uint32_t(meshIndex), ResolveMaterial(shape), shape, identity);
+            }
+        }
+    }
+
+    LoadPendingMeshes();
+    materials = m_MaterialTable.Materials();
+}
+
+std::string SceneGeometry::LocalMeshKey(const MitsubaSceneParser::Shape& shape, uint32_t segments)
+{
+    // Rectangles are all the same unit quad, analytic shapes the same at
+    // equal tessellation; '<' cannot appear in a filename
+    if (shape.type == "rectangle")
+    {
+        return "<rectangle>";
+    }
+    AnalyticType type;
+    if (AnalyticTypeOf(shape, type))
+    {
+        return "<" + std::string(shape.type) + " " + std::to_string(segments) + ">";
+    }
+    std::string key(shape.filename);
+    if (shape.type == "serialized")
+    {
+        key += "<" + std::to_string(shape.shapeIndex) + ">";
+    }
+    return key;
+}
+
+std::string_view SceneGeometry::LocalMeshFile(std::string_view key, uint32_t& shapeIndex)
+{
+    size_t open = key.find('<');
+    shapeIndex = 0;
+    if (open != std::string_view::npos)
+    {
+        std::string_view digits = key.substr(open + 1);
+        parse_utils::NextNumber(digits, shapeIndex);
+    }
+    return key.substr(0, open);
+}
+
+int32_t SceneGeometry::LocalShapeMesh(const MitsubaSceneParser& scene, const MitsubaSceneParser::Shape& shape,
+                                      const HMM_Mat4& toWorld)
+{
+    AnalyticType type;
+    uint32_t segments = AnalyticTypeOf(shape, type) ? AnalyticSegments(scene.camera, type, toWorld) : 0;
+    auto [it, isNew] = m_LocalMeshes.try_emplace(LocalMeshKey(shape, segments), -1);
+    if (isNew)
+    {
+        it->second = RequestShapeMesh(scene, shape, HMM_M4D(1.0f), toWorld);
+    }
+    return it->second;
+}
+
+// ============================================================================
+// Hot Reload
+// ============================================================================
+void SceneDelta::Range::Include(uint32_t first, uint32_t length)
+{
+    if (length == 0)
+    {
+        return;
+    }
+    if (count == 0)
+    {
+        offset = first;
+        count = length;
+        return;
+    }
+    uint32_t end = std::max(offset + count, first + length);
+    offset = std::min(offset, first);
+    count = end - offset;
+}
+
+bool SceneGeometry::Reload(const MitsubaSceneParser& scene, const std::vector<std::filesystem::path>& changedFiles,
+                           SceneDelta& delta)
+{
+    delta = {};
+    if (!m_LoadedLocal)
+    {
+        log::warning("SceneGeometry::Reload requires a Load() with keepShapesLocal");
+        return false;
+    }
+
+    auto isChanged = [&](std::string_view filename)
+    {
+        return std::find(changedFiles.begin(), changedFiles.end(), scene.sceneDirectory / filename) != changedFiles.end();
+    };
+
+    // Re-read changed meshes; files that failed before get another try
+    // through LocalShapeMesh() below
+    for (auto it = m_LocalMeshes.begin(); it != m_LocalMeshes.end();)
+    {
+        uint32_t shapeIndex = 0;
+        std::string_view file = LocalMeshFile(it->first, shapeIndex);
+        if (!file.empty() && isChanged(file))
+        {
+            if (it->second < 0)
+            {
+                it = m_LocalMeshes.erase(it);
+                continue;
+            }
+            ReplaceFileMesh(uint32_t(it->second), scene.sceneDirectory / file, shapeIndex, delta);
+        }
+        ++it;
+    }
+
+    std::vector<GPUMaterial> oldMaterials = std::move(materials);
+    std::vector<GPUInstance> oldInstances = std::move(instances);
+    std::vector<InstancePlacement> oldPlacements = std::move(placements);
+    std::vector<AnalyticShape> oldAnalyticShapes = std::move(analyticShapes);
+
+    // Shapes of files that were not referenced before are appended
+    delta.firstNewMesh = static_cast<uint32_t>(meshes.size());
+    uint32_t vertexEnd = static_cast<uint32_t>(vertices.size());
+    uint32_t indexEnd = static_cast<uint32_t>(indices.size());
+
+    PlaceShapes(scene);
+
+    if (vertices.size() > vertexEnd)
+    {
+        delta.vertexRanges.push_back({ vertexEnd, static_cast<uint32_t>(vertices.size()) - vertexEnd });
+        delta.indexRanges.push_back({ indexEnd, static_cast<uint32_t>(indices.size()) - indexEnd });
+    }
+
+    // Diff the rebuilt records against the previous ones
+    if (materials.size() != oldMaterials.size())
+    {
+        delta.materialsResized = true;
+    }
+    else
+    {
+        for (size_t i = 0; i < materials.size(); i++)
+        {
+            if (memcmp(&materials[i], &oldMaterials[i], sizeof(GPUMaterial)) != 0)
+            {
+                delta.materialRange.Include(uint32_t(i), 1);
+            }
+        }
+    }
+
+    if (instances.size() != oldInstances.size())
+    {
+        delta.instancesResized = true;
+        delta.placementsChanged = true;
+    }
+    else
+    {
+        for (size_t i = 0; i < instances.size(); i++)
+        {
+            if (memcmp(&instances[i], &oldInstances[i], sizeof(GPUInstance)) != 0)
+            {
+                delta.instanceRange.Include(uint32_t(i), 1);
+            }
+            if (placements[i].meshIndex != oldPlacements[i].meshIndex ||
+                memcmp(&placements[i].transform, &oldPlacements[i].transform, sizeof(HMM_Mat4)) != 0)
+            {
+                delta.placementsChanged = true;
+            }
+        }
+    }
+
+    delta.analyticShapesChanged = analyticShapes.size() != oldAnalyticShapes.size() ||
+        (!analyticShapes.empty() &&
+         memcmp(analyticShapes.data(), oldAnalyticShapes.data(), analyticShapes.size() * sizeof(AnalyticShape)) != 0);
+
+    return true;
+}
+
+bool SceneGeometry::ReplaceFileMesh(uint32_t meshIndex, const std::filesystem::path& path, uint32_t shapeIndex,
+                                    SceneDelta& delta)
+{
+    MeshData fresh;
+    if (!BuildFileMesh(path, shapeIndex, HMM_M4D(1.0f), loadThreads, fresh))
+    {
+        log::warning("Keeping the previous version of %s", path.string().c_str());
+        return false;
+    }
+    if (optimizeVertexCache)
+    {
+        OptimizeMesh(fresh);
+    }
+
+    // Reuse the old range when the new mesh fits; otherwise append it and
+    // leave the old range unused until the next full Load()
+    MeshRange range = meshes[meshIndex];
+    uint32_t vertexCount = static_cast<uint32_t>(fresh.vertices.size());
+    uint32_t indexCount = static_cast<uint32_t>(fresh.indices.size());
+    if (vertexCount > range.vertexCount || indexCount > range.indexCount)
+    {
+        range.vertexOffset = static_cast<uint32_t>(vertices.size());
+        range.indexOffset = static_cast<uint32_t>(indices.size());
+        positions.resize(positions.size() + vertexCount);
+        vertices.resize(vertices.size() + vertexCount);
+        indices.resize(indices.size() + indexCount);
+    }
+    range.vertexCount = vertexCount;
+    range.indexCount = indexCount;
+    StoreMesh(fresh, range);
+
+    meshes[meshIndex] = range;
+    delta.rebuiltMeshes.push_back(meshIndex);
+    delta.vertexRanges.push_back({ range.vertexOffset, range.vertexCount });
+    delta.indexRanges.push_back({ range.indexOffset, range.indexCount });
+    return true;
+}
+
+std::vector<int> SceneGeometry::UsedTextureIndices() const
+{
+    std::vector<int> used;
+    auto addMaterial = [&](uint32_t materialIndex)
+    {
+        const GPUMaterial& mat = materials[materialIndex];
+        for (int32_t index : { mat.baseColorTexIdx, mat.roughnessTexIdx, mat.normalTexIdx })
+        {
+            if (index >= 0)
+            {
+                used.push_back(index);
+            }
+        }
+    };
+    for (const GPUInstance& instance : instances)
+    {
+        addMaterial(instance.materialIndex);
+    }
+    for (const AnalyticShape& shape : analyticShapes)
+    {
+        addMaterial(shape.materialIndex);
+    }
+    std::sort(used.begin(), used.end());
+    used.erase(std::unique(used.begin(), used.end()), used.end());
+    return used;
+}
+
+size_t SceneGeometry::GeometryByteSize() const
+{
+    return positions.size() * sizeof(GPUPosition) + vertices.size() * sizeof(GPUVertex) +
+           indices.size() * sizeof(uint32_t);
+}
+
+size_t SceneGeometry::FlattenedGeometryByteSize() const
+{
+    size_t bytes = 0;
+    for (const InstancePlacement& placement : placements)
+    {
+        const MeshRange& mesh = meshes[placement.meshIndex];
+        bytes += mesh.vertexCount * (sizeof(GPUPosition) + sizeof(GPUVertex)) + mesh.indexCount * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+// ============================================================================
+// Mesh Ingest
+// Shapes only queue their meshes while PlaceShapes() walks the scene. The
+// queued meshes are then parsed, deduplicated, transformed and reordered
+// for the vertex cache concurrently, each into its own buffer, and
+// concatenated in request order - so the result does not depend on the
+// thread count.
+// ============================================================================
+int32_t SceneGeometry::RequestShapeMesh(const MitsubaSceneParser& scene, const MitsubaSceneParser::Shape& shape,
+                                        const HMM_Mat4& transform, const HMM_Mat4& toWorld)
+{
+    PendingMesh pending;
+    pending.transform = transform;
+    if (IsFileShape(shape))
+    {
+        pending.path = scene.sceneDirectory / shape.filename;
+        pending.shapeIndex = shape.shapeIndex;
+    }
+    else if (AnalyticTypeOf(shape, pending.analyticType))
+    {
+        pending.isAnalytic = true;
+        pending.segments = AnalyticSegments(scene.camera, pending.analyticType, toWorld);
+    }
+    else if (shape.type != "rectangle")
+    {
+        return -1;
+    }
+
+    // Provisional index, assuming every queued mesh loads
+    m_PendingMeshes.push_back(std::move(pending));
+    return static_cast<int32_t>(meshes.size() + m_PendingMeshes.size() - 1);
+}
+
+void SceneGeometry::LoadPendingMeshes()
+{
+    const size_t pendingCount = m_PendingMeshes.size();
+    const uint32_t firstPending = static_cast<uint32_t>(meshes.size());
+
+    std::vector<MeshData> loaded(pendingCount);
+    std::vector<uint8_t> succeeded(pendingCount, 0);
+    auto build = [&](size_t i, unsigned parseThreads)
+    {
+        const PendingMesh& pending = m_PendingMeshes[i];
+        bool ok = false;
+        if (pending.isAnalytic)
+        {
+            ok = BuildAnalyticMesh(pending.analyticType, pending.segments, pending.transform, loaded[i]);
+        }
+        else
+        {
+            ok = pending.path.empty()
+                ? BuildRectangleMesh(pending.transform, loaded[i])
+                : BuildFileMesh(pending.path, pending.shapeIndex, pending.transform, parseThreads, loaded[i]);
+        }
+        if (ok && optimizeVertexCache)
+        {
+            OptimizeMesh(loaded[i]);
+        }
+        succeeded[i] = ok ? 1 : 0;
+    };
+
+    // OBJs big enough for the chunked parser go first, one at a time with
+    // all loadThreads each; inside the per-mesh workers every one of them
+    // would start loadThreads more threads
+    std::vector<uint8_t> chunked(pendingCount, 0);
+    for (size_t i = 0; i < pendingCount; i++)
+    {
+        if (!m_PendingMeshes[i].isAnalytic && IsChunkedOBJ(m_PendingMeshes[i].path))
+        {
+            chunked[i] = 1;
+            build(i, loadThreads);
+        }
+    }
+    parallel::ForEach(pendingCount, loadThreads, [&](size_t i)
+    {
+        if (!chunked[i])
+        {
+            build(i, 1);
+        }
+    });
+
+    // Prefix sum over the meshes that loaded assigns their final index and
+    // their vertex/index offsets
+    std::vector<int32_t> finalIndex(pendingCount, -1);
+    size_t vertexEnd = vertices.size();
+    size_t indexEnd = indices.size();
+    for (size_t i = 0; i < pendingCount; i++)
+    {
+        if (!succeeded[i])
+        {
+            continue;
+        }
+        MeshRange mesh;
+        mesh.vertexOffset = static_cast<uint32_t>(vertexEnd);
+        mesh.vertexCount = static_cast<uint32_t>(loaded[i].vertices.size());
+        mesh.indexOffset = static_cast<uint32_t>(indexEnd);
+        mesh.indexCount = static_cast<uint32_t>(loaded[i].indices.size());
+        vertexEnd += mesh.vertexCount;
+        indexEnd += mesh.indexCount;
+
+        finalIndex[i] = static_cast<int32_t>(meshes.size());
+        meshes.push_back(mesh);
+    }
+
+    positions.resize(vertexEnd);
+    vertices.resize(vertexEnd);
+    indices.resize(indexEnd);
+    parallel::ForEach(pendingCount, loadThreads, [&](size_t i)
+    {
+        if (finalIndex[i] >= 0)
+        {
+            StoreMesh(loaded[i], meshes[finalIndex[i]]);
+        }
+        loaded[i] = {};
+    });
+
+    // Point provisional indices at the final meshes; instances of meshes
+    // that failed to load are dropped
+    auto resolve = [&](uint32_t meshIndex)
+    {
+        return meshIndex < firstPending ? static_cast<int32_t>(meshIndex) : finalIndex[meshIndex - firstPending];
+    };
+    size_t kept = 0;
+    for (size_t i = 0; i < placements.size(); i++)
+    {
+        int32_t meshIndex = resolve(placements[i].meshIndex);
+        if (meshIndex < 0)
+        {
+            continue;
+        }
+        const MeshRange& mesh = meshes[meshIndex];
+        instances[kept] = instances[i];
+        instances[kept].vertexOffset = mesh.vertexOffset;
+        instances[kept].indexOffset = mesh.indexOffset;
+        placements[kept] = placements[i];
+        placements[kept].meshIndex = static_cast<uint32_t>(meshIndex);
+        kept++;
+    }
+    instances.resize(kept);
+    placements.resize(kept);
+
+    for (auto& [file, meshIndex] : m_LocalMeshes)
+    {
+        if (meshIndex >= static_cast<int32_t>(firstPending))
+        {
+            meshIndex = resolve(static_cast<uint32_t>(meshIndex));
+        }
+    }
+    m_PendingMeshes.clear();
+}
+
+void SceneGeometry::OptimizeMesh(MeshData& mesh)
+{
+    OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+    std::vector<uint32_t> remap = OptimizeVertexFetch(mesh.indices, mesh.vertices.size());
+    RemapVertices(mesh.vertices, remap);
+}
+
+void SceneGeometry::StoreMesh(const MeshData& data, const MeshRange& range)
+{
+    for (size_t i = 0; i < data.vertices.size(); i++)
+    {
+        PackVertex(data.vertices[i], positions[range.vertexOffset + i], vertices[range.vertexOffset + i]);
+    }
+    std::copy(data.indices.begin(), data.indices.end(), indices.begin() + range.indexOffset);
+}
+
+uint32_t SceneGeometry::ResolveMaterial(const MitsubaSceneParser::Shape& shape)
+{
+    // Shapes without a (known) material fall back to the first one
+    uint32_t matIndex = 0;
+    if (!shape.materialRef.empty())
+    {
+        int32_t found = m_MaterialTable.Find(shape.materialRef);
+        if (found >= 0)
+        {
+            matIndex = static_cast<uint32_t>(found);
+        }
+    }
+    else if (shape.hasInlineMaterial)
+    {
+        // Inline materials identical to an existing record reuse it
+        matIndex = m_MaterialTable.Intern(PackMaterial(shape.inlineMaterial));
+    }
+    return matIndex;
+}
+
+void SceneGeometry::AddInstance(uint32_t meshIndex, uint32_t materialIndex,
+                                const MitsubaSceneParser::Shape& shape, const HMM_Mat4& transform)
+{
+    // Offsets are filled in by LoadPendingMeshes() once mesh ranges are final
+    GPUInstance instance;
+    instance.vertexOffset = 0;
+    instance.indexOffset = 0;
+    instance.materialIndex = materialIndex;
+    instance.isEmitter = shape.isEmitter ? 1 : 0;
+    instance.emission[0] = shape.emission.X;
+    instance.emission[1] = shape.emission.Y;
+    instance.emission[2] = shape.emission.Z;
+    instance.pad = 0.0f;
+    instances.push_back(instance);
+
+    placements.push_back({ meshIndex, {}, transform });
+}
+
+bool SceneGeometry::IsFileShape(const MitsubaSceneParser::Shape& shape)
+{
+    return shape.type == "obj" || shape.type == "ply" || shape.type == "serialized";
+}
+
+std::string SceneGeometry::MeshFileExtension(const std::filesystem::path& path)
+{
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension;
+}
+
+bool SceneGeometry::IsChunkedOBJ(const std::filesystem::path& path) const
+{
+    if (path.empty())
+    {
+        return false;
+    }
+    const std::string extension = MeshFileExtension(path);
+    if (extension == ".ply" || extension == ".serialized")
+    {
+        return false;
+    }
+    std::error_code ec;
+    uintmax_t fileSize = std::filesystem::file_size(path, ec);
+    return !ec && fileSize >= chunkedOBJBytes;
+}
+
+bool SceneGeometry::BuildFileMesh(const std::filesystem::path& path, uint32_t shapeIndex, const HMM_Mat4& transform,
+                                  unsigned parseThreads, MeshData& mesh) const
+{
+    // Local mesh keys hold no shape type, so the extension decides here
+    const std::string extension = MeshFileExtension(path);
+    if (extension == ".ply")
+    {
+        return BuildPLYMesh(path, transform, mesh);
+    }
+    if (extension == ".serialized")
+    {
+        return BuildSerializedMesh(path, shapeIndex, transform, mesh);
+    }
+    return BuildOBJMesh(path, transform, parseThreads, mesh);
+}
+
+// Local-space vertex, transformed later by TransformVertices(). A missing
+// normal is left zero (TransformVertices() turns it into +Y) and a missing
+// texcoord becomes (0, 0).
+static MeshVertex LocalVertex(const float* position, const float* normal, const float* texcoord)
+{
+    MeshVertex vertex = {};
+    vertex.position[0] = position[0];
+    vertex.position[1] = position[1];
+    vertex.position[2] = position[2];
+    if (normal)
+    {
+        vertex.normal[0] = normal[0];
+        vertex.normal[1] = normal[1];
+        vertex.normal[2] = normal[2];
+    }
+    if (texcoord)
+    {
+        vertex.texcoord[0] = texcoord[0];
+        vertex.texcoord[1] = texcoord[1];
+    }
+    return vertex;
+}
+
+bool SceneGeometry::BuildOBJMesh(const std::filesystem::path& objPath, const HMM_Mat4& transform, unsigned parseThreads,
+                                 MeshData& mesh) const
+{
+    if (IsChunkedOBJ(objPath))
+    {
+        OBJAttributes attributes;
+        if (!ParseOBJChunked(objPath, parseThreads, attributes))
+        {
+            log::warning("Failed to load OBJ: %s", objPath.string().c_str());
+            return false;
+        }
+        BuildMeshFromOBJ(OBJMeshView::FromAttributes(attributes), transform, mesh);
+    }
+    else
+    {
+        tinyobj_attrib_t attrib;
+        tinyobj_shape_t* shapes = nullptr;
+        size_t numShapes = 0;
+        tinyobj_material_t* objMaterials = nullptr;
+        size_t numMaterials = 0;
+
+        // Keeps the mapped OBJ alive until parsing is done
+        OBJReaderContext reader;
+        int ret = tinyobj_parse_obj(&attrib, &shapes, &numShapes, &objMaterials, &numMaterials,
+            objPath.string().c_str(), FileReaderCallback, &reader, TINYOBJ_FLAG_TRIANGULATE);
+
+        if (ret != TINYOBJ_SUCCESS)
+        {
+            log::warning("Failed to load OBJ: %s", objPath.string().c_str());
+            return false;
+        }
+
+        BuildMeshFromOBJ(OBJMeshView::FromTinyObj(attrib), transform, mesh);
+
+        tinyobj_attrib_free(&attrib);
+        tinyobj_shapes_free(shapes, numShapes);
+        tinyobj_materials_free(objMaterials, numMaterials);
+    }
+
+    if (mesh.indices.empty())
+    {
+        log::warning("OBJ has no faces: %s", objPath.string().c_str());
+        return false;
+    }
+    return true;
+}
+
+// Deduplicate corners into vertices and bake `transform` in
+void SceneGeometry::BuildMeshFromOBJ(const OBJMeshView& obj, const HMM_Mat4& transform, MeshData& mesh)
+{
+    size_t attributeCount = std::max({ obj.positions.size() / 3, obj.normals.size() / 3, obj.texcoords.size() / 2 });
+    VertexDedup dedup;
+    dedup.Build(obj.corners, attributeCount);
+
+    // Gather the attributes, then transform them as one batch
+    mesh.vertices.resize(dedup.VertexCount());
+    for (size_t i = 0; i < dedup.VertexCount(); i++)
+    {
+        const tinyobj_vertex_index_t& idx = obj.corners[dedup.firstCorner[i]];
+        const float* normal = idx.vn_idx >= 0 && !obj.normals.empty() ? &obj.normals[3 * idx.vn_idx] : nullptr;
+        const float* texcoord = idx.vt_idx >= 0 && !obj.texcoords.empty() ? &obj.texcoords[2 * idx.vt_idx] : nullptr;
+        mesh.vertices[i] = LocalVertex(&obj.positions[3 * idx.v_idx], normal, texcoord);
+    }
+    TransformVertices(VertexTransform(transform), mesh.vertices);
+
+    mesh.indices = std::move(dedup.cornerVertex);
+}
+
+bool SceneGeometry::BuildPLYMesh(const std::filesystem::path& plyPath, const HMM_Mat4& transform, MeshData& mesh)
+{
+    PLYFile ply;
+    if (!ply.Open(plyPath))
+    {
+        log::warning("Failed to load PLY: %s", plyPath.string().c_str());
+        return false;
+    }
+
+    // PLY vertices are already unique; only the transform is applied
+    const PLYAttribute& positions = ply.Positions();
+    const PLYAttribute& normals = ply.Normals();
+    const PLYAttribute& texcoords = ply.Texcoords();
+    mesh.vertices.resize(ply.VertexCount());
+    for (size_t i = 0; i < ply.VertexCount(); i++)
+    {
+        float position[3];
+        float normal[3];
+        float texcoord[2];
+        positions.Read(i, position, 3);
+        if (normals)
+        {
+            normals.Read(i, normal, 3);
+        }
+        if (texcoords)
+        {
+            texcoords.Read(i, texcoord, 2);
+        }
+        mesh.vertices[i] = LocalVertex(position, normals ? normal : nullptr, texcoords ? texcoord : nullptr);
+    }
+    TransformVertices(VertexTransform(transform), mesh.vertices);
+    mesh.indices = std::move(ply.Indices());
+
+    if (mesh.indices.empty())
+    {
+        log::warning("PLY has no faces: %s", plyPath.string().c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SceneGeometry::BuildSerializedMesh(const std::filesystem::path& path, uint32_t shapeIndex,
+                                        const HMM_Mat4& transform, MeshData& mesh)
+{
+    // Each pending mesh maps the file on its own, so the meshes of one
+    // file inflate in parallel on the ingest workers
+    SerializedFile file;
+    SerializedMesh serialized;
+    if (!file.Open(path) || !file.ReadMesh(shapeIndex, serialized))
+    {
+        log::warning("Failed to load serialized mesh %u: %s", shapeIndex, path.string().c_str());
+        return false;
+    }
+
+    const bool hasNormals = !serialized.normals.empty();
+    const bool hasTexcoords = !serialized.texcoords.empty();
+    mesh.vertices.resize(serialized.VertexCount());
+    for (size_t i = 0; i < serialized.VertexCount(); i++)
+    {
+        mesh.vertices[i] = LocalVertex(&serialized.positions[3 * i],
+            hasNormals ? &serialized.normals[3 * i] : nullptr, hasTexcoords ? &serialized.texcoords[2 * i] : nullptr);
+    }
+    TransformVertices(VertexTransform(transform), mesh.vertices);
+    mesh.indices = std::move(serialized.indices);
+
+    if (mesh.indices.empty())
+    {
+        log::warning("Serialized mesh %u has no faces: %s", shapeIndex, path.string().c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SceneGeometry::BuildRectangleMesh(const HMM_Mat4& transform, MeshData& mesh)
+{
+    // Create a unit rectangle in XY plane, centered at origin
+    const float positions[4][3] = {
+        { -1.0f, -1.0f, 0.0f },
+        {  1.0f, -1.0f, 0.0f },
+        {  1.0f,  1.0f, 0.0f },
+        { -1.0f,  1.0f, 0.0f }
+    };
+
+    const float normal[3] = { 0.0f, 0.0f, 1.0f };
+    const float texcoords[4][2] = {
+        {0.0f, 0.0f},
+        {1.0f, 0.0f},
+        {1.0f, 1.0f},
+        {0.0f, 1.0f}
+    };
+
+    for (int i = 0; i < 4; i++)
+    {
+        mesh.vertices.push_back(LocalVertex(positions[i], normal, texcoords[i]));
+    }
+    TransformVertices(VertexTransform(transform), mesh.vertices);
+
+    // Add indices (two triangles)
+    mesh.indices = { 0, 1, 2, 0, 2, 3 };
+    return true;
+}
+
+// ============================================================================
+// Analytic Shapes
+// Mitsuba's sphere, disk, cylinder and cube, generated around their
+// canonical primitive. Curved shapes get `segments` edges per full turn,
+// picked from their projected size so distant shapes stay cheap.
+// ============================================================================
+bool SceneGeometry::AnalyticTypeOf(const MitsubaSceneParser::Shape& shape, AnalyticType& type)
+{
+    if (shape.type == "sphere")         type = AnalyticType::Sphere;
+    else if (shape.type == "disk")      type = AnalyticType::Disk;
+    else if (shape.type == "cylinder")  type = AnalyticType::Cylinder;
+    else if (shape.type == "cube")      type = AnalyticType::Cube;
+    else return false;
+    return true;
+}
+
+HMM_Mat4 SceneGeometry::ShapeTransform(const MitsubaSceneParser::Shape& shape)
+{
+    if (shape.type == "sphere")
+    {
+        return HMM_MulM4(shape.transform,
+            HMM_MulM4(HMM_Translate(shape.center), HMM_Scale(HMM_V3(shape.radius, shape.radius, shape.radius))));
+    }
+    if (shape.type == "cylinder")
+    {
+        // Any frame around the axis will do; the tessellation is symmetric
+        HMM_Vec3 axis = HMM_SubV3(shape.p1, shape.p0);
+        float length = HMM_LenV3(axis);
+        HMM_Vec3 z = length > 0.0f ? HMM_DivV3F(axis, length) : HMM_V3(0.0f, 0.0f, 1.0f);
+        HMM_Vec3 x = HMM_NormV3(HMM_Cross(fabsf(z.X) > 0.9f ? HMM_V3(0.0f, 1.0f, 0.0f) : HMM_V3(1.0f, 0.0f, 0.0f), z));
+        HMM_Vec3 y = HMM_Cross(z, x);
+
+        HMM_Mat4 frame;
+        frame.Columns[0] = HMM_V4V(HMM_MulV3F(x, shape.radius), 0.0f);
+        frame.Columns[1] = HMM_V4V(HMM_MulV3F(y, shape.radius), 0.0f);
+        frame.Columns[2] = HMM_V4V(HMM_MulV3F(z, length), 0.0f);
+        frame.Columns[3] = HMM_V4V(shape.p0, 1.0f);
+        return HMM_MulM4(shape.transform, frame);
+    }
+    return shape.transform;
+}
+
+uint32_t SceneGeometry::AnalyticSegments(const MitsubaSceneParser::Camera& camera, AnalyticType type,
+                                         const HMM_Mat4& toWorld) const
+{
+    const uint32_t minSegments = 8;
+    const uint32_t maxSegments = std::max(minSegments, maxAnalyticSegments);
+    if (type == AnalyticType::Cube)
+    {
+        return minSegments;
+    }
+
+    // Bounding sphere of the primitive, scaled by the longest axis
+    HMM_Vec3 localCenter = type == AnalyticType::Cylinder ? HMM_V3(0.0f, 0.0f, 0.5f) : HMM_V3(0.0f, 0.0f, 0.0f);
+    float localRadius = type == AnalyticType::Cylinder ? 1.118034f : 1.0f;
+    float scale = std::max({ HMM_LenV3(toWorld.Columns[0].XYZ), HMM_LenV3(toWorld.Columns[1].XYZ),
+                             HMM_LenV3(toWorld.Columns[2].XYZ) });
+    float radius = localRadius * scale;
+    HMM_Vec3 center = HMM_MulM4V4(toWorld, HMM_V4V(localCenter, 1.0f)).XYZ;
+
+    // Cameras inside the bound get the finest level
+    float distance = HMM_LenV3(HMM_SubV3(center, camera.transform.Columns[3].XYZ)) - radius;
+    if (distance <= 0.0f)
+    {
+        return maxSegments;
+    }
+
+    // Mitsuba's fov is horizontal by default
+    float halfWidth = distance * tanf(0.5f * camera.fov * (HMM_PI32 / 180.0f));
+    float pixelsPerUnit = 0.5f * float(camera.width) / std::max(halfWidth, 1e-6f);
+    float wanted = 2.0f * HMM_PI32 * radius * pixelsPerUnit / std::max(analyticEdgePixels, 0.01f);
+
+    uint32_t segments = minSegments;
+    while (float(segments) < wanted && segments < maxSegments)
+    {
+        segments *= 2;
+    }
+    return std::min(segments, maxSegments);
+}
+
+bool SceneGeometry::KeepAnalytic(const MitsubaSceneParser::Shape& shape, const HMM_Mat4& toWorld)
+{
+    AnalyticType type;
+    if (!AnalyticTypeOf(shape, type) || (analyticPrimitives & (1u << uint32_t(type))) == 0)
+    {
+        return false;
+    }
+
+    AnalyticShape analytic = {};
+    analytic.transform = toWorld;
+    analytic.type = type;
+    analytic.materialIndex = ResolveMaterial(shape);
+    analytic.isEmitter = shape.isEmitter ? 1 : 0;
+    analytic.emission[0] = shape.emission.X;
+    analytic.emission[1] = shape.emission.Y;
+    analytic.emission[2] = shape.emission.Z;
+    analyticShapes.push_back(analytic);
+    return true;
+}
+
+bool SceneGeometry::BuildAnalyticMesh(AnalyticType type, uint32_t segments, const HMM_Mat4& transform, MeshData& mesh)
+{
+    const float twoPi = 2.0f * HMM_PI32;
+    auto addVertex = [&](HMM_Vec3 position, HMM_Vec3 normal, float u, float v)
+    {
+        const float texcoord[2] = { u, v };
+        mesh.vertices.push_back(LocalVertex(position.Elements, normal.Elements, texcoord));
+    };
+
+    // Triangles wind counter-clockwise seen from outside, as rectangles do
+    switch (type)
+    {
+    case AnalyticType::Sphere:
+    {
+        // Mitsuba's parameterization: u = phi / 2pi, v = theta / pi from +Z
+        const uint32_t rings = segments / 2;
+        mesh.vertices.reserve(size_t(rings + 1) * (segments + 1));
+        for (uint32_t r = 0; r <= rings; r++)
+        {
+            float theta = HMM_PI32 * float(r) / float(rings);
+            for (uint32_t s = 0; s <= segments; s++)
+            {
+                float phi = twoPi * float(s) / float(segments);
+                HMM_Vec3 p = HMM_V3(sinf(theta) * cosf(phi), sinf(theta) * sinf(phi), cosf(theta));
+                addVertex(p, p, float(s) / float(segments), float(r) / float(rings));
+            }
+        }
+        // The first and last ring each lose their degenerate pole triangle
+        for (uint32_t r = 0; r < rings; r++)
+        {
+            for (uint32_t s = 0; s < segments; s++)
+            {
+                uint32_t a = r * (segments + 1) + s;
+                uint32_t b = a + 1;
+                uint32_t c = a + segments + 1;
+                uint32_t d = c + 1;
+                if (r != 0)
+                {
+                    mesh.indices.insert(mesh.indices.end(), { a, c, b });
+                }
+                if (r != rings - 1)
+                {
+                    mesh.indices.insert(mesh.indices.end(), { b, c, d });
+                }
+            }
+        }
+        break;
+    }
+    case AnalyticType::Disk:
+    {
+        // u = radius, v = phi / 2pi; the centre is split per segment so v
+        // stays continuous across each triangle
+        const HMM_Vec3 normal = HMM_V3(0.0f, 0.0f, 1.0f);
+        for (uint32_t s = 0; s < segments; s++)
+        {
+            addVertex(HMM_V3(0.0f, 0.0f, 0.0f), normal, 0.0f, (float(s) + 0.5f) / float(segments));
+        }
+        for (uint32_t s = 0; s <= segments; s++)
+        {
+            float phi = twoPi * float(s) / float(segments);
+            addVertex(HMM_V3(cosf(phi), sinf(phi), 0.0f), normal, 1.0f, float(s) / float(segments));
+        }
+        for (uint32_t s = 0; s < segments; s++)
+        {
+            mesh.indices.insert(mesh.indices.end(), { s, segments + s, segments + s + 1 });
+        }
+        break;
+    }
+    case AnalyticType::Cylinder:
+    {
+        // u = phi / 2pi, v = z
+        for (uint32_t end = 0; end < 2; end++)
+        {
+            for (uint32_t s = 0; s <= segments; s++)
+            {
+                float phi = twoPi * float(s) / float(segments);
+                HMM_Vec3 normal = HMM_V3(cosf(phi), sinf(phi), 0.0f);
+                addVertex(HMM_V3(normal.X, normal.Y, float(end)), normal, float(s) / float(segments), float(end));
+            }
+        }
+        for (uint32_t s = 0; s < segments; s++)
+        {
+            uint32_t a = s;
+            uint32_t b = s + 1;
+            uint32_t c = s + segments + 1;
+            uint32_t d = c + 1;
+            mesh.indices.insert(mesh.indices.end(), { a, b, c, b, d, c });
+        }
+        break;
+    }
+    case AnalyticType::Cube:
+    {
+        // One quad per face with its own normal; u x v = normal
+        const HMM_Vec3 faces[6][3] = {
+            { HMM_V3( 1, 0, 0), HMM_V3(0, 1, 0), HMM_V3(0, 0, 1) },
+            { HMM_V3(-1, 0, 0), HMM_V3(0, 0, 1), HMM_V3(0, 1, 0) },
+            { HMM_V3(0,  1, 0), HMM_V3(0, 0, 1), HMM_V3(1, 0, 0) },
+            { HMM_V3(0, -1, 0), HMM_V3(1, 0, 0), HMM_V3(0, 0, 1) },
+            { HMM_V3(0, 0,  1), HMM_V3(1, 0, 0), HMM_V3(0, 1, 0) },
+            { HMM_V3(0, 0, -1), HMM_V3(0, 1, 0), HMM_V3(1, 0, 0) },
+        };
+        const float corners[4][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+        for (uint32_t f = 0; f < 6; f++)
+        {
+            const HMM_Vec3& normal = faces[f][0];
+            for (const auto& corner : corners)
+            {
+                HMM_Vec3 p = HMM_AddV3(normal, HMM_AddV3(HMM_MulV3F(faces[f][1], 2.0f * corner[0] - 1.0f),
+                                                         HMM_MulV3F(faces[f][2], 2.0f * corner[1] - 1.0f)));
+                addVertex(p, normal, corner[0], corner[1]);
+            }
+            uint32_t base = 4 * f;
+            mesh.indices.insert(mesh.indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+        }
+        break;
+    }
+    }
+    TransformVertices(VertexTransform(transform), mesh.vertices);
+    return !mesh.indices.empty();
+}
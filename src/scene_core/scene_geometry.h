@@ -0,0 +1,367 @@
+#pragma once
+
+// ============================================================================
+// Scene Geometry
+// Turns a parsed Mitsuba scene into the packed vertex/index/material/instance
+// arrays consumed by the ray tracer. CPU only - uploading is up to the caller.
+// ============================================================================
+
+#include "mitsuba_parser.h"
+
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+struct OBJMeshView;
+
+// ============================================================================
+// GPU Structures (must match HLSL) - using plain floats for GPU compatibility
+// ============================================================================
+struct GPUMaterial
+{
+    float baseColor[3];
+    float roughness;
+    
+    float eta[3];          // For conductors: complex IOR real part
+    float metallic;
+    
+    float k[3];            // For conductors: complex IOR imaginary part
+    uint32_t type;
+    
+    float intIOR;          // Interior index of refraction
+    float extIOR;          // Exterior index of refraction
+    int32_t baseColorTexIdx;   // -1 if no texture
+    int32_t roughnessTexIdx;   // -1 if no texture
+    
+    int32_t normalTexIdx;      // -1 if no texture
+    
+    // Principled BSDF parameters
+    float specular;        // Specular intensity
+    float specTint;        // Tint specular towards base color
+    float sheen;           // Sheen intensity
+    
+    float sheenTint;       // Tint sheen towards base color
+    float clearcoat;       // Clearcoat intensity
+    float clearcoatGloss;  // Clearcoat glossiness
+    float specTrans;       // Specular transmission
+    
+    // Mask/Blend parameters
+    float opacity;         // Opacity for mask material
+    float blendWeight;     // Blend weight for blendbsdf
+    float nonlinear;       // Nonlinear mode for plastic (0 or 1)
+    float padding;
+};
+
+// Vertex positions are a stream of their own, tightly packed so BLAS
+// builds read exactly the bytes they need as RGB32_FLOAT
+struct GPUPosition
+{
+    float position[3];
+};
+static_assert(sizeof(GPUPosition) == 12, "BLAS builds expect tightly packed float3");
+
+// Shading attributes of the vertex at the same index in the position
+// stream, packed by PackVertex() (vertex_format.h)
+struct GPUVertex
+{
+    uint32_t normal;        // Octahedral, two snorm16 (x in the low half)
+    uint32_t texcoord;      // Two half floats (u in the low half)
+};
+static_assert(sizeof(GPUVertex) == 8, "GPUVertex must match HLSL");
+
+struct GPUInstance
+{
+    uint32_t vertexOffset;
+    uint32_t indexOffset;
+    uint32_t materialIndex;
+    uint32_t isEmitter;
+    float emission[3];
+    float pad;
+};
+
+// Full-precision vertex a mesh is built and transformed in before it is
+// packed. The pads keep position and normal 16-byte vectors for the SIMD
+// transform (vertex_transform.h).
+struct MeshVertex
+{
+    float position[3];
+    float pad0;
+    float normal[3];
+    float pad1;
+    float texcoord[2];
+};
+
+// Contiguous slice of the shared vertex/index arrays. Indices are local to
+// the mesh (0 to vertexCount - 1); readers add vertexOffset. Each mesh gets
+// one BLAS, built from its own vertex range only.
+struct MeshRange
+{
+    uint32_t vertexOffset;
+    uint32_t vertexCount;
+    uint32_t indexOffset;
+    uint32_t indexCount;
+};
+
+// CPU-side placement of a mesh, parallel to SceneGeometry::instances:
+// entry i becomes TLAS instance i, so InstanceID() indexes both arrays.
+// Written to the scene cache as raw bytes, so the padding is explicit.
+struct InstancePlacement
+{
+    uint32_t meshIndex;
+    uint32_t pad[3];
+    HMM_Mat4 transform;  // Object to world, identity for pre-transformed meshes
+};
+
+// Mitsuba shapes defined by parameters rather than a mesh file, in their
+// canonical form; sphere and cylinder parameters go into the transform
+enum class AnalyticType : uint32_t
+{
+    Sphere = 0,     // Radius 1 around the origin
+    Disk = 1,       // Radius 1 in the XY plane, facing +Z
+    Cylinder = 2,   // Radius 1 around Z from z = 0 to 1, no caps
+    Cube = 3        // [-1, 1]^3
+};
+
+// An analytic shape the renderer intersects itself instead of triangles
+// (see SceneGeometry::analyticPrimitives)
+struct AnalyticShape
+{
+    HMM_Mat4 transform;     // Canonical primitive to world
+    AnalyticType type;
+    uint32_t materialIndex;
+    uint32_t isEmitter;
+    float emission[3];
+    float pad[2];
+};
+
+// Pack a parsed material into its GPU representation
+GPUMaterial PackMaterial(const MitsubaSceneParser::Material& mat);
+
+// Insertion-ordered material buffer. Identical GPUMaterial records are
+// stored once (hash-consed on their bytes) and named materials resolve
+// to their index in O(1).
+class MaterialTable
+{
+public:
+    void Clear();
+
+    // Index of an existing identical record, or of a newly appended one
+    uint32_t Intern(const GPUMaterial& material);
+    // Intern `material` and bind `id` to its index (rebinding replaces)
+    uint32_t AddNamed(std::string_view id, const GPUMaterial& material);
+    // Index bound to `id`, or -1 if unknown
+    int32_t Find(std::string_view id) const;
+
+    const std::vector<GPUMaterial>& Materials() const { return m_Materials; }
+    size_t InternRequests() const { return m_InternRequests; }
+
+private:
+    struct RecordHash
+    {
+        size_t operator()(const GPUMaterial& material) const;
+    };
+    struct RecordEqual
+    {
+        bool operator()(const GPUMaterial& a, const GPUMaterial& b) const;
+    };
+
+    std::vector<GPUMaterial> m_Materials;
+    std::unordered_map<GPUMaterial, uint32_t, RecordHash, RecordEqual> m_RecordIndices;
+    std::unordered_map<std::string_view, uint32_t> m_NamedIndices;
+    size_t m_InternRequests = 0;
+};
+
+// What SceneGeometry::Reload() changed, so a renderer can patch its GPU
+// copies instead of re-uploading the scene
+struct SceneDelta
+{
+    struct Range
+    {
+        uint32_t offset = 0;
+        uint32_t count = 0;
+
+        bool IsEmpty() const { return count == 0; }
+        // Grow to cover [offset, offset + count) as well
+        void Include(uint32_t first, uint32_t length);
+    };
+
+    std::vector<uint32_t> rebuiltMeshes;    // Existing meshes with new contents (BLAS rebuild)
+    uint32_t firstNewMesh = 0;              // meshes[firstNewMesh..] were added (BLAS build)
+    std::vector<Range> vertexRanges;        // Dirty vertex ranges
+    std::vector<Range> indexRanges;         // Dirty index ranges
+    Range materialRange;                    // Dirty materials, if the count is unchanged
+    bool materialsResized = false;
+    Range instanceRange;                    // Dirty instances, if the count is unchanged
+    bool instancesResized = false;
+    bool placementsChanged = false;         // Transforms or mesh assignments differ (TLAS)
+    bool analyticShapesChanged = false;
+
+    bool IsEmpty() const
+    {
+        return rebuiltMeshes.empty() && vertexRanges.empty() && indexRanges.empty() &&
+               materialRange.IsEmpty() && !materialsResized &&
+               instanceRange.IsEmpty() && !instancesResized && !placementsChanged && !analyticShapesChanged;
+    }
+};
+
+class SceneGeometry
+{
+public:
+    std::vector<GPUPosition> positions;
+    std::vector<GPUVertex> vertices;        // Attributes, parallel to positions
+    std::vector<uint32_t> indices;
+    std::vector<GPUMaterial> materials;
+    std::vector<GPUInstance> instances;
+    std::vector<MeshRange> meshes;
+    std::vector<InstancePlacement> placements;
+    std::vector<AnalyticShape> analyticShapes;
+
+    // Load all supported shapes of a parsed scene (OBJ, PLY and serialized
+    // meshes, rectangles, analytic shapes and shape group instances). Standalone shapes are baked into
+    // world space, except mesh files used by several shapes, loaded once in
+    // local space. Shape group members stay in group space and are shared
+    // by every instance of the group. Returns false if there is no geometry.
+    bool Load(const MitsubaSceneParser& scene);
+
+    // Load every shape in local space, one mesh per source file, placed by
+    // its instance transform. Costs a TLAS transform per shape but lets
+    // Reload() patch single meshes and move shapes without touching
+    // vertices. Must be set before Load().
+    bool keepShapesLocal = false;
+
+    // Mesh ingest worker threads (0 = hardware concurrency). The result is
+    // identical for every thread count.
+    unsigned loadThreads = 0;
+
+    // OBJ files at least this large are parsed by the chunked parser on
+    // loadThreads threads instead of tinyobj (0 = always). Below a few MB
+    // the chunks cannot keep threads busy.
+    size_t chunkedOBJBytes = size_t(64) << 20;
+
+    // Reorder each mesh's triangles for the post-transform vertex cache and
+    // its vertices for fetch locality (vertex_cache.h). Adds a few hundred
+    // nanoseconds per triangle to ingest, spread over loadThreads.
+    bool optimizeVertexCache = true;
+
+    // Analytic shapes are tessellated so that, seen from the scene camera,
+    // their edges along the silhouette span about analyticEdgePixels. The
+    // segments per full turn are a power of two from 8 to maxAnalyticSegments.
+    float analyticEdgePixels = 8.0f;
+    uint32_t maxAnalyticSegments = 256;
+
+    // Bitmask of 1 << AnalyticType. Shapes of these types are listed in
+    // analyticShapes for exact intersection instead of being tessellated.
+    uint32_t analyticPrimitives = 0;
+
+    // Bring the arrays up to date with `scene` (a re-parse of the same or an
+    // edited XML) after the files in `changedFiles` were modified. Changed
+    // meshes are re-read into their old range when they still fit, otherwise
+    // appended; materials, instances and placements are rebuilt and diffed.
+    // Requires keepShapesLocal. The previous parser may be released after.
+    bool Reload(const MitsubaSceneParser& scene, const std::vector<std::filesystem::path>& changedFiles,
+                SceneDelta& delta);
+
+    // Texture indices referenced by materials that some instance uses,
+    // sorted and unique. Only these need decoding.
+    std::vector<int> UsedTextureIndices() const;
+
+    // Position + attribute + index bytes actually stored
+    size_t GeometryByteSize() const;
+    // Same, if every instance carried its own copy of its mesh
+    size_t FlattenedGeometryByteSize() const;
+
+private:
+    // One mesh built on its own: indices are local (0-based)
+    struct MeshData
+    {
+        std::vector<MeshVertex> vertices;
+        std::vector<uint32_t> indices;
+    };
+
+    // A mesh requested while placing shapes, loaded by LoadPendingMeshes()
+    struct PendingMesh
+    {
+        std::filesystem::path path;     // Mesh file, empty for generated meshes
+        uint32_t shapeIndex = 0;        // Mesh within a .serialized file
+        bool isAnalytic = false;        // Else a rectangle when there is no path
+        AnalyticType analyticType = AnalyticType::Sphere;
+        uint32_t segments = 0;          // Tessellation of analytic shapes
+        HMM_Mat4 transform;             // Baked into the vertices
+    };
+
+    // Queue the mesh of `shape` with `transform` baked in; analytic shapes
+    // are tessellated for their size at `toWorld`. Returns the provisional
+    // index in `meshes` (valid once LoadPendingMeshes() has run), or -1 for
+    // unsupported shape types.
+    int32_t RequestShapeMesh(const MitsubaSceneParser& scene, const MitsubaSceneParser::Shape& shape,
+                             const HMM_Mat4& transform, const HMM_Mat4& toWorld);
+    // Build all queued meshes on loadThreads workers (chunked OBJs first,
+    // one at a time), append them in request order and resolve provisional
+    // indices in instances, placements and m_LocalMeshes. Instances of
+    // meshes that failed to load are removed.
+    void LoadPendingMeshes();
+    // Forsyth triangle order, then vertices in order of first use
+    static void OptimizeMesh(MeshData& mesh);
+    // Pack `data` into `range` of the shared arrays
+    void StoreMesh(const MeshData& data, const MeshRange& range);
+
+    // "obj", "ply" and "serialized" shapes reference a mesh file
+    static bool IsFileShape(const MitsubaSceneParser::Shape& shape);
+    // Lower-case extension of a mesh file
+    static std::string MeshFileExtension(const std::filesystem::path& path);
+    // An OBJ file of at least chunkedOBJBytes
+    bool IsChunkedOBJ(const std::filesystem::path& path) const;
+    // OBJ, PLY or serialized by file extension; `parseThreads` only
+    // applies to chunked OBJs
+    bool BuildFileMesh(const std::filesystem::path& path, uint32_t shapeIndex, const HMM_Mat4& transform,
+                       unsigned parseThreads, MeshData& mesh) const;
+    // Parse with tinyobj or, on `parseThreads` threads, ParseOBJChunked (see
+    // chunkedOBJBytes), then dedup and transform through BuildMeshFromOBJ
+    bool BuildOBJMesh(const std::filesystem::path& objPath, const HMM_Mat4& transform, unsigned parseThreads,
+                      MeshData& mesh) const;
+    static void BuildMeshFromOBJ(const OBJMeshView& obj, const HMM_Mat4& transform, MeshData& mesh);
+    static bool BuildPLYMesh(const std::filesystem::path& plyPath, const HMM_Mat4& transform, MeshData& mesh);
+    static bool BuildSerializedMesh(const std::filesystem::path& path, uint32_t shapeIndex, const HMM_Mat4& transform,
+                                    MeshData& mesh);
+    static bool BuildRectangleMesh(const HMM_Mat4& transform, MeshData& mesh);
+    static bool BuildAnalyticMesh(AnalyticType type, uint32_t segments, const HMM_Mat4& transform, MeshData& mesh);
+
+    static bool AnalyticTypeOf(const MitsubaSceneParser::Shape& shape, AnalyticType& type);
+    // `shape.transform`, with sphere and cylinder parameters folded in
+    static HMM_Mat4 ShapeTransform(const MitsubaSceneParser::Shape& shape);
+    // Segments per full turn for the canonical primitive placed at `toWorld`
+    uint32_t AnalyticSegments(const MitsubaSceneParser::Camera& camera, AnalyticType type,
+                              const HMM_Mat4& toWorld) const;
+    // Add `shape` to analyticShapes if analyticPrimitives asks for its type
+    bool KeepAnalytic(const MitsubaSceneParser::Shape& shape, const HMM_Mat4& toWorld);
+
+    // m_LocalMeshes key of `shape`: its filename, plus "<shape_index>" for
+    // serialized shapes, or "<rectangle>" and "<sphere 64>" (type and
+    // segments) for generated meshes
+    static std::string LocalMeshKey(const MitsubaSceneParser::Shape& shape, uint32_t segments = 0);
+    // Filename (empty for rectangles) and shape index of a LocalMeshKey()
+    static std::string_view LocalMeshFile(std::string_view key, uint32_t& shapeIndex);
+    // Mesh of `shape` in local space, requested on first use and shared by
+    // every shape that references the same mesh. `toWorld` only picks the
+    // tessellation of analytic shapes.
+    int32_t LocalShapeMesh(const MitsubaSceneParser& scene, const MitsubaSceneParser::Shape& shape,
+                           const HMM_Mat4& toWorld);
+    // Rebuild materials, instances and placements for the scene's shapes
+    void PlaceShapes(const MitsubaSceneParser& scene);
+    // Re-read one local mesh from `path`, in place if it still fits
+    bool ReplaceFileMesh(uint32_t meshIndex, const std::filesystem::path& path, uint32_t shapeIndex,
+                         SceneDelta& delta);
+
+    uint32_t ResolveMaterial(const MitsubaSceneParser::Shape& shape);
+    void AddInstance(uint32_t meshIndex, uint32_t materialIndex,
+                     const MitsubaSceneParser::Shape& shape, const HMM_Mat4& transform);
+
+    MaterialTable m_MaterialTable;
+    // LocalMeshKey() -> mesh index of local-space meshes. Owns
+    // its keys so it outlives the parser it was built from.
+    std::unordered_map<std::string, int32_t> m_LocalMeshes;
+    bool m_LoadedLocal = false;
+    std::vector<PendingMesh> m_PendingMeshes;
+};
@@ -0,0 +1,280 @@
+#include "serialized_reader.h"
+
+#include <donut/core/log.h>
+
+#ifdef SCENE_CORE_WITH_MINIZ
+#include <miniz.h>
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <cstring>
+
+using namespace donut;
+
+// Every field is stored little-endian
+static_assert(std::endian::native == std::endian::little, "SerializedFile reads fields in host byte order");
+
+namespace
+{
+
+constexpr uint16_t kFormatIdentifier = 0x041C;
+constexpr uint64_t kMaxDeflateRatio = 1032;   // Largest zlib expansion, plus slack
+
+enum MeshFlags : uint32_t
+{
+    HasNormals = 0x0001,
+    HasTexcoords = 0x0002,
+    HasColors = 0x0008,
+    DoublePrecision = 0x2000
+};
+
+template <typename T>
+T Load(const char* data)
+{
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+#ifdef SCENE_CORE_WITH_MINIZ
+// Reads exact byte counts from one zlib stream held entirely in memory
+class Inflater
+{
+public:
+    Inflater(const char* data, size_t size)
+    {
+        memset(&m_Stream, 0, sizeof(m_Stream));
+        m_Stream.next_in = reinterpret_cast<const unsigned char*>(data);
+        m_Stream.avail_in = static_cast<unsigned int>(size);
+        m_IsValid = mz_inflateInit(&m_Stream) == MZ_OK;
+    }
+
+    ~Inflater()
+    {
+        if (m_IsValid)
+        {
+            mz_inflateEnd(&m_Stream);
+        }
+    }
+
+    Inflater(const Inflater&) = delete;
+    Inflater& operator=(const Inflater&) = delete;
+
+    bool Read(void* out, size_t bytes)
+    {
+        unsigned char* dest = static_cast<unsigned char*>(out);
+        while (m_IsValid && bytes > 0)
+        {
+            // avail_out is 32-bit; large attribute arrays take several calls
+            unsigned int chunk = static_cast<unsigned int>(std::min<size_t>(bytes, 1u << 30));
+            m_Stream.next_out = dest;
+            m_Stream.avail_out = chunk;
+            int status = mz_inflate(&m_Stream, MZ_NO_FLUSH);
+            size_t written = chunk - m_Stream.avail_out;
+            dest += written;
+            bytes -= written;
+            if (status != MZ_OK && !(status == MZ_STREAM_END && bytes == 0))
+            {
+                m_IsValid = false;
+            }
+        }
+        return m_IsValid;
+    }
+
+    // Discard `bytes` bytes of output
+    bool Skip(size_t bytes)
+    {
+        char scratch[4096];
+        while (bytes > 0)
+        {
+            size_t chunk = std::min(bytes, sizeof(scratch));
+            if (!Read(scratch, chunk))
+            {
+                return false;
+            }
+            bytes -= chunk;
+        }
+        return true;
+    }
+
+private:
+    mz_stream m_Stream;
+    bool m_IsValid = false;
+};
+
+// `count` floats or doubles, narrowed to float
+bool ReadFloats(Inflater& inflater, bool doublePrecision, size_t count, std::vector<float>& out)
+{
+    out.resize(count);
+    if (!doublePrecision)
+    {
+        return inflater.Read(out.data(), count * sizeof(float));
+    }
+    std::vector<double> wide(count);
+    if (!inflater.Read(wide.data(), count * sizeof(double)))
+    {
+        return false;
+    }
+    std::transform(wide.begin(), wide.end(), out.begin(), [](double value) { return static_cast<float>(value); });
+    return true;
+}
+#endif
+
+} // namespace
+
+// ============================================================================
+// SerializedFile
+// ============================================================================
+bool SerializedFile::Open(const std::filesystem::path& path)
+{
+    m_Path = path;
+    m_Offsets.clear();
+    if (!m_File.Open(path))
+    {
+        log::warning("Cannot read serialized mesh file: %s", path.string().c_str());
+        return false;
+    }
+
+    // The table layout follows the version of the first mesh: 64-bit
+    // offsets since version 4, 32-bit before
+    const char* data = m_File.Data();
+    const size_t size = m_File.Size();
+    if (size < 8 || Load<uint16_t>(data) != kFormatIdentifier)
+    {
+        log::warning("Not a Mitsuba serialized mesh file: %s", path.string().c_str());
+        return false;
+    }
+    const uint16_t version = Load<uint16_t>(data + 2);
+    if (version != 3 && version != 4)
+    {
+        log::warning("Unsupported serialized mesh version %u: %s", unsigned(version), path.string().c_str());
+        return false;
+    }
+
+    const uint32_t count = Load<uint32_t>(data + size - sizeof(uint32_t));
+    const size_t entrySize = version == 4 ? sizeof(uint64_t) : sizeof(uint32_t);
+    if (count == 0 || count > (size - sizeof(uint32_t)) / entrySize)
+    {
+        log::warning("Corrupt serialized mesh offset table: %s", path.string().c_str());
+        return false;
+    }
+
+    m_TableOffset = size - sizeof(uint32_t) - size_t(count) * entrySize;
+    m_Offsets.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const char* entry = data + m_TableOffset + size_t(i) * entrySize;
+        m_Offsets[i] = version == 4 ? Load<uint64_t>(entry) : Load<uint32_t>(entry);
+        // Streams are stored in order; the table start bounds the last one
+        if (m_Offsets[i] + 4 > m_TableOffset || (i > 0 && m_Offsets[i] <= m_Offsets[i - 1]))
+        {
+            log::warning("Corrupt serialized mesh offset table: %s", path.string().c_str());
+            m_Offsets.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SerializedFile::ReadMesh(uint32_t index, SerializedMesh& mesh) const
+{
+    mesh = {};
+    if (index >= MeshCount())
+    {
+        log::warning("shape_index %u is out of range (%u meshes): %s", index, MeshCount(), m_Path.string().c_str());
+        return false;
+    }
+
+#ifdef SCENE_CORE_WITH_MINIZ
+    const char* header = m_File.Data() + m_Offsets[index];
+    const uint16_t version = Load<uint16_t>(header + 2);
+    if (Load<uint16_t>(header) != kFormatIdentifier || (version != 3 && version != 4))
+    {
+        log::warning("Corrupt serialized mesh %u: %s", index, m_Path.string().c_str());
+        return false;
+    }
+
+    const uint64_t end = index + 1 < MeshCount() ? m_Offsets[index + 1] : m_TableOffset;
+    const uint64_t compressedSize = end - m_Offsets[index] - 4;
+    if (compressedSize > std::numeric_limits<unsigned int>::max())
+    {
+        log::warning("Serialized mesh %u is too large: %s", index, m_Path.string().c_str());
+        return false;
+    }
+    Inflater inflater(header + 4, size_t(compressedSize));
+
+    uint32_t flags = 0;
+    bool ok = inflater.Read(&flags, sizeof(flags));
+
+    // Version 4 adds a null-terminated mesh name
+    for (char c = 1; ok && version == 4 && c != 0;)
+    {
+        ok = inflater.Read(&c, 1);
+    }
+
+    uint64_t vertexCount = 0;
+    uint64_t triangleCount = 0;
+    ok = ok && inflater.Read(&vertexCount, sizeof(vertexCount)) && inflater.Read(&triangleCount, sizeof(triangleCount));
+    if (ok && (vertexCount > std::numeric_limits<uint32_t>::max() || triangleCount > std::numeric_limits<uint32_t>::max() / 3))
+    {
+        log::warning("Serialized mesh %u is too large for 32-bit indices: %s", index, m_Path.string().c_str());
+        return false;
+    }
+
+    // Deflate expands at most about 1032:1, so counts that need more bytes
+    // than the stream can inflate to are corrupt; they must not size the
+    // allocations below
+    const bool doublePrecision = (flags & DoublePrecision) != 0;
+    const uint64_t floatsPerVertex = 3 + ((flags & HasNormals) ? 3 : 0) + ((flags & HasTexcoords) ? 2 : 0)
+                                   + ((flags & HasColors) ? 3 : 0);
+    const uint64_t decodedSize = vertexCount * floatsPerVertex * (doublePrecision ? sizeof(double) : sizeof(float))
+                               + triangleCount * 3 * sizeof(uint32_t);
+    if (ok && decodedSize > compressedSize * kMaxDeflateRatio)
+    {
+        log::warning("Serialized mesh %u claims more data than its stream holds: %s", index, m_Path.string().c_str());
+        return false;
+    }
+
+    const size_t vertices = size_t(vertexCount);
+    ok = ok && ReadFloats(inflater, doublePrecision, 3 * vertices, mesh.positions);
+    if (ok && (flags & HasNormals))
+    {
+        ok = ReadFloats(inflater, doublePrecision, 3 * vertices, mesh.normals);
+    }
+    if (ok && (flags & HasTexcoords))
+    {
+        ok = ReadFloats(inflater, doublePrecision, 2 * vertices, mesh.texcoords);
+    }
+    if (ok && (flags & HasColors))
+    {
+        ok = inflater.Skip(3 * vertices * (doublePrecision ? sizeof(double) : sizeof(float)));
+    }
+    if (ok)
+    {
+        mesh.indices.resize(3 * size_t(triangleCount));
+        ok = inflater.Read(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+    }
+
+    if (!ok)
+    {
+        log::warning("Serialized mesh %u is truncated or corrupt: %s", index, m_Path.string().c_str());
+        mesh = {};
+        return false;
+    }
+    for (uint32_t vertex : mesh.indices)
+    {
+        if (vertex >= vertexCount)
+        {
+            log::warning("Serialized mesh %u has out-of-range indices: %s", index, m_Path.string().c_str());
+            mesh = {};
+            return false;
+        }
+    }
+    return true;
+#else
+    log::warning("Built without miniz, cannot inflate %s", m_Path.string().c_str());
+    return false;
+#endif
+}
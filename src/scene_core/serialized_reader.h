@@ -0,0 +1,48 @@
+#pragma once
+
+// ============================================================================
+// Serialized Reader
+// Reader for Mitsuba's .serialized mesh container (<shape type="serialized">):
+// a sequence of zlib-compressed meshes followed by an offset table with one
+// entry per mesh and the mesh count. Every mesh is a separate zlib stream, so
+// threads may inflate different meshes of one mapped file at the same time.
+// Inflating needs miniz (SCENE_CORE_WITH_MINIZ); without it ReadMesh() fails.
+// ============================================================================
+
+#include "../common/mapped_file.h"
+
+#include <filesystem>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+struct SerializedMesh
+{
+    std::vector<float> positions;   // xyz
+    std::vector<float> normals;     // xyz, empty if not stored
+    std::vector<float> texcoords;   // uv, empty if not stored
+    std::vector<uint32_t> indices;  // Three per triangle
+
+    size_t VertexCount() const { return positions.size() / 3; }
+};
+
+class SerializedFile
+{
+public:
+    // Map `path` and read its offset table. Logs and returns false for
+    // files that are not version 3 or 4 .serialized containers.
+    bool Open(const std::filesystem::path& path);
+
+    uint32_t MeshCount() const { return static_cast<uint32_t>(m_Offsets.size()); }
+
+    // Inflate mesh `index`; doubles are narrowed and vertex colors skipped.
+    // Logs and returns false for corrupt streams and out-of-range indices.
+    // Safe to call concurrently.
+    bool ReadMesh(uint32_t index, SerializedMesh& mesh) const;
+
+private:
+    MappedFile m_File;
+    std::filesystem::path m_Path;
+    std::vector<uint64_t> m_Offsets;    // Mesh headers; the table start ends the last
+    uint64_t m_TableOffset = 0;
+};
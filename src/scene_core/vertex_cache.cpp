@@ -0,0 +1,274 @@
+#include "vertex_cache.h"
+
+#include <algorithm>
+#include <cmath>
+
+// ============================================================================
+// Scores
+// A vertex scores higher the more recently it was used (it is probably still
+// transformed) and the fewer unemitted triangles it has left (finishing it
+// frees its cache entry and avoids leaving lone triangles behind). A
+// triangle scores the sum of its vertices.
+// ============================================================================
+namespace
+{
+
+constexpr uint32_t kCacheSize = 32;         // Modelled LRU cache
+constexpr float kLastTriangleScore = 0.75f; // Vertices of the triangle just emitted
+constexpr float kCacheDecayPower = 1.5f;
+constexpr float kValenceBoostScale = 2.0f;
+constexpr float kValenceBoostPower = 0.5f;
+constexpr uint32_t kValenceTableSize = 64;
+// Triangles of vertices with more remaining than this are not rescored when
+// the vertex enters the cache; the rims of a fan still lead the order
+// around it, and the pass stays linear for n-gon caps and fan hubs
+constexpr uint32_t kMaxRescoreValence = 64;
+constexpr uint32_t kNone = UINT32_MAX;
+
+struct ScoreTables
+{
+    float cache[kCacheSize];
+    float valence[kValenceTableSize];
+
+    ScoreTables()
+    {
+        for (uint32_t i = 0; i < kCacheSize; i++)
+        {
+            // The last triangle's vertices get a fixed score a little below
+            // the next entries, so the order does not just run along a strip
+            cache[i] = i < 3 ? kLastTriangleScore
+                             : std::pow(1.0f - float(i - 3) / float(kCacheSize - 3), kCacheDecayPower);
+        }
+        valence[0] = 0.0f;
+        for (uint32_t i = 1; i < kValenceTableSize; i++)
+        {
+            valence[i] = kValenceBoostScale * std::pow(float(i), -kValenceBoostPower);
+        }
+    }
+
+    // `cachePosition` is kNone outside the cache
+    float VertexScore(uint32_t cachePosition, uint32_t remaining) const
+    {
+        if (remaining == 0)
+        {
+            return -1.0f;
+        }
+        float score = cachePosition < kCacheSize ? cache[cachePosition] : 0.0f;
+        score += remaining < kValenceTableSize ? valence[remaining]
+                                               : kValenceBoostScale * std::pow(float(remaining), -kValenceBoostPower);
+        return score;
+    }
+};
+
+const ScoreTables& Scores()
+{
+    static const ScoreTables tables;
+    return tables;
+}
+
+} // namespace
+
+// ============================================================================
+// Triangle Order
+// Greedy: emit the best triangle among those touching the cache, update the
+// modelled cache and the scores it changed, repeat. When no triangle
+// touches the cache, the next unemitted one in input order restarts it,
+// which keeps the whole pass linear in the triangle count.
+// Adjacency lists hold corners (triangle * 3 + k), and each corner knows
+// its slot, so an emitted triangle leaves its vertices' lists in O(1).
+// ============================================================================
+void OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+    {
+        return;
+    }
+    const ScoreTables& scores = Scores();
+
+    // Corners of each vertex; the first remaining[v] entries of a vertex's
+    // list are the ones not emitted yet
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+    {
+        remaining[indices[i]]++;
+    }
+    std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+    }
+    std::vector<uint32_t> vertexCorners(triangleCount * 3);
+    std::vector<uint32_t> cornerSlot(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+        {
+            cornerSlot[i] = fill[indices[i]]++;
+            vertexCorners[cornerSlot[i]] = static_cast<uint32_t>(i);
+        }
+    }
+
+    std::vector<uint32_t> cachePosition(vertexCount, kNone);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        vertexScore[v] = scores.VertexScore(kNone, remaining[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    uint32_t best = 0;
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        const uint32_t* corners = &indices[t * 3];
+        triangleScore[t] = vertexScore[corners[0]] + vertexScore[corners[1]] + vertexScore[corners[2]];
+        if (triangleScore[t] > triangleScore[best])
+        {
+            best = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> output(triangleCount * 3);
+    uint32_t cache[kCacheSize + 3];
+    uint32_t cacheCount = 0;
+    size_t inputCursor = 0;
+
+    for (size_t out = 0; out < triangleCount; out++)
+    {
+        if (best == kNone)
+        {
+            while (emitted[inputCursor])
+            {
+                inputCursor++;
+            }
+            best = static_cast<uint32_t>(inputCursor);
+        }
+
+        const uint32_t corners[3] = { indices[best * 3 + 0], indices[best * 3 + 1], indices[best * 3 + 2] };
+        std::copy(corners, corners + 3, &output[out * 3]);
+        emitted[best] = 1;
+
+        // Drop the triangle from its vertices' lists: the last remaining
+        // corner moves into each freed slot
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            const uint32_t v = corners[k];
+            const uint32_t slot = cornerSlot[best * 3 + k];
+            const uint32_t last = firstTriangle[v] + remaining[v] - 1;
+            const uint32_t moved = vertexCorners[last];
+            vertexCorners[slot] = moved;
+            cornerSlot[moved] = slot;
+            remaining[v]--;
+        }
+
+        // Its vertices move to the front of the cache; the oldest entries
+        // fall out the back but still need their scores lowered
+        uint32_t next[kCacheSize + 3];
+        uint32_t nextCount = 0;
+        for (uint32_t v : corners)
+        {
+            if (std::find(next, next + nextCount, v) == next + nextCount)
+            {
+                next[nextCount++] = v;
+            }
+        }
+        for (uint32_t i = 0; i < cacheCount; i++)
+        {
+            const uint32_t v = cache[i];
+            if (v != corners[0] && v != corners[1] && v != corners[2])
+            {
+                next[nextCount++] = v;
+            }
+        }
+        for (uint32_t i = 0; i < nextCount; i++)
+        {
+            const uint32_t v = next[i];
+            cachePosition[v] = i < kCacheSize ? i : kNone;
+            vertexScore[v] = scores.VertexScore(cachePosition[v], remaining[v]);
+        }
+
+        // Rescore the triangles whose vertices changed and pick the best
+        // one that touches the cache
+        best = kNone;
+        float bestScore = 0.0f;
+        for (uint32_t i = 0; i < nextCount; i++)
+        {
+            const uint32_t v = next[i];
+            if (remaining[v] > kMaxRescoreValence)
+            {
+                continue;
+            }
+            const uint32_t* list = &vertexCorners[firstTriangle[v]];
+            for (uint32_t k = 0; k < remaining[v]; k++)
+            {
+                const uint32_t t = list[k] / 3;
+                const uint32_t* triangle = &indices[t * 3];
+                const float score = vertexScore[triangle[0]] + vertexScore[triangle[1]] + vertexScore[triangle[2]];
+                triangleScore[t] = score;
+                if (i < kCacheSize && (best == kNone || score > bestScore))
+                {
+                    best = t;
+                    bestScore = score;
+                }
+            }
+        }
+
+        cacheCount = std::min(nextCount, kCacheSize);
+        std::copy(next, next + cacheCount, cache);
+    }
+
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+// ============================================================================
+// Vertex Order
+// ============================================================================
+std::vector<uint32_t> OptimizeVertexFetch(std::span<uint32_t> indices, size_t vertexCount)
+{
+    std::vector<uint32_t> remap(vertexCount, kNone);
+    uint32_t nextVertex = 0;
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == kNone)
+        {
+            remap[index] = nextVertex++;
+        }
+        index = remap[index];
+    }
+    for (uint32_t& target : remap)
+    {
+        if (target == kNone)
+        {
+            target = nextVertex++;
+        }
+    }
+    return remap;
+}
+
+// ============================================================================
+// Statistics
+// ============================================================================
+VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize)
+{
+    // A vertex is in a FIFO cache while fewer than cacheSize misses happened
+    // since its own; the miss counter starts past cacheSize so every
+    // vertex misses on first use
+    std::vector<uint32_t> missedAt(vertexCount, 0);
+    uint32_t misses = 0;
+    uint32_t clock = cacheSize + 1;
+    for (uint32_t index : indices)
+    {
+        if (clock - missedAt[index] > cacheSize)
+        {
+            missedAt[index] = clock++;
+            misses++;
+        }
+    }
+
+    VertexCacheStats stats;
+    const size_t triangleCount = indices.size() / 3;
+    stats.acmr = triangleCount > 0 ? double(misses) / double(triangleCount) : 0.0;
+    stats.atvr = vertexCount > 0 ? double(misses) / double(vertexCount) : 0.0;
+    return stats;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// ============================================================================
+// Vertex Cache
+// Reorders a deduplicated mesh for the GPU's vertex pipeline. Triangles are
+// sorted so that consecutive ones reuse vertices still in the post-transform
+// cache (Forsyth, "Linear-Speed Vertex Cache Optimisation", 2006), then the
+// vertices are renumbered in order of first use so fetches walk the vertex
+// buffer forward. The set of triangles and their winding are kept.
+// ============================================================================
+
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Reorder the triangles of `indices` in place. Every index must be below
+// `vertexCount`.
+void OptimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount);
+
+// Renumber the vertices in order of first use by `indices`, which are
+// rewritten in place, and return the old -> new map. Unreferenced vertices
+// go last. Apply the map to the vertex array with RemapVertices().
+std::vector<uint32_t> OptimizeVertexFetch(std::span<uint32_t> indices, size_t vertexCount);
+
+template <typename T>
+void RemapVertices(std::vector<T>& vertices, std::span<const uint32_t> remap)
+{
+    std::vector<T> reordered(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        reordered[remap[i]] = vertices[i];
+    }
+    vertices = std::move(reordered);
+}
+
+struct VertexCacheStats
+{
+    double acmr = 0.0;  // Average cache miss ratio: transformed vertices per triangle, 0.5 at best, 3 at worst
+    double atvr = 0.0;  // Average transform to vertex ratio: transformed vertices per vertex, 1 at best
+};
+
+// Replay `indices` through a FIFO post-transform cache of `cacheSize`
+// vertices, the model most GPUs are closest to
+VertexCacheStats AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize = 16);
@@ -0,0 +1,253 @@
+#include "vertex_dedup.h"
+
+#include <algorithm>
+#include <bit>
+
+// ============================================================================
+// Keys
+// ============================================================================
+namespace
+{
+
+struct Key
+{
+    uint32_t v;
+    uint32_t vt;    // Index + 1, 0 = not given
+    uint32_t vn;    // Index + 1, 0 = not given
+
+    bool operator==(const Key&) const = default;
+};
+
+inline Key MakeKey(const tinyobj_vertex_index_t& corner)
+{
+    // tinyobj leaves a large negative value for a missing index, the
+    // chunked parser -1
+    return { static_cast<uint32_t>(corner.v_idx),
+             static_cast<uint32_t>(std::max(corner.vt_idx, -1) + 1),
+             static_cast<uint32_t>(std::max(corner.vn_idx, -1) + 1) };
+}
+
+// Mix of the attributes other than the position, used to spread the keys
+// that share a position
+inline uint32_t HashAttributes(const Key& key)
+{
+    return static_cast<uint32_t>(((uint64_t(key.vt) << 32 | key.vn) * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+// ============================================================================
+// Hash Method
+// Linear probing over inline keys, 16 bytes per slot. Instead of scattering
+// keys randomly, each position index owns a window of `stride` slots and the
+// other attributes pick a slot inside it. Faces reference nearby positions,
+// so lookups stay in cache the way the vertex array itself does. The load
+// factor is kept at or below 3/4.
+// ============================================================================
+struct Slot
+{
+    Key key;
+    uint32_t vertex;    // kEmpty = unused
+};
+
+constexpr uint32_t kEmpty = UINT32_MAX;
+
+class VertexTable
+{
+public:
+    VertexTable(uint32_t positionCount, size_t expectedCount)
+        : m_PositionCapacity(std::bit_ceil(std::max<size_t>(1, positionCount)))
+    {
+        Allocate(std::bit_ceil(std::max<size_t>({ 16, expectedCount * 2, m_PositionCapacity })));
+    }
+
+    // Vertex of `key`, or kEmpty after inserting it as `newVertex`
+    uint32_t FindOrInsert(const Key& key, uint32_t newVertex)
+    {
+        for (size_t i = Home(key); ; i = (i + 1) & m_Mask)
+        {
+            Slot& slot = m_Slots[i];
+            if (slot.vertex == kEmpty)
+            {
+                slot = { key, newVertex };
+                if (++m_Count * 4 > m_Slots.size() * 3)
+                {
+                    Grow();
+                }
+                return kEmpty;
+            }
+            if (slot.key == key)
+            {
+                return slot.vertex;
+            }
+        }
+    }
+
+private:
+    size_t Home(const Key& key) const
+    {
+        return (size_t(key.v) * m_Stride + (HashAttributes(key) & (m_Stride - 1))) & m_Mask;
+    }
+
+    void Allocate(size_t capacity)
+    {
+        m_Slots.assign(capacity, Slot{ {}, kEmpty });
+        m_Mask = capacity - 1;
+        m_Stride = capacity / m_PositionCapacity;
+    }
+
+    void Grow()
+    {
+        std::vector<Slot> old = std::move(m_Slots);
+        Allocate(old.size() * 2);
+        for (const Slot& slot : old)
+        {
+            if (slot.vertex != kEmpty)
+            {
+                size_t i = Home(slot.key);
+                while (m_Slots[i].vertex != kEmpty)
+                {
+                    i = (i + 1) & m_Mask;
+                }
+                m_Slots[i] = slot;
+            }
+        }
+    }
+
+    std::vector<Slot> m_Slots;
+    size_t m_PositionCapacity;
+    size_t m_Mask = 0;
+    size_t m_Stride = 1;
+    size_t m_Count = 0;
+};
+
+void BuildHashed(std::span<const tinyobj_vertex_index_t> corners, size_t attributeCount, VertexDedup& dedup)
+{
+    uint32_t positionCount = 0;
+    for (const tinyobj_vertex_index_t& corner : corners)
+    {
+        positionCount = std::max(positionCount, static_cast<uint32_t>(std::max(corner.v_idx, -1) + 1));
+    }
+
+    VertexTable table(positionCount, attributeCount);
+    for (size_t c = 0; c < corners.size(); c++)
+    {
+        uint32_t newVertex = static_cast<uint32_t>(dedup.firstCorner.size());
+        uint32_t vertex = table.FindOrInsert(MakeKey(corners[c]), newVertex);
+        if (vertex == kEmpty)
+        {
+            vertex = newVertex;
+            dedup.firstCorner.push_back(static_cast<uint32_t>(c));
+        }
+        dedup.cornerVertex[c] = vertex;
+    }
+}
+
+// ============================================================================
+// Radix Method
+// LSD radix sort of (key, corner) records, 11 bits per pass and only as many
+// passes as the largest index needs. The sort is stable, so every run of
+// equal keys starts with its first corner, which numbers the vertices in
+// first-use order without a second sort.
+// ============================================================================
+struct Record
+{
+    Key key;
+    uint32_t corner;
+};
+
+constexpr uint32_t kRadixBits = 11;
+constexpr uint32_t kRadixBuckets = 1u << kRadixBits;
+
+void RadixPass(std::vector<Record>& records, std::vector<Record>& scratch, uint32_t Key::*field, uint32_t shift)
+{
+    uint32_t offsets[kRadixBuckets] = {};
+    for (const Record& record : records)
+    {
+        offsets[(record.key.*field >> shift) & (kRadixBuckets - 1)]++;
+    }
+
+    uint32_t sum = 0;
+    for (uint32_t& offset : offsets)
+    {
+        uint32_t count = offset;
+        offset = sum;
+        sum += count;
+    }
+
+    for (const Record& record : records)
+    {
+        scratch[offsets[(record.key.*field >> shift) & (kRadixBuckets - 1)]++] = record;
+    }
+    records.swap(scratch);
+}
+
+void BuildSorted(std::span<const tinyobj_vertex_index_t> corners, VertexDedup& dedup)
+{
+    std::vector<Record> records(corners.size());
+    Key maxKey = {};
+    for (size_t c = 0; c < corners.size(); c++)
+    {
+        records[c] = { MakeKey(corners[c]), static_cast<uint32_t>(c) };
+        maxKey.v = std::max(maxKey.v, records[c].key.v);
+        maxKey.vt = std::max(maxKey.vt, records[c].key.vt);
+        maxKey.vn = std::max(maxKey.vn, records[c].key.vn);
+    }
+
+    // Least significant field first
+    std::vector<Record> scratch(records.size());
+    for (uint32_t Key::*field : { &Key::vn, &Key::vt, &Key::v })
+    {
+        for (uint32_t shift = 0; shift < 32 && (maxKey.*field >> shift) != 0; shift += kRadixBits)
+        {
+            RadixPass(records, scratch, field, shift);
+        }
+    }
+    scratch = {};
+
+    // Runs of equal keys, each remembering its first corner
+    std::vector<uint32_t> cornerRun(corners.size());
+    std::vector<uint32_t> runFirst;
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        if (i == 0 || !(records[i].key == records[i - 1].key))
+        {
+            runFirst.push_back(records[i].corner);
+        }
+        cornerRun[records[i].corner] = static_cast<uint32_t>(runFirst.size() - 1);
+    }
+    records = {};
+
+    // Visiting corners in order reaches each run's first corner before any
+    // other member of it
+    std::vector<uint32_t> runVertex(runFirst.size());
+    dedup.firstCorner.reserve(runFirst.size());
+    for (size_t c = 0; c < corners.size(); c++)
+    {
+        uint32_t run = cornerRun[c];
+        if (runFirst[run] == c)
+        {
+            runVertex[run] = static_cast<uint32_t>(dedup.firstCorner.size());
+            dedup.firstCorner.push_back(static_cast<uint32_t>(c));
+        }
+        dedup.cornerVertex[c] = runVertex[run];
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// VertexDedup
+// ============================================================================
+void VertexDedup::Build(std::span<const tinyobj_vertex_index_t> corners, size_t attributeCount, Method method)
+{
+    cornerVertex.resize(corners.size());
+    firstCorner.clear();
+
+    if (method == Method::Radix)
+    {
+        BuildSorted(corners, *this);
+    }
+    else
+    {
+        BuildHashed(corners, attributeCount, *this);
+    }
+}
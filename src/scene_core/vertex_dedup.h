@@ -0,0 +1,35 @@
+#pragma once
+
+// ============================================================================
+// Vertex Dedup
+// Collapses OBJ face corners that reference the same (v, vt, vn) index
+// triple into one vertex. Keys compare all three 32-bit indices, so large
+// indices never alias; any negative index counts as "not given".
+// ============================================================================
+
+#include <tinyobj_loader_c.h>
+
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+struct VertexDedup
+{
+    enum class Method
+    {
+        Hash,       // Open-addressing table, pre-sized from the attribute count
+        Radix       // Sort corners by key: streams memory instead of probing,
+                    // at ~6 passes over 32 bytes of scratch per corner
+    };
+
+    std::vector<uint32_t> cornerVertex;     // Per corner: its vertex
+    std::vector<uint32_t> firstCorner;      // Per vertex: first corner using it
+
+    // Vertices are numbered in order of first use, as a map filled in a
+    // single pass over the corners would; both methods give the same result.
+    // `attributeCount` (the largest of the v/vt/vn counts) sizes the table.
+    void Build(std::span<const tinyobj_vertex_index_t> corners, size_t attributeCount, Method method = Method::Hash);
+
+    size_t VertexCount() const { return firstCorner.size(); }
+};
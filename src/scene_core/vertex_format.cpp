@@ -0,0 +1,206 @@
+#include "vertex_format.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+// ============================================================================
+// Octahedral Normals
+// The unit sphere is projected onto the octahedron |x| + |y| + |z| = 1; its
+// lower half is folded over the diagonals, so the square [-1, 1]^2 covers
+// every direction once (Cigolle et al., "A Survey of Efficient
+// Representations for Independent Unit Vectors", 2014).
+// ============================================================================
+namespace
+{
+
+constexpr float kSnorm16Max = 32767.0f;
+
+inline float SignNotZero(float value)
+{
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+void ToOctahedron(const float normal[3], float& u, float& v)
+{
+    const float l1 = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+    if (!(l1 > 0.0f))
+    {
+        u = v = 0.0f;
+        return;
+    }
+    const float scale = 1.0f / l1;
+    u = normal[0] * scale;
+    v = normal[1] * scale;
+    if (normal[2] < 0.0f)
+    {
+        const float foldedU = (1.0f - std::fabs(v)) * SignNotZero(u);
+        const float foldedV = (1.0f - std::fabs(u)) * SignNotZero(v);
+        u = foldedU;
+        v = foldedV;
+    }
+}
+
+// Point of the octahedron for square coordinates (u, v), not normalized.
+// Folded points move back by t = |u| + |v| - 1 towards the axes, which
+// is (1 - |v|) * sign(u), (1 - |u|) * sign(v) without a branch.
+void Unfold(float u, float v, float direction[3])
+{
+    direction[2] = 1.0f - std::fabs(u) - std::fabs(v);
+    const float t = std::max(-direction[2], 0.0f);
+    direction[0] = u - SignNotZero(u) * t;
+    direction[1] = v - SignNotZero(v) * t;
+}
+
+inline float FromSnorm16(int32_t value)
+{
+    return std::fmax(float(value) / kSnorm16Max, -1.0f);
+}
+
+inline uint32_t PackSnorm16(int32_t x, int32_t y)
+{
+    return (uint32_t(x) & 0xFFFF) | (uint32_t(y) << 16);
+}
+
+} // namespace
+
+uint32_t PackNormal(const float normal[3])
+{
+    float u;
+    float v;
+    ToOctahedron(normal, u, v);
+
+    // Rounding each coordinate on its own is up to twice as far off as the
+    // best of the four neighbouring grid points. Candidates are ranked by
+    // the squared sine of their angle to `normal`, |d x n|^2 / |d|^2, which
+    // needs no square root and, unlike a float dot product, does not round
+    // to the same value for all of them.
+    int32_t baseX = static_cast<int32_t>(u * kSnorm16Max);
+    int32_t baseY = static_cast<int32_t>(v * kSnorm16Max);
+    baseX -= float(baseX) > u * kSnorm16Max ? 1 : 0;
+    baseY -= float(baseY) > v * kSnorm16Max ? 1 : 0;
+
+    uint32_t best = PackSnorm16(0, 0);
+    float bestCross = 1.0f;
+    float bestLength = 0.0f;
+    for (int32_t dy = 0; dy < 2; dy++)
+    {
+        for (int32_t dx = 0; dx < 2; dx++)
+        {
+            const int32_t x = std::min(baseX + dx, 32767);
+            const int32_t y = std::min(baseY + dy, 32767);
+            float d[3];
+            Unfold(float(x) * (1.0f / kSnorm16Max), float(y) * (1.0f / kSnorm16Max), d);
+            const float cx = d[1] * normal[2] - d[2] * normal[1];
+            const float cy = d[2] * normal[0] - d[0] * normal[2];
+            const float cz = d[0] * normal[1] - d[1] * normal[0];
+            const float cross = cx * cx + cy * cy + cz * cz;
+            const float length = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+            // cross / length < bestCross / bestLength, written to compile
+            // to conditional moves: which candidate wins is random
+            const bool better = cross * bestLength < bestCross * length;
+            bestCross = better ? cross : bestCross;
+            bestLength = better ? length : bestLength;
+            best = better ? PackSnorm16(x, y) : best;
+        }
+    }
+    return best;
+}
+
+void UnpackNormal(uint32_t packed, float normal[3])
+{
+    const int32_t x = static_cast<int16_t>(packed & 0xFFFF);
+    const int32_t y = static_cast<int16_t>(packed >> 16);
+    Unfold(FromSnorm16(x), FromSnorm16(y), normal);
+    const float scale = 1.0f / std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    normal[0] *= scale;
+    normal[1] *= scale;
+    normal[2] *= scale;
+}
+
+// ============================================================================
+// Half Floats
+// ============================================================================
+uint16_t FloatToHalf(float value)
+{
+    const uint32_t bits = std::bit_cast<uint32_t>(value);
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const uint32_t magnitude = bits & 0x7FFFFFFF;
+
+    if (magnitude >= 0x7F800000)
+    {
+        // Infinity, or a quiet NaN
+        return static_cast<uint16_t>(sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x0200 : 0));
+    }
+    if (magnitude > 0x477FE000)
+    {
+        // Above 65504, the largest finite half
+        return static_cast<uint16_t>(sign | 0x7BFF);
+    }
+    if (magnitude < 0x38800000)
+    {
+        // Below 2^-14 halfs are subnormal: a multiple of 2^-24. The product
+        // is exact and nearbyint() rounds to even; 1024 carries into the
+        // smallest normal half, which has the same encoding.
+        const float scaled = std::bit_cast<float>(magnitude) * 16777216.0f;
+        return static_cast<uint16_t>(sign | static_cast<uint32_t>(std::nearbyint(scaled)));
+    }
+
+    // Rebias the exponent (127 -> 15) and round the mantissa from 23 to 10
+    // bits; a carry out of the mantissa correctly bumps the exponent
+    uint32_t half = (magnitude - 0x38000000) >> 13;
+    const uint32_t rest = magnitude & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+    {
+        half++;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+float HalfToFloat(uint16_t half)
+{
+    const uint32_t sign = uint32_t(half & 0x8000) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1F;
+    const uint32_t mantissa = half & 0x3FF;
+    if (exponent == 0)
+    {
+        const float magnitude = std::ldexp(float(mantissa), -24);
+        return sign ? -magnitude : magnitude;
+    }
+    if (exponent == 31)
+    {
+        return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+    }
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+uint32_t PackTexcoord(const float texcoord[2])
+{
+    return uint32_t(FloatToHalf(texcoord[0])) | (uint32_t(FloatToHalf(texcoord[1])) << 16);
+}
+
+void UnpackTexcoord(uint32_t packed, float texcoord[2])
+{
+    texcoord[0] = HalfToFloat(static_cast<uint16_t>(packed & 0xFFFF));
+    texcoord[1] = HalfToFloat(static_cast<uint16_t>(packed >> 16));
+}
+
+// ============================================================================
+// Vertices
+// ============================================================================
+void PackVertex(const MeshVertex& vertex, GPUPosition& position, GPUVertex& attributes)
+{
+    memcpy(position.position, vertex.position, sizeof(position.position));
+    attributes.normal = PackNormal(vertex.normal);
+    attributes.texcoord = PackTexcoord(vertex.texcoord);
+}
+
+MeshVertex UnpackVertex(const GPUPosition& position, const GPUVertex& attributes)
+{
+    MeshVertex unpacked = {};
+    memcpy(unpacked.position, position.position, sizeof(unpacked.position));
+    UnpackNormal(attributes.normal, unpacked.normal);
+    UnpackTexcoord(attributes.texcoord, unpacked.texcoord);
+    return unpacked;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// ============================================================================
+// Vertex Format
+// Packing between MeshVertex (40 bytes, used while building meshes) and the
+// GPU streams: a 12-byte GPUPosition, copied as it is, and an 8-byte
+// GPUVertex. Normals are mapped onto an octahedron unfolded into a square
+// and stored as two snorm16. Texcoords become IEEE half floats, as HLSL's
+// f16tof32() reads them.
+// ============================================================================
+
+#include "scene_geometry.h"
+
+// Round-trip bounds, checked by scene_core_tests (vertex_format group).
+// Normal: angle between a unit normal and its decoded version, in radians.
+constexpr float kPackedNormalMaxError = 5.0e-5f;   // About 0.003 degrees
+// Texcoord: |decoded - value| <= max(|value| * 2^-11, 2^-25) within the half
+// range; larger magnitudes clamp to +-65504.
+constexpr float kPackedTexcoordRelativeError = 1.0f / 2048.0f;
+constexpr float kPackedTexcoordAbsoluteError = 1.0f / 33554432.0f;
+
+// Octahedral encoding of a unit normal. Of the four snorm16 pairs around
+// the exact point, the one that decodes closest to `normal` is kept. A zero
+// vector packs as +Z.
+uint32_t PackNormal(const float normal[3]);
+void UnpackNormal(uint32_t packed, float normal[3]);
+
+// Round to nearest even; NaN and infinity are kept, finite values beyond
+// the half range clamp to +-65504
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t half);
+
+uint32_t PackTexcoord(const float texcoord[2]);
+void UnpackTexcoord(uint32_t packed, float texcoord[2]);
+
+void PackVertex(const MeshVertex& vertex, GPUPosition& position, GPUVertex& attributes);
+// Pads are zero
+MeshVertex UnpackVertex(const GPUPosition& position, const GPUVertex& attributes);
@@ -0,0 +1,331 @@
+#include "vertex_transform.h"
+
+#include <algorithm>
+#include <cmath>
+
+// SSE is part of every x86-64 target; AVX needs a runtime check and is
+// compiled per function so the rest of the build keeps its baseline ISA
+#ifdef HANDMADE_MATH__USE_SSE
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define VERTEX_TRANSFORM_AVX 1
+#define TARGET_AVX __attribute__((target("avx")))
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define VERTEX_TRANSFORM_AVX 1
+#define TARGET_AVX
+#endif
+#endif
+
+VertexTransform::VertexTransform(const HMM_Mat4& transform)
+    : position(transform)
+{
+    // The cofactor matrix is the inverse transpose times the determinant.
+    // Only its sign matters once normals are normalized, and unlike the
+    // inverse it stays usable for flattening transforms (determinant 0).
+    HMM_Vec3 c0 = transform.Columns[0].XYZ;
+    HMM_Vec3 c1 = transform.Columns[1].XYZ;
+    HMM_Vec3 c2 = transform.Columns[2].XYZ;
+    normal.Columns[0] = HMM_Cross(c1, c2);
+    normal.Columns[1] = HMM_Cross(c2, c0);
+    normal.Columns[2] = HMM_Cross(c0, c1);
+    if (HMM_DotV3(normal.Columns[2], c2) < 0.0f)
+    {
+        // Mirroring transforms keep normals on the same side of the surface
+        normal = HMM_MulM3F(normal, -1.0f);
+    }
+}
+
+// ============================================================================
+// Scalar
+// The reference every SIMD path must match: the same operations in the same
+// order as HMM_MulM4V4 (positions) and HMM_NormV3 (normals), without FMA.
+// ============================================================================
+static void TransformScalar(const VertexTransform& transform, MeshVertex* vertices, size_t count)
+{
+    const HMM_Mat4& m = transform.position;
+    const HMM_Mat3& n = transform.normal;
+    for (size_t i = 0; i < count; i++)
+    {
+        MeshVertex& vertex = vertices[i];
+        const float x = vertex.position[0];
+        const float y = vertex.position[1];
+        const float z = vertex.position[2];
+        for (int r = 0; r < 3; r++)
+        {
+            vertex.position[r] = ((x * m.Columns[0].Elements[r] + y * m.Columns[1].Elements[r]) +
+                                  z * m.Columns[2].Elements[r]) + m.Columns[3].Elements[r];
+        }
+
+        const float nx = vertex.normal[0];
+        const float ny = vertex.normal[1];
+        const float nz = vertex.normal[2];
+        float world[3];
+        for (int r = 0; r < 3; r++)
+        {
+            world[r] = (nx * n.Columns[0].Elements[r] + ny * n.Columns[1].Elements[r]) + nz * n.Columns[2].Elements[r];
+        }
+        const float lengthSquared = (world[0] * world[0] + world[1] * world[1]) + world[2] * world[2];
+        if (lengthSquared > 0.0f)
+        {
+            const float scale = 1.0f / std::sqrt(lengthSquared);
+            vertex.normal[0] = world[0] * scale;
+            vertex.normal[1] = world[1] * scale;
+            vertex.normal[2] = world[2] * scale;
+        }
+        else
+        {
+            vertex.normal[0] = 0.0f;
+            vertex.normal[1] = 1.0f;
+            vertex.normal[2] = 0.0f;
+        }
+        vertex.pad0 = 0.0f;
+        vertex.pad1 = 0.0f;
+    }
+}
+
+#ifdef HANDMADE_MATH__USE_SSE
+// ============================================================================
+// SSE
+// The position (and normal) of four vertices, each loaded with its pad as
+// one register, transposes into x, y, z and pad registers.
+// ============================================================================
+static void TransformSSE(const VertexTransform& transform, MeshVertex* vertices, size_t count)
+{
+    __m128 m[4][3];
+    __m128 n[3][3];
+    for (int r = 0; r < 3; r++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            m[c][r] = _mm_set1_ps(transform.position.Columns[c].Elements[r]);
+        }
+        for (int c = 0; c < 3; c++)
+        {
+            n[c][r] = _mm_set1_ps(transform.normal.Columns[c].Elements[r]);
+        }
+    }
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (size_t i = 0; i + 4 <= count; i += 4)
+    {
+        MeshVertex* v = vertices + i;
+
+        __m128 x = _mm_loadu_ps(v[0].position);
+        __m128 y = _mm_loadu_ps(v[1].position);
+        __m128 z = _mm_loadu_ps(v[2].position);
+        __m128 w = _mm_loadu_ps(v[3].position);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        __m128 p[3];
+        for (int r = 0; r < 3; r++)
+        {
+            p[r] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m[0][r]), _mm_mul_ps(y, m[1][r])),
+                                         _mm_mul_ps(z, m[2][r])), m[3][r]);
+        }
+        w = zero;
+        _MM_TRANSPOSE4_PS(p[0], p[1], p[2], w);
+        _mm_storeu_ps(v[0].position, p[0]);
+        _mm_storeu_ps(v[1].position, p[1]);
+        _mm_storeu_ps(v[2].position, p[2]);
+        _mm_storeu_ps(v[3].position, w);
+
+        x = _mm_loadu_ps(v[0].normal);
+        y = _mm_loadu_ps(v[1].normal);
+        z = _mm_loadu_ps(v[2].normal);
+        w = _mm_loadu_ps(v[3].normal);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        __m128 q[3];
+        for (int r = 0; r < 3; r++)
+        {
+            q[r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, n[0][r]), _mm_mul_ps(y, n[1][r])), _mm_mul_ps(z, n[2][r]));
+        }
+        __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(q[0], q[0]), _mm_mul_ps(q[1], q[1])),
+                                          _mm_mul_ps(q[2], q[2]));
+        __m128 scale = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+        __m128 given = _mm_cmpgt_ps(lengthSquared, zero);
+        for (int r = 0; r < 3; r++)
+        {
+            __m128 fallback = r == 1 ? one : zero;
+            q[r] = _mm_or_ps(_mm_and_ps(given, _mm_mul_ps(q[r], scale)), _mm_andnot_ps(given, fallback));
+        }
+        w = zero;
+        _MM_TRANSPOSE4_PS(q[0], q[1], q[2], w);
+        _mm_storeu_ps(v[0].normal, q[0]);
+        _mm_storeu_ps(v[1].normal, q[1]);
+        _mm_storeu_ps(v[2].normal, q[2]);
+        _mm_storeu_ps(v[3].normal, w);
+    }
+}
+#endif
+
+#ifdef VERTEX_TRANSFORM_AVX
+// ============================================================================
+// AVX
+// Vertices i and i + 4 share a register, one per 128-bit lane. The in-lane
+// shuffles then transpose both groups of four at once.
+// ============================================================================
+TARGET_AVX static inline void Transpose8(__m256& a, __m256& b, __m256& c, __m256& d)
+{
+    __m256 ab0 = _mm256_unpacklo_ps(a, b);
+    __m256 cd0 = _mm256_unpacklo_ps(c, d);
+    __m256 ab1 = _mm256_unpackhi_ps(a, b);
+    __m256 cd1 = _mm256_unpackhi_ps(c, d);
+    a = _mm256_shuffle_ps(ab0, cd0, _MM_SHUFFLE(1, 0, 1, 0));
+    b = _mm256_shuffle_ps(ab0, cd0, _MM_SHUFFLE(3, 2, 3, 2));
+    c = _mm256_shuffle_ps(ab1, cd1, _MM_SHUFFLE(1, 0, 1, 0));
+    d = _mm256_shuffle_ps(ab1, cd1, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+TARGET_AVX static inline __m256 LoadPair(const float* low, const float* high)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low)), _mm_loadu_ps(high), 1);
+}
+
+TARGET_AVX static inline void StorePair(float* low, float* high, __m256 value)
+{
+    _mm_storeu_ps(low, _mm256_castps256_ps128(value));
+    _mm_storeu_ps(high, _mm256_extractf128_ps(value, 1));
+}
+
+TARGET_AVX static void TransformAVX(const VertexTransform& transform, MeshVertex* vertices, size_t count)
+{
+    __m256 m[4][3];
+    __m256 n[3][3];
+    for (int r = 0; r < 3; r++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            m[c][r] = _mm256_set1_ps(transform.position.Columns[c].Elements[r]);
+        }
+        for (int c = 0; c < 3; c++)
+        {
+            n[c][r] = _mm256_set1_ps(transform.normal.Columns[c].Elements[r]);
+        }
+    }
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    for (size_t i = 0; i + 8 <= count; i += 8)
+    {
+        MeshVertex* v = vertices + i;
+
+        __m256 x = LoadPair(v[0].position, v[4].position);
+        __m256 y = LoadPair(v[1].position, v[5].position);
+        __m256 z = LoadPair(v[2].position, v[6].position);
+        __m256 w = LoadPair(v[3].position, v[7].position);
+        Transpose8(x, y, z, w);
+        __m256 p[3];
+        for (int r = 0; r < 3; r++)
+        {
+            p[r] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, m[0][r]), _mm256_mul_ps(y, m[1][r])),
+                                               _mm256_mul_ps(z, m[2][r])), m[3][r]);
+        }
+        w = zero;
+        Transpose8(p[0], p[1], p[2], w);
+        StorePair(v[0].position, v[4].position, p[0]);
+        StorePair(v[1].position, v[5].position, p[1]);
+        StorePair(v[2].position, v[6].position, p[2]);
+        StorePair(v[3].position, v[7].position, w);
+
+        x = LoadPair(v[0].normal, v[4].normal);
+        y = LoadPair(v[1].normal, v[5].normal);
+        z = LoadPair(v[2].normal, v[6].normal);
+        w = LoadPair(v[3].normal, v[7].normal);
+        Transpose8(x, y, z, w);
+        __m256 q[3];
+        for (int r = 0; r < 3; r++)
+        {
+            q[r] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, n[0][r]), _mm256_mul_ps(y, n[1][r])),
+                                 _mm256_mul_ps(z, n[2][r]));
+        }
+        __m256 lengthSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(q[0], q[0]), _mm256_mul_ps(q[1], q[1])),
+                                             _mm256_mul_ps(q[2], q[2]));
+        __m256 scale = _mm256_div_ps(one, _mm256_sqrt_ps(lengthSquared));
+        __m256 given = _mm256_cmp_ps(lengthSquared, zero, _CMP_GT_OQ);
+        for (int r = 0; r < 3; r++)
+        {
+            q[r] = _mm256_blendv_ps(r == 1 ? one : zero, _mm256_mul_ps(q[r], scale), given);
+        }
+        w = zero;
+        Transpose8(q[0], q[1], q[2], w);
+        StorePair(v[0].normal, v[4].normal, q[0]);
+        StorePair(v[1].normal, v[5].normal, q[1]);
+        StorePair(v[2].normal, v[6].normal, q[2]);
+        StorePair(v[3].normal, v[7].normal, w);
+    }
+}
+
+static bool CPUHasAVX()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    // CPUID.1:ECX bit 28 is AVX; bit 27 (OSXSAVE) plus XCR0 tell whether
+    // the OS saves the YMM registers
+    int info[4];
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    return osxsave && avx && (_xgetbv(0) & 6) == 6;
+#else
+    return __builtin_cpu_supports("avx");
+#endif
+}
+#endif
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+VertexTransformPath BestVertexTransformPath()
+{
+#if defined(VERTEX_TRANSFORM_AVX)
+    static const bool hasAVX = CPUHasAVX();
+    return hasAVX ? VertexTransformPath::AVX : VertexTransformPath::SSE;
+#elif defined(HANDMADE_MATH__USE_SSE)
+    return VertexTransformPath::SSE;
+#else
+    return VertexTransformPath::Scalar;
+#endif
+}
+
+const char* VertexTransformPathName(VertexTransformPath path)
+{
+    switch (path)
+    {
+    case VertexTransformPath::SSE: return "sse";
+    case VertexTransformPath::AVX: return "avx";
+    default: return "scalar";
+    }
+}
+
+void TransformVertices(const VertexTransform& transform, std::span<MeshVertex> vertices, VertexTransformPath path)
+{
+    // Paths the build or CPU lacks fall back to the next narrower one
+    size_t done = 0;
+#ifdef VERTEX_TRANSFORM_AVX
+    if (path == VertexTransformPath::AVX && BestVertexTransformPath() == VertexTransformPath::AVX)
+    {
+        TransformAVX(transform, vertices.data(), vertices.size());
+        done = vertices.size() & ~size_t(7);
+    }
+#endif
+#ifdef HANDMADE_MATH__USE_SSE
+    if (path != VertexTransformPath::Scalar)
+    {
+        TransformSSE(transform, vertices.data() + done, vertices.size() - done);
+        done += (vertices.size() - done) & ~size_t(3);
+
+        // The last few vertices go through SSE too, padded to a full block:
+        // compilers may contract the scalar code into FMA when the target
+        // has it, which would round differently from the vector lanes
+        if (done < vertices.size())
+        {
+            MeshVertex block[4] = {};
+            std::copy(vertices.begin() + done, vertices.end(), block);
+            TransformSSE(transform, block, 4);
+            std::copy(block, block + (vertices.size() - done), vertices.begin() + done);
+        }
+        return;
+    }
+#endif
+    TransformScalar(transform, vertices.data() + done, vertices.size() - done);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+// ============================================================================
+// Vertex Transform
+// Bakes an object-to-world transform into a batch of MeshVertex records in
+// place. Four (SSE) or eight (AVX) vertices are transposed into registers
+// holding one component each, so every lane runs the same multiply-adds.
+// Positions match HMM_MulM4V4 bit for bit on every path; normals go through
+// the inverse transpose, so they stay perpendicular under non-uniform scale.
+// ============================================================================
+
+#include "scene_geometry.h"
+
+#include <span>
+
+// Computed once per mesh
+struct VertexTransform
+{
+    HMM_Mat4 position;  // Object to world
+    HMM_Mat3 normal;    // Inverse transpose of the upper 3x3, up to scale
+
+    explicit VertexTransform(const HMM_Mat4& transform);
+};
+
+enum class VertexTransformPath
+{
+    Scalar,
+    SSE,        // 4 vertices per iteration
+    AVX         // 8 vertices per iteration, picked at runtime
+};
+
+// Widest path this CPU supports
+VertexTransformPath BestVertexTransformPath();
+const char* VertexTransformPathName(VertexTransformPath path);
+
+// Transform local-space positions and normals of `vertices` to world space
+// and normalize the normals. A zero normal means "not given" and becomes +Y.
+// Texcoords are left alone and the pad fields are zeroed. The SIMD paths
+// give the same bytes; so does Scalar unless the compiler fuses its
+// multiply-adds (FMA targets).
+void TransformVertices(const VertexTransform& transform, std::span<MeshVertex> vertices,
+                       VertexTransformPath path = BestVertexTransformPath());
@@ -0,0 +1,80 @@
+#include "test_registry.h"
+#include "fixtures.h"
+
+#include "../scene_core/vertex_dedup.h"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+namespace
+{
+
+// Vertex numbers a std::map filled in one pass over the corners assigns
+std::vector<uint32_t> ReferenceDedup(std::span<const tinyobj_vertex_index_t> corners, size_t& vertexCount)
+{
+    std::map<std::tuple<int, int, int>, uint32_t> vertices;
+    std::vector<uint32_t> cornerVertex(corners.size());
+    for (size_t c = 0; c < corners.size(); c++)
+    {
+        const tinyobj_vertex_index_t& corner = corners[c];
+        auto key = std::make_tuple(corner.v_idx, std::max(corner.vt_idx, -1), std::max(corner.vn_idx, -1));
+        cornerVertex[c] = vertices.try_emplace(key, static_cast<uint32_t>(vertices.size())).first->second;
+    }
+    vertexCount = vertices.size();
+    return cornerVertex;
+}
+
+void CheckBothMethods(std::span<const tinyobj_vertex_index_t> corners, size_t attributeCount)
+{
+    size_t referenceCount = 0;
+    const std::vector<uint32_t> reference = ReferenceDedup(corners, referenceCount);
+    for (VertexDedup::Method method : { VertexDedup::Method::Hash, VertexDedup::Method::Radix })
+    {
+        VertexDedup dedup;
+        dedup.Build(corners, attributeCount, method);
+        CHECK(dedup.cornerVertex == reference);
+        CHECK(dedup.VertexCount() == referenceCount);
+        for (size_t v = 0; v < dedup.firstCorner.size(); v++)
+        {
+            CHECK(dedup.cornerVertex[dedup.firstCorner[v]] == v);
+        }
+    }
+}
+
+} // namespace
+
+TEST(dedup, MatchesMap)
+{
+    size_t attributeCount = 0;
+    std::vector<tinyobj_vertex_index_t> corners = GridCorners(48, 40, attributeCount);
+    CheckBothMethods(corners, attributeCount);
+}
+
+// The old 64-bit key ((v << 40) | (vn << 20) | vt) merged these
+TEST(dedup, LargeIndicesStayApart)
+{
+    const int big = 1 << 20;
+    const tinyobj_vertex_index_t corners[] = {
+        { 0, big, 0 }, { 0, 0, 1 }, { 1, 2 * big, 3 }, { 1, 0, 5 }, { 0, big, 0 }, { big, 0, 0 }, { 0, 0, 0 },
+    };
+    CheckBothMethods(corners, size_t(2 * big + 1));
+}
+
+// tinyobj leaves a large negative index for a missing vt or vn, the chunked
+// parser -1; both mean the same vertex
+TEST(dedup, MissingIndicesMatch)
+{
+    const tinyobj_vertex_index_t corners[] = {
+        { 0, -1, -1 }, { 0, -2147483647, -1 }, { 0, -1, -2147483647 }, { 1, 0, -1 }, { 1, 0, -5 }, { 1, -1, 0 },
+    };
+    for (VertexDedup::Method method : { VertexDedup::Method::Hash, VertexDedup::Method::Radix })
+    {
+        VertexDedup dedup;
+        dedup.Build(corners, 2, method);
+        CHECK(dedup.VertexCount() == 3);
+        CHECK(dedup.cornerVertex[0] == dedup.cornerVertex[1] && dedup.cornerVertex[1] == dedup.cornerVertex[2]);
+        CHECK(dedup.cornerVertex[3] == dedup.cornerVertex[4]);
+        CHECK(dedup.cornerVertex[5] != dedup.cornerVertex[3]);
+    }
+}
@@ -0,0 +1,177 @@
+#include "fixtures.h"
+
+#include <HandmadeMath.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <cmath>
+
+std::vector<uint32_t> GridIndices(uint32_t width, uint32_t height)
+{
+    std::vector<uint32_t> indices;
+    indices.reserve(size_t(width - 1) * (height - 1) * 6);
+    for (uint32_t y = 0; y + 1 < height; y++)
+    {
+        for (uint32_t x = 0; x + 1 < width; x++)
+        {
+            const uint32_t v = y * width + x;
+            indices.insert(indices.end(), { v, v + 1, v + width + 1, v, v + width + 1, v + width });
+        }
+    }
+    return indices;
+}
+
+std::vector<tinyobj_vertex_index_t> GridCorners(int width, int height, size_t& attributeCount)
+{
+    const int positionCount = width * height;
+
+    std::vector<tinyobj_vertex_index_t> corners;
+    corners.reserve(size_t(width - 1) * (height - 1) * 6);
+    int face = 0;
+    for (int y = 0; y + 1 < height; y++)
+    {
+        for (int x = 0; x + 1 < width; x++)
+        {
+            const int cell[6][2] = { { x, y }, { x + 1, y }, { x + 1, y + 1 }, { x, y }, { x + 1, y + 1 }, { x, y + 1 } };
+            for (int k = 0; k < 6; k++)
+            {
+                if (k % 3 == 0)
+                {
+                    face++;
+                }
+                int v = cell[k][1] * width + cell[k][0];
+                int vt = (y % 11 == 10) ? -1 : (y % 2 == 1 && cell[k][0] % 5 == 0) ? v + positionCount : v;
+                int vn = (y % 3 == 0) ? face - 1 : (y % 3 == 1) ? v : -1;
+                corners.push_back({ v, vt, vn });
+            }
+        }
+    }
+    attributeCount = std::max(size_t(positionCount) * 2, size_t(face));
+    return corners;
+}
+
+TestMesh BumpySphere(uint32_t segments, uint32_t rings)
+{
+    TestMesh mesh;
+    for (uint32_t r = 0; r <= rings; r++)
+    {
+        for (uint32_t s = 0; s <= segments; s++)
+        {
+            const float theta = HMM_PI32 * float(r) / float(rings);
+            const float phi = 2.0f * HMM_PI32 * float(s % segments) / float(segments);
+            HMM_Vec3 n = HMM_V3(sinf(theta) * cosf(phi), sinf(theta) * sinf(phi), cosf(theta));
+            if (r == 0 || r == rings)
+            {
+                n = HMM_V3(0.0f, 0.0f, r == 0 ? 1.0f : -1.0f);
+            }
+            const float radius = 1.0f + 0.02f * sinf(8.0f * theta) * sinf(8.0f * phi);
+            MeshVertex vertex = {};
+            vertex.position[0] = n.X * radius;
+            vertex.position[1] = n.Y * radius;
+            vertex.position[2] = n.Z * radius;
+            vertex.normal[0] = n.X;
+            vertex.normal[1] = n.Y;
+            vertex.normal[2] = n.Z;
+            vertex.texcoord[0] = float(s) / float(segments);
+            vertex.texcoord[1] = float(r) / float(rings);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+    for (uint32_t r = 0; r < rings; r++)
+    {
+        for (uint32_t s = 0; s < segments; s++)
+        {
+            const uint32_t v = r * (segments + 1) + s;
+            const uint32_t below = v + segments + 1;
+            if (r > 0)
+            {
+                mesh.indices.insert(mesh.indices.end(), { v, below, v + 1 });
+            }
+            if (r + 1 < rings)
+            {
+                mesh.indices.insert(mesh.indices.end(), { v + 1, below, below + 1 });
+            }
+        }
+    }
+    return mesh;
+}
+
+std::vector<std::array<uint32_t, 3>> CanonicalTriangles(std::span<const uint32_t> indices)
+{
+    std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+    for (size_t t = 0; t < triangles.size(); t++)
+    {
+        const uint32_t* corner = &indices[t * 3];
+        size_t first = corner[1] < corner[0] ? 1 : 0;
+        first = corner[2] < corner[first] ? 2 : first;
+        triangles[t] = { corner[first], corner[(first + 1) % 3], corner[(first + 2) % 3] };
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+size_t OpenEdges(std::span<const MeshVertex> vertices, std::span<const uint32_t> indices)
+{
+    std::map<std::array<float, 3>, uint32_t> positionIds;
+    std::vector<uint32_t> positionId(vertices.size());
+    for (size_t v = 0; v < vertices.size(); v++)
+    {
+        const float* p = vertices[v].position;
+        positionId[v] = positionIds.try_emplace({ p[0], p[1], p[2] }, uint32_t(positionIds.size())).first->second;
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        const size_t next = i - i % 3 + (i % 3 + 1) % 3;
+        edges.emplace_back(positionId[indices[i]], positionId[indices[next]]);
+    }
+    std::sort(edges.begin(), edges.end());
+    size_t open = 0;
+    for (const auto& [a, b] : edges)
+    {
+        open += std::binary_search(edges.begin(), edges.end(), std::make_pair(b, a)) ? 0 : 1;
+    }
+    return open;
+}
+
+TempDirectory::TempDirectory()
+{
+    std::random_device random;
+    std::error_code ec;
+    do
+    {
+        m_Path = std::filesystem::temp_directory_path(ec) / ("scene_core_tests_" + std::to_string(random()));
+    } while (!std::filesystem::create_directories(m_Path, ec) && !ec);
+}
+
+TempDirectory::~TempDirectory()
+{
+    std::error_code ec;
+    std::filesystem::remove_all(m_Path, ec);
+}
+
+bool WriteTextFile(const std::filesystem::path& path, std::string_view text)
+{
+    std::error_code ec;
+    const std::filesystem::file_time_type before = std::filesystem::last_write_time(path, ec);
+    const bool existed = !ec;
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(text.data(), std::streamsize(text.size()));
+        if (!file)
+        {
+            return false;
+        }
+    }
+    if (existed && std::filesystem::last_write_time(path, ec) <= before)
+    {
+        std::filesystem::last_write_time(path, before + std::chrono::seconds(1), ec);
+        return !ec;
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+// ============================================================================
+// Test Fixtures
+// Small deterministic meshes and helpers shared by the test groups.
+// ============================================================================
+
+#include "../scene_core/scene_geometry.h"
+
+#include <tinyobj_loader_c.h>
+
+#include <array>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Linear congruential values in [-1, 1), the same sequence on every platform
+class TestRandom
+{
+public:
+    explicit TestRandom(uint32_t seed) : m_State(seed) {}
+
+    float Next()
+    {
+        m_State = m_State * 1664525u + 1013904223u;
+        return float(m_State >> 8) / float(1 << 24) * 2.0f - 1.0f;
+    }
+
+private:
+    uint32_t m_State;
+};
+
+// Two triangles per cell of a width x height vertex grid, in row order
+std::vector<uint32_t> GridIndices(uint32_t width, uint32_t height);
+
+// OBJ corners of a width x height position grid: texcoords get seams
+// (duplicated columns), normals are per face on some rows and per position
+// on others, and some rows lack vt or vn. `attributeCount` receives the
+// largest of the v/vt/vn counts.
+std::vector<tinyobj_vertex_index_t> GridCorners(int width, int height, size_t& attributeCount);
+
+// Closed UV sphere with bumps and a texcoord seam. The rows at the poles
+// have one triangle per segment, so no triangle is degenerate.
+struct TestMesh
+{
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t> indices;
+};
+TestMesh BumpySphere(uint32_t segments, uint32_t rings);
+
+// Each triangle rotated to start at its smallest index, sorted: equal for
+// two index buffers that only differ in triangle order
+std::vector<std::array<uint32_t, 3>> CanonicalTriangles(std::span<const uint32_t> indices);
+
+// Directed edges of `indices` whose reverse is missing, with vertices at
+// the same position counted as one
+size_t OpenEdges(std::span<const MeshVertex> vertices, std::span<const uint32_t> indices);
+
+// Empty directory under the system temp directory, removed with everything
+// in it when the fixture goes out of scope
+class TempDirectory
+{
+public:
+    TempDirectory();
+    ~TempDirectory();
+
+    TempDirectory(const TempDirectory&) = delete;
+    TempDirectory& operator=(const TempDirectory&) = delete;
+
+    const std::filesystem::path& Path() const { return m_Path; }
+
+private:
+    std::filesystem::path m_Path;
+};
+
+// Replace the contents of `path` with `text`. The modification time moves
+// forward even where the file system keeps it in whole seconds, so a
+// FileWatcher sees every write.
+bool WriteTextFile(const std::filesystem::path& path, std::string_view text);
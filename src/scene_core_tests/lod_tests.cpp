@@ -0,0 +1,66 @@
+#include "test_registry.h"
+#include "fixtures.h"
+
+#include "../scene_core/mesh_simplify.h"
+#include "../scene_core/vertex_cache.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+SimplifyVertices Describe(const std::vector<MeshVertex>& vertices)
+{
+    const MeshVertex& first = vertices.front();
+    return { first.position, first.normal, first.texcoord, sizeof(MeshVertex), vertices.size() };
+}
+
+} // namespace
+
+// Every level indexes the shared vertices, is coarser and no more accurate
+// than the one before and keeps the closed mesh closed
+TEST(lod, SphereChain)
+{
+    TestMesh sphere = BumpySphere(96, 48);
+    OptimizeVertexCache(sphere.indices, sphere.vertices.size());
+    RemapVertices(sphere.vertices, OptimizeVertexFetch(sphere.indices, sphere.vertices.size()));
+    const size_t fullIndexCount = sphere.indices.size();
+    CHECK(OpenEdges(sphere.vertices, sphere.indices) == 0);
+
+    std::vector<MeshLOD> lods = BuildLODChain(Describe(sphere.vertices), sphere.indices);
+    CHECK(lods.size() >= 3);
+    CHECK(lods.front().indexOffset == 0 && lods.front().indexCount == fullIndexCount && lods.front().error == 0.0f);
+    for (size_t level = 1; level < lods.size(); level++)
+    {
+        const MeshLOD& lod = lods[level];
+        CHECK(uint64_t(lod.indexOffset) + lod.indexCount <= sphere.indices.size());
+        std::span<const uint32_t> levelIndices = std::span(sphere.indices).subspan(lod.indexOffset, lod.indexCount);
+        CHECK(lod.indexCount % 3 == 0);
+        CHECK(std::all_of(levelIndices.begin(), levelIndices.end(),
+            [&](uint32_t i) { return i < sphere.vertices.size(); }));
+        CHECK(lod.indexCount < lods[level - 1].indexCount);
+        CHECK(lod.error >= lods[level - 1].error && std::isfinite(lod.error));
+        CHECK(OpenEdges(sphere.vertices, levelIndices) == 0);
+    }
+}
+
+TEST(lod, StopsAtMinTriangles)
+{
+    TestMesh sphere = BumpySphere(32, 16);
+    const uint32_t fullTriangles = uint32_t(sphere.indices.size() / 3);
+
+    LODSettings settings;
+    settings.minTriangles = fullTriangles;
+    std::vector<MeshLOD> lods = BuildLODChain(Describe(sphere.vertices), sphere.indices, settings);
+    CHECK(lods.size() == 1);
+    CHECK(sphere.indices.size() == size_t(fullTriangles) * 3);
+
+    settings.minTriangles = fullTriangles / 3;
+    lods = BuildLODChain(Describe(sphere.vertices), sphere.indices, settings);
+    CHECK(lods.size() >= 2);
+    for (const MeshLOD& lod : lods)
+    {
+        CHECK(lod.indexCount / 3 >= settings.minTriangles);
+    }
+}
@@ -0,0 +1,116 @@
+#include "test_registry.h"
+#include "fixtures.h"
+
+#include "../scene_core/mitsuba_parser.h"
+
+namespace
+{
+
+// A material library with its own defaults; the sphere makes it more than
+// definitions, so every include applies it again
+const char* kLibraryXML =
+    "<scene version=\"3.0.0\">\n"
+    "    <default name=\"albedo\" value=\"0.2 0.4 0.6\"/>\n"
+    "    <default name=\"radius\" value=\"0.25\"/>\n"
+    "    <bsdf type=\"diffuse\" id=\"library\">\n"
+    "        <rgb name=\"reflectance\" value=\"$albedo\"/>\n"
+    "    </bsdf>\n"
+    "    <shape type=\"sphere\">\n"
+    "        <float name=\"radius\" value=\"$radius\"/>\n"
+    "        <ref id=\"library\"/>\n"
+    "    </shape>\n"
+    "</scene>\n";
+
+bool Near(HMM_Vec3 a, HMM_Vec3 b)
+{
+    return HMM_LenV3(HMM_SubV3(a, b)) < 1e-6f;
+}
+
+} // namespace
+
+// The second include finds the fragment under the values its own defaults
+// set, so it is parsed once and both copies resolve to those values
+TEST(parser, IncludeWithOwnDefaultsParsedOnce)
+{
+    TempDirectory directory;
+    CHECK(WriteTextFile(directory.Path() / "library.xml", kLibraryXML));
+    CHECK(WriteTextFile(directory.Path() / "scene.xml",
+        "<scene version=\"3.0.0\">\n"
+        "    <include filename=\"library.xml\"/>\n"
+        "    <include filename=\"library.xml\"/>\n"
+        "</scene>\n"));
+
+    MitsubaSceneParser parser;
+    CHECK(parser.Parse(directory.Path() / "scene.xml"));
+    CHECK(parser.stats.includeCount == 2);
+    CHECK(parser.stats.fragmentCount == 1);
+    CHECK(parser.includedFiles.size() == 1);
+    CHECK(parser.shapes.size() == 2);
+    for (const MitsubaSceneParser::Shape& shape : parser.shapes)
+    {
+        CHECK(shape.type == "sphere" && shape.radius == 0.25f && shape.materialRef == "library");
+    }
+    auto material = parser.materials.find("library");
+    CHECK(material != parser.materials.end() && Near(material->second.baseColor, HMM_V3(0.2f, 0.4f, 0.6f)));
+}
+
+// Caller parameters and earlier defaults win over the fragment's defaults
+TEST(parser, EarlierValuesOverrideDefaults)
+{
+    TempDirectory directory;
+    CHECK(WriteTextFile(directory.Path() / "library.xml", kLibraryXML));
+    CHECK(WriteTextFile(directory.Path() / "scene.xml",
+        "<scene version=\"3.0.0\">\n"
+        "    <default name=\"radius\" value=\"2\"/>\n"
+        "    <include filename=\"library.xml\"/>\n"
+        "    <include filename=\"library.xml\"/>\n"
+        "</scene>\n"));
+
+    MitsubaSceneParser parser;
+    parser.parameters["albedo"] = "1 0 0";
+    CHECK(parser.Parse(directory.Path() / "scene.xml"));
+    CHECK(parser.stats.fragmentCount == 1);
+    CHECK(parser.shapes.size() == 2);
+    for (const MitsubaSceneParser::Shape& shape : parser.shapes)
+    {
+        CHECK(shape.radius == 2.0f);
+    }
+    auto material = parser.materials.find("library");
+    CHECK(material != parser.materials.end() && Near(material->second.baseColor, HMM_V3(1.0f, 0.0f, 0.0f)));
+    CHECK(parser.parameters.at("radius") == "2");
+}
+
+// A value that changes between two includes gives the fragment a second parse
+TEST(parser, IncludeReparsedForNewValues)
+{
+    TempDirectory directory;
+    CHECK(WriteTextFile(directory.Path() / "ball.xml",
+        "<scene version=\"3.0.0\">\n"
+        "    <shape type=\"sphere\">\n"
+        "        <float name=\"radius\" value=\"$size\"/>\n"
+        "    </shape>\n"
+        "</scene>\n"));
+    CHECK(WriteTextFile(directory.Path() / "scene.xml",
+        "<scene version=\"3.0.0\">\n"
+        "    <default name=\"size\" value=\"3\"/>\n"
+        "    <include filename=\"ball.xml\"/>\n"
+        "    <include filename=\"ball.xml\"/>\n"
+        "</scene>\n"));
+
+    MitsubaSceneParser parser;
+    CHECK(parser.Parse(directory.Path() / "scene.xml"));
+    CHECK(parser.stats.fragmentCount == 1);
+    CHECK(parser.shapes.size() == 2 && parser.shapes.back().radius == 3.0f);
+
+    // The same fragment once before and once after the value is defined
+    CHECK(WriteTextFile(directory.Path() / "scene.xml",
+        "<scene version=\"3.0.0\">\n"
+        "    <include filename=\"ball.xml\"/>\n"
+        "    <default name=\"size\" value=\"3\"/>\n"
+        "    <include filename=\"ball.xml\"/>\n"
+        "</scene>\n"));
+    MitsubaSceneParser reordered;
+    CHECK(reordered.Parse(directory.Path() / "scene.xml"));
+    CHECK(reordered.stats.fragmentCount == 2);
+    CHECK(reordered.shapes.size() == 2 && reordered.shapes.back().radius == 3.0f);
+}
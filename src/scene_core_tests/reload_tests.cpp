@@ -0,0 +1,268 @@
+#include "test_registry.h"
+#include "fixtures.h"
+
+#include "../common/file_watcher.h"
+#include "../scene_core/mitsuba_parser.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+
+// A plain and a textured material, two OBJ files, a rectangle and an
+// environment map
+std::string SceneXML(std::string_view reflectance, float rectangleY)
+{
+    char rectangleMatrix[96];
+    snprintf(rectangleMatrix, sizeof(rectangleMatrix), "1 0 0 4 0 1 0 %g 0 0 1 0 0 0 0 1", rectangleY);
+    return std::string("<scene version=\"3.0.0\">\n"
+                       "    <bsdf type=\"diffuse\" id=\"plain\">\n"
+                       "        <rgb name=\"reflectance\" value=\"") + std::string(reflectance) + "\"/>\n"
+           "    </bsdf>\n"
+           "    <bsdf type=\"diffuse\" id=\"textured\">\n"
+           "        <texture name=\"reflectance\" type=\"bitmap\">\n"
+           "            <string name=\"filename\" value=\"albedo.tga\"/>\n"
+           "        </texture>\n"
+           "    </bsdf>\n"
+           "    <shape type=\"obj\">\n"
+           "        <string name=\"filename\" value=\"triangle.obj\"/>\n"
+           "        <ref id=\"plain\"/>\n"
+           "    </shape>\n"
+           "    <shape type=\"obj\">\n"
+           "        <string name=\"filename\" value=\"fan.obj\"/>\n"
+           "        <transform name=\"to_world\">\n"
+           "            <matrix value=\"1 0 0 2 0 1 0 0 0 0 1 0 0 0 0 1\"/>\n"
+           "        </transform>\n"
+           "        <ref id=\"textured\"/>\n"
+           "    </shape>\n"
+           "    <shape type=\"rectangle\">\n"
+           "        <transform name=\"to_world\">\n"
+           "            <matrix value=\"" + rectangleMatrix + "\"/>\n"
+           "        </transform>\n"
+           "        <ref id=\"plain\"/>\n"
+           "    </shape>\n"
+           "    <emitter type=\"envmap\">\n"
+           "        <string name=\"filename\" value=\"sky.tga\"/>\n"
+           "    </emitter>\n"
+           "</scene>\n";
+}
+
+const char* kTriangleOBJ = "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n";
+const char* kFanOBJ = "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv -1 1 0\nf 1 2 3\nf 1 3 4\nf 1 4 5\n";
+
+// 2x2 pixels of one color as an uncompressed 24-bit TGA
+std::string SolidTGA(uint8_t red, uint8_t green, uint8_t blue)
+{
+    std::string image(18, '\0');
+    image[2] = 2;   // Uncompressed true color
+    image[12] = 2;  // Width
+    image[14] = 2;  // Height
+    image[16] = 24; // Bits per pixel
+    for (int i = 0; i < 4; i++)
+    {
+        image += { char(blue), char(green), char(red) };
+    }
+    return image;
+}
+
+// The scene above on disk, loaded with local shapes as rt_scene --watch
+// does, and reloaded from whatever its FileWatcher reports
+class WatchedScene
+{
+public:
+    bool Load()
+    {
+        bool written = WriteTextFile(XMLPath(), SceneXML("0.8 0.1 0.1", 2.0f)) &&
+                       WriteTextFile(Path("triangle.obj"), kTriangleOBJ) && WriteTextFile(Path("fan.obj"), kFanOBJ) &&
+                       WriteTextFile(Path("albedo.tga"), SolidTGA(200, 100, 50)) &&
+                       WriteTextFile(Path("sky.tga"), SolidTGA(20, 40, 80));
+        parser = std::make_unique<MitsubaSceneParser>();
+        geometry.keepShapesLocal = true;
+        if (!written || !parser->Parse(XMLPath()) || !geometry.Load(*parser))
+        {
+            return false;
+        }
+        parser->DecodeTextures(geometry.UsedTextureIndices());
+
+        std::vector<std::filesystem::path> files = parser->ReferencedFiles();
+        files.push_back(XMLPath());
+        m_Watcher.SetFiles(std::move(files));
+        return true;
+    }
+
+    // rt_scene's reload without the uploads: an edited XML is parsed again,
+    // otherwise edited textures are invalidated, then the geometry is diffed
+    bool Reload(SceneDelta& delta)
+    {
+        // The first poll sees the new stamps, the second reports them settled
+        m_Watcher.Poll(std::chrono::milliseconds(0));
+        changed = m_Watcher.Poll(std::chrono::milliseconds(0));
+        invalidated.clear();
+
+        std::unique_ptr<MitsubaSceneParser> reparsed;
+        if (std::find(changed.begin(), changed.end(), XMLPath()) != changed.end())
+        {
+            reparsed = std::make_unique<MitsubaSceneParser>();
+            if (!reparsed->Parse(XMLPath()))
+            {
+                return false;
+            }
+            reparsed->AdoptDecodedTextures(*parser, changed);
+        }
+        else
+        {
+            invalidated = parser->InvalidateTextures(changed);
+        }
+        MitsubaSceneParser& scene = reparsed ? *reparsed : *parser;
+        if (!geometry.Reload(scene, changed, delta))
+        {
+            return false;
+        }
+        scene.DecodeTextures(geometry.UsedTextureIndices());
+        if (reparsed)
+        {
+            parser = std::move(reparsed);
+        }
+        return true;
+    }
+
+    std::filesystem::path Path(std::string_view file) const { return m_Directory.Path() / file; }
+    std::filesystem::path XMLPath() const { return Path("scene.xml"); }
+
+    // Index of the only mesh with `vertexCount` vertices, or -1
+    int MeshWithVertices(uint32_t vertexCount) const
+    {
+        auto it = std::find_if(geometry.meshes.begin(), geometry.meshes.end(),
+            [&](const MeshRange& mesh) { return mesh.vertexCount == vertexCount; });
+        bool unique = it != geometry.meshes.end() && std::count_if(geometry.meshes.begin(), geometry.meshes.end(),
+            [&](const MeshRange& mesh) { return mesh.vertexCount == vertexCount; }) == 1;
+        return unique ? int(it - geometry.meshes.begin()) : -1;
+    }
+
+    std::unique_ptr<MitsubaSceneParser> parser;
+    SceneGeometry geometry;
+    std::vector<std::filesystem::path> changed;
+    std::vector<int> invalidated;
+
+private:
+    TempDirectory m_Directory;
+    FileWatcher m_Watcher;
+};
+
+} // namespace
+
+TEST(reload, NoChange)
+{
+    WatchedScene scene;
+    CHECK(scene.Load());
+    SceneDelta delta;
+    CHECK(scene.Reload(delta));
+    CHECK(scene.changed.empty());
+    CHECK(delta.IsEmpty());
+}
+
+// A new color updates one material and nothing else
+TEST(reload, MaterialEdit)
+{
+    WatchedScene scene;
+    CHECK(scene.Load());
+    CHECK(WriteTextFile(scene.XMLPath(), SceneXML("0.2 0.1 0.1", 2.0f)));
+    SceneDelta delta;
+    CHECK(scene.Reload(delta));
+    CHECK(scene.changed == std::vector<std::filesystem::path>{ scene.XMLPath() });
+    CHECK(delta.materialRange.count == 1 && !delta.materialsResized);
+    CHECK(delta.rebuiltMeshes.empty());
+    CHECK(delta.vertexRanges.empty() && delta.indexRanges.empty());
+    CHECK(!delta.placementsChanged);
+}
+
+// A moved shape only updates the TLAS
+TEST(reload, MovedShape)
+{
+    WatchedScene scene;
+    CHECK(scene.Load());
+    const size_t meshCount = scene.geometry.meshes.size();
+    CHECK(WriteTextFile(scene.XMLPath(), SceneXML("0.8 0.1 0.1", 3.0f)));
+    SceneDelta delta;
+    CHECK(scene.Reload(delta));
+    CHECK(scene.changed == std::vector<std::filesystem::path>{ scene.XMLPath() });
+    CHECK(delta.placementsChanged);
+    CHECK(delta.vertexRanges.empty() && delta.indexRanges.empty());
+    CHECK(delta.rebuiltMeshes.empty() && scene.geometry.meshes.size() == meshCount);
+    CHECK(delta.materialRange.IsEmpty() && !delta.materialsResized);
+}
+
+// An edited OBJ rebuilds its own mesh in place and leaves the rest alone
+TEST(reload, MeshEdit)
+{
+    WatchedScene scene;
+    CHECK(scene.Load());
+    const int triangle = scene.MeshWithVertices(3);
+    CHECK(triangle >= 0 && scene.MeshWithVertices(5) >= 0);
+    const std::vector<MeshRange> before = scene.geometry.meshes;
+
+    CHECK(WriteTextFile(scene.Path("triangle.obj"), "v 0 0 0\nv 1 0 0\nv 0 2 0\nf 1 2 3\n"));
+    SceneDelta delta;
+    CHECK(scene.Reload(delta));
+    CHECK(scene.changed == std::vector<std::filesystem::path>{ scene.Path("triangle.obj") });
+    CHECK(delta.rebuiltMeshes == std::vector<uint32_t>{ uint32_t(triangle) });
+    CHECK(delta.vertexRanges.size() == 1 && delta.indexRanges.size() == 1);
+    CHECK(delta.firstNewMesh == scene.geometry.meshes.size());
+    CHECK(scene.geometry.meshes.size() == before.size());
+    for (size_t i = 0; i < before.size() && i < scene.geometry.meshes.size(); i++)
+    {
+        CHECK(int(i) == triangle || memcmp(&before[i], &scene.geometry.meshes[i], sizeof(MeshRange)) == 0);
+    }
+    CHECK(!delta.placementsChanged && delta.materialRange.IsEmpty());
+}
+
+// A repainted texture is decoded again; the geometry does not change
+TEST(reload, TextureEdit)
+{
+    WatchedScene scene;
+    CHECK(scene.Load());
+    CHECK(scene.parser->textures.size() == 1);
+    if (scene.parser->textures.size() != 1)
+    {
+        return;
+    }
+    const texture_utils::TextureData& original = scene.parser->GetTexture(0);
+    CHECK(original.IsValid());
+    const float red = original.IsValid() ? original.data[0] : 0.0f;
+
+    CHECK(WriteTextFile(scene.Path("albedo.tga"), SolidTGA(10, 100, 50)));
+    SceneDelta delta;
+    CHECK(scene.Reload(delta));
+    CHECK(scene.changed == std::vector<std::filesystem::path>{ scene.Path("albedo.tga") });
+    CHECK(scene.invalidated == std::vector<int>{ 0 });
+    CHECK(delta.IsEmpty());
+    const texture_utils::TextureData& texture = scene.parser->GetTexture(0);
+    CHECK(texture.IsValid() && texture.data[0] < red);
+}
+
+// The renderer reloads an edited environment map from the watcher's list;
+// neither the geometry nor the material textures change
+TEST(reload, EnvironmentMapEdit)
+{
+    WatchedScene scene;
+    CHECK(scene.Load());
+    const std::filesystem::path skyPath = scene.Path("sky.tga");
+    CHECK(scene.parser->environmentMap.isValid &&
+          scene.parser->sceneDirectory / scene.parser->environmentMap.filename == skyPath);
+    const texture_utils::EnvironmentMap original = texture_utils::LoadEnvironmentMap(skyPath);
+    CHECK(original.IsValid());
+    const float red = original.IsValid() ? original.texture.data[0] : 0.0f;
+
+    CHECK(WriteTextFile(skyPath, SolidTGA(220, 40, 80)));
+    SceneDelta delta;
+    CHECK(scene.Reload(delta));
+    CHECK(scene.changed == std::vector<std::filesystem::path>{ skyPath });
+    CHECK(scene.invalidated.empty());
+    CHECK(delta.IsEmpty());
+    const texture_utils::EnvironmentMap sky = texture_utils::LoadEnvironmentMap(skyPath);
+    CHECK(sky.IsValid() && sky.texture.data[0] > red);
+}
@@ -0,0 +1,118 @@
+#include "test_registry.h"
+#include "fixtures.h"
+
+#include "../scene_core/mitsuba_parser.h"
+#include "../scene_core/scene_cache.h"
+
+#include <cstring>
+
+namespace
+{
+
+template <typename T>
+bool SameBytes(std::span<const T> a, const std::vector<T>& b)
+{
+    return a.size() == b.size() && (b.empty() || memcmp(a.data(), b.data(), a.size_bytes()) == 0);
+}
+
+// A sphere and a cube kept analytic, a disk and a rectangle tessellated
+void AddShapes(MitsubaSceneParser& scene)
+{
+    MitsubaSceneParser::Material material;
+    material.id = "white";
+    scene.materials["white"] = material;
+    scene.materialOrder.push_back("white");
+
+    for (std::string_view type : { "sphere", "cube", "disk", "rectangle" })
+    {
+        MitsubaSceneParser::Shape shape;
+        shape.type = type;
+        shape.materialRef = "white";
+        shape.transform = HMM_Translate(HMM_V3(float(scene.shapes.size()) * 3.0f, 0.0f, 0.0f));
+        shape.radius = 0.5f;
+        shape.isEmitter = type == "cube";
+        shape.emission = HMM_V3(1.0f, 2.0f, 3.0f);
+        scene.shapes.push_back(shape);
+    }
+}
+
+} // namespace
+
+TEST(scene_cache, AnalyticShapesRoundTrip)
+{
+    TempDirectory directory;
+    const std::filesystem::path xmlPath = directory.Path() / "scene.xml";
+    CHECK(WriteTextFile(xmlPath, "<scene version=\"3.0.0\"/>\n"));
+
+    MitsubaSceneParser scene;
+    scene.sceneDirectory = directory.Path();
+    AddShapes(scene);
+
+    SceneGeometry geometry;
+    geometry.analyticPrimitives = (1u << uint32_t(AnalyticType::Sphere)) | (1u << uint32_t(AnalyticType::Cube));
+    CHECK(geometry.Load(scene));
+    CHECK(geometry.analyticShapes.size() == 2);
+    CHECK(geometry.meshes.size() == 2);
+    if (geometry.analyticShapes.size() != 2)
+    {
+        return;
+    }
+    CHECK(geometry.analyticShapes[0].type == AnalyticType::Sphere);
+    CHECK(geometry.analyticShapes[1].type == AnalyticType::Cube && geometry.analyticShapes[1].isEmitter == 1);
+
+    const PackedScene packed = PackedScene::FromGeometry(geometry, scene);
+    CHECK(packed.Verify());
+    CHECK(SameBytes(packed.analyticShapes, geometry.analyticShapes));
+
+    const std::filesystem::path cachePath = SceneCache::PathFor(xmlPath);
+    const uint64_t key = SceneCache::ComputeKey(scene, xmlPath, geometry);
+    CHECK(SceneCache::Write(cachePath, key, packed));
+
+    SceneCache cache;
+    CHECK(cache.Open(cachePath, key));
+    const PackedScene& cached = cache.Scene();
+    CHECK(SameBytes(cached.analyticShapes, geometry.analyticShapes));
+    CHECK(SameBytes(cached.positions, geometry.positions));
+    CHECK(SameBytes(cached.indices, geometry.indices));
+    CHECK(SameBytes(cached.instances, geometry.instances));
+    CHECK(SameBytes(cached.placements, geometry.placements));
+    CHECK(cached.Verify());
+    cache.Close();
+
+    // Tessellating everything instead must not pick up this cache
+    SceneGeometry tessellated;
+    CHECK(SceneCache::ComputeKey(scene, xmlPath, tessellated) != key);
+    CHECK(!cache.Open(cachePath, SceneCache::ComputeKey(scene, xmlPath, tessellated)));
+}
+
+// Settings that change the arrays change the key; thread counts do not
+TEST(scene_cache, KeyCoversSettings)
+{
+    TempDirectory directory;
+    const std::filesystem::path xmlPath = directory.Path() / "scene.xml";
+    CHECK(WriteTextFile(xmlPath, "<scene version=\"3.0.0\"/>\n"));
+    MitsubaSceneParser scene;
+    scene.sceneDirectory = directory.Path();
+
+    const SceneGeometry defaults;
+    const uint64_t key = SceneCache::ComputeKey(scene, xmlPath, defaults);
+    auto keyWith = [&](auto change)
+    {
+        SceneGeometry geometry;
+        change(geometry);
+        return SceneCache::ComputeKey(scene, xmlPath, geometry);
+    };
+    CHECK(keyWith([](SceneGeometry& g) { g.optimizeVertexCache = false; }) != key);
+    CHECK(keyWith([](SceneGeometry& g) { g.keepShapesLocal = true; }) != key);
+    CHECK(keyWith([](SceneGeometry& g) { g.analyticEdgePixels = 4.0f; }) != key);
+    CHECK(keyWith([](SceneGeometry& g) { g.maxAnalyticSegments = 128; }) != key);
+    CHECK(keyWith([](SceneGeometry& g) { g.analyticPrimitives = 1; }) != key);
+    CHECK(keyWith([](SceneGeometry& g) { g.loadThreads = 3; g.chunkedOBJBytes = 0; }) == key);
+
+    // A parameter value moving into the next name must not collide
+    scene.parameters = { { "ab", "c" } };
+    const uint64_t first = SceneCache::ComputeKey(scene, xmlPath, defaults);
+    scene.parameters = { { "a", "bc" } };
+    CHECK(first != key);
+    CHECK(SceneCache::ComputeKey(scene, xmlPath, defaults) != first);
+}
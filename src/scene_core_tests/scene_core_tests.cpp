@@ -0,0 +1,65 @@
+// ============================================================================
+// Scene Core Tests
+// Correctness checks for the scene_core building blocks on small inputs.
+// scene_stats keeps the timing runs on full-size data.
+//
+// Usage: scene_core_tests [<group>]
+//   Runs the tests of one group (dedup, transform, vertex_format,
+//   vertex_cache, lod, parser, scene_cache, reload), or all of them. Exits
+//   with 1 if a check failed or the group has no tests.
+// ============================================================================
+
+#include "test_registry.h"
+
+#include <donut/core/log.h>
+
+#include <cstdio>
+#include <cstring>
+
+using namespace donut;
+
+namespace
+{
+int g_Failures = 0;
+}
+
+std::vector<TestCase>& RegisteredTests()
+{
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+void ReportFailure(const char* file, int line, const char* expression)
+{
+    printf("    %s:%d: CHECK(%s) failed\n", file, line, expression);
+    g_Failures++;
+}
+
+int main(int argc, const char** argv)
+{
+    const char* group = argc >= 2 ? argv[1] : nullptr;
+    log::SetMinSeverity(log::Severity::Error);
+
+    size_t run = 0;
+    size_t failed = 0;
+    for (const TestCase& test : RegisteredTests())
+    {
+        if (group && strcmp(group, test.group) != 0)
+        {
+            continue;
+        }
+        g_Failures = 0;
+        test.function();
+        run++;
+        failed += g_Failures > 0 ? 1 : 0;
+        printf("  %-4s %s.%s\n", g_Failures > 0 ? "FAIL" : "ok", test.group, test.name);
+    }
+
+    if (run == 0)
+    {
+        fprintf(stderr, "No tests in group %s\n", group ? group : "(all)");
+        return 1;
+    }
+    printf("%zu of %zu tests passed\n", run - failed, run);
+    return failed > 0 ? 1 : 0;
+}
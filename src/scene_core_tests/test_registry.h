@@ -0,0 +1,38 @@
+#pragma once
+
+// ============================================================================
+// Test Registry
+// TEST(group, name) defines a test and registers it at static init; CHECK
+// reports a failed condition and lets the test go on. scene_core_tests runs
+// one group per CTest entry, or every group when given none.
+// ============================================================================
+
+#include <vector>
+
+struct TestCase
+{
+    const char* group;
+    const char* name;
+    void (*function)();
+};
+
+// Every registered test, in registration order
+std::vector<TestCase>& RegisteredTests();
+
+// Print the failed check and mark the running test as failed
+void ReportFailure(const char* file, int line, const char* expression);
+
+struct TestRegistrar
+{
+    TestRegistrar(const char* group, const char* name, void (*function)())
+    {
+        RegisteredTests().push_back({ group, name, function });
+    }
+};
+
+#define TEST(group, name)                                                       \
+    static void group##_##name();                                               \
+    static TestRegistrar group##_##name##_registrar(#group, #name, group##_##name); \
+    static void group##_##name()
+
+#define CHECK(condition) ((condition) ? (void)0 : ReportFailure(__FILE__, __LINE__, #condition))
@@ -0,0 +1,133 @@
+#include "test_registry.h"
+#include "fixtures.h"
+
+#include "../scene_core/vertex_transform.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+
+std::vector<MeshVertex> RandomVertices(size_t count)
+{
+    TestRandom random(1);
+    std::vector<MeshVertex> vertices(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        MeshVertex& vertex = vertices[i];
+        vertex = {};
+        for (int k = 0; k < 3; k++)
+        {
+            vertex.position[k] = 100.0f * random.Next();
+            vertex.normal[k] = i % 16 == 15 ? 0.0f : random.Next();
+        }
+        vertex.texcoord[0] = random.Next();
+        vertex.texcoord[1] = random.Next();
+        vertex.pad0 = 1.0f;
+        vertex.pad1 = 1.0f;
+    }
+    return vertices;
+}
+
+// Non-uniform scale, where the forward matrix bends normals
+HMM_Mat4 SkewedTransform()
+{
+    return HMM_MulM4(HMM_MulM4(HMM_Translate(HMM_V3(1.0f, 2.0f, 3.0f)),
+        HMM_Rotate_RH(0.7f, HMM_NormV3(HMM_V3(1.0f, 2.0f, 3.0f)))), HMM_Scale(HMM_V3(4.0f, 1.0f, 0.25f)));
+}
+
+// Normal through the cofactor matrix (the inverse transpose times the
+// determinant, which is positive here), in double precision
+void ReferenceNormal(const HMM_Mat4& m, const float in[3], double out[3])
+{
+    double a[3], b[3], c[3];
+    for (int k = 0; k < 3; k++)
+    {
+        a[k] = m.Columns[0].Elements[k];
+        b[k] = m.Columns[1].Elements[k];
+        c[k] = m.Columns[2].Elements[k];
+    }
+    auto cross = [](const double* u, const double* v, double* w)
+    {
+        w[0] = u[1] * v[2] - u[2] * v[1];
+        w[1] = u[2] * v[0] - u[0] * v[2];
+        w[2] = u[0] * v[1] - u[1] * v[0];
+    };
+    double bc[3], ca[3], ab[3];
+    cross(b, c, bc);
+    cross(c, a, ca);
+    cross(a, b, ab);
+    double length = 0.0;
+    for (int k = 0; k < 3; k++)
+    {
+        out[k] = bc[k] * in[0] + ca[k] * in[1] + ab[k] * in[2];
+        length += out[k] * out[k];
+    }
+    length = sqrt(length);
+    for (int k = 0; k < 3; k++)
+    {
+        out[k] /= length;
+    }
+}
+
+} // namespace
+
+// Positions match HMM_MulM4V4 bit for bit, normals the inverse transpose
+TEST(transform, MatchesReference)
+{
+    const std::vector<MeshVertex> local = RandomVertices(1003);
+    const HMM_Mat4 transform = SkewedTransform();
+    const VertexTransformPath best = BestVertexTransformPath();
+    for (VertexTransformPath path : { VertexTransformPath::Scalar, VertexTransformPath::SSE, VertexTransformPath::AVX })
+    {
+        if (int(path) > int(best))
+        {
+            continue;
+        }
+        std::vector<MeshVertex> vertices = local;
+        TransformVertices(VertexTransform(transform), vertices, path);
+
+        size_t positionMismatches = 0;
+        double maxNormalError = 0.0;
+        bool padsZero = true;
+        bool missingNormalsUp = true;
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            const MeshVertex& in = local[i];
+            const MeshVertex& out = vertices[i];
+            HMM_Vec4 position = HMM_MulM4V4(transform, HMM_V4(in.position[0], in.position[1], in.position[2], 1.0f));
+            positionMismatches += memcmp(out.position, position.Elements, sizeof(out.position)) != 0;
+            padsZero = padsZero && out.pad0 == 0.0f && out.pad1 == 0.0f;
+            if (in.normal[0] == 0.0f && in.normal[1] == 0.0f && in.normal[2] == 0.0f)
+            {
+                missingNormalsUp = missingNormalsUp && out.normal[0] == 0.0f && out.normal[1] == 1.0f && out.normal[2] == 0.0f;
+                continue;
+            }
+            double normal[3];
+            ReferenceNormal(transform, in.normal, normal);
+            for (int k = 0; k < 3; k++)
+            {
+                maxNormalError = std::max(maxNormalError, std::abs(normal[k] - double(out.normal[k])));
+            }
+        }
+        CHECK(positionMismatches == 0);
+        CHECK(maxNormalError < 1e-5);
+        CHECK(padsZero);
+        CHECK(missingNormalsUp);
+    }
+}
+
+// The SIMD paths give the same bytes
+TEST(transform, SIMDPathsAgree)
+{
+    if (BestVertexTransformPath() != VertexTransformPath::AVX)
+    {
+        return;
+    }
+    std::vector<MeshVertex> sse = RandomVertices(1003);
+    std::vector<MeshVertex> avx = sse;
+    TransformVertices(VertexTransform(SkewedTransform()), sse, VertexTransformPath::SSE);
+    TransformVertices(VertexTransform(SkewedTransform()), avx, VertexTransformPath::AVX);
+    CHECK(memcmp(sse.data(), avx.data(), sse.size() * sizeof(MeshVertex)) == 0);
+}
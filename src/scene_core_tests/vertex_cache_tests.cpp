@@ -0,0 +1,85 @@
+#include "test_registry.h"
+#include "fixtures.h"
+
+#include "../scene_core/vertex_cache.h"
+
+#include <algorithm>
+
+namespace
+{
+
+// Reorder for the cache and then for fetch, and check that the mesh still
+// has the same triangles and its vertices are numbered in order of first use
+void CheckReorder(std::vector<uint32_t> indices, size_t vertexCount)
+{
+    const std::vector<uint32_t> original = indices;
+    OptimizeVertexCache(indices, vertexCount);
+    CHECK(CanonicalTriangles(original) == CanonicalTriangles(indices));
+
+    const std::vector<uint32_t> ordered = indices;
+    std::vector<uint32_t> remap = OptimizeVertexFetch(indices, vertexCount);
+    CHECK(remap.size() == vertexCount);
+    bool mapped = true;
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        mapped = mapped && remap[ordered[i]] == indices[i];
+    }
+    CHECK(mapped);
+
+    uint32_t next = 0;
+    bool firstUseOrder = true;
+    for (uint32_t index : indices)
+    {
+        firstUseOrder = firstUseOrder && index <= next;
+        next = std::max(next, index + 1);
+    }
+    CHECK(firstUseOrder);
+}
+
+} // namespace
+
+TEST(vertex_cache, GridImproves)
+{
+    const uint32_t width = 64;
+    std::vector<uint32_t> indices = GridIndices(width, width);
+    CheckReorder(indices, size_t(width) * width);
+
+    const VertexCacheStats before = AnalyzeVertexCache(indices, size_t(width) * width);
+    OptimizeVertexCache(indices, size_t(width) * width);
+    const VertexCacheStats after = AnalyzeVertexCache(indices, size_t(width) * width);
+    CHECK(after.acmr < before.acmr);
+    CHECK(after.acmr < 0.8);
+}
+
+TEST(vertex_cache, SphereKeepsTriangles)
+{
+    const TestMesh sphere = BumpySphere(48, 24);
+    CheckReorder(sphere.indices, sphere.vertices.size());
+}
+
+// The hub is far above the valence where rescoring stops; this took seconds
+// while emitted triangles were searched for in the hub's list
+TEST(vertex_cache, HighValenceFan)
+{
+    const uint32_t triangles = 20000;
+    std::vector<uint32_t> indices;
+    for (uint32_t i = 0; i < triangles; i++)
+    {
+        indices.insert(indices.end(), { 0, i + 1, i + 2 });
+    }
+    CheckReorder(indices, triangles + 2);
+}
+
+// A triangle that uses a vertex twice holds two slots in its list
+TEST(vertex_cache, DegenerateTriangles)
+{
+    std::vector<uint32_t> indices = GridIndices(8, 8);
+    indices.insert(indices.end(), { 3, 3, 4, 5, 5, 5, 10, 9, 10, 0, 0, 1 });
+    CheckReorder(indices, 64);
+}
+
+TEST(vertex_cache, Empty)
+{
+    CheckReorder({}, 0);
+    CheckReorder({}, 4);
+}
@@ -0,0 +1,121 @@
+#include "test_registry.h"
+#include "fixtures.h"
+
+#include "../scene_core/vertex_format.h"
+
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+
+// Angle between two unit vectors, in radians
+double Angle(const float a[3], const float b[3])
+{
+    double cross[3] = { double(a[1]) * b[2] - double(a[2]) * b[1], double(a[2]) * b[0] - double(a[0]) * b[2],
+                        double(a[0]) * b[1] - double(a[1]) * b[0] };
+    double dot = double(a[0]) * b[0] + double(a[1]) * b[1] + double(a[2]) * b[2];
+    return atan2(sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]), dot);
+}
+
+// Texcoord round-trip error over its bound from vertex_format.h; <= 1 passes
+double TexcoordExcess(float value, float decoded)
+{
+    double clamped = std::clamp(double(value), -65504.0, 65504.0);
+    double bound = std::max(fabs(clamped) * kPackedTexcoordRelativeError, double(kPackedTexcoordAbsoluteError));
+    return fabs(double(decoded) - clamped) / bound;
+}
+
+void CheckRoundTrip(const MeshVertex& vertex, double& maxNormalError, double& maxTexcoordExcess, size_t& positionMismatches)
+{
+    GPUPosition position;
+    GPUVertex attributes;
+    PackVertex(vertex, position, attributes);
+    const MeshVertex unpacked = UnpackVertex(position, attributes);
+    maxNormalError = std::max(maxNormalError, Angle(vertex.normal, unpacked.normal));
+    for (int k = 0; k < 2; k++)
+    {
+        maxTexcoordExcess = std::max(maxTexcoordExcess, TexcoordExcess(vertex.texcoord[k], unpacked.texcoord[k]));
+    }
+    positionMismatches += memcmp(vertex.position, unpacked.position, sizeof(vertex.position)) != 0;
+}
+
+} // namespace
+
+// Axes, octahedron edges and folds, half-float limits and subnormals
+TEST(vertex_format, HardCases)
+{
+    const float edge = 0.70710678f;
+    const float normals[][3] = {
+        { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+        { edge, edge, 0 }, { -edge, edge, 0 }, { edge, 0, -edge }, { 0, -edge, -edge },
+        { 1e-7f, 0, -1 }, { -1e-7f, 1e-7f, -1 }, { 0.57735027f, -0.57735027f, -0.57735027f }
+    };
+    const float texcoords[][2] = {
+        { 0, 0 }, { -0.0f, 1 }, { 65504, -65504 }, { 6.1035156e-5f, 5.9604645e-8f }, { 2.9802322e-8f, 1e-30f },
+        { 0.99951171875f, 1.00048828125f }, { 1000.3f, -1000.3f }, { 1e6f, -1e6f }
+    };
+
+    double maxNormalError = 0.0;
+    double maxTexcoordExcess = 0.0;
+    size_t positionMismatches = 0;
+    for (size_t i = 0; i < std::size(normals) || i < std::size(texcoords); i++)
+    {
+        MeshVertex vertex = {};
+        vertex.position[0] = float(i) * 0.1f;
+        memcpy(vertex.normal, normals[i % std::size(normals)], sizeof(vertex.normal));
+        memcpy(vertex.texcoord, texcoords[i % std::size(texcoords)], sizeof(vertex.texcoord));
+        CheckRoundTrip(vertex, maxNormalError, maxTexcoordExcess, positionMismatches);
+    }
+    CHECK(maxNormalError <= kPackedNormalMaxError);
+    CHECK(maxTexcoordExcess <= 1.0);
+    CHECK(positionMismatches == 0);
+}
+
+TEST(vertex_format, RandomVertices)
+{
+    TestRandom random(7);
+    double maxNormalError = 0.0;
+    double maxTexcoordExcess = 0.0;
+    size_t positionMismatches = 0;
+    for (int i = 0; i < 20000; i++)
+    {
+        // Rejection-sample a direction; texcoords span 2^-26 .. 2^16
+        MeshVertex vertex = {};
+        float x, y, z, lengthSquared;
+        do
+        {
+            x = random.Next();
+            y = random.Next();
+            z = random.Next();
+            lengthSquared = x * x + y * y + z * z;
+        } while (lengthSquared > 1.0f || lengthSquared < 1e-6f);
+        const float scale = 1.0f / sqrtf(lengthSquared);
+        vertex.position[0] = random.Next();
+        vertex.normal[0] = x * scale;
+        vertex.normal[1] = y * scale;
+        vertex.normal[2] = z * scale;
+        vertex.texcoord[0] = ldexpf(random.Next(), i % 43 - 26);
+        vertex.texcoord[1] = random.Next() * 4.0f;
+        CheckRoundTrip(vertex, maxNormalError, maxTexcoordExcess, positionMismatches);
+    }
+    CHECK(maxNormalError <= kPackedNormalMaxError);
+    CHECK(maxTexcoordExcess <= 1.0);
+    CHECK(positionMismatches == 0);
+}
+
+TEST(vertex_format, HalfSpecialValues)
+{
+    CHECK(std::isinf(HalfToFloat(FloatToHalf(INFINITY))));
+    CHECK(std::isnan(HalfToFloat(FloatToHalf(NAN))));
+    CHECK(HalfToFloat(FloatToHalf(1e9f)) == 65504.0f);
+    CHECK(HalfToFloat(FloatToHalf(-1e9f)) == -65504.0f);
+    CHECK(std::signbit(HalfToFloat(FloatToHalf(-0.0f))));
+
+    const float zero[3] = { 0.0f, 0.0f, 0.0f };
+    float unpacked[3];
+    UnpackNormal(PackNormal(zero), unpacked);
+    CHECK(unpacked[0] == 0.0f && unpacked[1] == 0.0f && unpacked[2] == 1.0f);
+}
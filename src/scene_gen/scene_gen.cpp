@@ -0,0 +1,905 @@
+// ============================================================================
+// Scene Gen
+// Writes a synthetic Mitsuba scene (XML + OBJ or PLY meshes + PNG textures) at a
+// configurable scale so load, BVH build and render timings can be compared
+// without sharing production scenes. Output is deterministic for a given
+// config and seed, and uses only the subset MitsubaSceneParser reads.
+//
+// Usage: scene_gen <config.cfg> <output dir> [key=value ...] [--no-verify]
+//   key=value      Override a config entry, e.g. shapes=5000
+//   --no-verify    Skip re-parsing the written scene
+//
+// Config keys (see configs/*.cfg):
+//   shapes               Number of mesh shapes placed in the scene
+//   triangles_per_mesh   Approximate triangle count of every mesh
+//   instancing           Fraction of shapes [0, 1) that reuse a mesh already
+//                        used by another shape instead of getting their own
+//   materials            Number of named BSDFs
+//   textures             Number of bitmap textures (one per material, from
+//                        the first material on)
+//   texture_size         Width and height of every texture in pixels
+//   seed                 RNG seed
+//   mesh_format          obj (default) or ply; PLY meshes are binary
+// ============================================================================
+
+#include <donut/core/log.h>
+
+#include "../scene_core/mitsuba_parser.h"
+#include "../common/parallel.h"
+#include "../common/parse_utils.h"
+
+#define STB_IMAGE_WRITE_STATIC
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <HandmadeMath.h>
+
+#include <filesystem>
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+using namespace donut;
+
+namespace
+{
+
+struct GenConfig
+{
+    uint32_t shapes = 100;
+    uint32_t trianglesPerMesh = 1000;
+    float instancing = 0.5f;
+    uint32_t materials = 16;
+    uint32_t textures = 4;
+    uint32_t textureSize = 256;
+    uint32_t seed = 1;
+    std::string meshFormat = "obj";     // "obj" or "ply"
+};
+
+// ============================================================================
+// Config
+// ============================================================================
+std::string_view Trim(std::string_view text)
+{
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+    {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r'))
+    {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+template <typename T>
+bool ParseValue(std::string_view text, T& value)
+{
+    T parsed;
+    if (!parse_utils::NextNumber(text, parsed) || !Trim(text).empty())
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+// Apply one "key = value" entry
+bool ApplySetting(GenConfig& config, std::string_view line)
+{
+    size_t equals = line.find('=');
+    if (equals == std::string_view::npos)
+    {
+        log::error("Expected key = value: %.*s", static_cast<int>(line.size()), line.data());
+        return false;
+    }
+    std::string_view key = Trim(line.substr(0, equals));
+    std::string_view value = Trim(line.substr(equals + 1));
+
+    bool ok = false;
+    if (key == "shapes")                    ok = ParseValue(value, config.shapes);
+    else if (key == "triangles_per_mesh")   ok = ParseValue(value, config.trianglesPerMesh);
+    else if (key == "instancing")           ok = ParseValue(value, config.instancing);
+    else if (key == "materials")            ok = ParseValue(value, config.materials);
+    else if (key == "textures")             ok = ParseValue(value, config.textures);
+    else if (key == "texture_size")         ok = ParseValue(value, config.textureSize);
+    else if (key == "seed")                 ok = ParseValue(value, config.seed);
+    else if (key == "mesh_format")
+    {
+        ok = value == "obj" || value == "ply";
+        if (ok)
+        {
+            config.meshFormat = value;
+        }
+    }
+    else
+    {
+        log::error("Unknown config key '%.*s'", static_cast<int>(key.size()), key.data());
+        return false;
+    }
+
+    if (!ok)
+    {
+        log::error("Invalid value for '%.*s': %.*s",
+            static_cast<int>(key.size()), key.data(), static_cast<int>(value.size()), value.data());
+    }
+    return ok;
+}
+
+bool LoadConfig(const std::filesystem::path& path, GenConfig& config)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        log::error("Cannot open config: %s", path.string().c_str());
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::string_view text = line;
+        text = Trim(text.substr(0, text.find('#')));
+        if (!text.empty() && !ApplySetting(config, text))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ValidateConfig(GenConfig& config)
+{
+    if (config.shapes == 0 || config.trianglesPerMesh == 0 || config.materials == 0)
+    {
+        log::error("shapes, triangles_per_mesh and materials must be positive");
+        return false;
+    }
+    if (!(config.instancing >= 0.0f && config.instancing < 1.0f))
+    {
+        log::error("instancing must be in [0, 1)");
+        return false;
+    }
+    if (config.textures > 0 && config.textureSize == 0)
+    {
+        log::error("texture_size must be positive");
+        return false;
+    }
+    // Only textures bound to a material are loaded, so extra ones would not
+    // show up in any measurement
+    if (config.textures > config.materials)
+    {
+        log::warning("Clamping textures (%u) to the material count (%u)", config.textures, config.materials);
+        config.textures = config.materials;
+    }
+    return true;
+}
+
+// ============================================================================
+// Random Numbers
+// ============================================================================
+// PCG32; identical sequences on every platform and standard library
+struct Rng
+{
+    uint64_t state = 0;
+    uint64_t increment;
+
+    explicit Rng(uint64_t seed, uint64_t stream = 0)
+        : increment((stream << 1u) | 1u)
+    {
+        Next();
+        state += seed;
+        Next();
+    }
+
+    uint32_t Next()
+    {
+        uint64_t old = state;
+        state = old * 6364136223846793005ull + increment;
+        uint32_t xorShifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = static_cast<uint32_t>(old >> 59u);
+        return (xorShifted >> rot) | (xorShifted << ((32u - rot) & 31u));
+    }
+
+    // [0, 1)
+    float Uniform()
+    {
+        return static_cast<float>(Next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    float Range(float low, float high)
+    {
+        return low + (high - low) * Uniform();
+    }
+
+    uint32_t Below(uint32_t bound)
+    {
+        return static_cast<uint32_t>((uint64_t(Next()) * bound) >> 32);
+    }
+};
+
+// ============================================================================
+// Text Output
+// ============================================================================
+// Append-only buffer with std::to_chars formatting; fprintf dominates the
+// run time for large meshes otherwise
+class TextBuffer
+{
+public:
+    void Append(std::string_view text)
+    {
+        m_Data.append(text);
+    }
+
+    void Append(float value)
+    {
+        char digits[32];
+        auto [ptr, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+        m_Data.append(digits, ptr);
+    }
+
+    void Append(uint32_t value)
+    {
+        char digits[16];
+        auto [ptr, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+        m_Data.append(digits, ptr);
+    }
+
+    void Reserve(size_t bytes) { m_Data.reserve(bytes); }
+
+    bool WriteTo(const std::filesystem::path& path) const
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(m_Data.data(), static_cast<std::streamsize>(m_Data.size()));
+        if (!file)
+        {
+            log::error("Failed to write %s", path.string().c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::string m_Data;
+};
+
+// Mitsuba matrices are written row-major; HMM stores columns
+void AppendMatrix(TextBuffer& out, const HMM_Mat4& m)
+{
+    for (int row = 0; row < 4; row++)
+    {
+        for (int col = 0; col < 4; col++)
+        {
+            if (row + col > 0)
+            {
+                out.Append(" ");
+            }
+            out.Append(m.Columns[col].Elements[row]);
+        }
+    }
+}
+
+void AppendTransform(TextBuffer& out, const HMM_Mat4& m, std::string_view indent)
+{
+    out.Append(indent);
+    out.Append("<transform name=\"to_world\">\n");
+    out.Append(indent);
+    out.Append("    <matrix value=\"");
+    AppendMatrix(out, m);
+    out.Append("\"/>\n");
+    out.Append(indent);
+    out.Append("</transform>\n");
+}
+
+void AppendRGB(TextBuffer& out, std::string_view name, HMM_Vec3 color, std::string_view indent = "        ")
+{
+    out.Append(indent);
+    out.Append("<rgb name=\"");
+    out.Append(name);
+    out.Append("\" value=\"");
+    out.Append(color.X);
+    out.Append(" ");
+    out.Append(color.Y);
+    out.Append(" ");
+    out.Append(color.Z);
+    out.Append("\"/>\n");
+}
+
+void AppendFloat(TextBuffer& out, std::string_view name, float value)
+{
+    out.Append("        <float name=\"");
+    out.Append(name);
+    out.Append("\" value=\"");
+    out.Append(value);
+    out.Append("\"/>\n");
+}
+
+std::string NumberedName(const char* prefix, uint32_t index, const char* extension)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%s_%05u%s", prefix, index, extension);
+    return name;
+}
+
+// ============================================================================
+// Meshes
+// ============================================================================
+// A lumpy sphere: unit sphere displaced by a few random sine waves, written
+// with positions, normals and texcoords so every face is v/vt/vn.
+struct BlobShape
+{
+    HMM_Vec3 frequency[3];
+    float phase[3];
+    float amplitude[3];
+
+    explicit BlobShape(Rng& rng)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            float scale = rng.Range(1.0f, 4.0f);
+            frequency[k] = HMM_MulV3F(HMM_NormV3(HMM_V3(rng.Range(-1, 1), rng.Range(-1, 1), rng.Range(-1, 1) + 0.01f)), scale);
+            phase[k] = rng.Range(0.0f, 6.2831853f);
+            amplitude[k] = rng.Range(0.03f, 0.15f);
+        }
+    }
+
+    HMM_Vec3 Position(float theta, float phi) const
+    {
+        HMM_Vec3 dir = HMM_V3(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+        float radius = 1.0f;
+        for (int k = 0; k < 3; k++)
+        {
+            radius += amplitude[k] * sinf(HMM_DotV3(frequency[k], dir) + phase[k]);
+        }
+        return HMM_MulV3F(dir, radius);
+    }
+};
+
+// Vertex attributes share one index, so OBJ faces are v/vt/vn with equal
+// indices and PLY vertices need no splitting
+struct BlobMesh
+{
+    std::vector<HMM_Vec3> positions;
+    std::vector<HMM_Vec3> normals;
+    std::vector<HMM_Vec2> texcoords;
+    std::vector<uint32_t> indices;
+
+    uint32_t TriangleCount() const { return static_cast<uint32_t>(indices.size() / 3); }
+};
+
+// Tessellate one blob with ~triangleCount triangles
+BlobMesh BuildBlobMesh(uint32_t triangleCount, Rng rng)
+{
+    // A rings x segments grid loses one triangle per segment at each pole:
+    // 2 * segments * (rings - 1) triangles with segments = 2 * rings
+    uint32_t rings = std::max(2u, static_cast<uint32_t>(std::lround((1.0 + std::sqrt(1.0 + triangleCount)) * 0.5)));
+    uint32_t segments = 2 * rings;
+    const float pi = 3.14159265f;
+    const float eps = 1e-3f;
+
+    BlobShape shape(rng);
+    uint32_t vertexCount = (rings + 1) * (segments + 1);
+
+    BlobMesh mesh;
+    mesh.positions.reserve(vertexCount);
+    mesh.normals.reserve(vertexCount);
+    mesh.texcoords.reserve(vertexCount);
+    mesh.indices.reserve(size_t(6) * segments * (rings - 1));
+
+    for (uint32_t r = 0; r <= rings; r++)
+    {
+        float theta = pi * float(r) / float(rings);
+        for (uint32_t s = 0; s <= segments; s++)
+        {
+            float phi = 2.0f * pi * float(s) / float(segments);
+            HMM_Vec3 p = shape.Position(theta, phi);
+
+            // Outward normal from the surface tangents; the poles have no
+            // phi tangent, fall back to the radial direction there
+            HMM_Vec3 dTheta = HMM_SubV3(shape.Position(theta + eps, phi), shape.Position(theta - eps, phi));
+            HMM_Vec3 dPhi = HMM_SubV3(shape.Position(theta, phi + eps), shape.Position(theta, phi - eps));
+            HMM_Vec3 n = HMM_Cross(dPhi, dTheta);
+
+            mesh.positions.push_back(p);
+            mesh.normals.push_back((r == 0 || r == rings || HMM_LenSqrV3(n) < 1e-12f) ? HMM_NormV3(p) : HMM_NormV3(n));
+            mesh.texcoords.push_back(HMM_V2(float(s) / float(segments), 1.0f - float(r) / float(rings)));
+        }
+    }
+
+    for (uint32_t r = 0; r < rings; r++)
+    {
+        for (uint32_t s = 0; s < segments; s++)
+        {
+            uint32_t a = r * (segments + 1) + s;
+            uint32_t b = a + 1;
+            uint32_t c = a + segments + 1;
+            uint32_t d = c + 1;
+            if (r != 0)
+            {
+                mesh.indices.insert(mesh.indices.end(), { a, b, c });
+            }
+            if (r != rings - 1)
+            {
+                mesh.indices.insert(mesh.indices.end(), { b, d, c });
+            }
+        }
+    }
+    return mesh;
+}
+
+bool WriteOBJMesh(const std::filesystem::path& path, const BlobMesh& mesh)
+{
+    TextBuffer out;
+    out.Reserve(mesh.positions.size() * 96 + size_t(mesh.TriangleCount()) * 40);
+    out.Append("# scene_gen blob\n");
+
+    for (const HMM_Vec3& p : mesh.positions)
+    {
+        out.Append("v ");
+        out.Append(p.X);
+        out.Append(" ");
+        out.Append(p.Y);
+        out.Append(" ");
+        out.Append(p.Z);
+        out.Append("\n");
+    }
+    for (const HMM_Vec2& t : mesh.texcoords)
+    {
+        out.Append("vt ");
+        out.Append(t.X);
+        out.Append(" ");
+        out.Append(t.Y);
+        out.Append("\n");
+    }
+    for (const HMM_Vec3& n : mesh.normals)
+    {
+        out.Append("vn ");
+        out.Append(n.X);
+        out.Append(" ");
+        out.Append(n.Y);
+        out.Append(" ");
+        out.Append(n.Z);
+        out.Append("\n");
+    }
+
+    for (size_t i = 0; i < mesh.indices.size(); i += 3)
+    {
+        out.Append("f");
+        for (size_t k = 0; k < 3; k++)
+        {
+            uint32_t index = mesh.indices[i + k] + 1;
+            out.Append(" ");
+            out.Append(index);
+            out.Append("/");
+            out.Append(index);
+            out.Append("/");
+            out.Append(index);
+        }
+        out.Append("\n");
+    }
+    return out.WriteTo(path);
+}
+
+// Binary PLY in the host byte order with float x y z nx ny nz u v vertices,
+// the layout the loader reads in place
+bool WritePLYMesh(const std::filesystem::path& path, const BlobMesh& mesh)
+{
+    char header[512];
+    int headerSize = snprintf(header, sizeof(header),
+        "ply\n"
+        "format %s 1.0\n"
+        "comment scene_gen blob\n"
+        "element vertex %zu\n"
+        "property float x\nproperty float y\nproperty float z\n"
+        "property float nx\nproperty float ny\nproperty float nz\n"
+        "property float u\nproperty float v\n"
+        "element face %u\n"
+        "property list uchar int vertex_indices\n"
+        "end_header\n",
+        std::endian::native == std::endian::little ? "binary_little_endian" : "binary_big_endian",
+        mesh.positions.size(), mesh.TriangleCount());
+
+    const size_t vertexBytes = 8 * sizeof(float);
+    const size_t faceBytes = 1 + 3 * sizeof(uint32_t);
+    std::vector<char> data(size_t(headerSize) + mesh.positions.size() * vertexBytes + size_t(mesh.TriangleCount()) * faceBytes);
+    memcpy(data.data(), header, size_t(headerSize));
+
+    char* out = data.data() + headerSize;
+    for (size_t i = 0; i < mesh.positions.size(); i++)
+    {
+        const float vertex[8] = {
+            mesh.positions[i].X, mesh.positions[i].Y, mesh.positions[i].Z,
+            mesh.normals[i].X, mesh.normals[i].Y, mesh.normals[i].Z,
+            mesh.texcoords[i].X, mesh.texcoords[i].Y,
+        };
+        memcpy(out, vertex, vertexBytes);
+        out += vertexBytes;
+    }
+    for (size_t i = 0; i < mesh.indices.size(); i += 3)
+    {
+        *out++ = 3;
+        memcpy(out, &mesh.indices[i], 3 * sizeof(uint32_t));
+        out += 3 * sizeof(uint32_t);
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file)
+    {
+        log::error("Failed to write %s", path.string().c_str());
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Textures
+// ============================================================================
+// Checkerboard between two random colors with a soft diagonal gradient, so
+// filtering and mip selection have something to show
+bool WriteTexture(const std::filesystem::path& path, uint32_t size, Rng rng)
+{
+    uint8_t colors[2][3];
+    for (auto& color : colors)
+    {
+        for (uint8_t& channel : color)
+        {
+            channel = static_cast<uint8_t>(40 + rng.Below(200));
+        }
+    }
+    uint32_t cells = 4u << rng.Below(3);
+    uint32_t cellSize = std::max(1u, size / cells);
+
+    std::vector<uint8_t> pixels(size_t(size) * size * 3);
+    for (uint32_t y = 0; y < size; y++)
+    {
+        for (uint32_t x = 0; x < size; x++)
+        {
+            const uint8_t* color = colors[((x / cellSize) + (y / cellSize)) & 1];
+            float shade = 0.75f + 0.25f * float(x + y) / float(2 * size);
+            uint8_t* pixel = &pixels[(size_t(y) * size + x) * 3];
+            for (int c = 0; c < 3; c++)
+            {
+                pixel[c] = static_cast<uint8_t>(float(color[c]) * shade);
+            }
+        }
+    }
+
+    if (!stbi_write_png(path.string().c_str(), int(size), int(size), 3, pixels.data(), int(size) * 3))
+    {
+        log::error("Failed to write %s", path.string().c_str());
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Scene XML
+// ============================================================================
+const char* const kMaterialTypes[] = {
+    "diffuse", "roughplastic", "roughconductor", "principled", "plastic", "conductor", "dielectric",
+};
+
+void AppendMaterial(TextBuffer& out, uint32_t index, const GenConfig& config, Rng& rng)
+{
+    bool textured = index < config.textures;
+    // Textured materials use the two types whose reflectance takes a bitmap
+    const char* type = textured ? kMaterialTypes[index % 2] : kMaterialTypes[index % std::size(kMaterialTypes)];
+    HMM_Vec3 color = HMM_V3(rng.Range(0.1f, 0.9f), rng.Range(0.1f, 0.9f), rng.Range(0.1f, 0.9f));
+
+    out.Append("    <bsdf type=\"");
+    out.Append(type);
+    out.Append("\" id=\"");
+    out.Append(NumberedName("mat", index, ""));
+    out.Append("\">\n");
+
+    std::string_view name = type;
+    std::string_view reflectance = name == "diffuse" ? "reflectance" : "diffuse_reflectance";
+    if (textured)
+    {
+        out.Append("        <texture type=\"bitmap\" name=\"");
+        out.Append(reflectance);
+        out.Append("\">\n            <string name=\"filename\" value=\"textures/");
+        out.Append(NumberedName("tex", index, ".png"));
+        out.Append("\"/>\n        </texture>\n");
+    }
+    else if (name == "diffuse" || name == "roughplastic" || name == "plastic")
+    {
+        AppendRGB(out, reflectance, color);
+    }
+
+    if (name == "roughplastic" || name == "roughconductor")
+    {
+        AppendFloat(out, "alpha", rng.Range(0.05f, 0.5f));
+    }
+    else if (name == "principled")
+    {
+        AppendRGB(out, "base_color", color);
+        AppendFloat(out, "metallic", rng.Uniform());
+        AppendFloat(out, "roughness", rng.Range(0.1f, 0.9f));
+    }
+    else if (name == "dielectric")
+    {
+        AppendFloat(out, "int_ior", 1.5f);
+    }
+    out.Append("    </bsdf>\n");
+}
+
+// Mitsuba camera-to-world: the camera looks down +Z with +Y up
+HMM_Mat4 CameraToWorld(HMM_Vec3 position, HMM_Vec3 target)
+{
+    HMM_Vec3 forward = HMM_NormV3(HMM_SubV3(target, position));
+    HMM_Vec3 left = HMM_NormV3(HMM_Cross(HMM_V3(0, 1, 0), forward));
+    HMM_Vec3 up = HMM_Cross(forward, left);
+
+    HMM_Mat4 m = HMM_M4D(1.0f);
+    m.Columns[0] = HMM_V4V(left, 0.0f);
+    m.Columns[1] = HMM_V4V(up, 0.0f);
+    m.Columns[2] = HMM_V4V(forward, 0.0f);
+    m.Columns[3] = HMM_V4V(position, 1.0f);
+    return m;
+}
+
+// Mitsuba rectangles span [-1, 1]^2 in XY facing +Z; lay one flat in XZ
+// with its normal along +Y (up = true) or -Y
+HMM_Mat4 HorizontalRectangle(float halfSize, float height, bool up)
+{
+    HMM_Mat4 m = HMM_M4D(1.0f);
+    m.Columns[0] = HMM_V4(halfSize, 0.0f, 0.0f, 0.0f);
+    m.Columns[1] = HMM_V4(0.0f, 0.0f, up ? -halfSize : halfSize, 0.0f);
+    m.Columns[2] = HMM_V4(0.0f, up ? 1.0f : -1.0f, 0.0f, 0.0f);
+    m.Columns[3] = HMM_V4(0.0f, height, 0.0f, 1.0f);
+    return m;
+}
+
+struct GenStats
+{
+    uint32_t meshCount = 0;
+    uint64_t meshTriangles = 0;     // Sum over unique meshes
+    uint64_t placedTriangles = 0;   // Sum over shapes, instancing expanded
+};
+
+bool WriteSceneXML(const std::filesystem::path& path, const GenConfig& config,
+                   const std::vector<uint32_t>& triangleCounts, GenStats& stats)
+{
+    Rng rng(config.seed, 1);
+    const float spacing = 3.0f;
+    uint32_t gridSide = static_cast<uint32_t>(std::ceil(std::sqrt(double(config.shapes))));
+    float halfExtent = 0.5f * spacing * float(gridSide);
+
+    TextBuffer out;
+    out.Reserve(size_t(config.shapes) * 400 + size_t(config.materials) * 300 + 4096);
+
+    char header[640];
+    snprintf(header, sizeof(header),
+        "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+        "<!-- Generated by scene_gen: shapes=%u triangles_per_mesh=%u instancing=%g "
+        "materials=%u textures=%u texture_size=%u seed=%u mesh_format=%s -->\n"
+        "<scene version=\"3.0.0\">\n"
+        "    <integrator type=\"path\">\n"
+        "        <integer name=\"max_depth\" value=\"8\"/>\n"
+        "    </integrator>\n\n",
+        config.shapes, config.trianglesPerMesh, double(config.instancing),
+        config.materials, config.textures, config.textureSize, config.seed, config.meshFormat.c_str());
+    out.Append(header);
+
+    // Camera above one corner looking at the grid centre
+    out.Append("    <sensor type=\"perspective\">\n");
+    out.Append("        <float name=\"fov\" value=\"45\"/>\n");
+    HMM_Vec3 eye = HMM_V3(-halfExtent * 1.2f, halfExtent * 0.8f + 2.0f, -halfExtent * 1.2f);
+    AppendTransform(out, CameraToWorld(eye, HMM_V3(0.0f, 0.0f, 0.0f)), "        ");
+    out.Append("        <film type=\"hdrfilm\">\n");
+    out.Append("            <integer name=\"width\" value=\"1280\"/>\n");
+    out.Append("            <integer name=\"height\" value=\"720\"/>\n");
+    out.Append("        </film>\n");
+    out.Append("    </sensor>\n\n");
+
+    for (uint32_t i = 0; i < config.materials; i++)
+    {
+        AppendMaterial(out, i, config, rng);
+    }
+    out.Append("    <bsdf type=\"diffuse\" id=\"mat_ground\">\n");
+    AppendRGB(out, "reflectance", HMM_V3(0.5f, 0.5f, 0.5f));
+    out.Append("    </bsdf>\n\n");
+
+    // The first meshCount shapes each introduce a mesh; the rest reuse a
+    // random earlier one, which the loader turns into instances
+    std::string meshExtension = "." + config.meshFormat;
+    uint32_t meshCount = static_cast<uint32_t>(triangleCounts.size());
+    for (uint32_t i = 0; i < config.shapes; i++)
+    {
+        uint32_t mesh = i < meshCount ? i : rng.Below(meshCount);
+        uint32_t material = rng.Below(config.materials);
+
+        float scale = rng.Range(0.6f, 1.2f);
+        float x = (float(i % gridSide) + 0.5f) * spacing - halfExtent + rng.Range(-0.3f, 0.3f);
+        float z = (float(i / gridSide) + 0.5f) * spacing - halfExtent + rng.Range(-0.3f, 0.3f);
+        HMM_Mat4 transform = HMM_MulM4(
+            HMM_Translate(HMM_V3(x, scale, z)),
+            HMM_MulM4(HMM_Rotate_RH(rng.Range(0.0f, 6.2831853f), HMM_V3(0, 1, 0)), HMM_Scale(HMM_V3(scale, scale, scale))));
+
+        out.Append("    <shape type=\"");
+        out.Append(config.meshFormat);
+        out.Append("\">\n");
+        out.Append("        <string name=\"filename\" value=\"meshes/");
+        out.Append(NumberedName("mesh", mesh, meshExtension.c_str()));
+        out.Append("\"/>\n");
+        AppendTransform(out, transform, "        ");
+        out.Append("        <ref id=\"");
+        out.Append(NumberedName("mat", material, ""));
+        out.Append("\"/>\n");
+        out.Append("    </shape>\n");
+
+        stats.placedTriangles += triangleCounts[mesh];
+    }
+
+    float groundSize = halfExtent + spacing;
+    out.Append("\n    <shape type=\"rectangle\">\n");
+    AppendTransform(out, HorizontalRectangle(groundSize, 0.0f, true), "        ");
+    out.Append("        <ref id=\"mat_ground\"/>\n");
+    out.Append("    </shape>\n");
+
+    // One area light sized with the scene so exposure stays comparable
+    out.Append("    <shape type=\"rectangle\">\n");
+    AppendTransform(out, HorizontalRectangle(halfExtent * 0.5f + 1.0f, halfExtent + 6.0f, false), "        ");
+    out.Append("        <emitter type=\"area\">\n");
+    AppendRGB(out, "radiance", HMM_V3(8.0f, 8.0f, 8.0f), "            ");
+    out.Append("        </emitter>\n");
+    out.Append("    </shape>\n");
+    out.Append("</scene>\n");
+
+    return out.WriteTo(path);
+}
+
+// Re-read the output with the real parser and check what it found
+bool VerifyScene(const std::filesystem::path& xmlPath, const GenConfig& config)
+{
+    log::SetMinSeverity(log::Severity::Warning);
+    MitsubaSceneParser parser;
+    bool parsed = parser.Parse(xmlPath);
+    log::SetMinSeverity(log::Severity::Info);
+
+    if (!parsed)
+    {
+        log::error("Generated scene failed to parse");
+        return false;
+    }
+
+    size_t validTextures = 0;
+    for (const auto& texture : parser.textures)
+    {
+        validTextures += texture.info.IsValid() ? 1 : 0;
+    }
+
+    bool ok = parser.shapes.size() == size_t(config.shapes) + 2 &&
+              parser.materials.size() == size_t(config.materials) + 1 &&
+              parser.textures.size() == config.textures &&
+              validTextures == config.textures;
+    if (!ok)
+    {
+        log::error("Generated scene parsed with %zu shapes, %zu materials, %zu/%zu textures "
+                   "(expected %u, %u, %u)",
+            parser.shapes.size(), parser.materials.size(), validTextures, parser.textures.size(),
+            config.shapes + 2, config.materials + 1, config.textures);
+        return false;
+    }
+    printf("Verified: %zu shapes, %zu materials, %zu textures\n",
+        parser.shapes.size(), parser.materials.size(), parser.textures.size());
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        printf("Usage: scene_gen <config.cfg> <output dir> [key=value ...] [--no-verify]\n");
+        return 1;
+    }
+
+    GenConfig config;
+    if (!LoadConfig(argv[1], config))
+    {
+        return 1;
+    }
+
+    std::filesystem::path outputDir = argv[2];
+    bool verify = true;
+    for (int i = 3; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--no-verify") == 0)
+        {
+            verify = false;
+        }
+        else if (!ApplySetting(config, argv[i]))
+        {
+            return 1;
+        }
+    }
+    if (!ValidateConfig(config))
+    {
+        return 1;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(outputDir / "meshes", ec);
+    if (!ec && config.textures > 0)
+    {
+        std::filesystem::create_directories(outputDir / "textures", ec);
+    }
+    if (ec)
+    {
+        log::error("Cannot create output directory %s: %s", outputDir.string().c_str(), ec.message().c_str());
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    uint32_t reused = static_cast<uint32_t>(std::lround(double(config.shapes) * config.instancing));
+    uint32_t meshCount = std::max(1u, config.shapes - reused);
+
+    // Every mesh and texture draws from its own RNG stream, so the output
+    // does not depend on the thread count
+    std::string meshExtension = "." + config.meshFormat;
+    std::vector<uint32_t> triangleCounts(meshCount);
+    std::vector<uint8_t> meshOk(meshCount, 1);
+    parallel::ForEach(meshCount, 0, [&](size_t i)
+    {
+        BlobMesh mesh = BuildBlobMesh(config.trianglesPerMesh, Rng(config.seed, 1000 + i));
+        std::filesystem::path path = outputDir / "meshes" / NumberedName("mesh", uint32_t(i), meshExtension.c_str());
+        triangleCounts[i] = mesh.TriangleCount();
+        meshOk[i] = (config.meshFormat == "ply" ? WritePLYMesh(path, mesh) : WriteOBJMesh(path, mesh)) ? 1 : 0;
+    });
+
+    std::vector<uint8_t> textureOk(config.textures, 1);
+    parallel::ForEach(config.textures, 0, [&](size_t i)
+    {
+        Rng rng(config.seed, 1ull << 32 | i);
+        textureOk[i] = WriteTexture(outputDir / "textures" / NumberedName("tex", uint32_t(i), ".png"),
+            config.textureSize, rng) ? 1 : 0;
+    });
+
+    if (std::find(meshOk.begin(), meshOk.end(), 0) != meshOk.end() ||
+        std::find(textureOk.begin(), textureOk.end(), 0) != textureOk.end())
+    {
+        return 1;
+    }
+
+    GenStats stats;
+    stats.meshCount = meshCount;
+    for (uint32_t count : triangleCounts)
+    {
+        stats.meshTriangles += count;
+    }
+
+    std::filesystem::path xmlPath = outputDir / "scene.xml";
+    if (!WriteSceneXML(xmlPath, config, triangleCounts, stats))
+    {
+        return 1;
+    }
+
+    printf("Wrote %s in %.1f ms\n", xmlPath.string().c_str(),
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    printf("  Shapes       %10u (%u meshes, %u instanced placements)\n",
+        config.shapes, stats.meshCount, config.shapes - std::min(config.shapes, stats.meshCount));
+    printf("  Triangles    %10llu unique, %llu placed\n",
+        static_cast<unsigned long long>(stats.meshTriangles), static_cast<unsigned long long>(stats.placedTriangles));
+    printf("  Materials    %10u (%u textured)\n", config.materials, config.textures);
+    printf("  Textures     %10u x %u^2\n", config.textures, config.textureSize);
+
+    if (verify && !VerifyScene(xmlPath, config))
+    {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,1583 @@
+// ============================================================================
+// Scene Stats
+// Loads a Mitsuba scene entirely on the CPU (no window, no GPU device) and
+// prints per-stage timings plus the size of the packed geometry. Exits
+// with 3 if an index leaves the vertex range of its mesh.
+//
+// Usage: scene_stats <scene.xml> [options]
+//        scene_stats --bench-obj <file.obj> [--load-threads <N>]
+//        scene_stats --bench-dedup [<file.obj>]
+//        scene_stats --bench-transform [<vertices>]
+//        scene_stats --bench-vertex-format [<vertices>]
+//        scene_stats --bench-vertex-cache [<file.obj>]
+//        scene_stats --bench-lod [<file.obj>]
+//   --bench-parse <N>      Parse the XML N more times without textures and
+//                          report parse / BSDF throughput
+//   --texture-threads <N>  Texture decode threads (default: all cores)
+//   --bench-textures       Time texture decoding with 1, 2, 4 ... N threads
+//   --load-threads <N>     Mesh ingest threads (default: all cores)
+//   --bench-load           Time geometry loading with 1, 2, 4 ... N threads
+//                          and check that every run matches the first
+//   --cache                Write <scene.xml>.rtcache if stale and time a
+//                          warm start from it
+//   --bench-reload         Copy the scene to a temp directory, edit a
+//                          material, a shape transform, an OBJ, a texture and
+//                          the environment map there and time each reload
+//                          from the FileWatcher's change list; fails if a
+//                          SceneDelta is not the minimal one for its edit
+//   --no-vertex-cache      Load meshes in source order, to compare the
+//                          vertex cache figures against
+//   --bench-obj <file>     Time tinyobj against the chunked OBJ parser on
+//                          1, 2, 4 ... N threads and compare their output
+//   --bench-dedup [file]   Time both vertex dedup methods on an OBJ (default:
+//                          a synthetic mesh with > 2^20 attributes) and check
+//                          them against a std::unordered_map; exits non-zero
+//                          on a mismatch
+//   --bench-transform [N]  Time the batched vertex transform on N synthetic
+//                          vertices (default 10M) per SIMD path against the
+//                          old per-vertex code; exits non-zero on a mismatch
+//   --bench-vertex-format [N]  Pack and unpack N vertices (default 10M) and
+//                          check the round-trip error bounds of GPUVertex;
+//                          exits non-zero if one is exceeded
+//   --bench-vertex-cache [file]  Reorder an OBJ (default: a synthetic
+//                          grid in row order) for the vertex cache and report
+//                          ACMR/ATVR before and after; exits non-zero if
+//                          the triangles changed
+//   --bench-lod [file]     Build the rasterizer's LOD chain for an OBJ
+//                          (default: a bumpy sphere with a texcoord seam) and
+//                          report the triangles drawn at a 1 pixel error
+//                          bound by distance; exits non-zero if a level is
+//                          malformed or opens a hole in a closed mesh
+// ============================================================================
+
+#include <donut/core/log.h>
+
+#include "../scene_core/mitsuba_parser.h"
+#include "../scene_core/scene_geometry.h"
+#include "../scene_core/scene_cache.h"
+#include "../scene_core/obj_reader.h"
+#include "../scene_core/obj_parser.h"
+#include "../scene_core/vertex_dedup.h"
+#include "../scene_core/vertex_transform.h"
+#include "../scene_core/vertex_format.h"
+#include "../scene_core/vertex_cache.h"
+#include "../scene_core/mesh_simplify.h"
+#include "../common/parallel.h"
+#include "../common/parse_utils.h"
+#include "../common/file_watcher.h"
+
+#include <pugixml.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <map>
+#include <tuple>
+#include <array>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace donut;
+
+static double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void PrintBytes(const char* label, size_t count, size_t stride)
+{
+    printf("  %-12s %10zu x %3zu B = %10.2f MB\n", label, count, stride, double(count * stride) / (1024.0 * 1024.0));
+}
+
+// Miss ratios of all meshes together, each mesh starting with a cold cache
+static void PrintVertexCache(const SceneGeometry& geometry)
+{
+    double misses = 0.0;
+    size_t vertexCount = 0;
+    for (const MeshRange& mesh : geometry.meshes)
+    {
+        std::span<const uint32_t> indices(geometry.indices.data() + mesh.indexOffset, mesh.indexCount);
+        misses += AnalyzeVertexCache(indices, mesh.vertexCount).atvr * mesh.vertexCount;
+        vertexCount += mesh.vertexCount;
+    }
+    const size_t triangleCount = geometry.indices.size() / 3;
+    printf("  Vertex cache ACMR %.3f  ATVR %.3f (FIFO 16)\n", triangleCount > 0 ? misses / double(triangleCount) : 0.0,
+        vertexCount > 0 ? misses / double(vertexCount) : 0.0);
+}
+
+static double Median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values.empty() ? 0.0 : values[values.size() / 2];
+}
+
+// Repeatedly parse the scene XML (no textures, no geometry)
+static void BenchParse(const std::filesystem::path& scenePath, int iterations)
+{
+    std::vector<double> xmlMs;
+    std::vector<double> bsdfMs;
+    size_t bsdfCount = 0;
+
+    log::SetMinSeverity(log::Severity::Warning);
+    for (int i = 0; i < iterations; i++)
+    {
+        MitsubaSceneParser parser;
+        parser.probeTextures = false;
+        if (!parser.Parse(scenePath))
+        {
+            break;
+        }
+        xmlMs.push_back(parser.stats.xmlParseMs);
+        bsdfMs.push_back(parser.stats.bsdfParseMs);
+        bsdfCount = parser.stats.bsdfCount;
+    }
+    log::SetMinSeverity(log::Severity::Info);
+
+    if (xmlMs.empty())
+    {
+        return;
+    }
+
+    double bsdfMedian = Median(bsdfMs);
+    printf("Parse benchmark (%zu runs):\n", xmlMs.size());
+    printf("  XML parse    %10.3f ms median, %.3f ms min\n", Median(xmlMs), *std::min_element(xmlMs.begin(), xmlMs.end()));
+    printf("  BSDF parse   %10.3f ms median, %.3f ms min (%zu BSDFs)\n", bsdfMedian, *std::min_element(bsdfMs.begin(), bsdfMs.end()), bsdfCount);
+    if (bsdfCount > 0 && bsdfMedian > 0.0)
+    {
+        printf("  BSDF rate    %10.0f ns/BSDF, %.2f M BSDFs/s\n",
+            bsdfMedian * 1e6 / double(bsdfCount), double(bsdfCount) / (bsdfMedian * 1e3));
+    }
+}
+
+// Decode the scene's textures with increasing thread counts
+static void BenchTextures(const std::filesystem::path& scenePath, unsigned maxThreads)
+{
+    printf("Texture decode scaling:\n");
+    double baselineMs = 0.0;
+
+    log::SetMinSeverity(log::Severity::Warning);
+    for (unsigned threads = 1; ; threads = std::min(threads * 2, maxThreads))
+    {
+        MitsubaSceneParser parser;
+        parser.textureThreads = threads;
+        if (!parser.Parse(scenePath))
+        {
+            break;
+        }
+
+        std::vector<int> allTextures(parser.textures.size());
+        for (size_t i = 0; i < allTextures.size(); i++)
+        {
+            allTextures[i] = static_cast<int>(i);
+        }
+        parser.DecodeTextures(allTextures);
+
+        double ms = parser.stats.textureDecodeMs;
+        if (threads == 1)
+        {
+            baselineMs = ms;
+        }
+        printf("  %3u threads  %10.2f ms  %5.2fx  (peak in flight %.1f MB)\n", threads, ms,
+            ms > 0.0 ? baselineMs / ms : 0.0, double(parser.stats.peakDecodeBytes) / (1024.0 * 1024.0));
+
+        if (threads >= maxThreads)
+        {
+            break;
+        }
+    }
+    log::SetMinSeverity(log::Severity::Info);
+}
+
+// Load the geometry with increasing thread counts and compare each result
+// with `reference` byte for byte
+template <typename T>
+static bool SameBytes(const std::vector<T>& a, const std::vector<T>& b)
+{
+    return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+static bool BenchLoad(const MitsubaSceneParser& parser, const SceneGeometry& reference, unsigned maxThreads)
+{
+    printf("Geometry load scaling:\n");
+    double baselineMs = 0.0;
+    bool allSame = true;
+
+    log::SetMinSeverity(log::Severity::Warning);
+    for (unsigned threads = 1; ; threads = std::min(threads * 2, maxThreads))
+    {
+        auto start = std::chrono::steady_clock::now();
+        SceneGeometry geometry;
+        geometry.loadThreads = threads;
+        geometry.optimizeVertexCache = reference.optimizeVertexCache;
+        geometry.Load(parser);
+        double ms = ElapsedMs(start);
+        if (threads == 1)
+        {
+            baselineMs = ms;
+        }
+
+        bool same = SameBytes(geometry.positions, reference.positions) &&
+                    SameBytes(geometry.vertices, reference.vertices) && SameBytes(geometry.indices, reference.indices) &&
+                    SameBytes(geometry.meshes, reference.meshes) && SameBytes(geometry.instances, reference.instances) &&
+                    SameBytes(geometry.placements, reference.placements);
+        allSame = allSame && same;
+
+        printf("  %3u threads  %10.2f ms  %5.2fx  %s\n", threads, ms, ms > 0.0 ? baselineMs / ms : 0.0,
+            same ? "identical" : "MISMATCH");
+
+        if (threads >= maxThreads)
+        {
+            break;
+        }
+    }
+    log::SetMinSeverity(log::Severity::Info);
+    return allSame;
+}
+
+// Parse one OBJ with tinyobj, then with the chunked parser on 1, 2, 4 ... N
+// threads, and compare the chunked attributes with tinyobj's
+static bool BenchOBJ(const std::filesystem::path& objPath, unsigned maxThreads)
+{
+    std::error_code ec;
+    double megabytes = double(std::filesystem::file_size(objPath, ec)) / (1024.0 * 1024.0);
+
+    auto tinyStart = std::chrono::steady_clock::now();
+    tinyobj_attrib_t attrib;
+    tinyobj_shape_t* shapes = nullptr;
+    size_t numShapes = 0;
+    tinyobj_material_t* materials = nullptr;
+    size_t numMaterials = 0;
+    OBJReaderContext reader;
+    int ret = tinyobj_parse_obj(&attrib, &shapes, &numShapes, &materials, &numMaterials,
+        objPath.string().c_str(), FileReaderCallback, &reader, TINYOBJ_FLAG_TRIANGULATE);
+    double tinyMs = ElapsedMs(tinyStart);
+    if (ret != TINYOBJ_SUCCESS)
+    {
+        log::error("tinyobj failed to parse %s", objPath.string().c_str());
+        return false;
+    }
+
+    printf("OBJ parse (%.1f MB, %u positions, %u triangles):\n", megabytes, attrib.num_vertices, attrib.num_faces / 3);
+    printf("  tinyobj            %10.2f ms  %8.1f MB/s\n", tinyMs, megabytes / (tinyMs / 1000.0));
+
+    const OBJMeshView reference = OBJMeshView::FromTinyObj(attrib);
+    bool allSame = true;
+    for (unsigned threads = 1; ; threads = std::min(threads * 2, maxThreads))
+    {
+        auto start = std::chrono::steady_clock::now();
+        OBJAttributes attributes;
+        bool ok = ParseOBJChunked(objPath, threads, attributes);
+        double ms = ElapsedMs(start);
+        if (!ok)
+        {
+            allSame = false;
+            break;
+        }
+
+        // Floats may differ in the last bit: tinyobj rounds via double
+        const OBJMeshView chunked = OBJMeshView::FromAttributes(attributes);
+        bool same = chunked.positions.size() == reference.positions.size() &&
+                    chunked.normals.size() == reference.normals.size() &&
+                    chunked.texcoords.size() == reference.texcoords.size() &&
+                    chunked.corners.size() == reference.corners.size();
+        float maxError = 0.0f;
+        auto compareFloats = [&](std::span<const float> a, std::span<const float> b)
+        {
+            for (size_t i = 0; same && i < a.size(); i++)
+            {
+                maxError = std::max(maxError, std::abs(a[i] - b[i]));
+            }
+        };
+        compareFloats(chunked.positions, reference.positions);
+        compareFloats(chunked.normals, reference.normals);
+        compareFloats(chunked.texcoords, reference.texcoords);
+        for (size_t i = 0; same && i < chunked.corners.size(); i++)
+        {
+            const tinyobj_vertex_index_t& a = chunked.corners[i];
+            const tinyobj_vertex_index_t& b = reference.corners[i];
+            same = a.v_idx == b.v_idx && a.vt_idx == std::max(b.vt_idx, -1) && a.vn_idx == std::max(b.vn_idx, -1);
+        }
+        allSame = allSame && same;
+
+        printf("  chunked %3u threads %10.2f ms  %8.1f MB/s  %5.2fx  %s (max error %g)\n", threads, ms,
+            megabytes / (ms / 1000.0), ms > 0.0 ? tinyMs / ms : 0.0, same ? "identical" : "MISMATCH", double(maxError));
+
+        if (threads >= maxThreads)
+        {
+            break;
+        }
+    }
+
+    tinyobj_attrib_free(&attrib);
+    tinyobj_shapes_free(shapes, numShapes);
+    tinyobj_materials_free(materials, numMaterials);
+    return allSame;
+}
+
+// Reference dedup keyed on the full index triple
+struct CornerKeyHash
+{
+    size_t operator()(const std::tuple<int, int, int>& key) const
+    {
+        auto [v, vt, vn] = key;
+        return std::hash<uint64_t>()((uint64_t(uint32_t(v)) << 32 | uint32_t(vt)) ^ (uint64_t(uint32_t(vn)) * 0x9E3779B97F4A7C15ull));
+    }
+};
+
+// Grid of 1200 x 1000 positions, so every attribute count exceeds 2^20:
+// texcoords get seams (duplicated columns), normals are per face on some
+// rows and per position on others, and some rows lack vt or vn
+static std::vector<tinyobj_vertex_index_t> SyntheticCorners(size_t& attributeCount)
+{
+    const int width = 1200;
+    const int height = 1000;
+    const int positionCount = width * height;
+
+    std::vector<tinyobj_vertex_index_t> corners;
+    corners.reserve(size_t(width - 1) * (height - 1) * 6);
+    int face = 0;
+    for (int y = 0; y + 1 < height; y++)
+    {
+        for (int x = 0; x + 1 < width; x++)
+        {
+            const int cell[6][2] = { { x, y }, { x + 1, y }, { x + 1, y + 1 }, { x, y }, { x + 1, y + 1 }, { x, y + 1 } };
+            for (int k = 0; k < 6; k++)
+            {
+                if (k % 3 == 0)
+                {
+                    face++;
+                }
+                int v = cell[k][1] * width + cell[k][0];
+                int vt = (y % 11 == 10) ? -1 : (y % 2 == 1 && cell[k][0] % 5 == 0) ? v + positionCount : v;
+                int vn = (y % 3 == 0) ? face - 1 : (y % 3 == 1) ? v : -1;
+                corners.push_back({ v, vt, vn });
+            }
+        }
+    }
+    attributeCount = size_t(positionCount) * 2;
+    return corners;
+}
+
+// Dedup with both VertexDedup methods and a std::unordered_map reference,
+// check that all three agree and count the corners the old 64-bit key
+// ((v << 40) | (vn << 20) | vt) would have merged wrongly
+static bool BenchDedup(const std::filesystem::path& objPath)
+{
+    OBJAttributes attributes;
+    std::vector<tinyobj_vertex_index_t> synthetic;
+    std::span<const tinyobj_vertex_index_t> corners;
+    size_t attributeCount = 0;
+    if (objPath.empty())
+    {
+        synthetic = SyntheticCorners(attributeCount);
+        corners = synthetic;
+        printf("Vertex dedup (synthetic grid, %zu corners):\n", corners.size());
+    }
+    else
+    {
+        if (!ParseOBJChunked(objPath, 0, attributes))
+        {
+            return false;
+        }
+        corners = attributes.corners;
+        attributeCount = std::max({ attributes.positions.size() / 3, attributes.normals.size() / 3, attributes.texcoords.size() / 2 });
+        printf("Vertex dedup (%s, %zu corners):\n", objPath.filename().string().c_str(), corners.size());
+    }
+
+    auto referenceStart = std::chrono::steady_clock::now();
+    std::unordered_map<std::tuple<int, int, int>, uint32_t, CornerKeyHash> referenceMap;
+    std::vector<uint32_t> referenceIndices(corners.size());
+    for (size_t c = 0; c < corners.size(); c++)
+    {
+        const tinyobj_vertex_index_t& corner = corners[c];
+        auto key = std::make_tuple(corner.v_idx, std::max(corner.vt_idx, -1), std::max(corner.vn_idx, -1));
+        referenceIndices[c] = referenceMap.try_emplace(key, static_cast<uint32_t>(referenceMap.size())).first->second;
+    }
+    double referenceMs = ElapsedMs(referenceStart);
+
+    std::unordered_map<uint64_t, uint32_t> oldMap;
+    for (const tinyobj_vertex_index_t& corner : corners)
+    {
+        uint64_t key = (uint64_t(corner.v_idx) << 40) | (uint64_t(corner.vn_idx) << 20) | uint64_t(corner.vt_idx);
+        oldMap.try_emplace(key, 0);
+    }
+
+    printf("  unordered_map  %10.2f ms  %zu vertices\n", referenceMs, referenceMap.size());
+    printf("  old 64-bit key                %zu vertices (%zd aliased)\n", oldMap.size(),
+        static_cast<ptrdiff_t>(referenceMap.size()) - static_cast<ptrdiff_t>(oldMap.size()));
+
+    bool allSame = true;
+    for (VertexDedup::Method method : { VertexDedup::Method::Hash, VertexDedup::Method::Radix })
+    {
+        auto start = std::chrono::steady_clock::now();
+        VertexDedup dedup;
+        dedup.Build(corners, attributeCount, method);
+        double ms = ElapsedMs(start);
+
+        bool same = dedup.cornerVertex == referenceIndices && dedup.VertexCount() == referenceMap.size();
+        allSame = allSame && same;
+        printf("  %-14s %10.2f ms  %zu vertices  %5.2fx  %s\n", method == VertexDedup::Method::Hash ? "hash" : "radix",
+            ms, dedup.VertexCount(), ms > 0.0 ? referenceMs / ms : 0.0, same ? "identical" : "MISMATCH");
+    }
+    return allSame;
+}
+
+// Triangles of `indices` with each rotated to start at its smallest index,
+// sorted: equal for two index buffers that only differ in triangle order
+static std::vector<std::array<uint32_t, 3>> CanonicalTriangles(std::span<const uint32_t> indices)
+{
+    std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+    for (size_t t = 0; t < triangles.size(); t++)
+    {
+        const uint32_t* corner = &indices[t * 3];
+        size_t first = corner[1] < corner[0] ? 1 : 0;
+        first = corner[2] < corner[first] ? 2 : first;
+        triangles[t] = { corner[first], corner[(first + 1) % 3], corner[(first + 2) % 3] };
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+// Dedup an OBJ (default: a smoothly shaded 1024 x 1024 vertex grid in row
+// order, as scanned meshes and heightfields come), reorder it with the
+// vertex cache and fetch passes and report ACMR/ATVR before and after.
+// Exits non-zero if the triangles changed.
+static bool BenchVertexCache(const std::filesystem::path& objPath)
+{
+    std::vector<uint32_t> indices;
+    size_t vertexCount = 0;
+    if (objPath.empty())
+    {
+        const uint32_t width = 1024;
+        vertexCount = size_t(width) * width;
+        indices.reserve(size_t(width - 1) * (width - 1) * 6);
+        for (uint32_t y = 0; y + 1 < width; y++)
+        {
+            for (uint32_t x = 0; x + 1 < width; x++)
+            {
+                const uint32_t v = y * width + x;
+                indices.insert(indices.end(), { v, v + 1, v + width + 1, v, v + width + 1, v + width });
+            }
+        }
+    }
+    else
+    {
+        OBJAttributes attributes;
+        if (!ParseOBJChunked(objPath, 0, attributes))
+        {
+            return false;
+        }
+        VertexDedup dedup;
+        dedup.Build(attributes.corners, std::max({ attributes.positions.size() / 3, attributes.normals.size() / 3,
+                                                   attributes.texcoords.size() / 2 }));
+        vertexCount = dedup.VertexCount();
+        indices = std::move(dedup.cornerVertex);
+    }
+    printf("Vertex cache (%s, %zu triangles, %zu vertices):\n",
+        objPath.empty() ? "synthetic grid" : objPath.filename().string().c_str(), indices.size() / 3, vertexCount);
+
+    const VertexCacheStats before16 = AnalyzeVertexCache(indices, vertexCount, 16);
+    const VertexCacheStats before32 = AnalyzeVertexCache(indices, vertexCount, 32);
+    std::vector<uint32_t> original = indices;
+
+    auto cacheStart = std::chrono::steady_clock::now();
+    OptimizeVertexCache(indices, vertexCount);
+    double cacheMs = ElapsedMs(cacheStart);
+    auto fetchStart = std::chrono::steady_clock::now();
+    std::vector<uint32_t> remap = OptimizeVertexFetch(indices, vertexCount);
+    double fetchMs = ElapsedMs(fetchStart);
+
+    const VertexCacheStats after16 = AnalyzeVertexCache(indices, vertexCount, 16);
+    const VertexCacheStats after32 = AnalyzeVertexCache(indices, vertexCount, 32);
+
+    for (uint32_t& index : original)
+    {
+        index = remap[index];
+    }
+    bool same = CanonicalTriangles(original) == CanonicalTriangles(indices);
+
+    const double triangles = double(indices.size() / 3);
+    printf("  triangle order %10.2f ms  (%.0f ns per triangle)\n", cacheMs, triangles > 0 ? cacheMs * 1e6 / triangles : 0.0);
+    printf("  vertex order   %10.2f ms\n", fetchMs);
+    printf("  FIFO 16   ACMR %.3f -> %.3f   ATVR %.3f -> %.3f\n", before16.acmr, after16.acmr, before16.atvr, after16.atvr);
+    printf("  FIFO 32   ACMR %.3f -> %.3f   ATVR %.3f -> %.3f\n", before32.acmr, after32.acmr, before32.atvr, after32.atvr);
+    printf("  triangles %s\n", same ? "unchanged" : "MISMATCH");
+    return same;
+}
+
+struct LODVertex
+{
+    float position[3];
+    float normal[3];
+    float texcoord[2];
+};
+
+// Directed edges of `indices` whose reverse is missing,
+// with vertices at the same position counted as one
+static size_t OpenEdges(const std::vector<LODVertex>& vertices, std::span<const uint32_t> indices)
+{
+    std::map<std::array<float, 3>, uint32_t> positionIds;
+    std::vector<uint32_t> positionId(vertices.size());
+    for (size_t v = 0; v < vertices.size(); v++)
+    {
+        const float* p = vertices[v].position;
+        positionId[v] = positionIds.try_emplace({ p[0], p[1], p[2] }, uint32_t(positionIds.size())).first->second;
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        const size_t next = i - i % 3 + (i % 3 + 1) % 3;
+        edges.emplace_back(positionId[indices[i]], positionId[indices[next]]);
+    }
+    std::sort(edges.begin(), edges.end());
+    size_t open = 0;
+    for (const auto& [a, b] : edges)
+    {
+        open += std::binary_search(edges.begin(), edges.end(), std::make_pair(b, a)) ? 0 : 1;
+    }
+    return open;
+}
+
+// Build the LOD chain of an OBJ (default: a 512 x 256 segment sphere with
+// bumps and a texcoord seam) as the rasterizer does, and report each level
+// and the triangles a 1 pixel error bound draws at a range of distances, for
+// a 1080 pixel high, 60 degree view. Exits non-zero if a level indexes past
+// the vertices, is not coarser than the previous one, or opens a hole in a
+// mesh that was closed.
+static bool BenchLOD(const std::filesystem::path& objPath)
+{
+    std::vector<LODVertex> vertices;
+    std::vector<uint32_t> indices;
+    if (objPath.empty())
+    {
+        const uint32_t segments = 512;
+        const uint32_t rings = 256;
+        for (uint32_t r = 0; r <= rings; r++)
+        {
+            for (uint32_t s = 0; s <= segments; s++)
+            {
+                const float theta = HMM_PI32 * float(r) / float(rings);
+                const float phi = 2.0f * HMM_PI32 * float(s % segments) / float(segments);
+                HMM_Vec3 n = HMM_V3(sinf(theta) * cosf(phi), sinf(theta) * sinf(phi), cosf(theta));
+                if (r == 0 || r == rings)
+                {
+                    n = HMM_V3(0.0f, 0.0f, r == 0 ? 1.0f : -1.0f);
+                }
+                const float radius = 1.0f + 0.02f * sinf(8.0f * theta) * sinf(8.0f * phi);
+                vertices.push_back({ { n.X * radius, n.Y * radius, n.Z * radius }, { n.X, n.Y, n.Z },
+                                     { float(s) / float(segments), float(r) / float(rings) } });
+            }
+        }
+        for (uint32_t r = 0; r < rings; r++)
+        {
+            for (uint32_t s = 0; s < segments; s++)
+            {
+                const uint32_t v = r * (segments + 1) + s;
+                const uint32_t below = v + segments + 1;
+                if (r > 0)
+                {
+                    indices.insert(indices.end(), { v, below, v + 1 });
+                }
+                if (r + 1 < rings)
+                {
+                    indices.insert(indices.end(), { v + 1, below, below + 1 });
+                }
+            }
+        }
+    }
+    else
+    {
+        OBJAttributes attributes;
+        if (!ParseOBJChunked(objPath, 0, attributes))
+        {
+            return false;
+        }
+        VertexDedup dedup;
+        dedup.Build(attributes.corners, std::max({ attributes.positions.size() / 3, attributes.normals.size() / 3,
+                                                   attributes.texcoords.size() / 2 }));
+        vertices.resize(dedup.VertexCount());
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            const tinyobj_vertex_index_t& corner = attributes.corners[dedup.firstCorner[i]];
+            LODVertex& vertex = vertices[i];
+            memcpy(vertex.position, &attributes.positions[3 * corner.v_idx], sizeof(vertex.position));
+            if (corner.vn_idx >= 0)
+            {
+                memcpy(vertex.normal, &attributes.normals[3 * corner.vn_idx], sizeof(vertex.normal));
+            }
+            if (corner.vt_idx >= 0)
+            {
+                memcpy(vertex.texcoord, &attributes.texcoords[2 * corner.vt_idx], sizeof(vertex.texcoord));
+            }
+        }
+        indices = std::move(dedup.cornerVertex);
+    }
+    if (vertices.empty() || indices.empty())
+    {
+        return false;
+    }
+
+    OptimizeVertexCache(indices, vertices.size());
+    RemapVertices(vertices, OptimizeVertexFetch(indices, vertices.size()));
+    const size_t fullIndexCount = indices.size();
+    const LODVertex& first = vertices.front();
+    const SimplifyVertices simplify = { first.position, first.normal, first.texcoord, sizeof(LODVertex), vertices.size() };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<MeshLOD> lods = BuildLODChain(simplify, indices);
+    double ms = ElapsedMs(start);
+
+    // Bounding sphere around the box centre, as the rasterizer's
+    HMM_Vec3 lower = HMM_V3(INFINITY, INFINITY, INFINITY);
+    HMM_Vec3 upper = HMM_V3(-INFINITY, -INFINITY, -INFINITY);
+    for (const LODVertex& vertex : vertices)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            lower.Elements[k] = std::min(lower.Elements[k], vertex.position[k]);
+            upper.Elements[k] = std::max(upper.Elements[k], vertex.position[k]);
+        }
+    }
+    const HMM_Vec3 center = HMM_MulV3F(HMM_AddV3(lower, upper), 0.5f);
+    float radius = 0.0f;
+    for (const LODVertex& vertex : vertices)
+    {
+        HMM_Vec3 position = HMM_V3(vertex.position[0], vertex.position[1], vertex.position[2]);
+        radius = std::max(radius, HMM_LenV3(HMM_SubV3(position, center)));
+    }
+    printf("LOD chain (%s, %zu triangles, %zu vertices): %zu levels in %.2f ms (%.0f ns per triangle)\n",
+        objPath.empty() ? "synthetic sphere" : objPath.filename().string().c_str(), fullIndexCount / 3,
+        vertices.size(), lods.size(), ms, ms * 1e6 / double(fullIndexCount / 3));
+
+    // Pixels per unit at distance 1 for the reference view
+    const float pixelsPerUnit = 1080.0f / (2.0f * tanf(HMM_PI32 / 6.0f));
+    const size_t closedOpenEdges = OpenEdges(vertices, std::span(indices).first(fullIndexCount));
+    bool valid = lods.front().indexOffset == 0 && lods.front().indexCount == fullIndexCount;
+    for (size_t level = 0; level < lods.size(); level++)
+    {
+        const MeshLOD& lod = lods[level];
+        std::span<const uint32_t> levelIndices = std::span(indices).subspan(lod.indexOffset, lod.indexCount);
+        bool ok = lod.indexCount % 3 == 0
+               && std::all_of(levelIndices.begin(), levelIndices.end(), [&](uint32_t i) { return i < vertices.size(); });
+        if (level > 0)
+        {
+            ok = ok && lod.indexCount < lods[level - 1].indexCount && lod.error >= lods[level - 1].error;
+        }
+        const size_t open = OpenEdges(vertices, levelIndices);
+        ok = ok && (closedOpenEdges > 0 || open == 0);
+        valid = valid && ok;
+        printf("  level %zu %10u triangles  %6.2f%%  error %.5f (%.3f%% of radius)  open edges %6zu  1 px from %8.1f radii  %s\n",
+            level, lod.indexCount / 3, 100.0 * double(lod.indexCount) / double(fullIndexCount), lod.error,
+            radius > 0.0f ? 100.0f * lod.error / radius : 0.0f, open,
+            radius > 0.0f ? 1.0f + lod.error * pixelsPerUnit / radius : 0.0f, ok ? "ok" : "INVALID");
+    }
+
+    // Same rule as MitsubaSceneRasterizer::SelectLOD, with the sphere centred
+    // `distance` radii in front of the camera
+    printf("  at 1 px error, 1080p, 60 degree vertical FOV:\n");
+    for (float distance : { 2.0f, 4.0f, 8.0f, 16.0f, 32.0f, 64.0f, 128.0f })
+    {
+        const float pixelsPerObjectUnit = pixelsPerUnit / std::max((distance - 1.0f) * radius, 0.1f);
+        size_t level = 0;
+        while (level + 1 < lods.size() && lods[level + 1].error * pixelsPerObjectUnit <= 1.0f)
+        {
+            level++;
+        }
+        printf("    %6.0f radii away  level %zu  %10u triangles  %5.1f%% fewer\n", distance, level,
+            lods[level].indexCount / 3, 100.0 * (1.0 - double(lods[level].indexCount) / double(fullIndexCount)));
+    }
+    printf("  levels %s\n", valid ? "valid" : "INVALID");
+    return valid;
+}
+
+// Transform `vertexCount` synthetic vertices (every 16th without a normal)
+// the way mesh ingest did before the batched kernel, one HMM_MulM4V4 per
+// attribute, then with every TransformVertices() path. Positions must match
+// the old code and all paths each other; exits non-zero otherwise.
+static bool BenchTransform(size_t vertexCount)
+{
+    std::vector<MeshVertex> local(vertexCount);
+    uint32_t state = 1;
+    auto next = [&state]()
+    {
+        state = state * 1664525u + 1013904223u;
+        return float(state >> 8) / float(1 << 24) * 2.0f - 1.0f;
+    };
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        MeshVertex& vertex = local[i];
+        vertex = {};
+        for (int k = 0; k < 3; k++)
+        {
+            vertex.position[k] = 100.0f * next();
+            vertex.normal[k] = i % 16 == 15 ? 0.0f : next();
+        }
+        vertex.texcoord[0] = next();
+        vertex.texcoord[1] = next();
+    }
+
+    // Non-uniform scale, where the forward matrix bends normals
+    const HMM_Mat4 transform = HMM_MulM4(HMM_MulM4(HMM_Translate(HMM_V3(1.0f, 2.0f, 3.0f)),
+        HMM_Rotate_RH(0.7f, HMM_NormV3(HMM_V3(1.0f, 2.0f, 3.0f)))), HMM_Scale(HMM_V3(4.0f, 1.0f, 0.25f)));
+    printf("Vertex transform (%zu vertices, %.2f MB):\n", vertexCount, double(vertexCount * sizeof(MeshVertex)) / (1024.0 * 1024.0));
+
+    const int runs = 5;
+    std::vector<MeshVertex> old(vertexCount);
+    std::vector<double> oldMs;
+    for (int run = 0; run < runs; run++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < vertexCount; i++)
+        {
+            const MeshVertex& in = local[i];
+            MeshVertex& out = old[i];
+            out = {};
+            HMM_Vec4 position = HMM_MulM4V4(transform, HMM_V4(in.position[0], in.position[1], in.position[2], 1.0f));
+            memcpy(out.position, position.Elements, sizeof(out.position));
+            HMM_Vec4 normal = HMM_MulM4V4(transform, HMM_V4(in.normal[0], in.normal[1], in.normal[2], 0.0f));
+            HMM_Vec3 n = HMM_NormV3(normal.XYZ);
+            memcpy(out.normal, n.Elements, sizeof(out.normal));
+            memcpy(out.texcoord, in.texcoord, sizeof(out.texcoord));
+        }
+        oldMs.push_back(ElapsedMs(start));
+    }
+    const double referenceMs = Median(oldMs);
+    printf("  per-vertex HMM %10.2f ms\n", referenceMs);
+
+    bool allSame = true;
+    std::vector<MeshVertex> first;
+    const VertexTransformPath best = BestVertexTransformPath();
+    for (VertexTransformPath path : { VertexTransformPath::Scalar, VertexTransformPath::SSE, VertexTransformPath::AVX })
+    {
+        if (int(path) > int(best))
+        {
+            printf("  %-14s not supported\n", VertexTransformPathName(path));
+            continue;
+        }
+
+        // The kernel works in place, so each run starts from a fresh copy;
+        // only the transform itself is timed
+        std::vector<MeshVertex> vertices;
+        std::vector<double> ms;
+        for (int run = 0; run < runs; run++)
+        {
+            vertices = local;
+            auto start = std::chrono::steady_clock::now();
+            TransformVertices(VertexTransform(transform), vertices, path);
+            ms.push_back(ElapsedMs(start));
+        }
+
+        size_t positionMismatches = 0;
+        for (size_t i = 0; i < vertexCount; i++)
+        {
+            positionMismatches += memcmp(vertices[i].position, old[i].position, sizeof(old[i].position)) != 0;
+        }
+        if (first.empty())
+        {
+            first = vertices;
+        }
+        bool same = positionMismatches == 0 && SameBytes(vertices, first);
+        allSame = allSame && same;
+        printf("  %-14s %10.2f ms  %5.2fx  %s\n", VertexTransformPathName(path), Median(ms),
+            Median(ms) > 0.0 ? referenceMs / Median(ms) : 0.0, same ? "identical" : "MISMATCH");
+    }
+    return allSame;
+}
+
+// Pack and unpack `vertexCount` random vertices plus hand-picked hard cases
+// (axes, octahedron edges and folds, half-float limits) and check the
+// round-trip errors against the bounds in vertex_format.h; exits non-zero
+// if one is exceeded
+static bool BenchVertexFormat(size_t vertexCount)
+{
+    uint32_t state = 7;
+    auto next = [&state]()
+    {
+        state = state * 1664525u + 1013904223u;
+        return float(state >> 8) / float(1 << 24) * 2.0f - 1.0f;
+    };
+
+    std::vector<MeshVertex> vertices;
+    vertices.reserve(vertexCount + 64);
+    const float edge = 0.70710678f;
+    const float hardNormals[][3] = {
+        { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+        { edge, edge, 0 }, { -edge, edge, 0 }, { edge, 0, -edge }, { 0, -edge, -edge },
+        { 1e-7f, 0, -1 }, { -1e-7f, 1e-7f, -1 }, { 0.57735027f, -0.57735027f, -0.57735027f }
+    };
+    const float hardTexcoords[][2] = {
+        { 0, 0 }, { -0.0f, 1 }, { 65504, -65504 }, { 6.1035156e-5f, 5.9604645e-8f }, { 2.9802322e-8f, 1e-30f },
+        { 0.99951171875f, 1.00048828125f }, { 1000.3f, -1000.3f }
+    };
+    for (size_t i = 0; i < std::size(hardNormals) || i < std::size(hardTexcoords); i++)
+    {
+        MeshVertex vertex = {};
+        memcpy(vertex.normal, hardNormals[i % std::size(hardNormals)], sizeof(vertex.normal));
+        memcpy(vertex.texcoord, hardTexcoords[i % std::size(hardTexcoords)], sizeof(vertex.texcoord));
+        vertices.push_back(vertex);
+    }
+    while (vertices.size() < vertexCount)
+    {
+        // Rejection-sample a direction; texcoords span 2^-26 .. 2^16
+        MeshVertex vertex = {};
+        float x, y, z, lengthSquared;
+        do
+        {
+            x = next();
+            y = next();
+            z = next();
+            lengthSquared = x * x + y * y + z * z;
+        } while (lengthSquared > 1.0f || lengthSquared < 1e-6f);
+        const float scale = 1.0f / sqrtf(lengthSquared);
+        vertex.position[0] = next();
+        vertex.normal[0] = x * scale;
+        vertex.normal[1] = y * scale;
+        vertex.normal[2] = z * scale;
+        vertex.texcoord[0] = ldexpf(next(), int(vertices.size() % 43) - 26);
+        vertex.texcoord[1] = next() * 4.0f;
+        vertices.push_back(vertex);
+    }
+
+    const size_t packedSize = sizeof(GPUPosition) + sizeof(GPUVertex);
+    printf("Vertex format (%zu vertices, %zu -> %zu bytes each, %.2f -> %.2f MB):\n", vertices.size(),
+        sizeof(MeshVertex), packedSize, double(vertices.size() * sizeof(MeshVertex)) / (1024.0 * 1024.0),
+        double(vertices.size() * packedSize) / (1024.0 * 1024.0));
+
+    std::vector<GPUPosition> positions(vertices.size());
+    std::vector<GPUVertex> packed(vertices.size());
+    auto packStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        PackVertex(vertices[i], positions[i], packed[i]);
+    }
+    double packMs = ElapsedMs(packStart);
+
+    std::vector<MeshVertex> unpacked(vertices.size());
+    auto unpackStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        unpacked[i] = UnpackVertex(positions[i], packed[i]);
+    }
+    double unpackMs = ElapsedMs(unpackStart);
+
+    double maxNormalError = 0.0;
+    double maxTexcoordExcess = 0.0;     // Error over its bound, <= 1 passes
+    size_t positionMismatches = 0;
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        const float* a = vertices[i].normal;
+        const float* b = unpacked[i].normal;
+        double cross[3] = { double(a[1]) * b[2] - double(a[2]) * b[1], double(a[2]) * b[0] - double(a[0]) * b[2],
+                            double(a[0]) * b[1] - double(a[1]) * b[0] };
+        double dot = double(a[0]) * b[0] + double(a[1]) * b[1] + double(a[2]) * b[2];
+        maxNormalError = std::max(maxNormalError,
+            atan2(sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]), dot));
+
+        for (int k = 0; k < 2; k++)
+        {
+            double value = std::clamp(double(vertices[i].texcoord[k]), -65504.0, 65504.0);
+            double bound = std::max(fabs(value) * kPackedTexcoordRelativeError, double(kPackedTexcoordAbsoluteError));
+            maxTexcoordExcess = std::max(maxTexcoordExcess, fabs(double(unpacked[i].texcoord[k]) - value) / bound);
+        }
+        positionMismatches += memcmp(vertices[i].position, unpacked[i].position, sizeof(float) * 3) != 0;
+    }
+
+    bool normalOk = maxNormalError <= kPackedNormalMaxError;
+    bool texcoordOk = maxTexcoordExcess <= 1.0;
+    printf("  pack     %10.2f ms\n", packMs);
+    printf("  unpack   %10.2f ms\n", unpackMs);
+    printf("  normal   max %.3g rad (bound %.3g)  %s\n", maxNormalError, double(kPackedNormalMaxError), normalOk ? "ok" : "EXCEEDED");
+    printf("  texcoord max %.3f of bound  %s\n", maxTexcoordExcess, texcoordOk ? "ok" : "EXCEEDED");
+    printf("  position %zu changed\n", positionMismatches);
+    return normalOk && texcoordOk && positionMismatches == 0;
+}
+
+// Make sure the binary cache is current, then time what a warm start does:
+// parse the XML, hash the sources and map the cache. Fails if the cached
+// arrays differ from `geometry`.
+static bool BenchCache(const std::filesystem::path& scenePath, MitsubaSceneParser& parser, const SceneGeometry& geometry)
+{
+    std::filesystem::path cachePath = SceneCache::PathFor(scenePath);
+    uint64_t key = SceneCache::ComputeKey(parser, scenePath, geometry);
+
+    double writeMs = 0.0;
+    SceneCache cache;
+    if (!cache.Open(cachePath, key))
+    {
+        auto writeStart = std::chrono::steady_clock::now();
+        if (!SceneCache::Write(cachePath, key, PackedScene::FromGeometry(geometry, parser)))
+        {
+            return false;
+        }
+        writeMs = ElapsedMs(writeStart);
+    }
+    cache.Close();
+
+    auto warmStart = std::chrono::steady_clock::now();
+    MitsubaSceneParser warmParser;
+    warmParser.parameters = parser.parameters;
+    if (!warmParser.Parse(scenePath))
+    {
+        return false;
+    }
+    auto openStart = std::chrono::steady_clock::now();
+    bool opened = cache.Open(cachePath, SceneCache::ComputeKey(warmParser, scenePath, geometry));
+    double openMs = ElapsedMs(openStart);
+    double warmMs = ElapsedMs(warmStart);
+
+    printf("Scene cache:\n");
+    if (writeMs > 0.0)
+    {
+        printf("  Write        %10.2f ms\n", writeMs);
+    }
+    if (!opened)
+    {
+        printf("  Could not open %s\n", cachePath.string().c_str());
+        return false;
+    }
+
+    const PackedScene& cached = cache.Scene();
+    auto same = [](auto cachedSpan, const auto& vector)
+    {
+        return cachedSpan.size() == vector.size() &&
+               (vector.empty() || memcmp(cachedSpan.data(), vector.data(), cachedSpan.size_bytes()) == 0);
+    };
+    bool matches = same(cached.positions, geometry.positions) && same(cached.vertices, geometry.vertices) &&
+                   same(cached.indices, geometry.indices) && same(cached.materials, geometry.materials) &&
+                   same(cached.instances, geometry.instances) && same(cached.meshes, geometry.meshes) &&
+                   same(cached.placements, geometry.placements) && same(cached.analyticShapes, geometry.analyticShapes);
+    printf("  Key + map    %10.2f ms (%.2f MB file, %s)\n", openMs, double(cache.FileSize()) / (1024.0 * 1024.0),
+        matches ? "matches" : "MISMATCH");
+    printf("  Warm start   %10.2f ms (XML parse + texture probe + key + map)\n", warmMs);
+    return matches;
+}
+
+// A scene copied under the system temp directory; the copy is removed on
+// destruction
+struct SceneCopy
+{
+    std::filesystem::path directory;
+    std::filesystem::path xmlPath;
+
+    ~SceneCopy()
+    {
+        std::error_code ec;
+        if (!directory.empty())
+        {
+            std::filesystem::remove_all(directory, ec);
+        }
+    }
+};
+
+// Copy the XML, its fragments and every file it references, keeping their
+// paths relative to the scene directory. Missing files stay missing.
+static bool CopyScene(const MitsubaSceneParser& parser, const std::filesystem::path& scenePath, SceneCopy& copy)
+{
+    std::error_code ec;
+    std::filesystem::path directory =
+        std::filesystem::temp_directory_path(ec) / ("scene_stats_reload_" + std::to_string(std::random_device()()));
+    if (ec || !std::filesystem::create_directories(directory, ec))
+    {
+        printf("  Could not create %s\n", directory.string().c_str());
+        return false;
+    }
+    copy.directory = directory;
+
+    const std::filesystem::path sceneDirectory = std::filesystem::absolute(scenePath).parent_path();
+    std::vector<std::filesystem::path> files = parser.ReferencedFiles();
+    files.push_back(scenePath);
+    for (const std::filesystem::path& file : files)
+    {
+        std::filesystem::path relative = std::filesystem::absolute(file).lexically_normal().lexically_relative(sceneDirectory);
+        if (relative.empty() || *relative.begin() == "..")
+        {
+            printf("  %s is outside the scene directory\n", file.string().c_str());
+            return false;
+        }
+        std::filesystem::path target = directory / relative;
+        if (file == scenePath)
+        {
+            copy.xmlPath = target;
+        }
+        if (!std::filesystem::exists(file, ec))
+        {
+            continue;
+        }
+        std::filesystem::create_directories(target.parent_path(), ec);
+        if (!std::filesystem::copy_file(file, target, std::filesystem::copy_options::overwrite_existing, ec))
+        {
+            printf("  Could not copy %s\n", file.string().c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool ReadWholeFile(const std::filesystem::path& path, std::string& contents)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// Save `contents` over `path` like an editor would. The modification time
+// moves forward even where the file system keeps it in whole seconds, so
+// the FileWatcher sees every save.
+static bool RewriteFile(const std::filesystem::path& path, std::string_view contents)
+{
+    std::error_code ec;
+    const std::filesystem::file_time_type before = std::filesystem::last_write_time(path, ec);
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(contents.data(), std::streamsize(contents.size()));
+        if (!file)
+        {
+            return false;
+        }
+    }
+    if (!ec && std::filesystem::last_write_time(path, ec) <= before)
+    {
+        std::filesystem::last_write_time(path, before + std::chrono::seconds(1), ec);
+    }
+    return true;
+}
+
+// The RGB reflectance of a top-level BSDF that a top-level shape references,
+// or an empty attribute. Parameter references ($name) are left alone.
+static pugi::xml_attribute UsedReflectance(pugi::xml_node sceneNode)
+{
+    for (pugi::xml_node bsdf : sceneNode.children("bsdf"))
+    {
+        std::string_view id = bsdf.attribute("id").value();
+        bool used = false;
+        for (pugi::xml_node shape : sceneNode.children("shape"))
+        {
+            used = used || (!id.empty() && id == shape.child("ref").attribute("id").value());
+        }
+        pugi::xml_node rgb = bsdf.find_node([](pugi::xml_node node)
+        {
+            std::string_view name = node.attribute("name").value();
+            return std::string_view(node.name()) == "rgb" && (name == "reflectance" || name == "diffuse_reflectance") &&
+                   node.attribute("value").value()[0] != '$';
+        });
+        if (used && rgb)
+        {
+            return rgb.attribute("value");
+        }
+    }
+    return {};
+}
+
+// Raise the first top-level mesh or rectangle shape by 0.1 through its
+// to_world matrix, the only transform element the parser reads
+static bool MoveShape(pugi::xml_node sceneNode)
+{
+    for (pugi::xml_node shape : sceneNode.children("shape"))
+    {
+        std::string_view type = shape.attribute("type").value();
+        if (type != "obj" && type != "ply" && type != "serialized" && type != "rectangle")
+        {
+            continue;
+        }
+        pugi::xml_node transform = shape.child("transform");
+        pugi::xml_node matrix = transform.child("matrix");
+        float values[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+        if (matrix && parse_utils::ParseList(std::string_view(matrix.attribute("value").value()), values, 16) != 16)
+        {
+            continue;
+        }
+        values[7] += 0.1f;  // Row-major: the Y translation
+
+        std::string text;
+        for (float value : values)
+        {
+            char number[32];
+            snprintf(number, sizeof(number), text.empty() ? "%.9g" : " %.9g", value);
+            text += number;
+        }
+        if (!transform)
+        {
+            transform = shape.prepend_child("transform");
+            transform.append_attribute("name").set_value("to_world");
+        }
+        if (!matrix)
+        {
+            matrix = transform.append_child("matrix");
+            matrix.append_attribute("value");
+        }
+        matrix.attribute("value").set_value(text.c_str());
+        return true;
+    }
+    return false;
+}
+
+// Raise the first vertex of an OBJ file and save the whole file again
+static bool NudgeFirstVertex(const std::filesystem::path& objPath)
+{
+    std::string text;
+    if (!ReadWholeFile(objPath, text))
+    {
+        return false;
+    }
+    size_t line = text.starts_with("v ") ? 0 : text.find("\nv ");
+    if (line == std::string::npos)
+    {
+        return false;
+    }
+    line += text[line] == '\n' ? 1 : 0;
+
+    // Y is the third token of the line; whatever follows it is kept
+    size_t y = line;
+    for (int token = 0; token < 2 && y != std::string::npos; token++)
+    {
+        y = text.find_first_of(" \t", y);
+        y = y == std::string::npos ? y : text.find_first_not_of(" \t", y);
+    }
+    if (y == std::string::npos || text[y] == '\r' || text[y] == '\n')
+    {
+        return false;
+    }
+    size_t yEnd = std::min(text.find_first_of(" \t\r\n", y), text.size());
+    char value[32];
+    snprintf(value, sizeof(value), "%.9g", strtof(text.c_str() + y, nullptr) + 0.01f);
+    text.replace(y, yEnd - y, value);
+    return RewriteFile(objPath, text);
+}
+
+// Copy the scene to a temp directory, save edits to its files there and
+// reload from what a FileWatcher reports, as rt_scene --watch does. Every
+// edit has to come back as its minimal SceneDelta.
+static bool RunReloadEdits(const std::filesystem::path& scenePath)
+{
+    // Textures are only listed once their headers are probed
+    MitsubaSceneParser original;
+    SceneCopy copy;
+    if (!original.Parse(scenePath) || !CopyScene(original, scenePath, copy))
+    {
+        return false;
+    }
+
+    auto parser = std::make_unique<MitsubaSceneParser>();
+    SceneGeometry geometry;
+    geometry.keepShapesLocal = true;
+    pugi::xml_document document;
+    if (!parser->Parse(copy.xmlPath) || !geometry.Load(*parser) || !document.load_file(copy.xmlPath.c_str()))
+    {
+        return false;
+    }
+    parser->DecodeTextures(geometry.UsedTextureIndices());
+
+    FileWatcher watcher;
+    std::vector<std::filesystem::path> watched = parser->ReferencedFiles();
+    watched.push_back(copy.xmlPath);
+    watcher.SetFiles(std::move(watched));
+
+    printf("Hot reload (local-space layout, %zu meshes, %zu instances, copy in %s):\n", geometry.meshes.size(),
+        geometry.instances.size(), copy.directory.string().c_str());
+
+    // rt_scene's ReloadChangedFiles() without the uploads
+    std::vector<std::filesystem::path> changed;
+    std::vector<int> invalidated;
+    auto reload = [&](const char* label, SceneDelta& delta)
+    {
+        // The first poll sees the new stamps, the second reports them settled
+        watcher.Poll(std::chrono::milliseconds(0));
+        changed = watcher.Poll(std::chrono::milliseconds(0));
+        invalidated.clear();
+
+        auto start = std::chrono::steady_clock::now();
+        const std::vector<std::filesystem::path>& fragments = parser->includedFiles;
+        bool xmlChanged = std::any_of(changed.begin(), changed.end(), [&](const std::filesystem::path& file)
+        {
+            return file == copy.xmlPath || std::find(fragments.begin(), fragments.end(), file) != fragments.end();
+        });
+        std::unique_ptr<MitsubaSceneParser> reparsed;
+        if (xmlChanged)
+        {
+            reparsed = std::make_unique<MitsubaSceneParser>();
+            if (!reparsed->Parse(copy.xmlPath))
+            {
+                printf("  %-14s the edited XML does not parse\n", label);
+                return false;
+            }
+            reparsed->AdoptDecodedTextures(*parser, changed);
+        }
+        else
+        {
+            invalidated = parser->InvalidateTextures(changed);
+        }
+        MitsubaSceneParser& scene = reparsed ? *reparsed : *parser;
+        if (!geometry.Reload(scene, changed, delta))
+        {
+            return false;
+        }
+        scene.DecodeTextures(geometry.UsedTextureIndices());
+        if (reparsed)
+        {
+            parser = std::move(reparsed);
+        }
+        printf("  %-14s %10.3f ms  (%zu files, %zu meshes rebuilt, %u materials, %zu textures, %s)\n", label,
+            ElapsedMs(start), changed.size(), delta.rebuiltMeshes.size(), delta.materialRange.count,
+            invalidated.size(), delta.placementsChanged ? "TLAS update" : "TLAS unchanged");
+        return true;
+    };
+
+    bool passed = true;
+    auto expect = [&](const char* label, bool condition, const char* problem)
+    {
+        if (!condition)
+        {
+            printf("  %-14s MISMATCH: %s\n", label, problem);
+            passed = false;
+        }
+    };
+    auto onlyChanged = [&](const std::filesystem::path& file) { return changed.size() == 1 && changed[0] == file; };
+    auto saveXML = [&]
+    {
+        std::ostringstream xml;
+        document.save(xml, "    ");
+        return RewriteFile(copy.xmlPath, xml.str());
+    };
+    auto skip = [](const char* label, const char* reason) { printf("  %-14s skipped (%s)\n", label, reason); };
+
+    SceneDelta delta;
+    if (!reload("No change", delta))
+    {
+        return false;
+    }
+    expect("No change", changed.empty() && delta.IsEmpty(), "the delta is not empty");
+
+    const char* label = "Material edit";
+    pugi::xml_node sceneNode = document.child("scene");
+    if (pugi::xml_attribute color = UsedReflectance(sceneNode))
+    {
+        float rgb[3] = { 0.0f, 0.0f, 0.0f };
+        if (parse_utils::ParseList(std::string_view(color.value()), rgb, 3) == 1)
+        {
+            rgb[1] = rgb[2] = rgb[0];
+        }
+        char value[96];
+        snprintf(value, sizeof(value), "%g %g %g", rgb[0] > 0.5f ? rgb[0] - 0.25f : rgb[0] + 0.25f, rgb[1], rgb[2]);
+        color.set_value(value);
+        if (!saveXML() || !reload(label, delta))
+        {
+            return false;
+        }
+        expect(label, onlyChanged(copy.xmlPath), "the watcher did not report just the XML");
+        expect(label, delta.materialRange.count == 1 && !delta.materialsResized, "not exactly one material updated");
+        expect(label, delta.rebuiltMeshes.empty() && delta.vertexRanges.empty() && delta.indexRanges.empty(),
+            "geometry was rewritten");
+        expect(label, !delta.placementsChanged, "placements changed");
+    }
+    else
+    {
+        skip(label, "no used top-level BSDF with an RGB reflectance");
+    }
+
+    label = "Moved shape";
+    if (MoveShape(sceneNode))
+    {
+        if (!saveXML() || !reload(label, delta))
+        {
+            return false;
+        }
+        expect(label, onlyChanged(copy.xmlPath), "the watcher did not report just the XML");
+        expect(label, delta.placementsChanged, "placements did not change");
+        expect(label, delta.rebuiltMeshes.empty() && delta.vertexRanges.empty() && delta.indexRanges.empty(),
+            "geometry was rewritten");
+        expect(label, delta.materialRange.IsEmpty() && !delta.materialsResized, "materials changed");
+    }
+    else
+    {
+        skip(label, "no top-level mesh or rectangle with a to_world matrix");
+    }
+
+    label = "OBJ edit";
+    auto objIt = std::find_if(parser->shapes.begin(), parser->shapes.end(), [&](const MitsubaSceneParser::Shape& shape)
+    {
+        std::error_code ec;
+        return shape.type == "obj" && !shape.filename.empty() &&
+               std::filesystem::exists(parser->sceneDirectory / shape.filename, ec);
+    });
+    if (objIt != parser->shapes.end())
+    {
+        const std::filesystem::path objPath = parser->sceneDirectory / objIt->filename;
+        const size_t meshCount = geometry.meshes.size();
+        if (!NudgeFirstVertex(objPath) || !reload(label, delta))
+        {
+            return false;
+        }
+        expect(label, onlyChanged(objPath), "the watcher did not report just the OBJ");
+        expect(label, delta.rebuiltMeshes.size() == 1 && delta.vertexRanges.size() == 1 && delta.indexRanges.size() == 1,
+            "not exactly one mesh rebuilt");
+        expect(label, geometry.meshes.size() == meshCount && delta.firstNewMesh == meshCount, "meshes were added");
+        expect(label, !delta.placementsChanged && delta.materialRange.IsEmpty(), "placements or materials changed");
+    }
+    else
+    {
+        skip(label, "no top-level OBJ shape");
+    }
+
+    label = "Texture edit";
+    std::vector<int> usedTextures = geometry.UsedTextureIndices();
+    auto textureIt = std::find_if(usedTextures.begin(), usedTextures.end(),
+        [&](int index) { return parser->GetTexture(index).IsValid(); });
+    if (textureIt != usedTextures.end())
+    {
+        const int index = *textureIt;
+        const std::filesystem::path texturePath = parser->sceneDirectory / parser->textures[index].filename;
+        std::string contents;
+        if (!ReadWholeFile(texturePath, contents) || !RewriteFile(texturePath, contents) || !reload(label, delta))
+        {
+            return false;
+        }
+        expect(label, onlyChanged(texturePath), "the watcher did not report just the texture");
+        expect(label, invalidated == std::vector<int>{ index }, "not exactly the edited texture invalidated");
+        expect(label, delta.IsEmpty(), "the geometry delta is not empty");
+        expect(label, parser->GetTexture(index).IsValid(), "the texture did not decode again");
+    }
+    else
+    {
+        skip(label, "no decodable texture in use");
+    }
+
+    // rt_scene recreates the environment map when its file is in the list
+    label = "Env map edit";
+    std::error_code ec;
+    const std::filesystem::path envPath = parser->sceneDirectory / parser->environmentMap.filename;
+    if (parser->environmentMap.isValid && std::filesystem::exists(envPath, ec))
+    {
+        std::string contents;
+        if (!ReadWholeFile(envPath, contents) || !RewriteFile(envPath, contents) || !reload(label, delta))
+        {
+            return false;
+        }
+        auto envStart = std::chrono::steady_clock::now();
+        bool loaded = texture_utils::LoadEnvironmentMap(envPath, parser->environmentMap.intensity).IsValid();
+        printf("  %-14s %10.3f ms  (environment map decode)\n", "", ElapsedMs(envStart));
+        expect(label, onlyChanged(envPath), "the watcher did not report just the environment map");
+        expect(label, delta.IsEmpty(), "the geometry delta is not empty");
+        expect(label, loaded, "the environment map did not load again");
+    }
+    else
+    {
+        skip(label, "no environment map");
+    }
+    return passed;
+}
+
+static bool BenchReload(const std::filesystem::path& scenePath)
+{
+    log::SetMinSeverity(log::Severity::Warning);
+    bool passed = RunReloadEdits(scenePath);
+    log::SetMinSeverity(log::Severity::Info);
+    return passed;
+}
+
+int main(int argc, const char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <scene.xml> [--bench-parse N] [--texture-threads N] [--bench-textures] [--load-threads N] [--bench-load] [--cache] [--bench-reload] [--no-vertex-cache]\n"
+                        "       %s --bench-obj <file.obj> [--load-threads N]\n"
+                        "       %s --bench-dedup [file.obj]\n"
+                        "       %s --bench-transform [vertices]\n"
+                        "       %s --bench-vertex-format [vertices]\n"
+                        "       %s --bench-vertex-cache [file.obj]\n"
+                        "       %s --bench-lod [file.obj]\n", argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+        return 1;
+    }
+
+    // Standalone OBJ parser benchmark, no scene involved
+    if (strcmp(argv[1], "--bench-obj") == 0 && argc >= 3)
+    {
+        unsigned threads = (argc >= 5 && strcmp(argv[3], "--load-threads") == 0) ? static_cast<unsigned>(atoi(argv[4])) : 0;
+        return BenchOBJ(argv[2], threads > 0 ? threads : parallel::DefaultThreadCount()) ? 0 : 1;
+    }
+    if (strcmp(argv[1], "--bench-dedup") == 0)
+    {
+        return BenchDedup(argc >= 3 ? argv[2] : std::filesystem::path()) ? 0 : 1;
+    }
+    if (strcmp(argv[1], "--bench-transform") == 0)
+    {
+        return BenchTransform(argc >= 3 ? strtoull(argv[2], nullptr, 10) : 10000000) ? 0 : 1;
+    }
+    if (strcmp(argv[1], "--bench-vertex-format") == 0)
+    {
+        return BenchVertexFormat(argc >= 3 ? strtoull(argv[2], nullptr, 10) : 10000000) ? 0 : 1;
+    }
+    if (strcmp(argv[1], "--bench-vertex-cache") == 0)
+    {
+        return BenchVertexCache(argc >= 3 ? argv[2] : std::filesystem::path()) ? 0 : 1;
+    }
+    if (strcmp(argv[1], "--bench-lod") == 0)
+    {
+        return BenchLOD(argc >= 3 ? argv[2] : std::filesystem::path()) ? 0 : 1;
+    }
+
+    std::filesystem::path scenePath = argv[1];
+    int benchParseIterations = 0;
+    unsigned textureThreads = 0;
+    bool benchTextures = false;
+    unsigned loadThreads = 0;
+    bool benchLoad = false;
+    bool benchCache = false;
+    bool benchReload = false;
+    bool optimizeVertexCache = true;
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--bench-parse") == 0 && i + 1 < argc)
+        {
+            benchParseIterations = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--texture-threads") == 0 && i + 1 < argc)
+        {
+            textureThreads = static_cast<unsigned>(atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--bench-textures") == 0)
+        {
+            benchTextures = true;
+        }
+        else if (strcmp(argv[i], "--load-threads") == 0 && i + 1 < argc)
+        {
+            loadThreads = static_cast<unsigned>(atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--bench-load") == 0)
+        {
+            benchLoad = true;
+        }
+        else if (strcmp(argv[i], "--cache") == 0)
+        {
+            benchCache = true;
+        }
+        else if (strcmp(argv[i], "--bench-reload") == 0)
+        {
+            benchReload = true;
+        }
+        else if (strcmp(argv[i], "--no-vertex-cache") == 0)
+        {
+            optimizeVertexCache = false;
+        }
+        else
+        {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!std::filesystem::exists(scenePath))
+    {
+        log::error("Scene file not found: %s", scenePath.string().c_str());
+        return 1;
+    }
+
+    auto totalStart = std::chrono::steady_clock::now();
+
+    MitsubaSceneParser parser;
+    parser.textureThreads = textureThreads;
+    if (!parser.Parse(scenePath))
+    {
+        return 1;
+    }
+
+    auto geometryStart = std::chrono::steady_clock::now();
+    SceneGeometry geometry;
+    geometry.loadThreads = loadThreads;
+    geometry.optimizeVertexCache = optimizeVertexCache;
+    bool hasGeometry = geometry.Load(parser);
+    double geometryMs = ElapsedMs(geometryStart);
+
+    // Decode what the renderer would upload: textures of placed instances
+    parser.DecodeTextures(geometry.UsedTextureIndices());
+    double totalMs = ElapsedMs(totalStart);
+
+    size_t textureBytes = 0;
+    for (const auto& texture : parser.textures)
+    {
+        textureBytes += texture.data.GetDataSize();
+    }
+
+    printf("Scene: %s\n", scenePath.string().c_str());
+    printf("Timings:\n");
+    printf("  XML parse    %10.2f ms (%zu nodes)\n", parser.stats.xmlParseMs, parser.stats.nodeCount);
+    printf("    BSDFs      %10.2f ms (%zu BSDFs)\n", parser.stats.bsdfParseMs, parser.stats.bsdfCount);
+    if (parser.stats.includeCount > 0)
+    {
+        printf("    Includes   %10zu (%zu fragments parsed, %zu files)\n", parser.stats.includeCount,
+            parser.stats.fragmentCount, parser.includedFiles.size());
+    }
+    printf("  Tex probe    %10.2f ms\n", parser.stats.textureProbeMs);
+    printf("  Geometry     %10.2f ms\n", geometryMs);
+    printf("  Tex decode   %10.2f ms (peak in flight %.1f MB)\n", parser.stats.textureDecodeMs,
+        double(parser.stats.peakDecodeBytes) / (1024.0 * 1024.0));
+    printf("  Total        %10.2f ms\n", totalMs);
+    printf("Counts:\n");
+    printf("  Shapes       %10zu\n", parser.shapes.size());
+    printf("  Shape groups %10zu\n", parser.shapeGroups.size());
+    printf("  Triangles    %10zu\n", geometry.indices.size() / 3);
+    printf("  Vertices     %10zu\n", geometry.vertices.size());
+    printf("  Materials    %10zu\n", geometry.materials.size());
+    printf("  Meshes       %10zu\n", geometry.meshes.size());
+    printf("  Instances    %10zu\n", geometry.instances.size());
+    PrintVertexCache(geometry);
+    printf("  Textures     %10zu (%zu decoded)\n", parser.textures.size(), parser.stats.decodedTextures);
+    printf("Sizes:\n");
+    PrintBytes("Positions", geometry.positions.size(), sizeof(GPUPosition));
+    PrintBytes("Vertices", geometry.vertices.size(), sizeof(GPUVertex));
+    PrintBytes("Indices", geometry.indices.size(), sizeof(uint32_t));
+    PrintBytes("Materials", geometry.materials.size(), sizeof(GPUMaterial));
+    PrintBytes("Instances", geometry.instances.size(), sizeof(GPUInstance));
+    printf("  %-12s %29.2f MB\n", "Textures", double(textureBytes) / (1024.0 * 1024.0));
+    printf("  %-12s %29.2f MB (%.2f MB if flattened)\n", "Geometry",
+        double(geometry.GeometryByteSize()) / (1024.0 * 1024.0),
+        double(geometry.FlattenedGeometryByteSize()) / (1024.0 * 1024.0));
+
+    auto verifyStart = std::chrono::steady_clock::now();
+    bool indicesValid = PackedScene::FromGeometry(geometry, parser).Verify();
+    printf("Index check    %10.2f ms  %s\n", ElapsedMs(verifyStart), indicesValid ? "ok" : "FAILED");
+
+    // Benchmarks that compare their results fail the process on a mismatch
+    bool benchesPassed = true;
+    if (benchParseIterations > 0)
+    {
+        BenchParse(scenePath, benchParseIterations);
+    }
+    if (benchCache && hasGeometry)
+    {
+        benchesPassed = BenchCache(scenePath, parser, geometry) && benchesPassed;
+    }
+    if (benchReload)
+    {
+        benchesPassed = BenchReload(scenePath) && benchesPassed;
+    }
+    if (benchLoad && hasGeometry)
+    {
+        benchesPassed = BenchLoad(parser, geometry, loadThreads > 0 ? loadThreads : parallel::DefaultThreadCount()) && benchesPassed;
+    }
+    if (benchTextures)
+    {
+        BenchTextures(scenePath, textureThreads > 0 ? textureThreads : parallel::DefaultThreadCount());
+    }
+
+    if (!hasGeometry)
+    {
+        return 2;
+    }
+    if (!indicesValid)
+    {
+        return 3;
+    }
+    return benchesPassed ? 0 : 4;
+}